@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# Comparar dos reportes de make bench (make bench-compare)
+#
+# Para cada corrida presente en ambos reportes (categoría, operación, modo,
+# hilos) marca como regresión:
+#   - MB/s que bajó más del umbral
+#   - ratio que subió más del umbral (salida más grande)
+#   - pico de RSS que subió más del umbral
+#
+# Uso: bench/compare.sh <base.csv> <nuevo.csv> [umbral %, default 10]
+# Sale con 1 si hay alguna regresión.
+
+set -u
+
+BASE=${1:?Uso: $0 <base.csv> <nuevo.csv> [umbral %]}
+NEW=${2:?Falta el reporte nuevo}
+THRESHOLD=${3:-10}
+
+awk -F, -v threshold="$THRESHOLD" '
+    FNR == 1 { next }
+    NR == FNR {
+        key = $1 "," $2 "," $3 "," $4
+        base_mbs[key] = $10; base_ratio[key] = $8; base_rss[key] = $11
+        next
+    }
+    {
+        key = $1 "," $2 "," $3 "," $4
+        if (!(key in base_mbs)) next
+        compared++
+        label = sprintf("%-10s %-3s %-8s -j %-2s", $1, $2, $3, $4)
+        if (base_mbs[key] > 0 && $10 < base_mbs[key] * (1 - threshold / 100)) {
+            printf "✗ %s  MB/s  %10.1f → %10.1f (%+.1f%%)\n", label, base_mbs[key], $10,
+                   ($10 / base_mbs[key] - 1) * 100
+            regressions++
+        }
+        if (base_ratio[key] > 0 && $8 > base_ratio[key] * (1 + threshold / 100)) {
+            printf "✗ %s  ratio %10.3f → %10.3f\n", label, base_ratio[key], $8
+            regressions++
+        }
+        if (base_rss[key] > 0 && $11 > base_rss[key] * (1 + threshold / 100)) {
+            printf "✗ %s  RSS   %7d MB → %7d MB\n", label, base_rss[key] / 1048576, $11 / 1048576
+            regressions++
+        }
+    }
+    END {
+        printf "%d corridas comparadas, %d regresiones (umbral %s%%)\n", compared, regressions, threshold
+        exit regressions > 0 ? 1 : 0
+    }
+' "$BASE" "$NEW"
@@ -0,0 +1,247 @@
+// gsea-corpus: corpus determinístico para make bench
+//
+// Genera siempre los mismos bytes (semilla fija), así que dos reportes de
+// bench medidos en distintas versiones de gsea comparan exactamente los
+// mismos datos. Cada categoría es un directorio, para poder medir -j:
+//
+//   text/        prosa en español (palabras con frecuencia tipo Zipf)
+//   logs/        líneas de log con fecha, nivel, IP, ruta y latencia
+//   binary/      registros binarios (enteros, flotantes, relleno)
+//   random/      bytes aleatorios (incomprimibles)
+//   compressed/  texto ya comprimido con Huffman (casi incomprimible)
+//   huge/        un solo archivo grande (mezcla de lo anterior)
+//   small/       muchos archivos chicos (texto y logs, 200 B a 4 KB)
+//
+// Uso: gsea-corpus <directorio> [MB del archivo grande] [archivos chicos]
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "../huffman.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+static const size_t MB = 1024 * 1024;
+static const int FILES_PER_CATEGORY = 8;
+static const size_t CATEGORY_FILE_SIZE = 2 * MB;
+
+// xorshift64*: rápido y con la misma secuencia en cualquier máquina
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed ? seed : 0x9e3779b97f4a7c15ULL) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545f4914f6cdd1dULL;
+    }
+
+    uint32_t below(uint32_t limit) {
+        return (uint32_t)((next() >> 32) % limit);
+    }
+
+    // Índice sesgado hacia 0 (aproxima una distribución de Zipf)
+    uint32_t zipf(uint32_t limit) {
+        uint32_t a = below(limit);
+        uint32_t b = below(limit);
+        uint32_t c = below(limit);
+        return std::min(a, std::min(b, c));
+    }
+};
+
+static const char* const WORDS[] = {
+    "de", "la", "que", "el", "en", "y", "a", "los", "se", "del", "las", "un", "por", "con",
+    "no", "una", "su", "para", "es", "al", "lo", "como", "más", "pero", "sus", "le", "ya",
+    "archivo", "sistema", "proceso", "memoria", "bloque", "datos", "disco", "usuario",
+    "operativo", "tiempo", "clave", "compresión", "directorio", "kernel", "hilo", "cola",
+    "universidad", "estudiante", "proyecto", "resultado", "medición", "rendimiento",
+    "segundo", "siempre", "nunca", "porque", "entonces", "también", "durante", "mientras",
+    "mañana", "información", "configuración", "señal", "página", "caché", "núcleo"
+};
+static const uint32_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+static const char* const LEVELS[] = {"INFO", "INFO", "INFO", "DEBUG", "WARN", "ERROR"};
+static const char* const PATHS[] = {
+    "/api/v1/files", "/api/v1/files/upload", "/api/v1/users/login", "/static/app.js",
+    "/static/style.css", "/healthz", "/api/v2/blocks", "/metrics"
+};
+
+void append_text(std::string& out, size_t size, Random& rng) {
+    size_t sentence = 0;
+    while (out.size() < size) {
+        std::string word = WORDS[rng.zipf(WORD_COUNT)];
+        if (sentence == 0) word[0] = toupper(word[0]);
+        out += word;
+        sentence++;
+        if (sentence > 6 && rng.below(10) == 0) {
+            out += rng.below(5) == 0 ? ".\n" : ". ";
+            sentence = 0;
+        } else {
+            out += rng.below(12) == 0 ? ", " : " ";
+        }
+    }
+    out.resize(size);
+}
+
+void append_logs(std::string& out, size_t size, Random& rng) {
+    uint64_t seconds = 1700000000;
+    char line[256];
+    while (out.size() < size) {
+        seconds += rng.below(3);
+        time_t t = (time_t)seconds;
+        struct tm tm;
+        gmtime_r(&t, &tm);
+        int n = snprintf(line, sizeof(line),
+                         "%04d-%02d-%02dT%02d:%02d:%02dZ %-5s [worker-%u] 10.0.%u.%u %s %u %ums\n",
+                         tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec,
+                         LEVELS[rng.below(6)], rng.below(16), rng.below(4), rng.below(256),
+                         PATHS[rng.zipf(8)], rng.below(8) == 0 ? 404 : 200, rng.zipf(900) + 1);
+        out.append(line, n);
+    }
+    out.resize(size);
+}
+
+void append_binary(std::string& out, size_t size, Random& rng) {
+    // Registros de 32 bytes: id creciente, timestamp, dos flotantes, flags y relleno
+    uint32_t id = 0;
+    uint64_t stamp = 1700000000000ULL;
+    while (out.size() < size) {
+        unsigned char record[32];
+        memset(record, 0, sizeof(record));
+        stamp += rng.below(1000);
+        float a = (float)rng.below(100000) / 100.0f;
+        float b = (float)rng.zipf(1000);
+        memcpy(record, &id, 4);
+        memcpy(record + 4, &stamp, 8);
+        memcpy(record + 12, &a, 4);
+        memcpy(record + 16, &b, 4);
+        record[20] = (unsigned char)rng.below(4);
+        out.append((const char*)record, sizeof(record));
+        id++;
+    }
+    out.resize(size);
+}
+
+void append_random(std::string& out, size_t size, Random& rng) {
+    while (out.size() < size) {
+        uint64_t value = rng.next();
+        out.append((const char*)&value, sizeof(value));
+    }
+    out.resize(size);
+}
+
+void append_compressed(std::string& out, size_t size, Random& rng) {
+    std::string text;
+    append_text(text, size + size / 2, rng);
+    HuffmanCoder coder;
+    std::vector<unsigned char> packed =
+        coder.compress(std::vector<unsigned char>(text.begin(), text.end()));
+    out.append((const char*)packed.data(), std::min(packed.size(), size));
+    if (out.size() < size) append_random(out, size, rng);
+}
+
+bool write_file(const std::string& path, const std::string& data) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "Error: no se pudo crear %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error: write() en %s: %s\n", path.c_str(), strerror(errno));
+            close(fd);
+            return false;
+        }
+        done += n;
+    }
+    close(fd);
+    return true;
+}
+
+bool make_dir(const std::string& path) {
+    if (mkdir(path.c_str(), 0755) == -1 && errno != EEXIST) {
+        fprintf(stderr, "Error: no se pudo crear %s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+typedef void (*Generator)(std::string&, size_t, Random&);
+
+bool write_category(const std::string& root, const char* name, Generator generate, uint64_t seed) {
+    std::string dir = root + "/" + name;
+    if (!make_dir(dir)) return false;
+    Random rng(seed);
+    for (int i = 0; i < FILES_PER_CATEGORY; i++) {
+        std::string data;
+        generate(data, CATEGORY_FILE_SIZE, rng);
+        if (!write_file(dir + "/" + name + "_" + std::to_string(i) + ".dat", data)) return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <directorio> [MB del archivo grande] [archivos chicos]\n", argv[0]);
+        return 1;
+    }
+    std::string root = argv[1];
+    size_t huge_mb = argc > 2 ? strtoul(argv[2], nullptr, 10) : 256;
+    int small_count = argc > 3 ? atoi(argv[3]) : 10000;
+    Log::global().set_level(LOG_LEVEL_ERROR);
+
+    if (!make_dir(root) ||
+        !write_category(root, "text", append_text, 1) ||
+        !write_category(root, "logs", append_logs, 2) ||
+        !write_category(root, "binary", append_binary, 3) ||
+        !write_category(root, "random", append_random, 4) ||
+        !write_category(root, "compressed", append_compressed, 5) ||
+        !make_dir(root + "/huge") || !make_dir(root + "/small")) {
+        return 1;
+    }
+
+    // Archivo grande: tramos de 4 MB de cada tipo, en orden fijo
+    Random huge_rng(6);
+    Generator mix[] = {append_text, append_logs, append_binary, append_text, append_random};
+    std::string huge;
+    huge.reserve(huge_mb * MB);
+    for (size_t i = 0; huge.size() < huge_mb * MB; i++) {
+        std::string part;
+        mix[i % 5](part, std::min(4 * MB, huge_mb * MB - huge.size()), huge_rng);
+        huge += part;
+    }
+    if (!write_file(root + "/huge/huge.dat", huge)) return 1;
+    huge.clear();
+    huge.shrink_to_fit();
+
+    Random small_rng(7);
+    for (int i = 0; i < small_count; i++) {
+        std::string data;
+        size_t size = 200 + small_rng.below(3900);
+        if (i % 2 == 0) append_text(data, size, small_rng);
+        else append_logs(data, size, small_rng);
+        char name[32];
+        snprintf(name, sizeof(name), "/small/s%05d.txt", i);
+        if (!write_file(root + name, data)) return 1;
+    }
+
+    printf("Corpus en %s: 5 x %d archivos de %zu MB, 1 de %zu MB, %d chicos\n",
+           root.c_str(), FILES_PER_CATEGORY, CATEGORY_FILE_SIZE / MB, huge_mb, small_count);
+    return 0;
+}
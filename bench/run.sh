@@ -0,0 +1,122 @@
+#!/bin/bash
+
+# Benchmark de punta a punta de GSEA (make bench)
+#
+# Corre gsea en cada modo (-c/-d, -e/-u, -ce/-du) y con cada cantidad de
+# hilos sobre cada categoría del corpus, y escribe un CSV con una fila por
+# corrida: MB/s, ratio y pico de RSS salen del reporte de --stats=json.
+#
+# Uso: bench/run.sh <gsea> <corpus> <reporte.csv>
+# Variables: BENCH_THREADS (default "1 2 4"), BENCH_LEVELS (default
+# "1 2 3 5 7 9": -c/-d con cada --level), BENCH_REPEAT (default 3: se guarda
+# la corrida más rápida), BENCH_KEY, BENCH_MAX_MEMORY
+
+set -u
+
+GSEA=${1:?Uso: $0 <gsea> <corpus> <reporte.csv>}
+CORPUS=${2:?Falta el directorio del corpus}
+REPORT=${3:?Falta el archivo del reporte}
+THREADS=${BENCH_THREADS:-"1 2 4"}
+LEVELS=${BENCH_LEVELS:-"1 2 3 5 7 9"}
+REPEAT=${BENCH_REPEAT:-3}
+KEY=${BENCH_KEY:-benchClave123}
+MAX_MEMORY=${BENCH_MAX_MEMORY:-64M}
+
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/gsea-bench.XXXXXX")
+trap 'rm -rf "$WORK"' EXIT
+
+# Campo numérico del objeto "total" de un reporte de --stats=json
+total_field() {
+    sed -n '/"total"/,$p' "$1" | grep -o "\"$2\": [0-9.]*" | head -1 | awk '{print $2}'
+}
+
+# Una medición: gsea con --stats, REPEAT veces, y una fila en el CSV con la
+# corrida más rápida (la menos afectada por ruido del sistema)
+# run <categoría> <modo> <hilos> <operación> <entrada> <salida> [opciones...]
+failures=0
+run() {
+    local category=$1 mode=$2 threads=$3 op=$4 input=$5 output=$6
+    shift 6
+    local best=0 r failed speed
+    for ((r = 0; r < REPEAT; r++)); do
+        rm -rf "$output" && mkdir -p "$output"
+        if ! "$GSEA" -q "-$op" -i "$input" -o "$output" -j "$threads" -k "$KEY" "$@" \
+             --stats=json --stats-out "$WORK/run.json"; then
+            echo "✗ Falló: $category $op -j $threads $*" >&2
+            failures=$((failures + 1))
+            return
+        fi
+        failed=$(total_field "$WORK/run.json" failed)
+        if [ "${failed:-1}" != "0" ]; then
+            echo "✗ $failed archivos fallidos: $category $op -j $threads" >&2
+            failures=$((failures + 1))
+            return
+        fi
+        speed=$(total_field "$WORK/run.json" mb_per_s)
+        if awk -v a="$speed" -v b="$best" 'BEGIN { exit !(a > b) }'; then
+            best=$speed
+            cp "$WORK/run.json" "$WORK/stats.json"
+        fi
+    done
+    printf '%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n' "$category" "$op" "$mode" "$threads" \
+        "$(total_field "$WORK/stats.json" files)" \
+        "$(total_field "$WORK/stats.json" bytes_in)" \
+        "$(total_field "$WORK/stats.json" bytes_out)" \
+        "$(total_field "$WORK/stats.json" ratio)" \
+        "$(total_field "$WORK/stats.json" wall_ms)" \
+        "$(total_field "$WORK/stats.json" mb_per_s)" \
+        "$(total_field "$WORK/stats.json" peak_rss_bytes)" >> "$REPORT"
+    printf '  %-10s %-3s %-9s -j %-2s %10s MB/s  ratio %s\n' "$category" "$op" "$mode" "$threads" \
+        "$(total_field "$WORK/stats.json" mb_per_s)" "$(total_field "$WORK/stats.json" ratio)"
+}
+
+echo "categoria,operacion,modo,hilos,archivos,bytes_in,bytes_out,ratio,wall_ms,mb_per_s,peak_rss_bytes" > "$REPORT"
+
+for dir in "$CORPUS"/*/; do
+    category=$(basename "$dir")
+    for threads in $THREADS; do
+        # Un solo archivo no se reparte entre hilos: basta con -j 1
+        if [ "$category" = "huge" ] && [ "$threads" != "1" ]; then
+            continue
+        fi
+        for pair in c:d e:u ce:du; do
+            encode=${pair%%:*}
+            decode=${pair##*:}
+            run "$category" memoria "$threads" "$encode" "$dir" "$WORK/enc"
+            run "$category" memoria "$threads" "$decode" "$WORK/enc" "$WORK/dec"
+        done
+    done
+    # El archivo grande también por bloques (memoria fija)
+    if [ "$category" = "huge" ]; then
+        run "$category" bloques 1 ce "$dir" "$WORK/enc" --max-memory "$MAX_MEMORY"
+        run "$category" bloques 1 du "$WORK/enc" "$WORK/dec" --max-memory "$MAX_MEMORY"
+    fi
+    # Curva velocidad/ratio: cada nivel con un hilo
+    for level in $LEVELS; do
+        run "$category" "nivel$level" 1 c "$dir" "$WORK/enc" --level "$level"
+        run "$category" "nivel$level" 1 d "$WORK/enc" "$WORK/dec"
+    done
+done
+
+# Una línea por categoría y nivel: compresión, descompresión y ratio
+if [ -n "$LEVELS" ]; then
+    echo ""
+    echo "Niveles (-j 1):   categoría  nivel   comprime MB/s  descomprime MB/s  ratio"
+    awk -F, '
+        $3 ~ /^nivel/ && $2 == "c" { key = $1 " " substr($3, 6); order[++n] = key; c[key] = $10; r[key] = $8 }
+        $3 ~ /^nivel/ && $2 == "d" { d[$1 " " substr($3, 6)] = $10 }
+        END {
+            for (i = 1; i <= n; i++) {
+                split(order[i], part, " ")
+                printf "                  %-10s %5s %15s %17s  %s\n", part[1], part[2], c[order[i]], d[order[i]], r[order[i]]
+            }
+        }
+    ' "$REPORT"
+fi
+
+echo ""
+echo "Reporte: $REPORT"
+if [ "$failures" -gt 0 ]; then
+    echo "✗ $failures corridas fallaron" >&2
+    exit 1
+fi
@@ -0,0 +1,230 @@
+#ifndef GSEA_BUFFER_POOL_H
+#define GSEA_BUFFER_POOL_H
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+#include <sys/mman.h>
+
+// Buffer de bytes alineado, administrado por BufferPool
+// No se libera con delete: se devuelve al pool para reutilizarlo
+struct PoolBuffer {
+    unsigned char* data;   // Memoria alineada a línea de caché (o a página)
+    size_t size;           // Bytes válidos
+    size_t capacity;       // Bytes reservados (potencia de 2)
+    int size_class;        // Índice de la clase de tamaño
+    bool mapped;           // true = mmap(), false = posix_memalign()
+};
+
+// Pool de buffers reutilizables entre archivos y etapas
+//
+// En modo directorio cada archivo necesita los mismos buffers (lectura,
+// compresión, descompresión). En vez de reservarlos y liberarlos por
+// archivo, se guardan en listas libres por CLASE DE TAMAÑO (potencias de 2
+// desde 64 KB). Tras los primeros archivos, acquire() encuentra siempre un
+// buffer libre de la clase correcta: cero reservas de heap por archivo.
+//
+//   - < 1 MB : posix_memalign() alineado a 64 bytes (línea de caché)
+//   - >= 1 MB: mmap() anónimo, alineado a página; con huge pages activas
+//              se intenta MAP_HUGETLB (2 MB) y si no, madvise(MADV_HUGEPAGE)
+class BufferPool {
+private:
+    static const size_t ALIGNMENT = 64;
+    static const int MIN_SHIFT = 16;                  // Clase 0 = 64 KB
+    static const int NUM_CLASSES = 48 - MIN_SHIFT;    // Hasta 2^47 bytes
+    static const size_t MMAP_THRESHOLD = 1 << 20;
+    static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+    std::vector<PoolBuffer*> free_lists[NUM_CLASSES];
+    pthread_mutex_t mutex;
+    bool use_huge_pages;
+    uint64_t cache_limit;      // Máximo de bytes guardados en las listas libres
+    uint64_t cached_bytes;     // Bytes guardados ahora
+    uint64_t fresh_count;      // Buffers reservados al sistema
+    uint64_t reuse_count;      // Buffers reutilizados
+
+    static int class_for(size_t bytes) {
+        int shift = MIN_SHIFT;
+        while (shift < MIN_SHIFT + NUM_CLASSES - 1 && ((size_t)1 << shift) < bytes) {
+            shift++;
+        }
+        return shift - MIN_SHIFT;
+    }
+
+    PoolBuffer* allocate(int size_class) {
+        size_t capacity = (size_t)1 << (size_class + MIN_SHIFT);
+        PoolBuffer* buffer = new PoolBuffer();
+        buffer->size = 0;
+        buffer->capacity = capacity;
+        buffer->size_class = size_class;
+        buffer->data = nullptr;
+
+        if (capacity >= MMAP_THRESHOLD) {
+            buffer->mapped = true;
+            void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+            if (use_huge_pages && capacity >= HUGE_PAGE_SIZE) {
+                p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            }
+#endif
+            if (p == MAP_FAILED) {
+                // Sin huge pages reservadas: páginas normales y, si se pidió,
+                // sugerir huge pages transparentes al kernel
+                p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+                if (p != MAP_FAILED && use_huge_pages) {
+                    madvise(p, capacity, MADV_HUGEPAGE);
+                }
+#endif
+            }
+            if (p == MAP_FAILED) {
+                delete buffer;
+                return nullptr;
+            }
+            buffer->data = (unsigned char*)p;
+        } else {
+            buffer->mapped = false;
+            void* p = nullptr;
+            if (posix_memalign(&p, ALIGNMENT, capacity) != 0) {
+                delete buffer;
+                return nullptr;
+            }
+            buffer->data = (unsigned char*)p;
+        }
+        return buffer;
+    }
+
+    static void free_buffer(PoolBuffer* buffer) {
+        if (buffer->mapped) {
+            munmap(buffer->data, buffer->capacity);
+        } else {
+            free(buffer->data);
+        }
+        delete buffer;
+    }
+
+public:
+    BufferPool()
+        : use_huge_pages(false), cache_limit(256ULL << 20), cached_bytes(0),
+          fresh_count(0), reuse_count(0) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~BufferPool() {
+        for (int c = 0; c < NUM_CLASSES; c++) {
+            for (PoolBuffer* buffer : free_lists[c]) {
+                free_buffer(buffer);
+            }
+        }
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // Pool compartido por todo el proceso
+    static BufferPool& global() {
+        static BufferPool pool;
+        return pool;
+    }
+
+    void set_huge_pages(bool enabled) { use_huge_pages = enabled; }
+
+    // Límite de memoria que el pool puede retener sin usar
+    void set_cache_limit(uint64_t bytes) { cache_limit = bytes; }
+
+    // Obtener un buffer con al menos min_capacity bytes (size = 0)
+    // Retorna nullptr solo si el sistema no tiene memoria
+    PoolBuffer* acquire(size_t min_capacity) {
+        int size_class = class_for(min_capacity);
+
+        pthread_mutex_lock(&mutex);
+        if (!free_lists[size_class].empty()) {
+            PoolBuffer* buffer = free_lists[size_class].back();
+            free_lists[size_class].pop_back();
+            cached_bytes -= buffer->capacity;
+            reuse_count++;
+            pthread_mutex_unlock(&mutex);
+            buffer->size = 0;
+            return buffer;
+        }
+        fresh_count++;
+        pthread_mutex_unlock(&mutex);
+
+        return allocate(size_class);
+    }
+
+    // Devolver un buffer para que otro archivo/etapa lo reutilice
+    void release(PoolBuffer* buffer) {
+        if (buffer == nullptr) return;
+
+        pthread_mutex_lock(&mutex);
+        if (cached_bytes + buffer->capacity <= cache_limit) {
+            // reserve() al inicio: push_back no reserva en el camino normal
+            if (free_lists[buffer->size_class].capacity() == 0) {
+                free_lists[buffer->size_class].reserve(64);
+            }
+            if (free_lists[buffer->size_class].size() < free_lists[buffer->size_class].capacity()) {
+                free_lists[buffer->size_class].push_back(buffer);
+                cached_bytes += buffer->capacity;
+                pthread_mutex_unlock(&mutex);
+                return;
+            }
+        }
+        pthread_mutex_unlock(&mutex);
+
+        // No cabe en la caché: se devuelve al sistema
+        free_buffer(buffer);
+    }
+
+    uint64_t fresh_allocations() const { return fresh_count; }
+    uint64_t reuses() const { return reuse_count; }
+};
+
+// Buffer del pool con alcance: se devuelve automáticamente al salir del bloque
+class PooledBuffer {
+private:
+    PoolBuffer* buffer;
+
+public:
+    PooledBuffer() : buffer(nullptr) {}
+
+    explicit PooledBuffer(size_t min_capacity)
+        : buffer(BufferPool::global().acquire(min_capacity)) {}
+
+    ~PooledBuffer() {
+        BufferPool::global().release(buffer);
+    }
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    // Asegurar al menos min_capacity bytes (el contenido NO se conserva)
+    bool reserve(size_t min_capacity) {
+        if (buffer != nullptr && buffer->capacity >= min_capacity) {
+            buffer->size = 0;
+            return true;
+        }
+        BufferPool::global().release(buffer);
+        buffer = BufferPool::global().acquire(min_capacity);
+        return buffer != nullptr;
+    }
+
+    bool valid() const { return buffer != nullptr; }
+    unsigned char* data() { return buffer->data; }
+    const unsigned char* data() const { return buffer->data; }
+    size_t size() const { return buffer->size; }
+    size_t capacity() const { return buffer != nullptr ? buffer->capacity : 0; }
+    void set_size(size_t n) { buffer->size = n; }
+
+    // Intercambiar contenidos (p. ej. la salida de una etapa pasa a ser la entrada)
+    void swap(PooledBuffer& other) {
+        PoolBuffer* tmp = buffer;
+        buffer = other.buffer;
+        other.buffer = tmp;
+    }
+};
+
+#endif // GSEA_BUFFER_POOL_H
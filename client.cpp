@@ -0,0 +1,169 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include "daemon_protocol.h"
+
+// Cliente liviano para el daemon de GSEA (gsea --daemon <socket>)
+//
+// Por defecto abre la entrada y la salida en ESTE proceso y se las pasa al
+// daemon como file descriptors (SCM_RIGHTS): el daemon no necesita permisos
+// sobre las rutas del usuario. Con --paths envía las rutas absolutas.
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <errno.h>
+
+void print_usage(const char* program_name) {
+    std::cout << "Uso: " << program_name << " -s <socket> [operaciones] -i <entrada> -o <salida> [-k <clave>]\n\n";
+    std::cout << "Operaciones (mismas que gsea):\n";
+    std::cout << "  -c  Comprimir     -d  Descomprimir\n";
+    std::cout << "  -e  Encriptar     -u  Desencriptar\n\n";
+    std::cout << "Opciones:\n";
+    std::cout << "  -s <socket>      Socket del daemon (gsea --daemon <socket>)\n";
+    std::cout << "  --paths          Enviar rutas en vez de file descriptors\n\n";
+    std::cout << "Ejemplo:\n";
+    std::cout << "  " << program_name << " -s /tmp/gsea.sock -ce -i doc.pdf -o doc.gsea -k miClave\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string socket_path;
+    std::string input_path;
+    std::string output_path;
+    std::string key;
+    uint8_t ops = 0;
+    bool use_paths = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--paths") {
+            use_paths = true;
+        } else if (arg.size() > 1 && arg[0] == '-' && arg[1] != '-') {
+            for (size_t j = 1; j < arg.length(); j++) {
+                std::string* target = nullptr;
+                switch (arg[j]) {
+                    case 'c': ops |= DAEMON_OP_COMPRESS; break;
+                    case 'd': ops |= DAEMON_OP_DECOMPRESS; break;
+                    case 'e': ops |= DAEMON_OP_ENCRYPT; break;
+                    case 'u': ops |= DAEMON_OP_DECRYPT; break;
+                    case 's': target = &socket_path; break;
+                    case 'i': target = &input_path; break;
+                    case 'o': target = &output_path; break;
+                    case 'k': target = &key; break;
+                    default:
+                        std::cerr << "Error: Opción desconocida -" << arg[j] << "\n";
+                        return 1;
+                }
+                if (target != nullptr) {
+                    if (i + 1 >= argc) {
+                        std::cerr << "Error: -" << arg[j] << " requiere un argumento\n";
+                        return 1;
+                    }
+                    *target = argv[++i];
+                    j = arg.length();
+                }
+            }
+        } else {
+            std::cerr << "Error: Argumento desconocido " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (socket_path.empty() || input_path.empty() || output_path.empty() || ops == 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Conectarse al daemon
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (sock == -1 || connect(sock, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+        std::cerr << "Error: No se pudo conectar al daemon en " << socket_path
+                  << ": " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    DaemonRequest request;
+    memset(&request, 0, sizeof(request));
+    request.magic = DAEMON_REQUEST_MAGIC;
+    request.ops = ops;
+    request.key_length = key.size();
+
+    bool sent;
+    int fds[2] = {-1, -1};
+    if (use_paths) {
+        // El daemon puede tener otro directorio de trabajo: rutas absolutas
+        char resolved[PATH_MAX];
+        if (realpath(input_path.c_str(), resolved) == nullptr) {
+            std::cerr << "Error: realpath() de la entrada falló: " << strerror(errno) << "\n";
+            return 1;
+        }
+        input_path = resolved;
+        if (output_path[0] != '/') {
+            char cwd[PATH_MAX];
+            if (getcwd(cwd, sizeof(cwd)) == nullptr) return 1;
+            output_path = std::string(cwd) + "/" + output_path;
+        }
+
+        request.use_fds = 0;
+        request.input_length = input_path.size();
+        request.output_length = output_path.size();
+        sent = DaemonProtocol::send_request_header(sock, request, nullptr, 0) &&
+               DaemonProtocol::send_all(sock, key.data(), key.size()) &&
+               DaemonProtocol::send_all(sock, input_path.data(), input_path.size()) &&
+               DaemonProtocol::send_all(sock, output_path.data(), output_path.size());
+    } else {
+        fds[0] = open(input_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fds[0] == -1) {
+            std::cerr << "Error: open() de la entrada falló: " << strerror(errno) << "\n";
+            return 1;
+        }
+        fds[1] = open(output_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fds[1] == -1) {
+            std::cerr << "Error: open() de la salida falló: " << strerror(errno) << "\n";
+            return 1;
+        }
+
+        request.use_fds = 1;
+        sent = DaemonProtocol::send_request_header(sock, request, fds, 2) &&
+               DaemonProtocol::send_all(sock, key.data(), key.size());
+    }
+
+    if (!sent) {
+        std::cerr << "Error: No se pudo enviar la petición: " << strerror(errno) << "\n";
+        return 1;
+    }
+
+    // Esperar la respuesta
+    DaemonResponse response;
+    std::string message;
+    if (!DaemonProtocol::recv_all(sock, &response, sizeof(response)) ||
+        response.magic != DAEMON_RESPONSE_MAGIC || response.message_length > DAEMON_MAX_FIELD) {
+        std::cerr << "Error: Respuesta inválida del daemon\n";
+        return 1;
+    }
+    message.resize(response.message_length);
+    if (response.message_length > 0 &&
+        !DaemonProtocol::recv_all(sock, &message[0], response.message_length)) {
+        std::cerr << "Error: Respuesta incompleta del daemon\n";
+        return 1;
+    }
+    close(sock);
+    if (fds[0] != -1) close(fds[0]);
+    if (fds[1] != -1) close(fds[1]);
+
+    if (response.status != 0) {
+        std::cerr << "✗ Error del daemon: " << message << "\n";
+        return 1;
+    }
+
+    std::cout << "✓ " << input_path << " → " << output_path << " ("
+              << response.bytes_in << " → " << response.bytes_out << " bytes)\n";
+    return 0;
+}
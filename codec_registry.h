@@ -0,0 +1,291 @@
+#ifndef GSEA_CODEC_REGISTRY_H
+#define GSEA_CODEC_REGISTRY_H
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "huffman.h"
+#include "lz77.h"
+#include "codec_select.h"
+
+// Registro de códecs de bloque y de cifrados
+//
+// Cada códec tiene un id (el byte de códec de ContainerHeader y BlockHeader)
+// y un nombre (--comp-alg). BlockCodec y main.cpp solo los buscan acá: para
+// agregar un códec basta con implementar BlockCompressor y sumar una fila a
+// CodecRegistry::entries(). Se despacha una vez por bloque (un llamado
+// virtual cada 1 MB); los bucles por byte quedan dentro de cada códec.
+
+enum ContainerCodec {
+    CONTAINER_CODEC_NONE = 0,       // Guardado tal cual (no está en el registro)
+    CONTAINER_CODEC_HUFFMAN = 1,
+    CONTAINER_CODEC_LZ = 2
+};
+
+enum ContainerCipher {
+    CONTAINER_CIPHER_NONE = 0,
+    CONTAINER_CIPHER_XOR = 1
+};
+
+// Niveles de compresión (--level): velocidad a cambio de ratio
+static const int CONTAINER_MIN_LEVEL = 1;
+static const int CONTAINER_MAX_LEVEL = 9;
+static const int CONTAINER_DEFAULT_LEVEL = 2;
+
+// Qué hace cada nivel al comprimir
+//
+//   1    Huffman, bloques de 4 MB, frecuencias de una muestra del bloque
+//   2    Huffman, bloques de 1 MB, frecuencias exactas (el comportamiento de siempre)
+//   3-7  LZ77 + Huffman, bloques de 1 MB, búsqueda cada vez más profunda
+//   8-9  LZ77 + Huffman, bloques de 256 KB (árboles más ajustados a cada zona);
+//        el 9 con parseo óptimo
+//
+// Con --comp-alg se fuerza otro códec: usa los parámetros de ese códec en
+// el nivel (lz77 en los niveles 1 y 2 busca como en el 3)
+struct CompressionLevel {
+    uint8_t codec;          // Códec de los bloques
+    uint32_t block_size;
+    bool sampled;           // Árbol según una muestra (solo Huffman)
+    LzParams lz;            // Solo con CONTAINER_CODEC_LZ
+
+    static CompressionLevel of(int level) {
+        static const CompressionLevel LEVELS[CONTAINER_MAX_LEVEL] = {
+            {CONTAINER_CODEC_HUFFMAN, 4 << 20, true, {4, 16, false, false}},
+            {CONTAINER_CODEC_HUFFMAN, 1 << 20, false, {4, 16, false, false}},
+            {CONTAINER_CODEC_LZ, 1 << 20, false, {4, 16, false, false}},
+            {CONTAINER_CODEC_LZ, 1 << 20, false, {8, 32, false, false}},
+            {CONTAINER_CODEC_LZ, 1 << 20, false, {16, 64, true, false}},
+            {CONTAINER_CODEC_LZ, 1 << 20, false, {32, 128, true, false}},
+            {CONTAINER_CODEC_LZ, 1 << 20, false, {64, 256, true, false}},
+            {CONTAINER_CODEC_LZ, 256 << 10, false, {128, 512, true, false}},
+            {CONTAINER_CODEC_LZ, 256 << 10, false, {256, 1024, false, true}},
+        };
+        level = std::max(CONTAINER_MIN_LEVEL, std::min(CONTAINER_MAX_LEVEL, level));
+        return LEVELS[level - 1];
+    }
+};
+
+// Interfaz común de los códecs de bloque
+class BlockCompressor {
+public:
+    virtual ~BlockCompressor() {}
+
+    // Comprimir un bloque en out (HuffmanCoder::compress_bound(size) bytes)
+    // Retorna los bytes escritos, o 0 si no achica (se guarda tal cual)
+    virtual size_t compress(const unsigned char* raw, size_t size, const CompressionLevel& level,
+                            unsigned char* out) = 0;
+
+    // Descomprimir exactamente raw_size bytes en out
+    virtual bool decompress(const unsigned char* stored, size_t stored_size,
+                            unsigned char* out, size_t raw_size) = 0;
+
+    // Reservar de antemano lo que use con bloques de hasta block_size bytes
+    virtual void reserve(size_t block_size, bool for_compress) {
+        (void)block_size;
+        (void)for_compress;
+    }
+
+    // ¿Vale la pena intentar comprimir este bloque? (--comp-alg auto)
+    // Por defecto, la estimación de orden 0 de una muestra, que es
+    // exactamente lo que logra Huffman
+    virtual bool worth_compressing(const unsigned char* raw, size_t size, const CompressionLevel& level) {
+        (void)level;
+        return CodecSelector::worth_compressing(raw, size);
+    }
+};
+
+// Códec 1: un árbol de Huffman por bloque
+class HuffmanBlockCompressor : public BlockCompressor {
+private:
+    HuffmanCoder huffman;      // Se reutiliza entre bloques
+
+    // Árbol de una muestra del bloque (nivel 1): se ahorra contar todo el
+    // bloque. Todo byte recibe al menos frecuencia 1 para tener código
+    // aunque no haya salido en la muestra, y como el total de bits no se
+    // conoce de antemano, el padding se completa al final. Se codifica de a
+    // tramos para cortar en cuanto deja de achicar
+    size_t compress_sampled(const unsigned char* raw, size_t size, unsigned char* out) {
+        static const size_t SLICE = 256;
+        uint64_t frequencies[256];
+        CodecSelector::sample_frequencies(raw, size, frequencies);
+        for (int i = 0; i < 256; i++) frequencies[i]++;
+        huffman.build(frequencies);
+
+        size_t header_size = huffman.write_header(out, 0);
+        size_t written = header_size;
+        for (size_t offset = 0; offset < size; offset += SLICE) {
+            size_t n = std::min(SLICE, size - offset);
+            if (written > size) return 0;
+            written += huffman.encode(raw + offset, n, out + written);
+        }
+        out[header_size - 1] = (unsigned char)huffman.pending_padding();
+        written += huffman.finish_encode(out + written);
+        return written < size ? written : 0;
+    }
+
+public:
+    size_t compress(const unsigned char* raw, size_t size, const CompressionLevel& level,
+                    unsigned char* out) {
+        if (level.sampled) return compress_sampled(raw, size, out);
+
+        // Con las frecuencias exactas el tamaño se sabe antes de codificar
+        uint64_t frequencies[256] = {0};
+        HuffmanCoder::count_frequencies(raw, size, frequencies);
+        huffman.build(frequencies);
+        uint64_t bits = huffman.encoded_bits(frequencies);
+        size_t written = huffman.write_header(out, bits);
+        if (written + (bits + 7) / 8 >= size) return 0;
+        written += huffman.encode(raw, size, out + written);
+        written += huffman.finish_encode(out + written);
+        return written;
+    }
+
+    bool decompress(const unsigned char* stored, size_t stored_size, unsigned char* out, size_t raw_size) {
+        size_t consumed = 0;
+        size_t produced = 0;
+        return huffman.read_header(stored, stored_size, consumed) == 1 &&
+               huffman.decode(stored + consumed, stored_size - consumed, true, out, raw_size, produced) &&
+               produced == raw_size;
+    }
+};
+
+// Códec 2: LZ77 + Huffman (ver lz77.h)
+class LzBlockCompressor : public BlockCompressor {
+private:
+    LzCoder lz;
+    std::vector<unsigned char> sample;          // Muestra del bloque (worth_compressing())
+    std::vector<unsigned char> sample_out;
+
+public:
+    // La estimación de orden 0 no ve repeticiones: datos con muchos valores
+    // de byte distintos pero repetidos (chunks aleatorios copiados) parecen
+    // incompresibles. Si dice que no, se comprime de verdad la muestra con
+    // el mismo nivel y se mira cuánto achica
+    bool worth_compressing(const unsigned char* raw, size_t size, const CompressionLevel& level) {
+        if (CodecSelector::worth_compressing(raw, size)) return true;
+        const unsigned char* bytes = CodecSelector::sample_bytes(raw, size, sample);
+        size_t sampled = std::min(size, CodecSelector::SAMPLE_STRIPES * CodecSelector::STRIPE_SIZE);
+        sample_out.resize(sampled);
+        size_t written = lz.compress(bytes, sampled, level.lz, sample_out.data(), sampled);
+        return written > 0 &&
+               (uint64_t)written * 1000 < (uint64_t)sampled * (1000 - CodecSelector::MIN_SAVING_PERMILLE);
+    }
+
+    size_t compress(const unsigned char* raw, size_t size, const CompressionLevel& level,
+                    unsigned char* out) {
+        // Con capacidad size, lz.compress() no termina lo que no achica
+        return lz.compress(raw, size, level.lz, out, size);
+    }
+
+    bool decompress(const unsigned char* stored, size_t stored_size, unsigned char* out, size_t raw_size) {
+        return lz.decompress(stored, stored_size, out, raw_size);
+    }
+
+    void reserve(size_t block_size, bool for_compress) { lz.reserve(block_size, for_compress); }
+};
+
+struct CodecEntry {
+    uint8_t id;                     // Byte de códec en las cabeceras
+    const char* name;               // --comp-alg
+    const char* description;        // Para gsea-inspect y los mensajes
+    BlockCompressor* (*create)();
+};
+
+class CodecRegistry {
+private:
+    template <class Compressor>
+    static BlockCompressor* make() { return new Compressor(); }
+
+public:
+    // Un códec por fila; los ids no se reutilizan (los archivos viejos los llevan)
+    static const std::vector<CodecEntry>& entries() {
+        static const std::vector<CodecEntry> ENTRIES = {
+            {CONTAINER_CODEC_HUFFMAN, "huffman", "Huffman", &make<HuffmanBlockCompressor>},
+            {CONTAINER_CODEC_LZ, "lz77", "LZ77 + Huffman", &make<LzBlockCompressor>},
+        };
+        return ENTRIES;
+    }
+
+    static const CodecEntry* find(uint8_t id) {
+        for (const CodecEntry& entry : entries()) {
+            if (entry.id == id) return &entry;
+        }
+        return nullptr;
+    }
+
+    static const CodecEntry* find(const std::string& name) {
+        for (const CodecEntry& entry : entries()) {
+            if (name == entry.name) return &entry;
+        }
+        return nullptr;
+    }
+
+    // ¿Un byte de códec leído de un archivo es válido?
+    static bool known(uint8_t id) {
+        return id == CONTAINER_CODEC_NONE || find(id) != nullptr;
+    }
+
+    // "huffman, lz77" (para la ayuda y los errores)
+    static std::string names() {
+        std::string list;
+        for (const CodecEntry& entry : entries()) {
+            list += (list.empty() ? "" : ", ") + std::string(entry.name);
+        }
+        return list;
+    }
+
+    static const char* description(uint8_t id) {
+        const CodecEntry* entry = find(id);
+        return entry != nullptr ? entry->description : "ninguna";
+    }
+};
+
+// Cifrados: por ahora solo XORCipher (xor.h). El tipo del cifrado es
+// parámetro de las etapas de BlockCodec, así que uno nuevo necesita su fila
+// acá y su clase, no cambios en el recorrido de los bloques
+struct CipherEntry {
+    uint8_t id;                     // Byte de cifrado en ContainerHeader
+    const char* name;               // --enc-alg
+    const char* description;
+};
+
+class CipherRegistry {
+public:
+    static const std::vector<CipherEntry>& entries() {
+        static const std::vector<CipherEntry> ENTRIES = {
+            {CONTAINER_CIPHER_XOR, "xor", "XOR"},
+        };
+        return ENTRIES;
+    }
+
+    static const CipherEntry* find(uint8_t id) {
+        for (const CipherEntry& entry : entries()) {
+            if (entry.id == id) return &entry;
+        }
+        return nullptr;
+    }
+
+    static const CipherEntry* find(const std::string& name) {
+        for (const CipherEntry& entry : entries()) {
+            if (name == entry.name) return &entry;
+        }
+        return nullptr;
+    }
+
+    static bool known(uint8_t id) {
+        return id == CONTAINER_CIPHER_NONE || find(id) != nullptr;
+    }
+
+    static std::string names() {
+        std::string list;
+        for (const CipherEntry& entry : entries()) {
+            list += (list.empty() ? "" : ", ") + std::string(entry.name);
+        }
+        return list;
+    }
+};
+
+#endif // GSEA_CODEC_REGISTRY_H
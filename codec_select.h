@@ -0,0 +1,115 @@
+#ifndef GSEA_CODEC_SELECT_H
+#define GSEA_CODEC_SELECT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "huffman.h"
+
+// Elección automática del códec de cada bloque (--comp-alg auto)
+//
+// Huffman no le saca nada a un PNG, un ZIP o un archivo ya cifrado, y
+// codificarlo igual cuesta tanto como un bloque de texto. Antes de comprimir
+// se decide, barato, si vale la pena:
+//   - por el número mágico del archivo (formatos que ya vienen comprimidos)
+//   - por una muestra del bloque: 16 franjas de 4 KB repartidas en el bloque,
+//     con las que el códec del nivel estima si achica (BlockCompressor::
+//     worth_compressing(): Huffman mira el tamaño que tendría con su árbol;
+//     LZ77, si eso no alcanza, comprime la muestra)
+// La elección queda en el códec de cada bloque, así que descomprimir no
+// necesita saber nada de esto.
+class CodecSelector {
+public:
+    static const size_t SAMPLE_STRIPES = 16;
+    static const size_t STRIPE_SIZE = 4096;
+
+    // Ahorro mínimo estimado para comprimir un bloque (en milésimas):
+    // por debajo de 2% no compensa el tiempo de codificar y decodificar
+    static const uint64_t MIN_SAVING_PERMILLE = 20;
+
+    // Nombre del formato si data empieza con el número mágico de un formato
+    // ya comprimido (o de un archivo de gsea), o nullptr
+    static const char* compressed_format(const unsigned char* data, size_t size) {
+        struct Magic {
+            const char* name;
+            const char* bytes;
+            size_t length;
+        };
+        static const Magic MAGICS[] = {
+            {"PNG", "\x89PNG\r\n\x1a\n", 8},
+            {"JPEG", "\xff\xd8\xff", 3},
+            {"ZIP", "PK\x03\x04", 4},
+            {"GZIP", "\x1f\x8b", 2},
+            {"BZIP2", "BZh", 3},
+            {"XZ", "\xfd" "7zXZ\0", 6},
+            {"ZSTD", "\x28\xb5\x2f\xfd", 4},
+            {"7Z", "7z\xbc\xaf\x27\x1c", 6},
+            {"RAR", "Rar!\x1a\x07", 6},
+            {"GIF", "GIF8", 4},
+            {"OGG", "OggS", 4},
+            {"FLAC", "fLaC", 4},
+            {"MP3", "ID3", 3},
+            {"GSEA", "GSEA", 4},
+        };
+        for (const Magic& magic : MAGICS) {
+            if (size >= magic.length && memcmp(data, magic.bytes, magic.length) == 0) {
+                return magic.name;
+            }
+        }
+        // MP4/MOV: "ftyp" en el byte 4
+        if (size >= 8 && memcmp(data + 4, "ftyp", 4) == 0) return "MP4";
+        return nullptr;
+    }
+
+    // Frecuencias de la muestra (el bloque entero si no pasa de 64 KB)
+    // Retorna los bytes contados
+    static size_t sample_frequencies(const unsigned char* data, size_t size, uint64_t frequencies[256]) {
+        memset(frequencies, 0, 256 * sizeof(uint64_t));
+        if (size <= SAMPLE_STRIPES * STRIPE_SIZE) {
+            HuffmanCoder::count_frequencies(data, size, frequencies);
+            return size;
+        }
+        size_t step = size / SAMPLE_STRIPES;
+        for (size_t i = 0; i < SAMPLE_STRIPES; i++) {
+            HuffmanCoder::count_frequencies(data + i * step, STRIPE_SIZE, frequencies);
+        }
+        return SAMPLE_STRIPES * STRIPE_SIZE;
+    }
+
+    // Bytes de la muestra seguidos: el bloque mismo si no pasa de 64 KB, o
+    // sus franjas copiadas en buffer
+    static const unsigned char* sample_bytes(const unsigned char* data, size_t size,
+                                             std::vector<unsigned char>& buffer) {
+        if (size <= SAMPLE_STRIPES * STRIPE_SIZE) return data;
+        buffer.resize(SAMPLE_STRIPES * STRIPE_SIZE);
+        size_t step = size / SAMPLE_STRIPES;
+        for (size_t i = 0; i < SAMPLE_STRIPES; i++) {
+            memcpy(buffer.data() + i * STRIPE_SIZE, data + i * step, STRIPE_SIZE);
+        }
+        return buffer.data();
+    }
+
+    // ¿Vale la pena comprimir este bloque con Huffman?
+    // Solo cuenta las frecuencias de la muestra (64 KB de cada bloque grande)
+    static bool worth_compressing(const unsigned char* data, size_t size) {
+        if (size == 0) return false;
+
+        uint64_t frequencies[256];
+        size_t sampled = sample_frequencies(data, size, frequencies);
+
+        HuffmanCoder coder;
+        if (!coder.build(frequencies)) return false;
+        int symbols = 0;
+        for (int i = 0; i < 256; i++) {
+            if (frequencies[i] > 0) symbols++;
+        }
+        // Árbol serializado (2 bytes por hoja, 1 por nodo interno) + códigos
+        // de la muestra extrapolados al bloque completo
+        uint64_t tree = 5 + 3 * symbols - 1;
+        uint64_t estimated = tree + (uint64_t)((double)coder.encoded_bits(frequencies) / 8 * size / sampled);
+        return estimated * 1000 < (uint64_t)size * (1000 - MIN_SAVING_PERMILLE);
+    }
+};
+
+#endif
@@ -0,0 +1,803 @@
+#ifndef GSEA_CONTAINER_H
+#define GSEA_CONTAINER_H
+
+#include <iostream>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include "hash.h"
+#include "xor.h"
+#include "huffman.h"
+#include "codec_registry.h"
+#include "crc32c.h"
+#include "stats.h"
+#include "log.h"
+
+// Cabecera común de los archivos .huff, .enc y .gsea
+//
+// Va al principio del archivo, SIN encriptar, seguida del payload de
+// siempre (flujo Huffman y/o texto cifrado). Formato (32, 36 o 52 bytes, big-endian):
+//
+//   0  magic        "GSEA"
+//   4  version      1
+//   5  codec        0 = ninguno, 1 = Huffman, 2 = LZ77 + Huffman
+//   6  cipher       0 = ninguno, 1 = XOR
+//   7  header_size  32, 36 con el nivel, 52 con FLAG_DELTA (versiones futuras pueden
+//                   agregar campos al final)
+//   8  flags        u32, características que el lector DEBE entender
+//  12  original     u64, tamaño del archivo original
+//  20  block_size   u32, 0 = un solo bloque
+//  24  key_check    u32, verificador de la clave (si FLAG_KEY_CHECK)
+//  28  checksum     u32, hash de los bytes 0..27
+//  32  level        nivel de compresión con que se escribió (1-9; solo informativo)
+//  33  reservado    3 bytes en cero
+//  36  base_hash    u64, Hash64 del archivo base (solo con FLAG_DELTA)
+//  44  target_size  u64, tamaño del archivo reconstruido (solo con FLAG_DELTA)
+//
+// Con FLAG_BLOCKS el payload es una secuencia de bloques independientes de
+// block_size bytes originales (el último puede ser menor), cada uno con su
+// propia cabecera, códec y CRC32C (ver BlockHeader). Sin ese flag el payload es un
+// único flujo Huffman y/o cifrado.
+//
+// Con FLAG_HOLES algunos bloques son huecos: rachas de bloques completos de
+// ceros (huecos de un archivo disperso o ceros escritos) que no guardan nada,
+// solo cuántos bloques abarcan (ver BlockHeader). Al restaurar se recrean
+// como huecos.
+//
+// Con FLAG_DELTA los bloques no guardan el archivo sino instrucciones para
+// reconstruirlo a partir de un archivo base (ver delta.h): original_size es
+// el tamaño de esas instrucciones, y solo se restaura con --base.
+//
+// Los archivos sin cabecera (versiones anteriores) se siguen leyendo: un
+// flujo Huffman empieza con el tamaño del árbol (00 00 0X XX), nunca con
+// "GSEA", y un texto cifrado además tendría que acertar el checksum.
+
+// Los ids de códec y de cifrado, y los niveles, están en codec_registry.h
+
+// Características opcionales del archivo
+static const uint32_t CONTAINER_FLAG_KEY_CHECK = 1u << 0;   // key_check es válido
+static const uint32_t CONTAINER_FLAG_BLOCKS = 1u << 1;      // Payload en bloques con CRC32C
+static const uint32_t CONTAINER_FLAG_DELTA = 1u << 2;       // Payload = delta contra una base
+static const uint32_t CONTAINER_FLAG_HOLES = 1u << 3;       // Hay bloques de huecos
+static const uint32_t CONTAINER_KNOWN_FLAGS = CONTAINER_FLAG_KEY_CHECK | CONTAINER_FLAG_BLOCKS |
+                                              CONTAINER_FLAG_DELTA | CONTAINER_FLAG_HOLES;
+
+// Tamaño de bloque al escribir, y máximo aceptado al leer
+static const uint32_t CONTAINER_BLOCK_SIZE = 1 << 20;
+static const uint32_t CONTAINER_MAX_BLOCK_SIZE = 64 << 20;
+
+static const uint8_t CONTAINER_VERSION = 1;
+
+struct ContainerHeader {
+    static const size_t SIZE = 32;            // Campos obligatorios
+    static const size_t LEVEL_SIZE = 36;      // Con el nivel de compresión
+    static const size_t DELTA_SIZE = 52;      // Con la base de un delta
+    static const size_t MAX_SIZE = 255;       // header_size ocupa un byte
+
+    uint8_t version;
+    uint8_t codec;
+    uint8_t cipher;
+    uint32_t flags;
+    uint64_t original_size;
+    uint32_t block_size;
+    uint32_t key_check;
+    uint8_t level;          // 0 = no consta (sin compresión o archivo anterior)
+    uint64_t base_hash;     // Solo con FLAG_DELTA
+    uint64_t target_size;
+
+    ContainerHeader()
+        : version(CONTAINER_VERSION), codec(CONTAINER_CODEC_NONE), cipher(CONTAINER_CIPHER_NONE),
+          flags(0), original_size(0), block_size(0), key_check(0), level(0), base_hash(0),
+          target_size(0) {}
+
+    static void put_u32(unsigned char* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) p[i] = (v >> (24 - 8 * i)) & 0xFF;
+    }
+
+    static uint32_t get_u32(const unsigned char* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    static void put_u64(unsigned char* p, uint64_t v) {
+        put_u32(p, (uint32_t)(v >> 32));
+        put_u32(p + 4, (uint32_t)v);
+    }
+
+    static uint64_t get_u64(const unsigned char* p) {
+        return ((uint64_t)get_u32(p) << 32) | get_u32(p + 4);
+    }
+
+    // Verificador de la clave: hash del cifrado de un bloque de ceros
+    // Permite rechazar una clave incorrecta sin desencriptar nada, y no
+    // revela la clave (solo 32 bits de un hash de su expansión)
+    static uint32_t compute_key_check(const XORCipher& cipher) {
+        unsigned char probe[32];
+        memset(probe, 0, sizeof(probe));
+        XORCipher::StreamState stream = cipher.begin_stream();
+        cipher.encrypt_chunk(probe, probe, sizeof(probe), stream);
+        return (uint32_t)Hash64::of(probe, sizeof(probe), 0x4B4559434845434BULL);
+    }
+
+    // Bytes que ocupa la cabecera al escribirla
+    size_t size() const { return delta() ? DELTA_SIZE : level != 0 ? LEVEL_SIZE : SIZE; }
+
+    // Escribir la cabecera en out (MAX_SIZE bytes libres). Retorna size()
+    size_t write(unsigned char* out) const {
+        memcpy(out, "GSEA", 4);
+        out[4] = version;
+        out[5] = codec;
+        out[6] = cipher;
+        out[7] = (unsigned char)size();
+        put_u32(out + 8, flags);
+        put_u64(out + 12, original_size);
+        put_u32(out + 20, block_size);
+        put_u32(out + 24, key_check);
+        put_u32(out + 28, (uint32_t)Hash64::of(out, 28));
+        if (size() > SIZE) {
+            out[32] = level;
+            out[33] = out[34] = out[35] = 0;
+        }
+        if (delta()) {
+            put_u64(out + 36, base_hash);
+            put_u64(out + 44, target_size);
+        }
+        return size();
+    }
+
+    // Leer la cabecera del principio de data (conviene pasar hasta MAX_SIZE
+    // bytes: los campos opcionales van detrás de los 32 obligatorios)
+    // Retorna: 1 = cabecera válida (consumed = bytes que ocupa)
+    //          0 = no hay cabecera (archivo de una versión anterior)
+    //         -1 = cabecera dañada o de una versión no soportada
+    int read(const unsigned char* data, size_t size, size_t& consumed) {
+        if (size < SIZE || memcmp(data, "GSEA", 4) != 0) return 0;
+
+        if (get_u32(data + 28) != (uint32_t)Hash64::of(data, 28)) {
+            // Un archivo antiguo encriptado podría empezar por "GSEA" por
+            // casualidad; sin checksum válido se trata como antiguo
+            return 0;
+        }
+
+        version = data[4];
+        codec = data[5];
+        cipher = data[6];
+        size_t header_size = data[7];
+        flags = get_u32(data + 8);
+        original_size = get_u64(data + 12);
+        block_size = get_u32(data + 20);
+        key_check = get_u32(data + 24);
+
+        if (version == 0 || version > CONTAINER_VERSION) {
+            GSEA_ERROR("Error: Versión de formato " << (int)version << " no soportada\n");
+            return -1;
+        }
+        if (header_size < SIZE || header_size > size) {
+            GSEA_ERROR("Error: Cabecera inválida\n");
+            return -1;
+        }
+        if (flags & ~CONTAINER_KNOWN_FLAGS) {
+            GSEA_ERROR("Error: El archivo usa características no soportadas (flags 0x"
+                       << std::hex << flags << std::dec << ")\n");
+            return -1;
+        }
+        if (!CodecRegistry::known(codec) || !CipherRegistry::known(cipher)) {
+            GSEA_ERROR("Error: Algoritmo desconocido en la cabecera\n");
+            return -1;
+        }
+        if ((flags & CONTAINER_FLAG_BLOCKS) &&
+            (block_size == 0 || block_size > CONTAINER_MAX_BLOCK_SIZE)) {
+            GSEA_ERROR("Error: Tamaño de bloque inválido en la cabecera\n");
+            return -1;
+        }
+        level = header_size > SIZE ? data[SIZE] : 0;
+        if (level > CONTAINER_MAX_LEVEL) {
+            GSEA_ERROR("Error: Nivel de compresión inválido en la cabecera\n");
+            return -1;
+        }
+        if (flags & CONTAINER_FLAG_DELTA) {
+            if (header_size < DELTA_SIZE || !(flags & CONTAINER_FLAG_BLOCKS)) {
+                GSEA_ERROR("Error: Cabecera de delta inválida\n");
+                return -1;
+            }
+            base_hash = get_u64(data + 36);
+            target_size = get_u64(data + 44);
+        }
+
+        consumed = header_size;
+        return 1;
+    }
+
+    // Tamaño original de una cabecera intacta, sin validar el resto ni
+    // escribir mensajes (para estimar la memoria antes de procesar el archivo)
+    static bool peek_original_size(const unsigned char* data, size_t size, uint64_t& original) {
+        if (size < SIZE || memcmp(data, "GSEA", 4) != 0 ||
+            get_u32(data + 28) != (uint32_t)Hash64::of(data, 28)) {
+            return false;
+        }
+        original = get_u64(data + 12);
+        if (get_u32(data + 8) & CONTAINER_FLAG_DELTA) {
+            original = data[7] >= DELTA_SIZE && size >= DELTA_SIZE ? get_u64(data + 44) : 0;
+        }
+        return true;
+    }
+
+    // Flags de una cabecera intacta (0 si no la hay)
+    static uint32_t peek_flags(const unsigned char* data, size_t size) {
+        uint64_t original = 0;
+        return peek_original_size(data, size, original) ? get_u32(data + 8) : 0;
+    }
+
+    // Códec, cifrado y flags de una cabecera intacta, sin validar el resto ni
+    // escribir mensajes (para elegir el camino antes de procesar el archivo)
+    static bool peek(const unsigned char* data, size_t size, ContainerHeader& header) {
+        uint64_t original = 0;
+        if (!peek_original_size(data, size, original)) return false;
+        header.codec = data[5];
+        header.cipher = data[6];
+        header.flags = get_u32(data + 8);
+        header.original_size = original;
+        return true;
+    }
+
+    // ¿La clave coincide con la usada al encriptar? (true si no hay verificador)
+    bool key_matches(const XORCipher& cipher_to_check) const {
+        if (!(flags & CONTAINER_FLAG_KEY_CHECK)) return true;
+        return key_check == compute_key_check(cipher_to_check);
+    }
+
+    bool blocked() const { return (flags & CONTAINER_FLAG_BLOCKS) != 0; }
+    bool delta() const { return (flags & CONTAINER_FLAG_DELTA) != 0; }
+    bool holes() const { return (flags & CONTAINER_FLAG_HOLES) != 0; }
+
+    // Cabecera para un archivo que se va a comprimir y/o encriptar (en bloques)
+    // El nivel decide el tamaño de bloque y, salvo que se fuerce uno
+    // (--comp-alg), el códec (ver CompressionLevel)
+    static ContainerHeader for_encode(bool compress, const XORCipher* cipher, uint64_t original_size,
+                                      int level = CONTAINER_DEFAULT_LEVEL,
+                                      uint8_t forced_codec = CONTAINER_CODEC_NONE) {
+        ContainerHeader header;
+        header.original_size = original_size;
+        header.flags |= CONTAINER_FLAG_BLOCKS;
+        header.block_size = CONTAINER_BLOCK_SIZE;
+        if (compress) {
+            CompressionLevel profile = CompressionLevel::of(level);
+            header.codec = forced_codec != CONTAINER_CODEC_NONE ? forced_codec : profile.codec;
+            header.block_size = profile.block_size;
+            header.level = (uint8_t)level;
+        }
+        if (cipher != nullptr) {
+            header.cipher = CONTAINER_CIPHER_XOR;
+            header.flags |= CONTAINER_FLAG_KEY_CHECK;
+            header.key_check = compute_key_check(*cipher);
+        }
+        return header;
+    }
+};
+
+// Etapas a aplicar al decodificar un archivo
+//
+// Con cabecera, la cabecera manda: pedir -u sobre un archivo sin cifrar o -d
+// sobre uno sin comprimir es un error, una clave incorrecta se rechaza antes
+// de procesar nada, y si el archivo queda comprimido (-u sin -d) la salida
+// lleva su propia cabecera. Sin cabecera se aplican -u/-d tal cual.
+// Un archivo comprimido y después encriptado en otra ejecución (-c, luego
+// -e) es un contenedor dentro de otro: ver nested()
+struct ContainerPlan {
+    bool has_header;           // La entrada tenía cabecera
+    bool decrypt;              // Desencriptar el payload
+    bool decompress;           // Descomprimir el payload
+    bool write_header;         // La salida sigue comprimida: escribir output_header
+    ContainerHeader input_header;
+    ContainerHeader output_header;
+
+    ContainerPlan() : has_header(false), decrypt(false), decompress(false), write_header(false) {}
+
+    // ¿-du sobre un contenedor que solo encripta? Su payload es otro
+    // contenedor: se desencripta primero y se descomprime lo que sale
+    static bool nested(const ContainerHeader& header, bool want_decrypt, bool want_decompress) {
+        return want_decrypt && want_decompress && header.cipher != CONTAINER_CIPHER_NONE &&
+               header.codec == CONTAINER_CODEC_NONE && !header.delta();
+    }
+
+    // status: resultado de ContainerHeader::read() sobre la entrada
+    // cipher: nullptr si no se dio clave
+    // with_base: quien llama reconstruye deltas (--base)
+    // Retorna "" si se puede continuar, o el motivo del error
+    std::string prepare(int status, const ContainerHeader& header, bool want_decrypt,
+                        bool want_decompress, const XORCipher* cipher, bool with_base = false) {
+        has_header = (status == 1);
+        input_header = header;
+        write_header = false;
+
+        if (status < 0) return "Cabecera del archivo inválida";
+        if (with_base && !(has_header && header.delta())) {
+            return "El archivo no es un delta: --base solo sirve con lo que escribió -c --base";
+        }
+        if (!has_header) {
+            decrypt = want_decrypt;
+            decompress = want_decompress;
+            return "";
+        }
+
+        decrypt = header.cipher != CONTAINER_CIPHER_NONE;
+        if (decrypt && cipher == nullptr) {
+            return "El archivo está encriptado: use -u y la clave (-k)";
+        }
+        if (decrypt && !header.key_matches(*cipher)) {
+            return "Clave incorrecta";
+        }
+        if (!decrypt && want_decrypt) {
+            return "El archivo no está encriptado: quite -u";
+        }
+
+        if (header.delta() && want_decompress && !with_base) {
+            return "El archivo es un delta: se restaura con --base <versión base>";
+        }
+
+        if (header.codec == CONTAINER_CODEC_NONE && want_decompress) {
+            // Encriptado sin comprimir con -du: si el payload es otro
+            // contenedor (-c y luego -e), quien llama debe abrirlo aparte
+            return decrypt ? "El archivo encripta otro contenedor: se decodifica en dos pasadas"
+                           : "El archivo no está comprimido: quite -d";
+        }
+        decompress = want_decompress;
+        if (header.codec != CONTAINER_CODEC_NONE && !want_decompress) {
+            // Solo se quita el cifrado: queda un archivo comprimido con cabecera
+            write_header = true;
+            output_header = ContainerHeader();
+            output_header.codec = header.codec;
+            output_header.level = header.level;
+            output_header.original_size = header.original_size;
+            output_header.flags = header.flags & (CONTAINER_FLAG_BLOCKS | CONTAINER_FLAG_DELTA |
+                                                  CONTAINER_FLAG_HOLES);
+            output_header.block_size = header.block_size;
+            output_header.base_hash = header.base_hash;
+            output_header.target_size = header.target_size;
+        }
+        return "";
+    }
+};
+
+// Cabecera de cada bloque (20 bytes, big-endian)
+//
+//   0  codec        0 = guardado tal cual, 1 = Huffman, 2 = LZ77 + Huffman,
+//                   0xFF = huecos
+//   1  hole_blocks  u24, solo en huecos: bloques de ceros que abarca (si no, 0)
+//   4  raw_size     bytes originales del bloque (en huecos, block_size)
+//   8  stored_size  bytes guardados a continuación (comprimidos y/o cifrados;
+//                   0 en huecos)
+//  12  raw_crc      CRC32C de los bytes originales (0 en huecos)
+//  16  stored_crc   CRC32C de los bytes guardados (0 en huecos)
+//
+// stored_crc permite verificar un archivo sin la clave ni descomprimir;
+// raw_crc confirma que la decodificación reprodujo el original. Un hueco
+// cuenta como hole_blocks bloques (el índice de los siguientes, y con él su
+// flujo de cifrado, avanza eso).
+static const uint8_t CONTAINER_BLOCK_HOLE = 0xFF;
+
+struct BlockHeader {
+    static const size_t SIZE = 20;
+    static const uint32_t MAX_HOLE_BLOCKS = (1u << 24) - 1;
+
+    uint8_t codec;
+    uint32_t hole_blocks;
+    uint32_t raw_size;
+    uint32_t stored_size;
+    uint32_t raw_crc;
+    uint32_t stored_crc;
+
+    BlockHeader() : codec(0), hole_blocks(0), raw_size(0), stored_size(0), raw_crc(0), stored_crc(0) {}
+
+    // Hueco de blocks bloques (1..MAX_HOLE_BLOCKS) de block_size bytes
+    static BlockHeader hole_run(uint32_t blocks, uint32_t block_size) {
+        BlockHeader header;
+        header.codec = CONTAINER_BLOCK_HOLE;
+        header.hole_blocks = blocks;
+        header.raw_size = block_size;
+        return header;
+    }
+
+    bool hole() const { return codec == CONTAINER_BLOCK_HOLE; }
+
+    // Bloques que ocupa en la numeración y bytes originales que representa
+    uint64_t block_count() const { return hole() ? hole_blocks : 1; }
+    uint64_t raw_bytes() const { return block_count() * raw_size; }
+
+    size_t write(unsigned char* out) const {
+        out[0] = codec;
+        out[1] = (hole_blocks >> 16) & 0xFF;
+        out[2] = (hole_blocks >> 8) & 0xFF;
+        out[3] = hole_blocks & 0xFF;
+        ContainerHeader::put_u32(out + 4, raw_size);
+        ContainerHeader::put_u32(out + 8, stored_size);
+        ContainerHeader::put_u32(out + 12, raw_crc);
+        ContainerHeader::put_u32(out + 16, stored_crc);
+        return SIZE;
+    }
+
+    // Leer y validar contra el tamaño de bloque del archivo
+    bool read(const unsigned char* data, uint32_t block_size) {
+        codec = data[0];
+        raw_size = ContainerHeader::get_u32(data + 4);
+        stored_size = ContainerHeader::get_u32(data + 8);
+        raw_crc = ContainerHeader::get_u32(data + 12);
+        stored_crc = ContainerHeader::get_u32(data + 16);
+        if (hole()) {
+            hole_blocks = ((uint32_t)data[1] << 16) | ((uint32_t)data[2] << 8) | data[3];
+            return hole_blocks > 0 && raw_size == block_size && stored_size == 0 &&
+                   raw_crc == 0 && stored_crc == 0;
+        }
+        hole_blocks = 0;
+        return CodecRegistry::known(codec) && raw_size > 0 && raw_size <= block_size &&
+               stored_size > 0 && stored_size <= HuffmanCoder::compress_bound(block_size);
+    }
+};
+
+// Codificación y decodificación de bloques independientes
+//
+// Cada bloque tiene su propio árbol de Huffman y su propio flujo de cifrado
+// (que arranca en la posición block_index x block_size), así que los bloques
+// se pueden decodificar y verificar en cualquier orden o en paralelo.
+// Los códecs salen de CodecRegistry según el byte de códec de cada bloque;
+// no imprime nada por bloque.
+//
+// Cifrado y CRC de los bytes guardados se hacen en una sola pasada, de a
+// tramos que quedan en caché (seal/open). Son plantillas instanciadas con y
+// sin cifrado, así que el bucle de cada tramo no pregunta por etapas ni
+// pasa por llamados virtuales.
+template <class Cipher>
+class BasicBlockCodec {
+private:
+    static const size_t STAGE_CHUNK = 16 << 10;
+
+    uint8_t codec;
+    const Cipher* cipher;      // nullptr = sin cifrado
+    uint32_t block_size;
+    CompressionLevel profile;  // Cómo comprimir (--level)
+    std::unique_ptr<BlockCompressor> compressors[256];   // Por id, al usarse
+    FileStats* stats;          // Tiempos por etapa (--stats), o nullptr
+    bool adaptive;             // --comp-alg auto: guardar tal cual lo que no achica
+    bool known_format;         // El bloque 0 empezaba con el número mágico de un formato comprimido
+    uint64_t stored_blocks;    // Bloques que se guardaron tal cual en modo auto
+    bool zero_runs;            // Bloques completos de ceros → huecos
+    uint64_t pending_holes;    // Racha de huecos todavía sin escribir
+    uint64_t hole_total;       // Bloques que quedaron como huecos
+
+    typename Cipher::StreamState block_stream(uint64_t block_index) const {
+        typename Cipher::StreamState stream = cipher->begin_stream();
+        stream.position = block_index * block_size;
+        return stream;
+    }
+
+    BlockCompressor* compressor(uint8_t id) {
+        if (!compressors[id]) {
+            const CodecEntry* entry = CodecRegistry::find(id);
+            if (entry == nullptr) return nullptr;
+            compressors[id].reset(entry->create());
+        }
+        return compressors[id].get();
+    }
+
+    // Encriptar (si Encrypt) y calcular el CRC de lo guardado, tramo a tramo
+    template <bool Encrypt>
+    uint32_t seal(unsigned char* stored, size_t size, uint64_t block_index) const {
+        typename Cipher::StreamState stream = typename Cipher::StreamState();
+        if (Encrypt) stream = block_stream(block_index);
+        uint32_t crc = 0;
+        for (size_t offset = 0; offset < size; offset += STAGE_CHUNK) {
+            size_t n = std::min(STAGE_CHUNK, size - offset);
+            if (Encrypt) cipher->encrypt_chunk(stored + offset, stored + offset, n, stream);
+            crc = CRC32C::update(crc, stored + offset, n);
+        }
+        return crc;
+    }
+
+    // Comprobar el CRC de lo guardado y desencriptar (si Decrypt) en el
+    // lugar, tramo a tramo. Si Reseal, new_crc recibe el CRC de lo
+    // desencriptado (-u sin -d: el bloque queda comprimido y sin cifrar).
+    // Si el CRC no coincide el contenido ya no sirve: el llamador lo descarta
+    template <bool Decrypt, bool Reseal>
+    bool open(const BlockHeader& header, unsigned char* stored, uint64_t block_index,
+              uint32_t& new_crc) const {
+        typename Cipher::StreamState stream = typename Cipher::StreamState();
+        if (Decrypt) stream = block_stream(block_index);
+        uint32_t crc = 0;
+        new_crc = 0;
+        for (size_t offset = 0; offset < header.stored_size; offset += STAGE_CHUNK) {
+            size_t n = std::min(STAGE_CHUNK, (size_t)header.stored_size - offset);
+            crc = CRC32C::update(crc, stored + offset, n);
+            if (Decrypt) cipher->decrypt_chunk(stored + offset, stored + offset, n, stream);
+            if (Reseal) new_crc = CRC32C::update(new_crc, stored + offset, n);
+        }
+        return crc == header.stored_crc;
+    }
+
+    // Primer paso de decode_block/strip_cipher, con la etapa medida según lo que hace
+    bool open_stored(const BlockHeader& header, unsigned char* stored, uint64_t block_index,
+                     bool reseal, uint32_t& new_crc) const {
+        StageTimer timer(stats, cipher != nullptr ? STAGE_DECRYPT : STAGE_CHECKSUM);
+        bool intact;
+        if (cipher == nullptr) {
+            intact = open<false, false>(header, stored, block_index, new_crc);
+            new_crc = header.stored_crc;
+        } else if (reseal) {
+            intact = open<true, true>(header, stored, block_index, new_crc);
+        } else {
+            intact = open<true, false>(header, stored, block_index, new_crc);
+        }
+        timer.stop(header.stored_size, cipher != nullptr ? header.stored_size : 0);
+        return intact;
+    }
+
+public:
+    BasicBlockCodec(uint8_t codec_id, const Cipher* shared_cipher, uint32_t block_bytes)
+        : codec(codec_id), cipher(shared_cipher), block_size(block_bytes),
+          profile(CompressionLevel::of(CONTAINER_DEFAULT_LEVEL)), stats(nullptr),
+          adaptive(false), known_format(false), stored_blocks(0), zero_runs(false), pending_holes(0),
+          hole_total(0) {}
+
+    void set_stats(FileStats* file_stats) { stats = file_stats; }
+
+    // Reutilizar el codificador (y lo que ya reservaron sus códecs) con
+    // otra cabecera
+    void reset(uint8_t codec_id, const Cipher* shared_cipher, uint32_t block_bytes) {
+        codec = codec_id;
+        cipher = shared_cipher;
+        block_size = block_bytes;
+        known_format = false;
+        stored_blocks = 0;
+        pending_holes = 0;
+        hole_total = 0;
+    }
+
+    // Crear los códecs y reservar su memoria ahora y no en el primer bloque:
+    // al comprimir solo el del archivo, al descomprimir todos (cada bloque
+    // trae el suyo)
+    void reserve(bool for_compress) {
+        for (const CodecEntry& entry : CodecRegistry::entries()) {
+            if (for_compress && entry.id != codec) continue;
+            compressor(entry.id)->reserve(block_size, for_compress);
+        }
+    }
+
+    // Parámetros del nivel al comprimir (el códec y el tamaño de bloque ya
+    // vienen de la cabecera: ContainerHeader::for_encode)
+    void set_level(int level) { profile = CompressionLevel::of(level); }
+
+    // Elegir el códec de cada bloque (ver CodecSelector). Los bloques deben
+    // codificarse empezando por el 0, que es el que trae el número mágico
+    void set_adaptive(bool enabled) { adaptive = enabled; }
+
+    uint64_t adaptive_stored_blocks() const { return stored_blocks; }
+    bool detected_compressed_format() const { return known_format; }
+
+    // Guardar los bloques completos de ceros como huecos (la cabecera del
+    // archivo debe llevar FLAG_HOLES si hole_blocks() > 0)
+    void set_zero_runs(bool enabled) { zero_runs = enabled; }
+    uint64_t hole_blocks() const { return hole_total; }
+
+    static bool all_zero(const unsigned char* data, size_t size) {
+        return size > 0 && data[0] == 0 && memcmp(data, data + 1, size - 1) == 0;
+    }
+
+    // Sumar count bloques de ceros (p. ej. un hueco del archivo que no se
+    // leyó) a la racha pendiente. Quien llama avanza su índice de bloque
+    void add_holes(uint64_t count) {
+        pending_holes += count;
+        hole_total += count;
+    }
+
+    // Con set_zero_runs(), un bloque completo de ceros se suma a la racha en
+    // vez de codificarse. Retorna true si lo tomó
+    bool take_zero_block(const unsigned char* raw, size_t size) {
+        if (!zero_runs || size != block_size || !all_zero(raw, size)) return false;
+        add_holes(1);
+        return true;
+    }
+
+    // Escribir la racha pendiente (una cabecera por cada MAX_HOLE_BLOCKS
+    // bloques) en out, sin pasar de capacity. Lo que no entra queda pendiente
+    size_t flush_holes(unsigned char* out, size_t capacity) {
+        size_t written = 0;
+        while (pending_holes > 0 && capacity - written >= BlockHeader::SIZE) {
+            uint32_t blocks = (uint32_t)std::min<uint64_t>(pending_holes, BlockHeader::MAX_HOLE_BLOCKS);
+            written += BlockHeader::hole_run(blocks, block_size).write(out + written);
+            pending_holes -= blocks;
+        }
+        return written;
+    }
+
+    bool holes_pending() const { return pending_holes > 0; }
+
+    // Seguir una codificación interrumpida (--resume) desde un límite de
+    // bloque: lo que se detectó en el bloque 0 y los huecos ya escritos
+    void resume(bool compressed_format, uint64_t holes) {
+        known_format = compressed_format;
+        pending_holes = 0;
+        hole_total = holes;
+    }
+
+    // Bytes máximos de un bloque codificado (cabecera incluida)
+    static size_t frame_bound(size_t raw_size) {
+        return BlockHeader::SIZE + HuffmanCoder::compress_bound(raw_size);
+    }
+
+    // Bytes máximos de todos los bloques de un archivo
+    static uint64_t total_bound(uint64_t size, uint32_t block_bytes) {
+        uint64_t blocks = (size + block_bytes - 1) / block_bytes;
+        return size + blocks * (frame_bound(0) + 1);
+    }
+
+    // Tamaño original máximo que pueden declarar stored bytes de bloques:
+    // cada bloque ocupa al menos su cabecera y un hueco abarca hasta
+    // MAX_HOLE_BLOCKS bloques (para rechazar cabeceras infladas antes de
+    // reservar la salida)
+    static uint64_t raw_bound(uint64_t stored, uint32_t block_bytes, bool holes) {
+        uint64_t frames = stored / BlockHeader::SIZE;
+        uint64_t per_frame = (uint64_t)block_bytes * (holes ? BlockHeader::MAX_HOLE_BLOCKS : 1);
+        return frames > UINT64_MAX / per_frame ? UINT64_MAX : frames * per_frame;
+    }
+
+    // Codificar un bloque: [comprimir] → [encriptar] → cabecera + datos
+    // out debe tener frame_bound(size) bytes. Retorna los bytes escritos
+    size_t encode_block(const unsigned char* raw, size_t size, uint64_t block_index, unsigned char* out) {
+        BlockHeader header;
+        header.codec = codec;
+        header.raw_size = size;
+        StageTimer crc_timer(stats, STAGE_CHECKSUM);
+        header.raw_crc = CRC32C::of(raw, size);
+        crc_timer.stop(size, 0);
+
+        unsigned char* stored = out + BlockHeader::SIZE;
+        size_t stored_size = 0;
+        if (codec != CONTAINER_CODEC_NONE && adaptive) {
+            if (block_index == 0) {
+                known_format = CodecSelector::compressed_format(raw, size) != nullptr;
+            }
+            if (known_format || !compressor(header.codec)->worth_compressing(raw, size, profile)) {
+                header.codec = CONTAINER_CODEC_NONE;
+            }
+        }
+        if (header.codec != CONTAINER_CODEC_NONE) {
+            // Lo que no achica se guarda tal cual
+            StageTimer timer(stats, STAGE_COMPRESS);
+            stored_size = compressor(header.codec)->compress(raw, size, profile, stored);
+            timer.stop(size, stored_size);
+            if (stored_size == 0) header.codec = CONTAINER_CODEC_NONE;
+        }
+        if (header.codec == CONTAINER_CODEC_NONE) {
+            if (adaptive && codec != CONTAINER_CODEC_NONE) stored_blocks++;
+            memcpy(stored, raw, size);
+            stored_size = size;
+        }
+
+        header.stored_size = stored_size;
+        StageTimer timer(stats, cipher != nullptr ? STAGE_ENCRYPT : STAGE_CHECKSUM);
+        if (cipher != nullptr) {
+            header.stored_crc = seal<true>(stored, stored_size, block_index);
+        } else {
+            header.stored_crc = seal<false>(stored, stored_size, block_index);
+        }
+        timer.stop(stored_size, cipher != nullptr ? stored_size : 0);
+        header.write(out);
+        return BlockHeader::SIZE + stored_size;
+    }
+
+    // Codificar un buffer completo en bloques. out: total_bound() bytes
+    size_t encode_all(const unsigned char* data, size_t size, unsigned char* out) {
+        size_t written = 0;
+        uint64_t index = 0;
+        for (size_t offset = 0; offset < size; offset += block_size, index++) {
+            size_t n = std::min((size_t)block_size, size - offset);
+            if (take_zero_block(data + offset, n)) continue;
+            written += flush_holes(out + written, SIZE_MAX);
+            written += encode_block(data + offset, n, index, out + written);
+        }
+        return written + flush_holes(out + written, SIZE_MAX);
+    }
+
+    // ¿Los bytes guardados coinciden con su CRC? (no necesita la clave)
+    static bool stored_ok(const BlockHeader& header, const unsigned char* stored) {
+        return CRC32C::of(stored, header.stored_size) == header.stored_crc;
+    }
+
+    // Decodificar un bloque: [desencriptar] → [descomprimir] → out (raw_size bytes)
+    // stored se desencripta EN EL LUGAR. Retorna "" o el motivo del error
+    std::string decode_block(const BlockHeader& header, unsigned char* stored, uint64_t block_index,
+                             unsigned char* out) {
+        if (header.hole()) return "hueco inesperado";
+        uint32_t unused = 0;
+        if (!open_stored(header, stored, block_index, false, unused)) {
+            return "CRC de los datos guardados no coincide (archivo dañado)";
+        }
+
+        if (header.codec != CONTAINER_CODEC_NONE) {
+            StageTimer timer(stats, STAGE_DECOMPRESS);
+            BlockCompressor* decoder = compressor(header.codec);
+            if (decoder == nullptr ||
+                !decoder->decompress(stored, header.stored_size, out, header.raw_size)) {
+                return std::string("flujo ") + CodecRegistry::description(header.codec) + " inválido";
+            }
+            timer.stop(header.stored_size, header.raw_size);
+        } else {
+            if (header.stored_size != header.raw_size) return "tamaño inválido";
+            memcpy(out, stored, header.raw_size);
+        }
+
+        StageTimer raw_timer(stats, STAGE_CHECKSUM);
+        uint32_t raw_crc = CRC32C::of(out, header.raw_size);
+        raw_timer.stop(header.raw_size, 0);
+        if (raw_crc != header.raw_crc) {
+            return "CRC del contenido no coincide (clave o datos incorrectos)";
+        }
+        return "";
+    }
+
+    // Solo desencriptar un bloque en el lugar, dejándolo comprimido (-u sin -d)
+    std::string strip_cipher(BlockHeader& header, unsigned char* stored, uint64_t block_index) {
+        uint32_t new_crc = 0;
+        if (!open_stored(header, stored, block_index, true, new_crc)) {
+            return "CRC de los datos guardados no coincide (archivo dañado)";
+        }
+        header.stored_crc = new_crc;
+        return "";
+    }
+
+    // Decodificar todos los bloques de un payload en memoria
+    // full = true : out recibe los datos originales (capacity bytes)
+    // full = false: se quita solo el cifrado, en el lugar (out no se usa)
+    // Retorna "" o el motivo del error; produced = bytes originales
+    std::string decode_all(unsigned char* payload, size_t size, bool full,
+                           unsigned char* out, size_t capacity, size_t& produced) {
+        produced = 0;
+        size_t offset = 0;
+        uint64_t index = 0;
+        while (offset < size) {
+            BlockHeader header;
+            if (size - offset < BlockHeader::SIZE || !header.read(payload + offset, block_size) ||
+                header.stored_size > size - offset - BlockHeader::SIZE) {
+                return "Bloque " + std::to_string(index) + ": cabecera inválida";
+            }
+            if (header.hole()) {
+                // Nada guardado: con full, ceros en la salida
+                if (full && header.raw_bytes() > capacity - produced) {
+                    return "Bloque " + std::to_string(index) + ": más datos de los que indica la cabecera";
+                }
+                if (full) memset(out + produced, 0, header.raw_bytes());
+                produced += header.raw_bytes();
+                offset += BlockHeader::SIZE;
+                index += header.hole_blocks;
+                continue;
+            }
+            unsigned char* stored = payload + offset + BlockHeader::SIZE;
+
+            std::string error;
+            if (full) {
+                if (header.raw_size > capacity - produced) {
+                    return "Bloque " + std::to_string(index) + ": más datos de los que indica la cabecera";
+                }
+                error = decode_block(header, stored, index, out + produced);
+            } else {
+                error = strip_cipher(header, stored, index);
+                header.write(payload + offset);
+            }
+            if (!error.empty()) {
+                return "Bloque " + std::to_string(index) + ": " + error;
+            }
+
+            produced += header.raw_size;
+            offset += BlockHeader::SIZE + header.stored_size;
+            index++;
+        }
+        return "";
+    }
+};
+
+template <class Cipher>
+const size_t BasicBlockCodec<Cipher>::STAGE_CHUNK;
+
+typedef BasicBlockCodec<XORCipher> BlockCodec;
+
+#endif // GSEA_CONTAINER_H
@@ -0,0 +1,142 @@
+#ifndef GSEA_CRC32C_H
+#define GSEA_CRC32C_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define GSEA_CRC32C_X86 1
+#endif
+
+// CRC32C (Castagnoli, polinomio 0x1EDC6F41) para detectar datos dañados
+//
+// Dos implementaciones con el mismo resultado:
+//   - SSE4.2: instrucción crc32 del procesador, 8 bytes por instrucción.
+//     Se compila con target("sse4.2") solo para esa función y se usa si la
+//     CPU la soporta (se detecta una vez al arrancar), así el binario sigue
+//     funcionando en CPUs sin SSE4.2.
+//   - slicing-by-8: 8 tablas de 256 entradas, 8 bytes por iteración sin
+//     dependencias entre tablas. Es el camino en otras arquitecturas.
+//
+// Uso igual que crc32() de zlib: crc = CRC32C::update(crc, datos, n),
+// empezando con crc = 0.
+class CRC32C {
+private:
+    static const uint32_t POLY_REFLECTED = 0x82F63B78;
+
+    struct Tables {
+        uint32_t t[8][256];
+
+        Tables() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t crc = i;
+                for (int k = 0; k < 8; k++) {
+                    crc = (crc >> 1) ^ ((crc & 1) ? POLY_REFLECTED : 0);
+                }
+                t[0][i] = crc;
+            }
+            for (uint32_t i = 0; i < 256; i++) {
+                for (int s = 1; s < 8; s++) {
+                    t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    static const Tables& tables() {
+        static const Tables instance;
+        return instance;
+    }
+
+#ifdef GSEA_CRC32C_X86
+    __attribute__((target("sse4.2")))
+    static uint32_t update_sse42(uint32_t crc, const unsigned char* data, size_t size) {
+        uint32_t c = ~crc;
+        // Alinear a 8 bytes y luego 8 bytes por instrucción
+        while (size > 0 && ((uintptr_t)data & 7) != 0) {
+            c = _mm_crc32_u8(c, *data++);
+            size--;
+        }
+#if defined(__x86_64__)
+        uint64_t c64 = c;
+        while (size >= 8) {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            c64 = _mm_crc32_u64(c64, word);
+            data += 8;
+            size -= 8;
+        }
+        c = (uint32_t)c64;
+#endif
+        while (size >= 4) {
+            uint32_t word;
+            memcpy(&word, data, 4);
+            c = _mm_crc32_u32(c, word);
+            data += 4;
+            size -= 4;
+        }
+        while (size > 0) {
+            c = _mm_crc32_u8(c, *data++);
+            size--;
+        }
+        return ~c;
+    }
+
+    static bool detect_sse42() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+    }
+#endif
+
+public:
+    // Implementación portable (slicing-by-8)
+    static uint32_t update_portable(uint32_t crc, const unsigned char* data, size_t size) {
+        const Tables& tb = tables();
+        uint32_t c = ~crc;
+
+        while (size >= 8) {
+            // Bytes en orden de memoria: funciona igual en cualquier endianness
+            uint32_t lo = c ^ ((uint32_t)data[0] | ((uint32_t)data[1] << 8) |
+                               ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+            c = tb.t[7][lo & 0xFF] ^ tb.t[6][(lo >> 8) & 0xFF] ^
+                tb.t[5][(lo >> 16) & 0xFF] ^ tb.t[4][lo >> 24] ^
+                tb.t[3][data[4]] ^ tb.t[2][data[5]] ^ tb.t[1][data[6]] ^ tb.t[0][data[7]];
+            data += 8;
+            size -= 8;
+        }
+        while (size > 0) {
+            c = (c >> 8) ^ tb.t[0][(c ^ *data++) & 0xFF];
+            size--;
+        }
+        return ~c;
+    }
+
+    // ¿Se usa la instrucción de hardware?
+    static bool hardware() {
+#ifdef GSEA_CRC32C_X86
+        static const bool supported = detect_sse42();
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    static const char* implementation() {
+        return hardware() ? "SSE4.2" : "slicing-by-8";
+    }
+
+    static uint32_t update(uint32_t crc, const unsigned char* data, size_t size) {
+#ifdef GSEA_CRC32C_X86
+        if (hardware()) return update_sse42(crc, data, size);
+#endif
+        return update_portable(crc, data, size);
+    }
+
+    static uint32_t of(const unsigned char* data, size_t size) {
+        return update(0, data, size);
+    }
+};
+
+#endif // GSEA_CRC32C_H
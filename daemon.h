@@ -0,0 +1,520 @@
+#ifndef GSEA_DAEMON_H
+#define GSEA_DAEMON_H
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstring>
+#include <cstdint>
+#include "daemon_protocol.h"
+#include "huffman.h"
+#include "xor.h"
+#include "hash.h"
+#include "container.h"
+#include "log.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <errno.h>
+
+// Ruta del socket para poder borrarlo desde el manejador de señales
+static char g_daemon_socket_path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+
+static void daemon_signal_handler(int) {
+    // Solo funciones async-signal-safe: unlink() y _exit()
+    unlink(g_daemon_socket_path);
+    _exit(0);
+}
+
+// Daemon persistente de GSEA (gsea --daemon <socket>)
+//
+// Evita pagar en cada petición el arranque del proceso, el banner, el
+// parseo de argumentos y la expansión de la clave:
+//   - N hilos de trabajo (pthreads) esperan en accept() sobre el mismo socket
+//   - Cada hilo conserva sus buffers entre peticiones
+//   - Las claves expandidas (XORCipher) se guardan en una caché compartida
+class GseaDaemon {
+private:
+    static const size_t MAX_CACHED_KEYS = 256;
+
+    std::string socket_path;
+    int worker_count;
+    int listen_fd;
+
+    // Caché de claves expandidas: digest de la clave -> cifrador listo para
+    // usar. La clave en texto plano no se guarda: el digest usa dos Hash64
+    // con semillas aleatorias de este proceso, así que no se puede fabricar
+    // una clave que choque con otra sin conocerlas
+    // XORCipher no modifica su estado al encriptar, así que varios hilos
+    // pueden compartir la misma instancia
+    typedef std::pair<uint64_t, uint64_t> KeyDigest;
+    pthread_mutex_t key_mutex;
+    uint64_t key_seeds[2];
+    std::map<KeyDigest, std::shared_ptr<XORCipher> > key_cache;
+
+    // Buffers que cada hilo reutiliza entre peticiones: data (la entrada) y
+    // work (la salida de cada etapa) se intercambian con swap(), así que tras
+    // las primeras peticiones ninguno de los dos vuelve a reservar memoria
+    struct WorkerState {
+        GseaDaemon* daemon;
+        std::vector<unsigned char> data;
+        std::vector<unsigned char> work;
+        unsigned char header[ContainerHeader::MAX_SIZE];    // Cabecera de la salida
+        size_t header_size = 0;
+        size_t offset = 0;         // La salida es header + data[offset..]
+        std::string input_path;
+        std::string output_path;
+        std::string key;
+    };
+
+    KeyDigest digest_of(const std::string& key) const {
+        const unsigned char* bytes = (const unsigned char*)key.data();
+        return KeyDigest(Hash64::of(bytes, key.size(), key_seeds[0]),
+                         Hash64::of(bytes, key.size(), key_seeds[1]));
+    }
+
+    std::shared_ptr<XORCipher> cipher_for(const std::string& key) {
+        KeyDigest digest = digest_of(key);
+        pthread_mutex_lock(&key_mutex);
+        std::map<KeyDigest, std::shared_ptr<XORCipher> >::iterator it = key_cache.find(digest);
+        if (it != key_cache.end()) {
+            std::shared_ptr<XORCipher> cipher = it->second;
+            pthread_mutex_unlock(&key_mutex);
+            return cipher;
+        }
+        pthread_mutex_unlock(&key_mutex);
+
+        // Expandir la clave FUERA del lock (es la parte costosa)
+        std::shared_ptr<XORCipher> cipher(new XORCipher(key));
+
+        pthread_mutex_lock(&key_mutex);
+        if (key_cache.size() >= MAX_CACHED_KEYS) {
+            // Caché llena: se vacía; los hilos que usan un cifrador lo
+            // conservan gracias al shared_ptr
+            key_cache.clear();
+        }
+        key_cache[digest] = cipher;
+        pthread_mutex_unlock(&key_mutex);
+        return cipher;
+    }
+
+    static bool read_fd_fully(int fd, std::vector<unsigned char>& data) {
+        data.clear();
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            data.reserve(st.st_size);
+        }
+
+        unsigned char buffer[65536];
+        while (true) {
+            ssize_t n = read(fd, buffer, sizeof(buffer));
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (n == 0) return true;
+            data.insert(data.end(), buffer, buffer + n);
+        }
+    }
+
+    static bool write_fd_fully(int fd, const unsigned char* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = write(fd, data + done, size - done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    // Desencriptar y/o descomprimir state.data según su cabecera (ver
+    // ContainerPlan); la salida queda como en run_operations()
+    std::string decode_stage(bool want_decrypt, bool want_decompress, XORCipher* cipher,
+                             WorkerState& state) {
+        std::vector<unsigned char>& data = state.data;
+        std::vector<unsigned char>& work = state.work;
+        ContainerHeader input_header;
+        ContainerPlan plan;
+        size_t offset = 0;
+        int status = input_header.read(data.data(), data.size(), offset);
+        std::string error = plan.prepare(status, input_header, want_decrypt, want_decompress, cipher);
+        if (!error.empty()) return error;
+        unsigned char* payload = data.data() + offset;
+        size_t payload_size = data.size() - offset;
+        state.offset = offset;
+
+        if (plan.write_header) {
+            state.header_size = plan.output_header.write(state.header);
+        }
+
+        if (plan.has_header && input_header.blocked()) {
+            // Bloques con CRC32C, igual que gsea
+            BlockCodec codec(input_header.codec, plan.decrypt ? cipher : nullptr,
+                             input_header.block_size);
+            bool full = !plan.write_header;
+            // El tamaño original viene del cliente: no reservar más de lo
+            // que los bloques recibidos pueden producir
+            if (full && input_header.original_size >
+                            BlockCodec::raw_bound(payload_size, input_header.block_size, input_header.holes())) {
+                return "El tamaño original de la cabecera no corresponde a los datos";
+            }
+            work.resize(full ? input_header.original_size : 0);
+            size_t produced = 0;
+            error = codec.decode_all(payload, payload_size, full, work.data(), work.size(), produced);
+            if (!error.empty()) return error;
+            if (produced != input_header.original_size) {
+                return "El tamaño decodificado no coincide con la cabecera";
+            }
+            if (full) {
+                data.swap(work);
+                state.offset = 0;
+            }
+        } else {
+            if (plan.decrypt && !cipher->decrypt_in_place(payload, payload_size)) {
+                return "Fallo en la desencriptación";
+            }
+            if (plan.decompress) {
+                HuffmanCoder huffman;
+                size_t produced = 0;
+                work.resize(HuffmanCoder::decode_bound(payload_size));
+                if (!huffman.decompress_into(payload, payload_size, work.data(), work.size(), produced) ||
+                    produced == 0) {
+                    return "Fallo en la descompresión";
+                }
+                if (plan.has_header && produced != plan.input_header.original_size) {
+                    return "El tamaño descomprimido no coincide con la cabecera";
+                }
+                work.resize(produced);
+                data.swap(work);
+                state.offset = 0;
+            }
+        }
+        return "";
+    }
+
+    // Aplicar las operaciones en el mismo orden que la línea de comandos:
+    // comprimir → encriptar, desencriptar → descomprimir
+    // La salida usa la misma cabecera de contenedor que gsea y queda en
+    // state.header + state.data[state.offset..], sin copiar la cabecera
+    // delante de los datos
+    std::string run_operations(uint8_t ops, const std::string& key, WorkerState& state) {
+        std::vector<unsigned char>& data = state.data;
+        std::vector<unsigned char>& work = state.work;
+        state.header_size = 0;
+        state.offset = 0;
+
+        std::shared_ptr<XORCipher> cipher;
+        if (ops & (DAEMON_OP_ENCRYPT | DAEMON_OP_DECRYPT)) {
+            if (key.empty()) return "La encriptación/desencriptación requiere una clave";
+            cipher = cipher_for(key);
+        }
+
+        if (ops & (DAEMON_OP_COMPRESS | DAEMON_OP_ENCRYPT)) {
+            ContainerHeader header = ContainerHeader::for_encode((ops & DAEMON_OP_COMPRESS) != 0,
+                                                                 cipher.get(), data.size());
+            state.header_size = header.write(state.header);
+
+            BlockCodec codec(header.codec, cipher.get(), header.block_size);
+            work.resize(BlockCodec::total_bound(data.size(), header.block_size));
+            work.resize(codec.encode_all(data.data(), data.size(), work.data()));
+            data.swap(work);
+        }
+
+        if (ops & (DAEMON_OP_DECRYPT | DAEMON_OP_DECOMPRESS)) {
+            bool want_decrypt = (ops & DAEMON_OP_DECRYPT) != 0;
+            bool want_decompress = (ops & DAEMON_OP_DECOMPRESS) != 0;
+            ContainerHeader outer;
+            if (ContainerHeader::peek(data.data(), data.size(), outer) &&
+                ContainerPlan::nested(outer, want_decrypt, want_decompress)) {
+                // Comprimido con -c y encriptado después con -e: se
+                // desencripta y se descomprime el contenedor de adentro
+                std::string error = decode_stage(true, false, cipher.get(), state);
+                if (!error.empty()) return error;
+                data.erase(data.begin(), data.begin() + state.offset);
+                state.offset = 0;
+                ContainerHeader inner;
+                if (!ContainerHeader::peek(data.data(), data.size(), inner) ||
+                    inner.codec == CONTAINER_CODEC_NONE) {
+                    return "El contenido desencriptado no está comprimido: quite -d";
+                }
+                want_decrypt = false;
+            }
+            return decode_stage(want_decrypt, want_decompress, cipher.get(), state);
+        }
+        return "";
+    }
+
+    static bool recv_string(int sock, std::string& out, uint32_t length) {
+        out.resize(length);
+        return length == 0 || DaemonProtocol::recv_all(sock, &out[0], length);
+    }
+
+    // Abrir la salida de una petición en modo rutas. Un archivo regular (o
+    // que no existe) se escribe en un temporal junto a él que se renombra
+    // encima solo si la petición sale bien: una clave incorrecta o un
+    // contenedor dañado no destruyen la salida anterior. Otros destinos
+    // (/dev/null, un FIFO) se abren tal cual. temp_path queda "" si no hay
+    // temporal
+    static int open_output(const std::string& path, std::string& temp_path) {
+        temp_path.clear();
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && !S_ISREG(st.st_mode)) {
+            return open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        }
+        std::string temp = path + ".tmp." + std::to_string(getpid()) + "." +
+                           std::to_string((long)syscall(SYS_gettid));
+        int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd != -1) temp_path = temp;
+        return fd;
+    }
+
+    // Atender una petición. Retorna false si la conexión debe cerrarse
+    bool handle_request(int sock, WorkerState& state) {
+        DaemonRequest request;
+        int fds[2];
+        if (!DaemonProtocol::recv_request_header(sock, request, fds)) {
+            return false;
+        }
+
+        bool ok = request.magic == DAEMON_REQUEST_MAGIC &&
+                  request.key_length <= DAEMON_MAX_FIELD &&
+                  request.input_length <= DAEMON_MAX_FIELD &&
+                  request.output_length <= DAEMON_MAX_FIELD &&
+                  recv_string(sock, state.key, request.key_length);
+        if (ok && !request.use_fds) {
+            ok = recv_string(sock, state.input_path, request.input_length) &&
+                 recv_string(sock, state.output_path, request.output_length);
+        }
+        if (!ok) {
+            if (fds[0] != -1) close(fds[0]);
+            if (fds[1] != -1) close(fds[1]);
+            return false;  // Petición mal formada: cerrar la conexión
+        }
+        if (!request.use_fds) {
+            // Modo rutas: los fds que haya mandado el cliente no se usan y,
+            // sin cerrarlos, cada petición dejaría uno abierto en el daemon
+            if (fds[0] != -1) close(fds[0]);
+            if (fds[1] != -1) close(fds[1]);
+            fds[0] = fds[1] = -1;
+        }
+
+        std::string error;
+        int in_fd = fds[0];
+        int out_fd = fds[1];
+        std::string temp_path;     // Modo rutas: la salida se renombra al terminar
+
+        // Validaciones equivalentes a parse_arguments()
+        if (request.ops == 0) {
+            error = "Debe especificar al menos una operación";
+        } else if ((request.ops & DAEMON_OP_COMPRESS) && (request.ops & DAEMON_OP_DECOMPRESS)) {
+            error = "No se puede comprimir y descomprimir simultáneamente";
+        } else if ((request.ops & DAEMON_OP_ENCRYPT) && (request.ops & DAEMON_OP_DECRYPT)) {
+            error = "No se puede encriptar y desencriptar simultáneamente";
+        } else if (request.use_fds && (in_fd == -1 || out_fd == -1)) {
+            error = "Faltan los file descriptors de entrada/salida";
+        } else if (!request.use_fds) {
+            in_fd = open(state.input_path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (in_fd == -1) {
+                error = "open() de la entrada falló: " + std::string(strerror(errno));
+            } else {
+                out_fd = open_output(state.output_path, temp_path);
+                if (out_fd == -1) {
+                    error = "open() de la salida falló: " + std::string(strerror(errno));
+                }
+            }
+        }
+
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        if (error.empty()) {
+            // Entrada y tamaños vienen del cliente: sin memoria falla esta
+            // petición, no el daemon
+            try {
+                if (!read_fd_fully(in_fd, state.data)) {
+                    error = "read() de la entrada falló: " + std::string(strerror(errno));
+                } else if (state.data.empty()) {
+                    error = "La entrada está vacía";
+                } else {
+                    bytes_in = state.data.size();
+                    error = run_operations(request.ops, state.key, state);
+                    if (error.empty()) {
+                        size_t size = state.data.size() - state.offset;
+                        if (!write_fd_fully(out_fd, state.header, state.header_size) ||
+                            !write_fd_fully(out_fd, state.data.data() + state.offset, size)) {
+                            error = "write() de la salida falló: " + std::string(strerror(errno));
+                        } else {
+                            bytes_out = state.header_size + size;
+                        }
+                    }
+                }
+            } catch (const std::bad_alloc&) {
+                error = "No hay memoria para procesar la petición";
+            }
+        }
+
+        if (in_fd != -1) close(in_fd);
+        if (out_fd != -1 && close(out_fd) == -1 && error.empty()) {
+            error = "close() de la salida falló: " + std::string(strerror(errno));
+        }
+        if (!temp_path.empty()) {
+            if (error.empty() && rename(temp_path.c_str(), state.output_path.c_str()) == -1) {
+                error = "rename() de la salida falló: " + std::string(strerror(errno));
+            }
+            if (!error.empty()) unlink(temp_path.c_str());
+        }
+
+        // No conservar la clave en el buffer del hilo más de lo necesario
+        std::fill(state.key.begin(), state.key.end(), '\0');
+
+        return DaemonProtocol::send_response(sock, error.empty() ? 0 : 1, bytes_in, bytes_out,
+                                             error.empty() ? "OK" : error);
+    }
+
+    static void* worker_main(void* arg) {
+        WorkerState* state = (WorkerState*)arg;
+        GseaDaemon* daemon = state->daemon;
+
+        while (true) {
+            int client = accept4(daemon->listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client == -1) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                GSEA_ERROR("  [Daemon] accept() falló: " << strerror(errno) << "\n");
+                break;
+            }
+
+            // Solo se atiende a procesos del mismo usuario: en modo rutas el
+            // daemon abre y escribe lo que le piden con sus propios permisos
+            struct ucred peer;
+            socklen_t peer_size = sizeof(peer);
+            if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &peer_size) == -1 ||
+                peer.uid != geteuid()) {
+                GSEA_ERROR("  [Daemon] Conexión rechazada: el cliente no es del mismo usuario\n");
+                close(client);
+                continue;
+            }
+
+            // Una conexión puede enviar varias peticiones seguidas
+            while (daemon->handle_request(client, *state)) {
+            }
+            close(client);
+        }
+        return nullptr;
+    }
+
+public:
+    GseaDaemon(const std::string& path, int workers)
+        : socket_path(path), worker_count(workers > 0 ? workers : 1), listen_fd(-1) {
+        pthread_mutex_init(&key_mutex, nullptr);
+        // Semillas del digest de claves: /dev/urandom, o reloj y pid si no
+        // se puede leer
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        key_seeds[0] = ((uint64_t)now.tv_sec << 32) ^ (uint64_t)now.tv_nsec ^ ((uint64_t)getpid() << 16);
+        key_seeds[1] = Hash64::of((const unsigned char*)key_seeds, sizeof(key_seeds[0]));
+        int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+        if (fd != -1) {
+            if (read(fd, key_seeds, sizeof(key_seeds)) != (ssize_t)sizeof(key_seeds)) {
+                GSEA_VERBOSE("  [Daemon] /dev/urandom no respondió: semillas del reloj\n");
+            }
+            close(fd);
+        }
+    }
+
+    ~GseaDaemon() {
+        if (listen_fd != -1) {
+            close(listen_fd);
+            unlink(socket_path.c_str());
+        }
+        pthread_mutex_destroy(&key_mutex);
+    }
+
+    // Crear el socket, hacer bind() y listen()
+    bool start() {
+        struct sockaddr_un addr;
+        if (socket_path.size() >= sizeof(addr.sun_path)) {
+            GSEA_ERROR("  [Error] Ruta de socket demasiado larga: " << socket_path << "\n");
+            return false;
+        }
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (listen_fd == -1) {
+            GSEA_ERROR("  [Error] socket() falló: " << strerror(errno) << "\n");
+            return false;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        strncpy(g_daemon_socket_path, socket_path.c_str(), sizeof(g_daemon_socket_path) - 1);
+
+        // Un socket viejo de una ejecución anterior impediría el bind(). Solo
+        // se borra si es un socket: cualquier otro archivo se deja como está
+        struct stat st;
+        if (lstat(socket_path.c_str(), &st) == 0) {
+            if (!S_ISSOCK(st.st_mode)) {
+                GSEA_ERROR("  [Error] " << socket_path << " ya existe y no es un socket\n");
+                close(listen_fd);
+                listen_fd = -1;
+                return false;
+            }
+            unlink(socket_path.c_str());
+        }
+
+        if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+            GSEA_ERROR("  [Error] bind() falló: " << strerror(errno) << "\n");
+            close(listen_fd);
+            listen_fd = -1;
+            return false;
+        }
+        if (listen(listen_fd, 128) == -1) {
+            GSEA_ERROR("  [Error] listen() falló: " << strerror(errno) << "\n");
+            return false;
+        }
+        return true;
+    }
+
+    // Lanzar los hilos de trabajo y esperar (termina con SIGINT/SIGTERM)
+    int run() {
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, daemon_signal_handler);
+        signal(SIGTERM, daemon_signal_handler);
+
+        GSEA_INFO("  [Daemon] Escuchando en " << socket_path << " con "
+                  << worker_count << " hilos de trabajo\n");
+
+        // A partir de aquí no se imprime nada por petición: el daemon solo
+        // reporta errores por stderr
+        Log::global().flush();
+        Log::global().set_level(LOG_LEVEL_ERROR);
+
+        std::vector<pthread_t> threads(worker_count);
+        std::vector<WorkerState> states(worker_count);
+        for (int i = 0; i < worker_count; i++) {
+            states[i].daemon = this;
+            if (pthread_create(&threads[i], nullptr, worker_main, &states[i]) != 0) {
+                GSEA_ERROR("  [Error] pthread_create() falló\n");
+                return 1;
+            }
+        }
+        for (int i = 0; i < worker_count; i++) {
+            pthread_join(threads[i], nullptr);
+        }
+        return 1;  // Solo se llega aquí si accept() falló
+    }
+};
+
+#endif // GSEA_DAEMON_H
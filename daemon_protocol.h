@@ -0,0 +1,189 @@
+#ifndef GSEA_DAEMON_PROTOCOL_H
+#define GSEA_DAEMON_PROTOCOL_H
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
+
+// Protocolo entre gsea-client y el daemon (gsea --daemon)
+//
+// Cada petición viaja por un socket de dominio Unix (SOCK_STREAM):
+//   1. DaemonRequest (tamaño fijo). Si use_fds = 1, el mismo sendmsg()
+//      lleva adjuntos 2 file descriptors (entrada, salida) con SCM_RIGHTS.
+//   2. key_length bytes con la clave
+//   3. input_length + output_length bytes con las rutas (solo si use_fds = 0)
+// El daemon contesta con un DaemonResponse seguido de message_length bytes
+// de texto. Una conexión puede enviar varias peticiones seguidas.
+//
+// Ambos extremos corren en la misma máquina: los enteros van en el orden
+// nativo del procesador.
+
+// Bits de operación (mismo orden que en la línea de comandos)
+enum DaemonOp {
+    DAEMON_OP_COMPRESS   = 1,   // -c
+    DAEMON_OP_DECOMPRESS = 2,   // -d
+    DAEMON_OP_ENCRYPT    = 4,   // -e
+    DAEMON_OP_DECRYPT    = 8    // -u
+};
+
+static const uint32_t DAEMON_REQUEST_MAGIC = 0x47535251;   // "GSRQ"
+static const uint32_t DAEMON_RESPONSE_MAGIC = 0x47535250;  // "GSRP"
+static const uint32_t DAEMON_MAX_FIELD = 64 * 1024;        // Límite de clave/rutas
+
+struct DaemonRequest {
+    uint32_t magic;
+    uint8_t ops;             // Combinación de DaemonOp
+    uint8_t use_fds;         // 1 = fds adjuntos, 0 = rutas
+    uint16_t reserved;
+    uint32_t key_length;
+    uint32_t input_length;
+    uint32_t output_length;
+};
+
+struct DaemonResponse {
+    uint32_t magic;
+    int32_t status;          // 0 = éxito
+    uint64_t bytes_in;       // Bytes leídos de la entrada
+    uint64_t bytes_out;      // Bytes escritos en la salida
+    uint32_t message_length;
+    uint32_t reserved;
+};
+
+class DaemonProtocol {
+public:
+    // Enviar todo el buffer (send() puede enviar menos de lo pedido)
+    static bool send_all(int sock, const void* data, size_t size) {
+        const char* p = (const char*)data;
+        while (size > 0) {
+            ssize_t n = send(sock, p, size, MSG_NOSIGNAL);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    // Recibir exactamente size bytes (false si la conexión se cerró)
+    static bool recv_all(int sock, void* data, size_t size) {
+        char* p = (char*)data;
+        while (size > 0) {
+            ssize_t n = recv(sock, p, size, 0);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (n == 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    // Enviar la cabecera de la petición, con fds adjuntos si fds != nullptr
+    static bool send_request_header(int sock, const DaemonRequest& request, const int* fds, int fd_count) {
+        struct iovec iov;
+        iov.iov_base = (void*)&request;
+        iov.iov_len = sizeof(request);
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        // Buffer de control alineado para el mensaje SCM_RIGHTS
+        union {
+            char buffer[CMSG_SPACE(2 * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+
+        if (fds != nullptr && fd_count > 0) {
+            memset(&control, 0, sizeof(control));
+            msg.msg_control = control.buffer;
+            msg.msg_controllen = CMSG_SPACE(fd_count * sizeof(int));
+
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(fd_count * sizeof(int));
+            memcpy(CMSG_DATA(cmsg), fds, fd_count * sizeof(int));
+        }
+
+        ssize_t n;
+        do {
+            n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+        } while (n == -1 && errno == EINTR);
+        if (n == -1) return false;
+
+        // El kernel garantiza que los fds viajan con el primer byte;
+        // si el envío quedó incompleto, el resto va sin control
+        if ((size_t)n < sizeof(request)) {
+            return send_all(sock, (const char*)&request + n, sizeof(request) - n);
+        }
+        return true;
+    }
+
+    // Recibir la cabecera de la petición y los fds adjuntos (si hay)
+    // fds[] se llena con -1 cuando no llegan descriptores
+    static bool recv_request_header(int sock, DaemonRequest& request, int fds[2]) {
+        fds[0] = fds[1] = -1;
+
+        struct iovec iov;
+        iov.iov_base = &request;
+        iov.iov_len = sizeof(request);
+
+        union {
+            char buffer[CMSG_SPACE(2 * sizeof(int))];
+            struct cmsghdr align;
+        } control;
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buffer;
+        msg.msg_controllen = sizeof(control.buffer);
+
+        ssize_t n;
+        do {
+            n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+        } while (n == -1 && errno == EINTR);
+        if (n <= 0) return false;
+
+        for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                if (count > 2) count = 2;
+                memcpy(fds, CMSG_DATA(cmsg), count * sizeof(int));
+            }
+        }
+
+        if ((size_t)n < sizeof(request)) {
+            return recv_all(sock, (char*)&request + n, sizeof(request) - n);
+        }
+        return true;
+    }
+
+    static bool send_response(int sock, int32_t status, uint64_t bytes_in, uint64_t bytes_out,
+                              const std::string& message) {
+        DaemonResponse response;
+        memset(&response, 0, sizeof(response));
+        response.magic = DAEMON_RESPONSE_MAGIC;
+        response.status = status;
+        response.bytes_in = bytes_in;
+        response.bytes_out = bytes_out;
+        response.message_length = message.size();
+        return send_all(sock, &response, sizeof(response)) &&
+               send_all(sock, message.data(), message.size());
+    }
+};
+
+#endif // GSEA_DAEMON_PROTOCOL_H
@@ -0,0 +1,475 @@
+#ifndef GSEA_DEDUP_H
+#define GSEA_DEDUP_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "hash.h"
+#include "huffman.h"
+#include "xor.h"
+#include "crc32c.h"
+#include "container.h"
+#include "log.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+// ============================================================================
+// CHUNKING DEFINIDO POR CONTENIDO (CDC)
+// ============================================================================
+
+// Divide un buffer en chunks cuyos bordes dependen del CONTENIDO y no de
+// la posición: insertar un byte al inicio de un archivo solo cambia el
+// chunk afectado, los demás se vuelven a encontrar idénticos.
+//
+// Usa un "gear hash" rodante (como FastCDC): hash = (hash << 1) + gear[byte].
+// Como cada desplazamiento expulsa el bit más viejo, el hash solo depende
+// de los últimos 64 bytes. Se corta cuando los bits de la máscara son cero.
+class ContentChunker {
+public:
+    static const size_t MIN_CHUNK = 2 * 1024;     // Nunca cortar antes
+    static const size_t AVG_CHUNK = 8 * 1024;     // Tamaño promedio esperado
+    static const size_t MAX_CHUNK = 64 * 1024;    // Corte forzado
+
+private:
+    uint64_t gear[256];   // Tabla de valores pseudoaleatorios por byte
+
+public:
+    ContentChunker() {
+        // Tabla determinista (splitmix64): el mismo contenido debe producir
+        // los mismos cortes en todas las ejecuciones y máquinas
+        uint64_t seed = 0x6A09E667F3BCC908ULL;
+        for (int i = 0; i < 256; i++) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            gear[i] = z ^ (z >> 31);
+        }
+    }
+
+    // Retorna la longitud del siguiente chunk a partir de data[0]
+    size_t next_cut(const unsigned char* data, size_t size) const {
+        if (size <= MIN_CHUNK) return size;
+        size_t limit = (size < MAX_CHUNK) ? size : MAX_CHUNK;
+
+        // Máscara con log2(AVG_CHUNK) bits, tomados de la parte alta del
+        // hash (los bits altos mezclan más bytes de la ventana)
+        const uint64_t mask = (uint64_t)(AVG_CHUNK - 1) << (64 - 13);
+
+        uint64_t hash = 0;
+        for (size_t i = MIN_CHUNK; i < limit; i++) {
+            hash = (hash << 1) + gear[data[i]];
+            if ((hash & mask) == 0) {
+                return i + 1;
+            }
+        }
+        return limit;
+    }
+};
+
+// Identificador de chunk: 128 bits (dos Hash64 con semillas distintas)
+struct ChunkId {
+    uint64_t hi = 0;
+    uint64_t lo = 0;
+
+    static ChunkId of(const unsigned char* data, size_t size) {
+        ChunkId id;
+        id.hi = Hash64::of(data, size, 0x243F6A8885A308D3ULL);
+        id.lo = Hash64::of(data, size, 0x13198A2E03707344ULL);
+        return id;
+    }
+
+    bool operator<(const ChunkId& other) const {
+        return hi < other.hi || (hi == other.hi && lo < other.lo);
+    }
+
+    std::string to_hex() const {
+        char buffer[33];
+        snprintf(buffer, sizeof(buffer), "%016llx%016llx",
+                 (unsigned long long)hi, (unsigned long long)lo);
+        return buffer;
+    }
+
+    static bool from_hex(const std::string& hex, ChunkId& id) {
+        if (hex.size() != 32) return false;
+        id.hi = strtoull(hex.substr(0, 16).c_str(), nullptr, 16);
+        id.lo = strtoull(hex.substr(16, 16).c_str(), nullptr, 16);
+        return true;
+    }
+};
+
+// Ubicación de un chunk dentro del archivo de paquetes
+struct ChunkLocation {
+    uint64_t offset = 0;       // Posición en chunks.pack
+    uint32_t stored_size = 0;  // Bytes ocupados (ya comprimido/encriptado)
+    uint32_t raw_size = 0;     // Bytes originales
+    uint32_t crc = 0;          // CRC32C de los bytes originales
+};
+
+// Estadísticas acumuladas del modo dedup
+struct DedupStats {
+    uint64_t files = 0;
+    uint64_t logical_bytes = 0;   // Bytes de entrada (antes de deduplicar)
+    uint64_t chunks = 0;          // Chunks vistos en total
+    uint64_t new_chunks = 0;      // Chunks únicos que hubo que guardar
+    uint64_t new_raw_bytes = 0;   // Bytes originales de los chunks nuevos
+    uint64_t stored_bytes = 0;    // Bytes escritos al paquete
+};
+
+// ============================================================================
+// ALMACÉN DE CHUNKS
+// ============================================================================
+
+// Directorio con tres archivos:
+//   store.info  : firma con las operaciones aplicadas a cada chunk y el
+//                 verificador de la clave (el de la cabecera del contenedor)
+//   chunks.pack : chunks únicos, comprimidos y/o encriptados, uno tras otro
+//   chunks.idx  : una línea por chunk "<id_hex> <offset> <stored> <raw> <crc>"
+//
+// Con otra clave el almacén no se abre: los chunks nuevos quedarían mezclados
+// con los de la clave anterior. El CRC32C de los bytes originales se
+// comprueba al leer cada chunk, así que un chunk dañado (o una clave que no
+// se detectó) es un error y no bytes equivocados en el archivo restaurado.
+//
+// Ambos archivos son de solo-agregar. Antes de anotar un chunk en el índice
+// se fuerza el paquete a disco (fdatasync), así un corte nunca deja el
+// índice apuntando a datos que no existen.
+class ChunkStore {
+private:
+    std::string dir;
+    bool use_compression;
+    bool use_encryption;
+    XORCipher* cipher;                            // Compartido, clave ya expandida
+    std::map<ChunkId, ChunkLocation> index;       // id -> ubicación
+    std::string pending_index;                    // Líneas aún no escritas al índice
+    int pack_fd;
+    int index_fd;
+    uint64_t pack_size;
+
+    static bool write_all(int fd, const unsigned char* data, size_t size) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = write(fd, data + done, size - done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    static bool read_all_at(int fd, unsigned char* data, size_t size, uint64_t offset) {
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = pread(fd, data + done, size - done, offset + done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (n == 0) return false;  // EOF inesperado
+            done += n;
+        }
+        return true;
+    }
+
+    std::string signature() const {
+        std::string sig = "GSEA-STORE 2\tc=";
+        sig += use_compression ? "1" : "0";
+        sig += "\te=";
+        sig += use_encryption ? "1" : "0";
+        if (use_encryption) {
+            char key_check[16];
+            snprintf(key_check, sizeof(key_check), "%08x",
+                     (unsigned int)ContainerHeader::compute_key_check(*cipher));
+            sig += "\tk=";
+            sig += key_check;
+        }
+        sig += "\n";
+        return sig;
+    }
+
+    bool check_signature() {
+        std::string info_path = dir + "/store.info";
+        std::string expected = signature();
+
+        int fd = open(info_path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            // Almacén nuevo: escribir la firma
+            fd = open(info_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd == -1 || !write_all(fd, (const unsigned char*)expected.data(), expected.size())) {
+                GSEA_ERROR("  [Error] No se pudo crear " << info_path << ": " << strerror(errno) << "\n");
+                if (fd != -1) close(fd);
+                return false;
+            }
+            close(fd);
+            return true;
+        }
+
+        char buffer[128];
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        close(fd);
+        if (n < 0 || std::string(buffer, n) != expected) {
+            GSEA_ERROR("  [Error] El almacén " << dir << " fue creado con otras operaciones u otra clave\n");
+            GSEA_ERROR("  [Error] Firma esperada: " << expected);
+            return false;
+        }
+        return true;
+    }
+
+    bool load_index() {
+        std::string content;
+        char buffer[65536];
+        ssize_t n;
+        if (lseek(index_fd, 0, SEEK_SET) == -1) return false;
+        while ((n = read(index_fd, buffer, sizeof(buffer))) != 0) {
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            content.append(buffer, n);
+        }
+
+        size_t start = 0;
+        while (start < content.size()) {
+            size_t end = content.find('\n', start);
+            if (end == std::string::npos) break;  // Línea incompleta: se ignora
+            std::string line = content.substr(start, end - start);
+            start = end + 1;
+
+            char hex[64];
+            unsigned long long offset, stored, raw;
+            unsigned int crc;
+            if (sscanf(line.c_str(), "%40s %llu %llu %llu %x", hex, &offset, &stored, &raw, &crc) != 5) continue;
+
+            ChunkId id;
+            if (!ChunkId::from_hex(hex, id)) continue;
+            if (offset + stored > pack_size) continue;  // Apunta más allá del paquete
+
+            ChunkLocation loc;
+            loc.offset = offset;
+            loc.stored_size = stored;
+            loc.raw_size = raw;
+            loc.crc = crc;
+            index[id] = loc;
+        }
+        return true;
+    }
+
+public:
+    ChunkStore(const std::string& store_dir, bool compress, bool encrypt, XORCipher* shared_cipher)
+        : dir(store_dir), use_compression(compress), use_encryption(encrypt),
+          cipher(shared_cipher), pack_fd(-1), index_fd(-1), pack_size(0) {}
+
+    ~ChunkStore() {
+        flush();
+        if (pack_fd != -1) close(pack_fd);
+        if (index_fd != -1) close(index_fd);
+    }
+
+    // Abrir (o crear) el almacén y cargar el índice en memoria
+    bool open_store() {
+        if (mkdir(dir.c_str(), 0755) == -1 && errno != EEXIST) {
+            GSEA_ERROR("  [Error] mkdir() del almacén falló: " << strerror(errno) << "\n");
+            return false;
+        }
+        if (!check_signature()) return false;
+
+        std::string pack_path = dir + "/chunks.pack";
+        std::string index_path = dir + "/chunks.idx";
+        pack_fd = open(pack_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        index_fd = open(index_path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+        if (pack_fd == -1 || index_fd == -1) {
+            GSEA_ERROR("  [Error] open() del almacén falló: " << strerror(errno) << "\n");
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(pack_fd, &st) == -1) return false;
+        pack_size = st.st_size;
+
+        if (!load_index()) {
+            GSEA_ERROR("  [Error] No se pudo leer el índice del almacén\n");
+            return false;
+        }
+
+        GSEA_VERBOSE("  [Dedup] Almacén abierto: " << dir << " (" << index.size()
+                     << " chunks, " << pack_size << " bytes)\n");
+        return true;
+    }
+
+    bool contains(const ChunkId& id) const {
+        return index.find(id) != index.end();
+    }
+
+    // Guardar un chunk nuevo (comprimido y/o encriptado según el almacén)
+    // Si ya existe no se hace NADA: ni CPU de compresión ni disco
+    bool put(const ChunkId& id, const unsigned char* data, size_t size, DedupStats& stats) {
+        if (contains(id)) return same_as_stored(id, data, size);
+
+        std::vector<unsigned char> stored(data, data + size);
+        if (use_compression) {
+            HuffmanCoder huffman;
+            stored = huffman.compress(stored);
+        }
+        if (use_encryption) {
+            stored = cipher->encrypt(stored);
+        }
+        if (stored.empty()) return false;
+
+        if (!write_all(pack_fd, stored.data(), stored.size())) {
+            GSEA_ERROR("  [Error] write() al paquete falló: " << strerror(errno) << "\n");
+            return false;
+        }
+
+        ChunkLocation loc;
+        loc.offset = pack_size;
+        loc.stored_size = stored.size();
+        loc.raw_size = size;
+        loc.crc = CRC32C::of(data, size);
+        index[id] = loc;
+        pack_size += stored.size();
+
+        char line[128];
+        snprintf(line, sizeof(line), "%s %llu %u %u %08x\n", id.to_hex().c_str(),
+                 (unsigned long long)loc.offset, loc.stored_size, loc.raw_size, loc.crc);
+        pending_index += line;
+
+        stats.new_chunks++;
+        stats.new_raw_bytes += size;
+        stats.stored_bytes += stored.size();
+        return true;
+    }
+
+    // ¿El chunk ya guardado con este id tiene exactamente estos bytes?
+    // ChunkId no es criptográfico: se pueden fabricar dos chunks distintos con
+    // el mismo id, y sin comparar la restauración devolvería el que ya estaba
+    bool same_as_stored(const ChunkId& id, const unsigned char* data, size_t size) {
+        const ChunkLocation& loc = index.find(id)->second;
+        if (loc.raw_size == size && loc.crc == CRC32C::of(data, size)) {
+            std::vector<unsigned char> stored;
+            if (!get(id, stored)) return false;
+            if (memcmp(stored.data(), data, size) == 0) return true;
+        }
+        GSEA_ERROR("  [Error] Colisión de hash: el chunk " << id.to_hex()
+                   << " del almacén tiene otro contenido\n");
+        return false;
+    }
+
+    // Recuperar un chunk (desencriptado y descomprimido)
+    bool get(const ChunkId& id, std::vector<unsigned char>& out) {
+        std::map<ChunkId, ChunkLocation>::const_iterator it = index.find(id);
+        if (it == index.end()) {
+            GSEA_ERROR("  [Error] Chunk inexistente en el almacén: " << id.to_hex() << "\n");
+            return false;
+        }
+
+        std::vector<unsigned char> stored(it->second.stored_size);
+        if (!read_all_at(pack_fd, stored.data(), stored.size(), it->second.offset)) {
+            GSEA_ERROR("  [Error] pread() del paquete falló\n");
+            return false;
+        }
+
+        if (use_encryption) {
+            stored = cipher->decrypt(stored);
+        }
+        if (use_compression) {
+            HuffmanCoder huffman;
+            stored = huffman.decompress(stored);
+        }
+        if (stored.size() != it->second.raw_size ||
+            CRC32C::of(stored.data(), stored.size()) != it->second.crc) {
+            GSEA_ERROR("  [Error] Chunk " << id.to_hex() << " dañado o clave incorrecta\n");
+            return false;
+        }
+        out.swap(stored);
+        return true;
+    }
+
+    // Hacer durables los chunks nuevos y luego anotarlos en el índice
+    bool flush() {
+        if (pending_index.empty()) return true;
+        if (fdatasync(pack_fd) == -1 ||
+            !write_all(index_fd, (const unsigned char*)pending_index.data(), pending_index.size())) {
+            GSEA_ERROR("  [Error] No se pudo actualizar el índice: " << strerror(errno) << "\n");
+            return false;
+        }
+        pending_index.clear();
+        return true;
+    }
+};
+
+// ============================================================================
+// RECETA DE ARCHIVO
+// ============================================================================
+
+// Lista ordenada de chunks que reconstruye un archivo. Formato binario:
+//   "GDDR" | versión (1 byte) | tamaño total (8 bytes) | cantidad (8 bytes)
+//   y por chunk: id (16 bytes) | tamaño original (4 bytes)
+// Todos los enteros en big-endian, igual que el tamaño del árbol Huffman.
+struct DedupRecipe {
+    uint64_t total_size = 0;
+    std::vector<ChunkId> chunks;
+    std::vector<uint32_t> sizes;
+
+    static void put_u64(std::vector<unsigned char>& out, uint64_t v) {
+        for (int shift = 56; shift >= 0; shift -= 8) out.push_back((v >> shift) & 0xFF);
+    }
+
+    static uint64_t get_u64(const unsigned char* p) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v = (v << 8) | p[i];
+        return v;
+    }
+
+    std::vector<unsigned char> serialize() const {
+        std::vector<unsigned char> out;
+        out.reserve(21 + chunks.size() * 20);
+        out.push_back('G'); out.push_back('D'); out.push_back('D'); out.push_back('R');
+        out.push_back(1);
+        put_u64(out, total_size);
+        put_u64(out, chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++) {
+            put_u64(out, chunks[i].hi);
+            put_u64(out, chunks[i].lo);
+            out.push_back((sizes[i] >> 24) & 0xFF);
+            out.push_back((sizes[i] >> 16) & 0xFF);
+            out.push_back((sizes[i] >> 8) & 0xFF);
+            out.push_back(sizes[i] & 0xFF);
+        }
+        return out;
+    }
+
+    bool parse(const std::vector<unsigned char>& data) {
+        if (data.size() < 21 || memcmp(data.data(), "GDDR", 4) != 0 || data[4] != 1) {
+            GSEA_ERROR("  [Error] No es una receta de dedup válida\n");
+            return false;
+        }
+        total_size = get_u64(&data[5]);
+        uint64_t count = get_u64(&data[13]);
+        if (count > (data.size() - 21) / 20 || data.size() != 21 + count * 20) {
+            GSEA_ERROR("  [Error] Receta de dedup truncada\n");
+            return false;
+        }
+        chunks.resize(count);
+        sizes.resize(count);
+        const unsigned char* p = &data[21];
+        for (uint64_t i = 0; i < count; i++, p += 20) {
+            chunks[i].hi = get_u64(p);
+            chunks[i].lo = get_u64(p + 8);
+            sizes[i] = ((uint32_t)p[16] << 24) | ((uint32_t)p[17] << 16) |
+                       ((uint32_t)p[18] << 8) | (uint32_t)p[19];
+        }
+        return true;
+    }
+};
+
+#endif // GSEA_DEDUP_H
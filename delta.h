@@ -0,0 +1,400 @@
+#ifndef GSEA_DELTA_H
+#define GSEA_DELTA_H
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+// Delta contra una versión anterior del archivo (--base)
+//
+// La base se indexa por bloques de block_size bytes alineados (un hash
+// rodante de cada uno). El archivo nuevo se recorre con el mismo hash
+// rodante: cuando la ventana coincide con un bloque de la base y los bytes
+// lo confirman, la coincidencia se extiende hacia atrás (sobre el literal
+// pendiente) y hacia adelante de a 8 bytes, y se emite una copia. Lo que no
+// coincide queda como literal. Así lo que no cambió solo cuesta una
+// comparación de memoria, y el hash rodante corre sobre lo editado.
+//
+// El resultado es un flujo de instrucciones que se guarda en los bloques del
+// contenedor (FLAG_DELTA en container.h), así que los literales pasan por el
+// códec del nivel (Huffman, LZ77) y por el cifrado como cualquier archivo:
+//
+//   0x00 len           literal: siguen len bytes
+//   0x01 offset len    copia: len bytes de la base desde offset
+//
+// offset y len son varints (7 bits por byte, el bit alto indica que sigue).
+
+struct DeltaOp {
+    bool copy;
+    uint64_t offset;        // Copia: posición en la base; literal: posición en el archivo nuevo
+    uint64_t length;
+};
+
+struct DeltaStats {
+    uint64_t copied = 0;    // Bytes que salen de la base
+    uint64_t literal = 0;   // Bytes guardados tal cual en las instrucciones
+    uint64_t ops = 0;
+};
+
+// Índice de los bloques de la base
+class DeltaIndex {
+private:
+    static const size_t MIN_BLOCK = 64;
+    static const uint64_t MAX_BLOCKS = 1 << 21;   // Tabla de hasta 4M entradas (32 MB + 4 MB de filtro)
+    static const int PROBES = 4;
+    static const uint64_t PRIME = 0x100000001B3ULL;
+
+    // Una entrada por bloque, con sondeo lineal; filter tiene 8 bits por
+    // entrada de la tabla, así que casi todas las ventanas que no están en
+    // la base se descartan sin tocarla (la tabla no entra en caché, el filtro sí)
+    struct Slot {
+        uint32_t tag;       // 32 bits bajos del hash, para descartar sin comparar bytes
+        uint32_t block;     // Bloque + 1 (0 = libre)
+    };
+
+    const unsigned char* base;
+    uint64_t base_size;
+    size_t block;
+    uint64_t out_factor;    // PRIME^(block - 1): peso del byte que sale de la ventana
+    uint64_t powers[9];     // PRIME^0..PRIME^8
+    int shift;
+    std::vector<Slot> table;
+    std::vector<uint64_t> filter;
+
+    static uint64_t mix(uint64_t hash) { return (hash ^ (hash >> 29)) * 0xBF58476D1CE4E5B9ULL; }
+    size_t slot_of(uint64_t hash) const { return (size_t)(mix(hash) >> shift); }
+
+    // log2 de las entradas de la tabla: al menos el doble de bloques
+    static int table_bits(uint64_t blocks) {
+        int bits = 4;
+        while (((uint64_t)1 << bits) < 2 * blocks) bits++;
+        return bits;
+    }
+    size_t bit_of(uint64_t hash) const { return (size_t)(mix(hash) >> (shift - 3)); }
+
+public:
+    DeltaIndex() : base(nullptr), base_size(0), block(MIN_BLOCK), out_factor(1), powers{1}, shift(63) {}
+
+    // El bloque crece con la base para que el índice no pase de MAX_BLOCKS
+    // entradas: con bases chicas se detectan ediciones cercanas entre sí, y
+    // con las de varios GB el índice no pasa de ~36 MB
+    void build(const unsigned char* data, uint64_t size) {
+        base = data;
+        base_size = size;
+        block = block_for(size);
+        out_factor = 1;
+        for (size_t i = 1; i < block; i++) out_factor *= PRIME;
+        powers[0] = 1;
+        for (int i = 1; i <= 8; i++) powers[i] = powers[i - 1] * PRIME;
+
+        uint64_t blocks = size / block;
+        int bits = table_bits(blocks);
+        shift = 64 - bits;
+        table.assign((size_t)1 << bits, Slot{0, 0});
+        filter.assign(((size_t)1 << (bits + 3)) / 64, 0);
+
+        for (uint64_t b = 0; b < blocks; b++) {
+            uint64_t h = hash(data + b * block);
+            size_t bit = bit_of(h);
+            filter[bit >> 6] |= (uint64_t)1 << (bit & 63);
+            size_t slot = slot_of(h);
+            for (int p = 0; p < PROBES; p++) {
+                Slot& s = table[(slot + p) & (table.size() - 1)];
+                if (s.block == 0) {
+                    s.tag = (uint32_t)h;
+                    s.block = (uint32_t)(b + 1);
+                    break;
+                }
+                if (s.tag == (uint32_t)h && memcmp(data + (uint64_t)(s.block - 1) * block,
+                                                   data + b * block, block) == 0) {
+                    break;  // Bloque repetido: alcanza con el primero
+                }
+            }
+        }
+    }
+
+    size_t block_size() const { return block; }
+
+    // Bloque que usaría build() con una base de size bytes
+    static size_t block_for(uint64_t size) {
+        size_t bytes = MIN_BLOCK;
+        while (size / bytes > MAX_BLOCKS) bytes <<= 1;
+        return bytes;
+    }
+
+    // Memoria de la tabla y el filtro para una base de size bytes (para
+    // reservarla en --max-memory antes de construir el índice)
+    static uint64_t footprint(uint64_t size) {
+        uint64_t entries = (uint64_t)1 << table_bits(size / block_for(size));
+        return entries * sizeof(Slot) + entries / 8;
+    }
+
+    // El mismo valor que dejaría roll() con la ventana en window. Se suma de
+    // a 8 bytes (block es múltiplo de 8): los 8 productos son independientes
+    // y la cadena de multiplicaciones es 8 veces más corta (indexar una base
+    // de varios GB es casi todo esto)
+    uint64_t hash(const unsigned char* window) const {
+        uint64_t h = 0;
+        for (size_t i = 0; i < block; i += 8) {
+            const unsigned char* w = window + i;
+            h = h * powers[8] + (w[0] * powers[7] + w[1] * powers[6] + w[2] * powers[5] + w[3] * powers[4] +
+                                 w[4] * powers[3] + w[5] * powers[2] + w[6] * powers[1] + w[7]);
+        }
+        return h;
+    }
+
+    // Correr la ventana un byte: sale out, entra in
+    uint64_t roll(uint64_t h, unsigned char out, unsigned char in) const {
+        return (h - out * out_factor) * PRIME + in;
+    }
+
+    // Offset en la base de un bloque igual a window, o -1
+    int64_t find(uint64_t h, const unsigned char* window) const {
+        size_t bit = bit_of(h);
+        if (!(filter[bit >> 6] & ((uint64_t)1 << (bit & 63)))) return -1;
+        size_t slot = slot_of(h);
+        for (int p = 0; p < PROBES; p++) {
+            const Slot& s = table[(slot + p) & (table.size() - 1)];
+            if (s.block == 0) return -1;
+            uint64_t offset = (uint64_t)(s.block - 1) * block;
+            if (s.tag == (uint32_t)h && memcmp(base + offset, window, block) == 0) return offset;
+        }
+        return -1;
+    }
+};
+
+class DeltaEncoder {
+private:
+    // Bytes iguales al principio de a y b (hasta max), de a 8
+    static uint64_t common_prefix(const unsigned char* a, const unsigned char* b, uint64_t max) {
+        uint64_t n = 0;
+        while (n + 8 <= max) {
+            uint64_t x, y;
+            memcpy(&x, a + n, 8);
+            memcpy(&y, b + n, 8);
+            if (x != y) return n + (__builtin_ctzll(x ^ y) >> 3);
+            n += 8;
+        }
+        while (n < max && a[n] == b[n]) n++;
+        return n;
+    }
+
+    static void emit_literal(std::vector<DeltaOp>& ops, uint64_t start, uint64_t end) {
+        if (end > start) ops.push_back(DeltaOp{false, start, end - start});
+    }
+
+    static void emit_copy(std::vector<DeltaOp>& ops, uint64_t offset, uint64_t length) {
+        if (!ops.empty() && ops.back().copy && ops.back().offset + ops.back().length == offset) {
+            ops.back().length += length;
+            return;
+        }
+        ops.push_back(DeltaOp{true, offset, length});
+    }
+
+public:
+    // Memoria máxima de la lista de instrucciones para un archivo de
+    // target_size bytes: cada copia abarca al menos un bloque del índice y
+    // cada literal va seguido de una copia (más el margen de crecimiento
+    // del vector)
+    static uint64_t ops_footprint(uint64_t base_size, uint64_t target_size) {
+        uint64_t ops = 2 * (target_size / DeltaIndex::block_for(base_size)) + 1;
+        return 2 * ops * sizeof(DeltaOp);
+    }
+
+    // Instrucciones para reconstruir target a partir de la base indexada
+    static void plan(const DeltaIndex& index, const unsigned char* base, uint64_t base_size,
+                     const unsigned char* target, uint64_t size, std::vector<DeltaOp>& ops) {
+        ops.clear();
+        const uint64_t block = index.block_size();
+        uint64_t literal_start = 0;
+        uint64_t pos = 0;
+        uint64_t h = size >= block ? index.hash(target) : 0;
+
+        while (pos + block <= size) {
+            int64_t found = index.find(h, target + pos);
+            if (found < 0) {
+                if (pos + block < size) h = index.roll(h, target[pos], target[pos + block]);
+                pos++;
+                continue;
+            }
+
+            // Extender hacia atrás sobre el literal pendiente y hacia adelante
+            uint64_t start = pos;
+            uint64_t base_start = (uint64_t)found;
+            while (start > literal_start && base_start > 0 && target[start - 1] == base[base_start - 1]) {
+                start--;
+                base_start--;
+            }
+            uint64_t end = pos + block;
+            uint64_t base_end = (uint64_t)found + block;
+            uint64_t more = common_prefix(target + end, base + base_end,
+                                          std::min(size - end, base_size - base_end));
+            end += more;
+
+            emit_literal(ops, literal_start, start);
+            emit_copy(ops, base_start, end - start);
+            pos = literal_start = end;
+            if (pos + block <= size) h = index.hash(target + pos);
+        }
+        emit_literal(ops, literal_start, size);
+    }
+
+    // Cabecera de una instrucción (tipo y varints). head: MAX_HEAD bytes
+    static const size_t MAX_HEAD = 1 + 2 * 10;
+
+    static size_t write_head(const DeltaOp& op, unsigned char* head) {
+        size_t n = 0;
+        head[n++] = op.copy ? 1 : 0;
+        uint64_t fields[2] = {op.offset, op.length};
+        for (int f = op.copy ? 0 : 1; f < 2; f++) {
+            uint64_t v = fields[f];
+            while (v >= 0x80) {
+                head[n++] = (unsigned char)(v | 0x80);
+                v >>= 7;
+            }
+            head[n++] = (unsigned char)v;
+        }
+        return n;
+    }
+
+    // Bytes del flujo de instrucciones (va en la cabecera antes de escribirlo)
+    static uint64_t stream_size(const std::vector<DeltaOp>& ops, DeltaStats* stats = nullptr) {
+        unsigned char head[MAX_HEAD];
+        uint64_t total = 0;
+        for (const DeltaOp& op : ops) {
+            total += write_head(op, head) + (op.copy ? 0 : op.length);
+            if (stats != nullptr) {
+                (op.copy ? stats->copied : stats->literal) += op.length;
+                stats->ops++;
+            }
+        }
+        return total;
+    }
+};
+
+// Serializa las instrucciones de a tramos (un bloque del contenedor por vez)
+class DeltaWriter {
+private:
+    const std::vector<DeltaOp>& ops;
+    const unsigned char* target;
+    size_t op;
+    unsigned char head[DeltaEncoder::MAX_HEAD];
+    size_t head_size;
+    size_t head_pos;
+    uint64_t literal_done;
+
+public:
+    DeltaWriter(const std::vector<DeltaOp>& op_list, const unsigned char* target_data)
+        : ops(op_list), target(target_data), op(0), head_size(0), head_pos(0), literal_done(0) {}
+
+    // Llenar out con hasta capacity bytes del flujo. Retorna 0 al terminar
+    size_t next(unsigned char* out, size_t capacity) {
+        size_t written = 0;
+        while (written < capacity && op < ops.size()) {
+            const DeltaOp& current = ops[op];
+            if (head_size == 0) {
+                head_size = DeltaEncoder::write_head(current, head);
+                head_pos = 0;
+                literal_done = 0;
+            }
+            if (head_pos < head_size) {
+                size_t n = std::min(head_size - head_pos, capacity - written);
+                memcpy(out + written, head + head_pos, n);
+                head_pos += n;
+                written += n;
+                continue;
+            }
+            if (!current.copy && literal_done < current.length) {
+                size_t n = (size_t)std::min<uint64_t>(current.length - literal_done, capacity - written);
+                memcpy(out + written, target + current.offset + literal_done, n);
+                literal_done += n;
+                written += n;
+                continue;
+            }
+            op++;
+            head_size = 0;
+        }
+        return written;
+    }
+};
+
+// Aplica el flujo de instrucciones a medida que llega (los tramos pueden
+// cortar una instrucción en cualquier byte). Sink: bool write(data, size)
+class DeltaDecoder {
+private:
+    enum State { TAG, FIELD, LITERAL };
+
+    const unsigned char* base;
+    uint64_t base_size;
+    uint64_t target_size;
+    uint64_t produced;
+    State state;
+    bool copy;
+    int field;
+    uint64_t fields[2];
+    int shift;
+    uint64_t remaining;     // Bytes que faltan del literal actual
+
+public:
+    DeltaDecoder(const unsigned char* base_data, uint64_t base_bytes, uint64_t target_bytes)
+        : base(base_data), base_size(base_bytes), target_size(target_bytes), produced(0), state(TAG),
+          copy(false), field(0), fields{0, 0}, shift(0), remaining(0) {}
+
+    // false si el flujo es inválido o no lo pudo escribir el sink
+    template <class Sink>
+    bool feed(const unsigned char* data, size_t size, Sink& sink) {
+        while (size > 0) {
+            if (state == LITERAL) {
+                size_t n = (size_t)std::min<uint64_t>(remaining, size);
+                if (!sink.write(data, n)) return false;
+                produced += n;
+                remaining -= n;
+                data += n;
+                size -= n;
+                if (remaining == 0) state = TAG;
+                continue;
+            }
+
+            unsigned char byte = *data++;
+            size--;
+            if (state == TAG) {
+                if (byte > 1) return false;
+                copy = byte == 1;
+                field = copy ? 0 : 1;
+                fields[0] = fields[1] = 0;
+                shift = 0;
+                state = FIELD;
+                continue;
+            }
+
+            // Varint: offset (solo copias) y largo
+            if (shift > 63) return false;
+            fields[field] |= (uint64_t)(byte & 0x7F) << shift;
+            shift += 7;
+            if (byte & 0x80) continue;
+            shift = 0;
+            if (++field < 2) continue;
+
+            uint64_t length = fields[1];
+            if (length > target_size - produced) return false;
+            if (!copy) {
+                remaining = length;
+                state = length > 0 ? LITERAL : TAG;
+                continue;
+            }
+            uint64_t offset = fields[0];
+            if (offset > base_size || length > base_size - offset) return false;
+            if (!sink.write(base + offset, (size_t)length)) return false;
+            produced += length;
+            state = TAG;
+        }
+        return true;
+    }
+
+    // ¿El flujo terminó justo al final de una instrucción y con el tamaño esperado?
+    bool finished() const { return state == TAG && produced == target_size; }
+    uint64_t bytes_produced() const { return produced; }
+};
+
+#endif // GSEA_DELTA_H
@@ -0,0 +1,382 @@
+#ifndef GSEA_DIRECT_IO_H
+#define GSEA_DIRECT_IO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "buffer_pool.h"
+#include "stats.h"
+#include "throttle.h"
+
+// E/S por bloques sin ensuciar la caché de páginas (--direct)
+//
+// Con O_DIRECT el kernel copia entre el disco y el buffer sin pasar por la
+// caché, pero exige posición, largo y dirección alineados al bloque lógico
+// del dispositivo (DIRECT_ALIGNMENT cubre 512 y 4096). Los bloques del
+// formato no lo están (cabeceras de 20 bytes, datos comprimidos de
+// cualquier largo), así que la entrada y la salida pasan por un buffer
+// alineado de DIRECT_CHUNK bytes (de mmap(): alineado a página):
+//   - DirectReader lee de a DIRECT_CHUNK con pread() y entrega los bytes
+//     en los tamaños que se pidan
+//   - DirectWriter junta la salida y escribe DIRECT_CHUNK alineados; la
+//     cola que no llena un bloque lógico se escribe al final sin O_DIRECT
+//
+// Si el sistema de archivos no admite O_DIRECT (tmpfs, algunos FUSE) se
+// usa la E/S normal por el mismo buffer y lo ya procesado se descarta de
+// la caché con posix_fadvise(POSIX_FADV_DONTNEED); en la salida, después
+// de forzar su escritura con sync_file_range(). Sin --direct (y con pipes
+// o dispositivos de caracteres) las dos clases son read()/write() tal cual.
+
+static const size_t DIRECT_ALIGNMENT = 4096;
+static const size_t DIRECT_CHUNK = 1 << 20;
+
+enum DirectMode {
+    DIRECT_OFF = 0,        // read()/write() normales
+    DIRECT_ON,             // O_DIRECT
+    DIRECT_DONTNEED        // Sin O_DIRECT: posix_fadvise() tras cada tramo
+};
+
+static const char* const DIRECT_MODE_NAMES[] = {"con caché", "O_DIRECT", "posix_fadvise(DONTNEED)"};
+
+// Poner o quitar O_DIRECT (p. ej. si el primer acceso alineado igual
+// falla con EINVAL, o para escribir una cola sin alinear)
+inline bool set_direct(int fd, bool enabled) {
+    count_syscall(2);
+    int current = fcntl(fd, F_GETFL);
+    return current != -1 && fcntl(fd, F_SETFL, enabled ? current | O_DIRECT : current & ~O_DIRECT) == 0;
+}
+
+// Abrir path para E/S por bloques. Con direct se intenta O_DIRECT; si el
+// sistema de archivos lo rechaza, mode queda en DIRECT_DONTNEED. Solo los
+// archivos regulares evitan la caché (un pipe no tiene posición)
+inline int open_for_stream(const char* path, int flags, bool direct, DirectMode& mode) {
+    mode = DIRECT_OFF;
+    count_syscall();
+    int fd = open(path, flags, 0644);
+    if (fd == -1 || !direct) return fd;
+
+    struct stat st;
+    count_syscall();
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) return fd;
+    mode = set_direct(fd, true) ? DIRECT_ON : DIRECT_DONTNEED;
+    if (mode == DIRECT_DONTNEED) {
+        count_syscall();
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    return fd;
+}
+
+class DirectReader {
+private:
+    int fd;
+    DirectMode mode;
+    PooledBuffer buffer;
+    uint64_t buffer_start;     // Posición en el archivo del byte 0 del buffer
+    size_t filled;             // Bytes válidos en el buffer
+    uint64_t position;         // Próximo byte a entregar
+
+    // Cargar el tramo alineado que contiene position
+    bool refill() {
+        buffer_start = position / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+        filled = 0;
+        Throttle::global().charge_io(DIRECT_CHUNK);
+        while (filled < DIRECT_CHUNK) {
+            count_syscall();
+            ssize_t n = pread(fd, buffer.data() + filled, DIRECT_CHUNK - filled, buffer_start + filled);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                // Algunos sistemas de archivos aceptan O_DIRECT al abrir y
+                // no al leer: se sigue sin él
+                if (errno == EINVAL && mode == DIRECT_ON && set_direct(fd, false)) {
+                    mode = DIRECT_DONTNEED;
+                    continue;
+                }
+                return false;
+            }
+            if (n == 0) break;
+            filled += n;
+        }
+        if (mode == DIRECT_DONTNEED && filled > 0) {
+            count_syscall();
+            posix_fadvise(fd, buffer_start, filled, POSIX_FADV_DONTNEED);
+        }
+        return true;
+    }
+
+public:
+    DirectReader(int file, DirectMode direct_mode)
+        : fd(file), mode(direct_mode), buffer_start(0), filled(0), position(0) {
+        if (mode != DIRECT_OFF) buffer.reserve(DIRECT_CHUNK);
+    }
+
+    DirectReader(const DirectReader&) = delete;
+    DirectReader& operator=(const DirectReader&) = delete;
+
+    bool valid() const { return mode == DIRECT_OFF || buffer.valid(); }
+    DirectMode direct_mode() const { return mode; }
+    size_t footprint() const { return buffer.capacity(); }
+
+    // Leer hasta size bytes (menos solo al final del archivo), como read_full()
+    ssize_t read(unsigned char* out, size_t size, FileStats* stats = nullptr) {
+        StageTimer timer(stats, STAGE_READ);
+        size_t done = 0;
+        while (done < size) {
+            if (mode == DIRECT_OFF) {
+                size_t want = Throttle::global().grant_io(size - done);
+                count_syscall();
+                ssize_t n = ::read(fd, out + done, want);
+                if (n == -1) {
+                    if (errno == EINTR) continue;
+                    return -1;
+                }
+                if (n == 0) break;
+                done += n;
+                continue;
+            }
+            if (position < buffer_start || position >= buffer_start + filled) {
+                if (!refill()) return -1;
+                if (position >= buffer_start + filled) break;     // EOF
+            }
+            size_t offset = (size_t)(position - buffer_start);
+            size_t n = std::min(size - done, filled - offset);
+            memcpy(out + done, buffer.data() + offset, n);
+            done += n;
+            position += n;
+        }
+        timer.stop(done, done);
+        return done;
+    }
+
+    // Seguir leyendo desde offset
+    bool seek(uint64_t offset) {
+        if (mode != DIRECT_OFF) {
+            position = offset;
+            return true;
+        }
+        count_syscall();
+        return lseek(fd, offset, SEEK_SET) == (off_t)offset;
+    }
+};
+
+class DirectWriter {
+private:
+    int fd;
+    DirectMode mode;
+    PooledBuffer buffer;
+    size_t used;               // Bytes en el buffer, desde flushed
+    uint64_t flushed;          // Posición del byte 0 del buffer (alineada)
+    uint64_t synced;           // Hasta dónde se descartó de la caché (DONTNEED)
+    bool skipped;              // Algún hueco quedó sin escribir
+
+    bool pwrite_full(const unsigned char* data, size_t size, uint64_t offset) {
+        Throttle::global().charge_io(size);
+        size_t done = 0;
+        while (done < size) {
+            count_syscall();
+            ssize_t n = pwrite(fd, data + done, size - done, offset + done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                if (errno == EINVAL && mode == DIRECT_ON && set_direct(fd, false)) {
+                    mode = DIRECT_DONTNEED;
+                    continue;
+                }
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    // Escribir los primeros size bytes del buffer (múltiplo de
+    // DIRECT_ALIGNMENT salvo en finish()) y mover el resto al principio
+    bool flush(size_t size, FileStats* stats) {
+        StageTimer timer(stats, STAGE_WRITE);
+        if (size == 0) return true;
+        if (!pwrite_full(buffer.data(), size, flushed)) return false;
+        if (mode == DIRECT_DONTNEED) {
+            // Este tramo se manda a escribir sin esperar; lo anterior ya se
+            // mandó en el tramo previo: se espera a que termine y se descarta
+            count_syscall(3);
+            sync_file_range(fd, flushed, size, SYNC_FILE_RANGE_WRITE);
+            if (flushed > synced) {
+                sync_file_range(fd, synced, flushed - synced,
+                                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+                posix_fadvise(fd, synced, flushed - synced, POSIX_FADV_DONTNEED);
+                synced = flushed;
+            }
+        }
+        flushed += size;
+        memmove(buffer.data(), buffer.data() + size, used - size);
+        used -= size;
+        timer.stop(size, size);
+        return true;
+    }
+
+    // Ceros que no se pueden saltar sin romper la alineación
+    bool put_zeros(uint64_t size, FileStats* stats) {
+        while (size > 0) {
+            size_t n = (size_t)std::min<uint64_t>(size, DIRECT_CHUNK - used);
+            memset(buffer.data() + used, 0, n);
+            used += n;
+            size -= n;
+            if (used == DIRECT_CHUNK && !flush(DIRECT_CHUNK, stats)) return false;
+        }
+        return true;
+    }
+
+public:
+    DirectWriter(int file, DirectMode direct_mode)
+        : fd(file), mode(direct_mode), used(0), flushed(0), synced(0), skipped(false) {
+        if (mode != DIRECT_OFF) buffer.reserve(DIRECT_CHUNK);
+    }
+
+    DirectWriter(const DirectWriter&) = delete;
+    DirectWriter& operator=(const DirectWriter&) = delete;
+
+    bool valid() const { return mode == DIRECT_OFF || buffer.valid(); }
+    size_t footprint() const { return buffer.capacity(); }
+
+    // Escribir todo, como write_full()
+    bool write(const unsigned char* data, size_t size, FileStats* stats = nullptr) {
+        if (mode == DIRECT_OFF) {
+            StageTimer timer(stats, STAGE_WRITE);
+            size_t done = 0;
+            while (done < size) {
+                size_t want = Throttle::global().grant_io(size - done);
+                count_syscall();
+                ssize_t n = ::write(fd, data + done, want);
+                if (n == -1) {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                done += n;
+            }
+            timer.stop(size, size);
+            return true;
+        }
+        while (size > 0) {
+            size_t n = std::min(size, DIRECT_CHUNK - used);
+            memcpy(buffer.data() + used, data, n);
+            used += n;
+            data += n;
+            size -= n;
+            if (used == DIRECT_CHUNK && !flush(DIRECT_CHUNK, stats)) return false;
+        }
+        return true;
+    }
+
+    // Dejar size bytes de ceros como hueco (sin escribirlos) donde se pueda.
+    // En un pipe se escriben los ceros
+    bool skip(uint64_t size, FileStats* stats = nullptr) {
+        if (mode == DIRECT_OFF) {
+            count_syscall();
+            if (lseek(fd, size, SEEK_CUR) != -1) {
+                skipped = true;
+                return true;
+            }
+            static const unsigned char ZEROS[64 << 10] = {0};
+            while (size > 0) {
+                size_t n = (size_t)std::min<uint64_t>(size, sizeof(ZEROS));
+                if (!write(ZEROS, n, stats)) return false;
+                size -= n;
+            }
+            return true;
+        }
+        // Completar el bloque lógico en curso; el resto alineado se salta
+        uint64_t position = flushed + used;
+        uint64_t lead = std::min<uint64_t>(size, (DIRECT_ALIGNMENT - position % DIRECT_ALIGNMENT) % DIRECT_ALIGNMENT);
+        if (!put_zeros(lead, stats)) return false;
+        size -= lead;
+        uint64_t whole = size / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+        if (whole > 0) {
+            if (!flush(used, stats)) return false;
+            flushed += whole;
+            skipped = true;
+        }
+        return put_zeros(size - whole, stats);
+    }
+
+    // Seguir escribiendo desde offset (--resume): lo que ya hay en el
+    // archivo hasta offset se conserva
+    bool resume_at(uint64_t offset) {
+        if (mode == DIRECT_OFF) {
+            count_syscall();
+            return lseek(fd, offset, SEEK_SET) == (off_t)offset;
+        }
+        // El bloque lógico a medio llenar vuelve al buffer
+        flushed = offset / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+        synced = flushed;
+        used = (size_t)(offset - flushed);
+        size_t done = 0;
+        while (done < used) {
+            count_syscall();
+            ssize_t n = pread(fd, buffer.data() + done, DIRECT_ALIGNMENT - done, flushed + done);
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += n;
+        }
+        return true;
+    }
+
+    // Forzar a disco todo lo escrito hasta ahora (punto de control). Con
+    // O_DIRECT la parte del buffer que no llena un bloque lógico se escribe
+    // sin O_DIRECT y queda en el buffer: el próximo tramo la vuelve a escribir
+    bool sync(FileStats* stats = nullptr) {
+        if (mode != DIRECT_OFF) {
+            if (!flush(used / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT, stats)) return false;
+            if (used > 0) {
+                if (mode == DIRECT_ON && !set_direct(fd, false)) return false;
+                if (!pwrite_full(buffer.data(), used, flushed)) return false;
+                if (mode == DIRECT_ON && !set_direct(fd, true)) return false;
+            }
+        }
+        count_syscall();
+        if (fdatasync(fd) != 0) return false;
+        if (mode != DIRECT_OFF) {
+            count_syscall();
+            posix_fadvise(fd, synced, 0, POSIX_FADV_DONTNEED);
+        }
+        return true;
+    }
+
+    // Escribir lo pendiente y dejar el archivo con total bytes. Después de
+    // esto el descriptor ya no usa O_DIRECT (se puede parchear la cabecera)
+    bool finish(uint64_t total, FileStats* stats = nullptr) {
+        if (mode != DIRECT_OFF) {
+            size_t aligned = used / DIRECT_ALIGNMENT * DIRECT_ALIGNMENT;
+            if (!flush(aligned, stats)) return false;
+            if (mode == DIRECT_ON && !set_direct(fd, false)) return false;
+            if (!flush(used, stats)) return false;
+        }
+        if (skipped || (mode != DIRECT_OFF && flushed != total)) {
+            count_syscall();
+            if (ftruncate(fd, total) != 0) return false;
+        }
+        if (mode != DIRECT_OFF) {
+            // La cola (y lo que faltaba descartar) pasó por la caché
+            count_syscall(2);
+            fdatasync(fd);
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        }
+        return true;
+    }
+
+    // Reescribir bytes ya escritos (la cabecera), solo después de finish()
+    bool rewrite(uint64_t offset, const unsigned char* data, size_t size) {
+        count_syscall();
+        if (pwrite(fd, data, size, offset) != (ssize_t)size) return false;
+        if (mode != DIRECT_OFF) {
+            count_syscall(2);
+            fdatasync(fd);
+            posix_fadvise(fd, offset, size, POSIX_FADV_DONTNEED);
+        }
+        return true;
+    }
+};
+
+#endif // GSEA_DIRECT_IO_H
@@ -0,0 +1,98 @@
+#ifndef GSEA_LIB_H
+#define GSEA_LIB_H
+
+/*
+ * libgsea: compresión y cifrado de GSEA como biblioteca (make lib)
+ *
+ * Produce y lee el mismo formato que el ejecutable (cabecera de contenedor
+ * y bloques con CRC32C): lo que escribe la biblioteca se abre con
+ * gsea -d/-du y viceversa. Todo trabaja sobre buffers del llamador:
+ *
+ *   - Buffer a buffer: gsea_compress() / gsea_decompress(). El tamaño de la
+ *     salida sale de gsea_compress_bound() y de gsea_decompressed_size()
+ *   - Por tramos: gsea_encode_begin()/gsea_encode_update() y
+ *     gsea_decode_begin()/gsea_decode_update(), con cualquier tamaño de
+ *     entrada y salida en cada llamado
+ *
+ * Un contexto (gsea_ctx) guarda los buffers de un bloque y el estado de los
+ * códecs: se reserva al crearlo y se reutiliza, así que comprimir y
+ * descomprimir no piden memoria (salvo la primera vez que se lee un archivo
+ * con bloques más grandes que los del nivel del contexto). Cada hilo debe
+ * usar su propio contexto; contextos distintos no comparten nada mutable.
+ * La biblioteca no escribe nada en stdout ni stderr: los errores son los
+ * códigos de retorno.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GSEA_API __attribute__((visibility("default")))
+
+#define GSEA_LEVEL_NONE 0       /* Sin compresión: solo bloques con CRC (y cifrado) */
+#define GSEA_LEVEL_MIN 1
+#define GSEA_LEVEL_DEFAULT 2
+#define GSEA_LEVEL_MAX 9
+
+enum gsea_status {
+    GSEA_OK = 0,                /* Listo (por tramos: falta entrada o espacio) */
+    GSEA_END = 1,               /* Por tramos: la salida está completa */
+    GSEA_ERR_ARGS = -1,         /* Argumento inválido o llamado fuera de orden */
+    GSEA_ERR_DST_TOO_SMALL = -2,
+    GSEA_ERR_FORMAT = -3,       /* No es un archivo de GSEA por bloques (o es de otra versión, un delta o tiene huecos) */
+    GSEA_ERR_CORRUPT = -4,      /* CRC o flujo comprimido inválido, o datos truncados */
+    GSEA_ERR_KEY = -5,          /* Cifrado sin clave en el contexto, o clave incorrecta */
+    GSEA_ERR_NOMEM = -6,
+    GSEA_ERR_SIZE = -7          /* La entrada no coincide con el tamaño declarado */
+};
+
+typedef struct gsea_ctx gsea_ctx;
+
+/*
+ * Contexto para comprimir con level (GSEA_LEVEL_NONE..GSEA_LEVEL_MAX) y,
+ * si key no es NULL, cifrar con esa clave. La misma clave sirve para
+ * descomprimir archivos cifrados. Retorna NULL sin memoria o con un nivel
+ * inválido
+ */
+GSEA_API gsea_ctx* gsea_ctx_new(int level, const void* key, size_t key_size);
+GSEA_API void gsea_ctx_free(gsea_ctx* ctx);
+
+/* Bytes máximos que ocupa src_size bytes comprimidos con ese nivel */
+GSEA_API size_t gsea_compress_bound(size_t src_size, int level);
+
+/* Comprimir (y cifrar) src completo en dst. *dst_size = bytes escritos */
+GSEA_API int gsea_compress(gsea_ctx* ctx, const void* src, size_t src_size,
+                           void* dst, size_t dst_capacity, size_t* dst_size);
+
+/* Tamaño original según la cabecera (alcanzan los primeros 255 bytes) */
+GSEA_API int gsea_decompressed_size(const void* src, size_t src_size, uint64_t* size);
+
+/* Descomprimir (y descifrar) src completo en dst. *dst_size = bytes escritos */
+GSEA_API int gsea_decompress(gsea_ctx* ctx, const void* src, size_t src_size,
+                             void* dst, size_t dst_capacity, size_t* dst_size);
+
+/*
+ * Por tramos. total_size es el tamaño original completo (va en la
+ * cabecera). En cada update, *src_size y *dst_size entran con lo disponible
+ * y salen con lo consumido y lo escrito; se llama hasta que retorne
+ * GSEA_END (con finish != 0 una vez entregada toda la entrada) o un error
+ */
+GSEA_API int gsea_encode_begin(gsea_ctx* ctx, uint64_t total_size);
+GSEA_API int gsea_encode_update(gsea_ctx* ctx, const void* src, size_t* src_size,
+                                void* dst, size_t* dst_size, int finish);
+
+GSEA_API int gsea_decode_begin(gsea_ctx* ctx);
+GSEA_API int gsea_decode_update(gsea_ctx* ctx, const void* src, size_t* src_size,
+                                void* dst, size_t* dst_size);
+
+/* Texto de un código de retorno (estático) */
+GSEA_API const char* gsea_strerror(int status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GSEA_LIB_H */
@@ -0,0 +1,199 @@
+#ifndef GSEA_HASH_H
+#define GSEA_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <vector>
+
+// Hash rápido de contenido (NO criptográfico)
+// Procesa 8 bytes por iteración: mezcla multiplicativa + rotación,
+// con un avalancha final estilo "fmix64" (MurmurHash3).
+// Se usa para detectar si el contenido de un archivo cambió.
+class Hash64 {
+private:
+    static const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    static const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+
+    uint64_t state;              // Estado acumulado
+    uint64_t total_length;       // Bytes procesados en total
+    unsigned char tail[8];       // Bytes pendientes (menos de 8)
+    size_t tail_size;
+
+    static uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    void mix_word(uint64_t word) {
+        state ^= rotl(word * PRIME2, 31) * PRIME1;
+        state = rotl(state, 27) * PRIME1 + PRIME2;
+    }
+
+public:
+    explicit Hash64(uint64_t seed = 0)
+        : state(seed ^ PRIME1), total_length(0), tail_size(0) {}
+
+    // Agregar bytes al hash (se puede llamar varias veces, por bloques)
+    void update(const unsigned char* data, size_t size) {
+        total_length += size;
+
+        // Completar primero los bytes pendientes de la llamada anterior
+        if (tail_size > 0) {
+            size_t take = size < 8 - tail_size ? size : 8 - tail_size;
+            memcpy(tail + tail_size, data, take);
+            tail_size += take;
+            data += take;
+            size -= take;
+            if (tail_size < 8) return;
+            uint64_t word;
+            memcpy(&word, tail, 8);
+            mix_word(word);
+            tail_size = 0;
+        }
+
+        // Bucle principal: 8 bytes por iteración
+        while (size >= 8) {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            mix_word(word);
+            data += 8;
+            size -= 8;
+        }
+
+        // Guardar el resto para la próxima llamada (tail_size es 0 y size < 8)
+        memcpy(tail, data, size);
+        tail_size = size;
+    }
+
+    // Obtener el valor final (no modifica el estado)
+    uint64_t digest() const {
+        uint64_t h = state;
+        uint64_t last = 0;
+        for (size_t i = 0; i < tail_size; i++) {
+            last |= (uint64_t)tail[i] << (8 * i);
+        }
+        h ^= rotl(last * PRIME2, 31) * PRIME1;
+        h ^= total_length;
+
+        // Avalancha final
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Atajo para calcular el hash de un buffer completo
+    static uint64_t of(const unsigned char* data, size_t size, uint64_t seed = 0) {
+        Hash64 h(seed);
+        h.update(data, size);
+        return h.digest();
+    }
+};
+
+// Hash de contenido que no recorre los huecos (--incremental con archivos
+// dispersos)
+//
+// El contenido se mira en unidades alineadas de UNIT bytes: las que son todo
+// ceros no pasan por Hash64 byte a byte, se cuentan, y cada racha entra al
+// hash como su longitud. Da lo mismo si esos ceros se leyeron o se saltaron
+// como hueco (skip_zeros()), así que un hueco cuesta O(1) y el resultado no
+// depende de cómo se leyó el archivo. Los bytes de una unidad incompleta (al
+// final) entran tal cual.
+class ContentHash {
+public:
+    static const size_t UNIT = 64 << 10;
+
+private:
+    Hash64 hasher;
+    uint64_t zero_units;         // Racha de unidades en cero aún sin mezclar
+    std::vector<unsigned char> unit;    // Unidad incompleta (se reserva al usarla)
+    size_t pending;              // Bytes en unit
+
+    static bool all_zeros(const unsigned char* data) {
+        for (size_t i = 0; i < UNIT; i += 8) {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            if (word != 0) return false;
+        }
+        return true;
+    }
+
+    // Mezclar la racha pendiente: un marcador y su longitud en unidades
+    static void mix_zero_run(Hash64& h, uint64_t units) {
+        unsigned char record[16] = {'G', 'S', 'E', 'A', 'Z', 'E', 'R', 'O'};
+        memcpy(record + 8, &units, 8);
+        h.update(record, sizeof(record));
+    }
+
+    void add_unit(const unsigned char* data) {
+        if (all_zeros(data)) {
+            zero_units++;
+            return;
+        }
+        if (zero_units > 0) {
+            mix_zero_run(hasher, zero_units);
+            zero_units = 0;
+        }
+        hasher.update(data, UNIT);
+    }
+
+public:
+    ContentHash() : zero_units(0), pending(0) {}
+
+    void update(const unsigned char* data, size_t size) {
+        while (size > 0) {
+            if (pending == 0 && size >= UNIT) {
+                add_unit(data);
+                data += UNIT;
+                size -= UNIT;
+                continue;
+            }
+            if (unit.empty()) unit.resize(UNIT);
+            size_t take = std::min(size, UNIT - pending);
+            memcpy(unit.data() + pending, data, take);
+            pending += take;
+            data += take;
+            size -= take;
+            if (pending == UNIT) {
+                add_unit(unit.data());
+                pending = 0;
+            }
+        }
+    }
+
+    // Sumar size ceros sin leerlos (un hueco del archivo). Alineado a UNIT,
+    // como los huecos que salta el procesamiento por bloques, es O(1)
+    void skip_zeros(uint64_t size) {
+        static const unsigned char ZEROS[4096] = {0};
+        while (size > 0 && pending > 0) {
+            size_t take = (size_t)std::min<uint64_t>(size, std::min(UNIT - pending, sizeof(ZEROS)));
+            update(ZEROS, take);
+            size -= take;
+        }
+        zero_units += size / UNIT;
+        size %= UNIT;
+        while (size > 0) {
+            size_t take = (size_t)std::min<uint64_t>(size, sizeof(ZEROS));
+            update(ZEROS, take);
+            size -= take;
+        }
+    }
+
+    uint64_t digest() const {
+        Hash64 h = hasher;
+        if (zero_units > 0) mix_zero_run(h, zero_units);
+        if (pending > 0) h.update(unit.data(), pending);
+        return h.digest();
+    }
+
+    static uint64_t of(const unsigned char* data, size_t size) {
+        ContentHash h;
+        h.update(data, size);
+        return h.digest();
+    }
+};
+
+#endif // GSEA_HASH_H
@@ -4,25 +4,28 @@
 //POSIX (obligado para los hilos) buscar, hacer funciones, caché y buffer 4k (4096)
 
 #include <vector>
-#include <map>
-#include <queue>
+#include <algorithm>
 #include <string>
 #include <iostream>
 #include <cstring>
+#include <cstdint>
+#include "log.h"
 
 // Nodo del árbol de Huffman
 struct HuffmanNode {
     unsigned char data;       // El carácter (solo relevante en hojas)
-    unsigned int frequency;   // Frecuencia de aparición
+    uint64_t frequency;       // Frecuencia de aparición (64 bits: archivos > 4 GB)
     HuffmanNode* left;        // Hijo izquierdo
     HuffmanNode* right;       // Hijo derecho
     
+    HuffmanNode() : data(0), frequency(0), left(nullptr), right(nullptr) {}
+    
     // Constructor para nodos hoja (con carácter)
-    HuffmanNode(unsigned char d, unsigned int f) 
+    HuffmanNode(unsigned char d, uint64_t f) 
         : data(d), frequency(f), left(nullptr), right(nullptr) {}
     
     // Constructor para nodos internos (sin carácter)
-    HuffmanNode(unsigned int f, HuffmanNode* l, HuffmanNode* r)
+    HuffmanNode(uint64_t f, HuffmanNode* l, HuffmanNode* r)
         : data(0), frequency(f), left(l), right(r) {}
     
     // Verificar si es una hoja
@@ -41,270 +44,631 @@ struct CompareNode {
 };
 
 // Clase para la compresión/descompresión Huffman
+//
+// Además de compress()/decompress() sobre un vector completo, expone las
+// etapas por separado para poder procesar archivos POR BLOQUES sin tenerlos
+// completos en memoria:
+//   compresión:    count_frequencies() → build() → write_header() → encode()* → finish_encode()
+//   descompresión: read_header() → decode()*
+//
+// El árbol vive en un arreglo fijo de nodos dentro del objeto (no hay un
+// new por nodo) y las variantes *_into() trabajan sobre buffers del
+// llamador: comprimir o descomprimir no reserva memoria en el heap.
 class HuffmanCoder {
 private:
+    // Con códigos de hasta 57 bits, el acumulador de 64 bits nunca se desborda
+    // (quedan como máximo 7 bits pendientes antes de agregar un código)
+    static const int MAX_CODE_LENGTH = 57;
+    
+    // 256 hojas + 255 nodos internos
+    static const int MAX_NODES = 511;
+    
+    HuffmanNode nodes[MAX_NODES];   // Almacenamiento de todos los nodos del árbol
+    int node_count;                 // Nodos usados de nodes[]
     HuffmanNode* root;  // Raíz del árbol de Huffman
-    std::map<unsigned char, std::string> huffman_codes;  // Mapeo: carácter -> código
+    uint64_t codes[256];                 // Código de cada byte (bits alineados a la derecha)
+    unsigned char code_lengths[256];     // Longitud en bits de cada código (0 = no aparece)
     
-    // Función auxiliar para liberar memoria del árbol
-    void delete_tree(HuffmanNode* node) {
-        if (node == nullptr) return;
-        delete_tree(node->left);
-        delete_tree(node->right);
-        delete node;
+    // Estado del codificador por bloques
+    uint64_t bit_buffer;    // Bits pendientes de escribir
+    int bit_count;          // Cantidad de bits pendientes
+    
+    // Estado del decodificador por bloques
+    HuffmanNode* decode_node;   // Nodo actual (un código puede cruzar bloques)
+    unsigned char padding;      // Bits de relleno del último byte
+    
+    // Descartar el árbol actual (los nodos se reutilizan)
+    void reset_tree() {
+        node_count = 0;
+        root = nullptr;
+    }
+    
+    // Tomar un nodo libre del arreglo (nullptr si se agotó: árbol inválido)
+    HuffmanNode* new_node(unsigned char d, uint64_t f, HuffmanNode* l, HuffmanNode* r) {
+        if (node_count >= MAX_NODES) return nullptr;
+        HuffmanNode* node = &nodes[node_count++];
+        node->data = d;
+        node->frequency = f;
+        node->left = l;
+        node->right = r;
+        return node;
     }
     
     // Función recursiva para generar los códigos Huffman
     // Recorre el árbol: izquierda = '0', derecha = '1'
-    void generate_codes(HuffmanNode* node, std::string code) {
-        if (node == nullptr) return;
+    // Retorna la profundidad máxima encontrada
+    int generate_codes(HuffmanNode* node, uint64_t code, int length) {
+        if (node == nullptr) return 0;
         
         // Si es una hoja, guardar el código para ese carácter
         if (node->is_leaf()) {
-            huffman_codes[node->data] = code;
-            return;
+            if (length <= MAX_CODE_LENGTH) {
+                codes[node->data] = code;
+                code_lengths[node->data] = length;
+            }
+            return length;
         }
         
         // Recorrer recursivamente: izquierda con '0', derecha con '1'
-        generate_codes(node->left, code + "0");
-        generate_codes(node->right, code + "1");
+        int left_depth = generate_codes(node->left, code << 1, length + 1);
+        int right_depth = generate_codes(node->right, (code << 1) | 1, length + 1);
+        return left_depth > right_depth ? left_depth : right_depth;
+    }
+    
+    // Profundidad de cada hoja (el largo de su código)
+    static void collect_lengths(const HuffmanNode* node, int depth, unsigned char lengths[256]) {
+        if (node == nullptr) return;
+        if (node->is_leaf()) {
+            lengths[node->data] = (unsigned char)depth;
+            return;
+        }
+        collect_lengths(node->left, depth + 1, lengths);
+        collect_lengths(node->right, depth + 1, lengths);
     }
     
     // Construir el árbol de Huffman a partir de las frecuencias
-    HuffmanNode* build_tree(const std::map<unsigned char, unsigned int>& frequencies) {
-        // Cola de prioridad (min-heap) para construir el árbol
-        std::priority_queue<HuffmanNode*, std::vector<HuffmanNode*>, CompareNode> pq;
+    HuffmanNode* build_tree(const uint64_t frequencies[256]) {
+        // Min-heap sobre un arreglo fijo: push_heap/pop_heap con el mismo
+        // comparador que std::priority_queue, así el árbol (y la salida) es
+        // idéntico al de la cola de prioridad, sin reservar memoria
+        HuffmanNode* heap[256];
+        size_t heap_size = 0;
+        CompareNode compare;
         
         // Crear un nodo hoja para cada carácter y agregarlo a la cola
-        for (const auto& pair : frequencies) {
-            pq.push(new HuffmanNode(pair.first, pair.second));
+        for (int i = 0; i < 256; i++) {
+            if (frequencies[i] > 0) {
+                heap[heap_size++] = new_node((unsigned char)i, frequencies[i], nullptr, nullptr);
+                std::push_heap(heap, heap + heap_size, compare);
+            }
         }
         
+        if (heap_size == 0) return nullptr;
+        
         // Caso especial: si solo hay un carácter único
-        if (pq.size() == 1) {
-            HuffmanNode* single = pq.top();
-            pq.pop();
+        if (heap_size == 1) {
+            HuffmanNode* single = heap[0];
             // Crear un nodo padre artificial para evitar código vacío
-            return new HuffmanNode(single->frequency, single, nullptr);
+            return new_node(0, single->frequency, single, nullptr);
         }
         
         // Construir el árbol combinando los dos nodos de menor frecuencia
-        while (pq.size() > 1) {
+        while (heap_size > 1) {
             // Extraer los dos nodos con menor frecuencia
-            HuffmanNode* left = pq.top();
-            pq.pop();
-            HuffmanNode* right = pq.top();
-            pq.pop();
+            std::pop_heap(heap, heap + heap_size, compare);
+            HuffmanNode* left = heap[--heap_size];
+            std::pop_heap(heap, heap + heap_size, compare);
+            HuffmanNode* right = heap[--heap_size];
             
             // Crear un nuevo nodo interno con la suma de frecuencias
-            unsigned int sum_freq = left->frequency + right->frequency;
-            HuffmanNode* parent = new HuffmanNode(sum_freq, left, right);
+            uint64_t sum_freq = left->frequency + right->frequency;
+            HuffmanNode* parent = new_node(0, sum_freq, left, right);
             
             // Insertar el nuevo nodo en la cola
-            pq.push(parent);
+            heap[heap_size++] = parent;
+            std::push_heap(heap, heap + heap_size, compare);
         }
         
         // El último nodo en la cola es la raíz del árbol
-        return pq.top();
+        return heap[0];
     }
     
     // Serializar el árbol para guardarlo en el archivo comprimido
     // Usamos preorden: (tipo)(data_si_es_hoja)(izquierdo)(derecho)
-    void serialize_tree(HuffmanNode* node, std::vector<unsigned char>& output) {
+    // Escribe en output (hasta MAX_TREE_SIZE bytes) y avanza index
+    void serialize_tree(HuffmanNode* node, unsigned char* output, size_t& index) {
         if (node == nullptr) return;
         
         if (node->is_leaf()) {
             // Marcador '1' indica que es hoja
-            output.push_back(1);
+            output[index++] = 1;
             // Guardar el carácter
-            output.push_back(node->data);
+            output[index++] = node->data;
         } else {
             // Marcador '0' indica que es nodo interno
-            output.push_back(0);
+            output[index++] = 0;
             // Serializar recursivamente los hijos
-            serialize_tree(node->left, output);
-            serialize_tree(node->right, output);
+            serialize_tree(node->left, output, index);
+            serialize_tree(node->right, output, index);
         }
     }
     
     // Deserializar el árbol desde el archivo comprimido
-    HuffmanNode* deserialize_tree(const std::vector<unsigned char>& data, size_t& index) {
-        if (index >= data.size()) return nullptr;
+    HuffmanNode* deserialize_tree(const unsigned char* data, size_t size, size_t& index) {
+        if (index >= size) return nullptr;
         
         unsigned char marker = data[index++];
         
         if (marker == 1) {
             // Es una hoja
-            if (index >= data.size()) return nullptr;
+            if (index >= size) return nullptr;
             unsigned char ch = data[index++];
-            return new HuffmanNode(ch, 0);
+            return new_node(ch, 0, nullptr, nullptr);
         } else {
             // Es un nodo interno
-            HuffmanNode* left = deserialize_tree(data, index);
-            HuffmanNode* right = deserialize_tree(data, index);
-            return new HuffmanNode(0, left, right);
+            HuffmanNode* left = deserialize_tree(data, size, index);
+            HuffmanNode* right = deserialize_tree(data, size, index);
+            return new_node(0, 0, left, right);
         }
     }
     
 public:
+    // Tamaño máximo del árbol serializado: 256 hojas (2 bytes) + 255 internos (1 byte)
+    static const size_t MAX_TREE_SIZE = 767;
+    
+    // Tamaño máximo de la cabecera: tamaño del árbol (4) + árbol + padding (1)
+    static const size_t MAX_HEADER_SIZE = 5 + MAX_TREE_SIZE;
+    
     // Constructor
-    HuffmanCoder() : root(nullptr) {}
+    HuffmanCoder() : node_count(0), root(nullptr), bit_buffer(0), bit_count(0),
+                     decode_node(nullptr), padding(0) {
+        memset(codes, 0, sizeof(codes));
+        memset(code_lengths, 0, sizeof(code_lengths));
+    }
     
-    // Destructor
-    ~HuffmanCoder() {
-        delete_tree(root);
+    // Los nodos se apuntan entre sí dentro de nodes[]: una copia apuntaría
+    // al árbol del original
+    HuffmanCoder(const HuffmanCoder&) = delete;
+    HuffmanCoder& operator=(const HuffmanCoder&) = delete;
+    
+    // Bytes de salida que compress_into() puede necesitar como máximo
+    // (un código de Huffman óptimo nunca supera 8 bits/byte en promedio)
+    static size_t compress_bound(size_t input_size) {
+        return MAX_HEADER_SIZE + input_size + 1;
     }
     
-    // COMPRIMIR: Convierte datos originales en datos comprimidos
-    std::vector<unsigned char> compress(const std::vector<unsigned char>& input) {
-        std::vector<unsigned char> output;
-        
-        // Caso especial: entrada vacía
-        if (input.empty()) {
-            return output;
-        }
-        
-        // PASO 1: Calcular frecuencias de cada byte
-        std::map<unsigned char, unsigned int> frequencies;
-        for (unsigned char byte : input) {
-            frequencies[byte]++;
+    // Bytes que encode() puede producir para un bloque aislado: un bloque
+    // concreto sí puede superar 8 bits/byte si contiene símbolos raros
+    static size_t encode_bound(size_t input_size) {
+        return (input_size * MAX_CODE_LENGTH) / 8 + 8;
+    }
+    
+    // Bytes que decode() puede producir: como máximo 1 símbolo por bit
+    static size_t decode_bound(size_t input_size) {
+        return input_size * 8;
+    }
+    
+    // ------------------------------------------------------------------------
+    // ETAPAS DE COMPRESIÓN
+    // ------------------------------------------------------------------------
+    
+    // Acumular las frecuencias de un bloque de datos
+    //
+    // Cuatro tablas parciales: bytes iguales seguidos (texto, relleno) no
+    // esperan cada uno a que termine el incremento del anterior sobre el
+    // mismo contador. Los parciales son de 32 bits, así que se vuelcan a
+    // frequencies cada COUNT_SPAN bytes.
+    static void count_frequencies(const unsigned char* data, size_t size, uint64_t frequencies[256]) {
+        static const size_t COUNT_SPAN = (size_t)1 << 30;
+        uint32_t partial[4][256];
+        
+        while (size > 0) {
+            size_t span = std::min(size, COUNT_SPAN);
+            memset(partial, 0, sizeof(partial));
+            
+            size_t i = 0;
+            for (; i + 8 <= span; i += 8) {
+                uint64_t word;
+                memcpy(&word, data + i, sizeof(word));
+                partial[0][word & 0xFF]++;
+                partial[1][(word >> 8) & 0xFF]++;
+                partial[2][(word >> 16) & 0xFF]++;
+                partial[3][(word >> 24) & 0xFF]++;
+                partial[0][(word >> 32) & 0xFF]++;
+                partial[1][(word >> 40) & 0xFF]++;
+                partial[2][(word >> 48) & 0xFF]++;
+                partial[3][word >> 56]++;
+            }
+            for (; i < span; i++) {
+                partial[0][data[i]]++;
+            }
+            
+            for (int s = 0; s < 256; s++) {
+                frequencies[s] += (uint64_t)partial[0][s] + partial[1][s] + partial[2][s] + partial[3][s];
+            }
+            data += span;
+            size -= span;
         }
-        
-        std::cout << "  → Frecuencias calculadas para " << frequencies.size() 
-                  << " símbolos únicos\n";
-        
-        // PASO 2: Construir el árbol de Huffman
-        root = build_tree(frequencies);
-        
-        // PASO 3: Generar los códigos Huffman
-        huffman_codes.clear();
-        generate_codes(root, "");
-        
-        std::cout << "  → Códigos Huffman generados\n";
-        
-        // Mostrar algunos códigos (solo para debug)
-        if (huffman_codes.size() <= 10) {
-            for (const auto& pair : huffman_codes) {
-                std::cout << "     '" << (char)pair.first << "' -> " 
-                          << pair.second << "\n";
+    }
+    
+    // Construir el árbol y la tabla de códigos a partir de las frecuencias
+    // Retorna false si no hay ningún símbolo
+    bool build(const uint64_t frequencies[256]) {
+        uint64_t scaled[256];
+        memcpy(scaled, frequencies, sizeof(scaled));
+        
+        while (true) {
+            reset_tree();
+            memset(codes, 0, sizeof(codes));
+            memset(code_lengths, 0, sizeof(code_lengths));
+            
+            root = build_tree(scaled);
+            if (root == nullptr) return false;
+            
+            if (generate_codes(root, 0, 0) <= MAX_CODE_LENGTH) break;
+            
+            // Distribución extremadamente sesgada (solo posible con archivos
+            // enormes): se reducen las frecuencias a la mitad sin que ningún
+            // símbolo desaparezca, lo que acorta el árbol. El árbol sigue
+            // siendo válido, solo un poco menos óptimo.
+            for (int i = 0; i < 256; i++) {
+                if (scaled[i] > 0) scaled[i] = (scaled[i] + 1) / 2;
             }
         }
         
-        // PASO 4: Serializar el árbol en el output
-        std::vector<unsigned char> tree_data;
-        serialize_tree(root, tree_data);
-        
-        // Guardar el tamaño del árbol serializado (4 bytes)
-        unsigned int tree_size = tree_data.size();
-        output.push_back((tree_size >> 24) & 0xFF);
-        output.push_back((tree_size >> 16) & 0xFF);
-        output.push_back((tree_size >> 8) & 0xFF);
-        output.push_back(tree_size & 0xFF);
-        
-        // Agregar el árbol serializado
-        output.insert(output.end(), tree_data.begin(), tree_data.end());
-        
-        // PASO 5: Codificar los datos usando los códigos Huffman
-        std::string encoded_bits;
-        for (unsigned char byte : input) {
-            encoded_bits += huffman_codes[byte];
+        bit_buffer = 0;
+        bit_count = 0;
+        return true;
+    }
+    
+    // Cantidad total de bits que producirá encode() con estas frecuencias
+    uint64_t encoded_bits(const uint64_t frequencies[256]) const {
+        uint64_t total = 0;
+        for (int i = 0; i < 256; i++) {
+            total += frequencies[i] * code_lengths[i];
         }
+        return total;
+    }
+    
+    // Escribir la cabecera: tamaño del árbol (4 bytes), árbol y padding
+    // output debe tener MAX_HEADER_SIZE bytes libres. Retorna los bytes escritos
+    size_t write_header(unsigned char* output, uint64_t total_bits) {
+        // Serializar el árbol directamente detrás de los 4 bytes del tamaño
+        size_t index = 4;
+        serialize_tree(root, output, index);
         
-        // Guardar la cantidad de bits válidos en el último byte
-        unsigned char padding = (8 - (encoded_bits.length() % 8)) % 8;
-        output.push_back(padding);
-        
-        // Convertir la cadena de bits a bytes
-        for (size_t i = 0; i < encoded_bits.length(); i += 8) {
-            unsigned char byte = 0;
-            for (int j = 0; j < 8 && i + j < encoded_bits.length(); j++) {
-                if (encoded_bits[i + j] == '1') {
-                    byte |= (1 << (7 - j));
-                }
+        // Guardar el tamaño del árbol serializado (4 bytes)
+        uint32_t tree_size = (uint32_t)(index - 4);
+        output[0] = (tree_size >> 24) & 0xFF;
+        output[1] = (tree_size >> 16) & 0xFF;
+        output[2] = (tree_size >> 8) & 0xFF;
+        output[3] = tree_size & 0xFF;
+        
+        // Guardar la cantidad de bits de relleno del último byte
+        output[index++] = (unsigned char)((8 - (total_bits % 8)) % 8);
+        return index;
+    }
+    
+    void write_header(std::vector<unsigned char>& output, uint64_t total_bits) {
+        unsigned char header[MAX_HEADER_SIZE];
+        size_t size = write_header(header, total_bits);
+        output.insert(output.end(), header, header + size);
+    }
+    
+    // Codificar un bloque de datos, escribiendo los bytes completos en output
+    // (con encode_bound(size) bytes libres). Retorna los bytes escritos
+    // Los bits sobrantes quedan pendientes para el siguiente bloque
+    size_t encode(const unsigned char* data, size_t size, unsigned char* output) {
+        uint64_t buffer = bit_buffer;
+        int count = bit_count;
+        size_t written = 0;
+        
+        for (size_t i = 0; i < size; i++) {
+            unsigned char byte = data[i];
+            buffer = (buffer << code_lengths[byte]) | codes[byte];
+            count += code_lengths[byte];
+            
+            // Vaciar los bytes completos (bit más significativo primero)
+            while (count >= 8) {
+                count -= 8;
+                output[written++] = (unsigned char)(buffer >> count);
             }
-            output.push_back(byte);
         }
         
-        std::cout << "  → Compresión completada: " << input.size() 
-                  << " bytes → " << output.size() << " bytes\n";
-        std::cout << "  → Ratio: " << (100.0 * output.size() / input.size()) 
-                  << "%\n";
-        
-        return output;
+        bit_buffer = buffer;
+        bit_count = count;
+        return written;
     }
     
-    // DESCOMPRIMIR: Convierte datos comprimidos en datos originales
-    std::vector<unsigned char> decompress(const std::vector<unsigned char>& input) {
-        std::vector<unsigned char> output;
-        
-        if (input.size() < 5) {
-            std::cerr << "Error: Archivo comprimido demasiado pequeño\n";
-            return output;
+    void encode(const unsigned char* data, size_t size, std::vector<unsigned char>& output) {
+        size_t start = output.size();
+        output.resize(start + encode_bound(size));
+        output.resize(start + encode(data, size, output.data() + start));
+    }
+    
+    // Bits de relleno que tendrá el último byte si el flujo termina aquí
+    // (para completar la cabecera cuando no se conocía el total de bits)
+    int pending_padding() const { return (8 - bit_count) % 8; }
+    
+    // Escribir el último byte parcial (rellenado con ceros a la derecha)
+    // Retorna los bytes escritos (0 o 1)
+    size_t finish_encode(unsigned char* output) {
+        size_t written = 0;
+        if (bit_count > 0) {
+            output[written++] = (unsigned char)(bit_buffer << (8 - bit_count));
         }
+        bit_buffer = 0;
+        bit_count = 0;
+        return written;
+    }
+    
+    void finish_encode(std::vector<unsigned char>& output) {
+        unsigned char last;
+        if (finish_encode(&last) > 0) {
+            output.push_back(last);
+        }
+    }
+    
+    // ------------------------------------------------------------------------
+    // ETAPAS DE DESCOMPRESIÓN
+    // ------------------------------------------------------------------------
+    
+    // Largo del código de cada símbolo según el árbol actual (0 = no aparece)
+    // Tras read_header() solo se tiene el árbol, no la tabla de códigos
+    void tree_code_lengths(unsigned char lengths[256]) const {
+        memset(lengths, 0, 256);
+        collect_lengths(root, 0, lengths);
+    }
+    
+    // Bits de relleno del último byte, según la cabecera leída
+    int get_padding() const { return padding; }
+
+    // Raíz del árbol leído (para decodificar desde otros hilos: el árbol no
+    // cambia hasta el próximo read_header() o build())
+    const HuffmanNode* tree_root() const { return root; }
+    
+    // Leer la cabecera (tamaño del árbol, árbol y padding)
+    // Retorna: 1 = lista (consumed = bytes usados), 0 = faltan bytes, -1 = inválida
+    int read_header(const unsigned char* data, size_t size, size_t& consumed) {
+        if (size < 5) return 0;
         
         size_t index = 0;
         
         // PASO 1: Leer el tamaño del árbol serializado
-        unsigned int tree_size = 0;
-        tree_size |= ((unsigned int)input[index++] << 24);
-        tree_size |= ((unsigned int)input[index++] << 16);
-        tree_size |= ((unsigned int)input[index++] << 8);
-        tree_size |= ((unsigned int)input[index++]);
-        
-        if (index + tree_size >= input.size()) {
-            std::cerr << "Error: Tamaño de árbol inválido\n";
-            return output;
+        uint32_t tree_size = 0;
+        tree_size |= ((uint32_t)data[index++] << 24);
+        tree_size |= ((uint32_t)data[index++] << 16);
+        tree_size |= ((uint32_t)data[index++] << 8);
+        tree_size |= ((uint32_t)data[index++]);
+        
+        if (tree_size == 0 || tree_size > MAX_TREE_SIZE) {
+            GSEA_ERROR("Error: Tamaño de árbol inválido\n");
+            return -1;
         }
+        if (index + tree_size >= size) return 0;
         
-        // PASO 2: Deserializar el árbol
-        delete_tree(root);
-        root = deserialize_tree(input, index);
+        // PASO 2: Deserializar el árbol (sin pasar del final del árbol: un
+        // árbol de un solo símbolo es un nodo interno sin hijo derecho)
+        reset_tree();
+        root = deserialize_tree(data, index + tree_size, index);
         
-        if (root == nullptr) {
-            std::cerr << "Error: No se pudo reconstruir el árbol\n";
-            return output;
+        if (root == nullptr || root->is_leaf()) {
+            GSEA_ERROR("Error: No se pudo reconstruir el árbol\n");
+            return -1;
         }
         
-        std::cout << "  → Árbol de Huffman reconstruido\n";
-        
         // PASO 3: Leer el padding
-        unsigned char padding = input[index++];
+        if (index >= size) return 0;
+        padding = data[index++];
+        if (padding > 7) {
+            GSEA_ERROR("Error: Padding inválido\n");
+            return -1;
+        }
         
-        // PASO 4: Decodificar los datos
-        HuffmanNode* current = root;
+        decode_node = root;
+        consumed = index;
+        return 1;
+    }
+    
+    // Decodificar un bloque de bits comprimidos en output (capacity bytes)
+    // is_last indica que data termina en el último byte del flujo (con padding)
+    // produced recibe los bytes escritos
+    bool decode(const unsigned char* data, size_t size, bool is_last,
+                unsigned char* output, size_t capacity, size_t& produced) {
+        HuffmanNode* current = decode_node;
+        size_t written = 0;
         
         // Procesar cada byte de datos comprimidos
-        for (size_t i = index; i < input.size(); i++) {
-            unsigned char byte = input[i];
+        for (size_t i = 0; i < size; i++) {
+            unsigned char byte = data[i];
             
             // Procesar cada bit del byte
             int bits_to_process = 8;
             // En el último byte, ignorar el padding
-            if (i == input.size() - 1) {
+            if (is_last && i == size - 1) {
                 bits_to_process = 8 - padding;
             }
             
             for (int j = 0; j < bits_to_process; j++) {
-                // Leer el bit más significativo
-                bool bit = (byte & (1 << (7 - j))) != 0;
-                
                 // Navegar por el árbol: 0=izquierda, 1=derecha
-                if (bit) {
-                    current = current->right;
-                } else {
-                    current = current->left;
+                current = (byte & (1 << (7 - j))) ? current->right : current->left;
+                
+                if (current == nullptr) {
+                    GSEA_ERROR("Error: Flujo comprimido dañado\n");
+                    return false;
                 }
                 
                 // Si llegamos a una hoja, tenemos un carácter completo
                 if (current->is_leaf()) {
-                    output.push_back(current->data);
+                    // Más símbolos de los que caben: flujo dañado o cabecera falsa
+                    if (written == capacity) {
+                        GSEA_ERROR("Error: Buffer de salida insuficiente\n");
+                        return false;
+                    }
+                    output[written++] = current->data;
                     current = root;  // Volver a la raíz
                 }
             }
         }
         
-        std::cout << "  → Descompresión completada: " << input.size() 
-                  << " bytes → " << output.size() << " bytes\n";
+        decode_node = current;
+        produced = written;
+        return true;
+    }
+    
+    bool decode(const unsigned char* data, size_t size, bool is_last, std::vector<unsigned char>& output) {
+        // Decodificar por tramos en un buffer local para no reservar 8x la entrada
+        static const size_t SLICE = 4096;
+        unsigned char slice_out[SLICE * 8];
+        size_t offset = 0;
+        do {
+            size_t n = std::min(SLICE, size - offset);
+            size_t produced = 0;
+            if (!decode(data + offset, n, is_last && offset + n == size,
+                        slice_out, sizeof(slice_out), produced)) {
+                return false;
+            }
+            output.insert(output.end(), slice_out, slice_out + produced);
+            offset += n;
+        } while (offset < size);
+        return true;
+    }
+    
+    // ------------------------------------------------------------------------
+    // API DE BUFFER COMPLETO
+    // ------------------------------------------------------------------------
+    
+    // COMPRIMIR en un buffer del llamador (capacity >= compress_bound(size))
+    // Retorna los bytes escritos (0 = error)
+    size_t compress_into(const unsigned char* input, size_t size, unsigned char* output, size_t capacity) {
+        // Caso especial: entrada vacía
+        if (size == 0) {
+            return 0;
+        }
+        
+        // PASO 1: Calcular frecuencias de cada byte
+        uint64_t frequencies[256] = {0};
+        count_frequencies(input, size, frequencies);
+        
+        int unique = 0;
+        for (int i = 0; i < 256; i++) {
+            if (frequencies[i] > 0) unique++;
+        }
+        GSEA_VERBOSE("  → Frecuencias calculadas para " << unique 
+                     << " símbolos únicos\n");
+        
+        // PASO 2 y 3: Construir el árbol de Huffman y generar los códigos
+        build(frequencies);
+        
+        GSEA_VERBOSE("  → Códigos Huffman generados\n");
+        
+        // Mostrar algunos códigos (solo con -vv)
+        if (unique <= 10 && Log::enabled(LOG_LEVEL_DEBUG)) {
+            for (int i = 0; i < 256; i++) {
+                if (code_lengths[i] == 0) continue;
+                std::string bits;
+                for (int b = code_lengths[i] - 1; b >= 0; b--) {
+                    bits += ((codes[i] >> b) & 1) ? '1' : '0';
+                }
+                GSEA_DEBUG("     '" << (char)i << "' -> " << bits << "\n");
+            }
+        }
+        
+        // El tamaño final se conoce de antemano: se verifica que quepa
+        uint64_t total_bits = encoded_bits(frequencies);
+        if (MAX_HEADER_SIZE + (total_bits + 7) / 8 > capacity) {
+            GSEA_ERROR("Error: Buffer de salida insuficiente para la compresión\n");
+            return 0;
+        }
+        
+        // PASO 4: Serializar el árbol en el output
+        size_t written = write_header(output, total_bits);
+        
+        // PASO 5: Codificar los datos usando los códigos Huffman
+        written += encode(input, size, output + written);
+        written += finish_encode(output + written);
+        
+        GSEA_VERBOSE("  → Compresión completada: " << size 
+                     << " bytes → " << written << " bytes\n");
+        GSEA_VERBOSE("  → Ratio: " << (100.0 * written / size) 
+                     << "%\n");
+        
+        return written;
+    }
+    
+    // DESCOMPRIMIR en un buffer del llamador
+    // capacity >= decode_bound(size) garantiza que cualquier flujo válido entra
+    bool decompress_into(const unsigned char* input, size_t size,
+                         unsigned char* output, size_t capacity, size_t& output_size) {
+        if (size < 5) {
+            GSEA_ERROR("Error: Archivo comprimido demasiado pequeño\n");
+            return false;
+        }
+        
+        size_t index = 0;
+        int header = read_header(input, size, index);
+        if (header == 0) {
+            GSEA_ERROR("Error: Tamaño de árbol inválido\n");
+        }
+        if (header != 1) {
+            return false;
+        }
+        
+        GSEA_VERBOSE("  → Árbol de Huffman reconstruido\n");
+        
+        // PASO 4: Decodificar los datos
+        if (!decode(input + index, size - index, true, output, capacity, output_size)) {
+            return false;
+        }
+        
+        GSEA_VERBOSE("  → Descompresión completada: " << size 
+                     << " bytes → " << output_size << " bytes\n");
+        
+        return true;
+    }
+    
+    // COMPRIMIR: Convierte datos originales en datos comprimidos
+    std::vector<unsigned char> compress(const std::vector<unsigned char>& input) {
+        std::vector<unsigned char> output;
+        
+        // Caso especial: entrada vacía
+        if (input.empty()) {
+            return output;
+        }
+        
+        output.resize(compress_bound(input.size()));
+        output.resize(compress_into(input.data(), input.size(), output.data(), output.size()));
+        return output;
+    }
+    
+    // DESCOMPRIMIR: Convierte datos comprimidos en datos originales
+    std::vector<unsigned char> decompress(const std::vector<unsigned char>& input) {
+        std::vector<unsigned char> output;
+        
+        if (input.size() < 5) {
+            GSEA_ERROR("Error: Archivo comprimido demasiado pequeño\n");
+            return output;
+        }
+        
+        size_t index = 0;
+        int header = read_header(input.data(), input.size(), index);
+        if (header == 0) {
+            GSEA_ERROR("Error: Tamaño de árbol inválido\n");
+        }
+        if (header != 1) {
+            return output;
+        }
+        
+        GSEA_VERBOSE("  → Árbol de Huffman reconstruido\n");
+        
+        // PASO 4: Decodificar los datos
+        if (!decode(input.data() + index, input.size() - index, true, output)) {
+            output.clear();
+            return output;
+        }
+        
+        GSEA_VERBOSE("  → Descompresión completada: " << input.size() 
+                     << " bytes → " << output.size() << " bytes\n");
         
         return output;
     }
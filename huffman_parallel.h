@@ -0,0 +1,281 @@
+#ifndef GSEA_HUFFMAN_PARALLEL_H
+#define GSEA_HUFFMAN_PARALLEL_H
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include <pthread.h>
+#include "huffman.h"
+#include "buffer_pool.h"
+#include "log.h"
+
+// Decodificación en paralelo de un flujo Huffman único (.huff sin bloques)
+//
+// El formato de un solo flujo no marca dónde empieza cada símbolo, pero los
+// códigos de Huffman se autosincronizan: decodificando desde un bit
+// cualquiera, a los pocos símbolos el recorrido cae en un límite de símbolo
+// verdadero y desde ahí coincide con la decodificación desde el principio.
+//
+// Cada ronda reparte hasta threads × SPAN_BYTES bytes del flujo en tramos
+// (alineados a byte) y cada hilo decodifica el suyo desde el comienzo del
+// tramo, sin saber si es un límite verdadero. Anota dónde empezó cada uno de
+// sus primeros SYNC_WINDOW símbolos. Después, en orden:
+//   - el tramo i empieza de verdad donde terminó el i-1 (el primer límite
+//     en o después de su comienzo nominal)
+//   - desde ahí se decodifica en serie hasta caer en un límite anotado por
+//     el hilo i: lo que el hilo produjo desde ese símbolo es correcto
+//   - si no sincroniza dentro de la ventana, el tramo se decodifica entero
+//     en serie (el resultado es el mismo, solo más lento)
+//
+// La salida va a un Sink (bool write(data, size)) en el orden del flujo.
+class ParallelHuffmanDecoder {
+public:
+    static const size_t SPAN_BYTES = 1 << 20;      // Tramo de cada hilo por ronda
+    static const size_t SYNC_WINDOW = 1024;        // Límites anotados por tramo
+
+    // Memoria que reserva con threads hilos: el máximo que puede producir
+    // cada tramo (un símbolo por bit) más los límites anotados
+    static uint64_t footprint(int threads) {
+        return (uint64_t)threads * (SPAN_BYTES * 8 + 64 + SYNC_WINDOW * sizeof(uint64_t));
+    }
+
+private:
+    // Un tramo de la ronda y lo que produjo su hilo
+    struct Span {
+        const ParallelHuffmanDecoder* owner;
+        uint64_t start;            // Comienzo nominal (no necesariamente un límite)
+        uint64_t stop;             // Se decodifican los símbolos que empiezan antes
+        PooledBuffer out;
+        size_t count;              // Símbolos producidos
+        std::vector<uint64_t> sync;     // Comienzo de los primeros símbolos
+        size_t recorded;
+        uint64_t end;              // Comienzo del primer símbolo no decodificado
+        bool failed;               // Código inválido en end
+    };
+
+    // Los primeros TABLE_BITS bits de un código en un solo paso: la hoja (y
+    // el largo del código) o el nodo interno al que llegan
+    static const int TABLE_BITS = 10;
+    struct TableEntry {
+        const HuffmanNode* node;   // nullptr = código inválido (lo informa el recorrido bit a bit)
+        int length;
+    };
+
+    const HuffmanNode* root;
+    TableEntry table[1 << TABLE_BITS];
+    int threads;
+    std::vector<Span> spans;
+    bool buffers_ok;
+
+    // Datos de la ronda actual (solo lectura para los hilos)
+    const unsigned char* data;
+    uint64_t end_bit;
+
+    uint64_t serial_symbols;       // Decodificados de nuevo al unir los tramos
+
+    void build_table() {
+        for (int value = 0; value < (1 << TABLE_BITS); value++) {
+            const HuffmanNode* node = root;
+            int length = 0;
+            while (node != nullptr && !node->is_leaf() && length < TABLE_BITS) {
+                node = ((value >> (TABLE_BITS - 1 - length)) & 1) ? node->right : node->left;
+                length++;
+            }
+            table[value].node = node;
+            table[value].length = length;
+        }
+    }
+
+    // Un símbolo desde el bit pos (bit más significativo primero)
+    // Retorna 1 (symbol listo, pos avanzado), 0 si no termina antes de
+    // limit, -1 si el código no existe en el árbol
+    int next_symbol(const unsigned char* bits, uint64_t& pos, uint64_t limit, unsigned char& symbol) const {
+        const HuffmanNode* node = root;
+        uint64_t p = pos;
+        if (p + 24 <= limit) {
+            const unsigned char* at = bits + (p >> 3);
+            uint32_t window = ((uint32_t)at[0] << 16) | ((uint32_t)at[1] << 8) | at[2];
+            const TableEntry& entry =
+                table[(window >> (24 - TABLE_BITS - (p & 7))) & ((1 << TABLE_BITS) - 1)];
+            if (entry.node != nullptr) {
+                node = entry.node;
+                p += entry.length;
+                if (node->is_leaf()) {
+                    symbol = node->data;
+                    pos = p;
+                    return 1;
+                }
+            }
+        }
+        do {
+            if (p >= limit) return 0;
+            node = ((bits[p >> 3] >> (7 - (p & 7))) & 1) ? node->right : node->left;
+            p++;
+            if (node == nullptr) return -1;
+        } while (!node->is_leaf());
+        symbol = node->data;
+        pos = p;
+        return 1;
+    }
+
+    void run_span(Span& span) const {
+        uint64_t pos = span.start;
+        unsigned char* out = span.out.data();
+        span.count = 0;
+        span.recorded = 0;
+        span.failed = false;
+        while (pos < span.stop) {
+            uint64_t at = pos;
+            int status = next_symbol(data, pos, end_bit, out[span.count]);
+            if (status <= 0) {
+                span.failed = status < 0;
+                break;
+            }
+            if (span.recorded < SYNC_WINDOW) span.sync[span.recorded++] = at;
+            span.count++;
+        }
+        span.end = pos;
+    }
+
+    static void* worker(void* arg) {
+        Span* span = (Span*)arg;
+        span->owner->run_span(*span);
+        return nullptr;
+    }
+
+    // Juntar los símbolos sueltos antes de pasarlos al sink
+    template <class Sink>
+    struct Staging {
+        Sink& sink;
+        unsigned char bytes[4096];
+        size_t used;
+
+        explicit Staging(Sink& target) : sink(target), used(0) {}
+
+        bool put(unsigned char symbol) {
+            if (used == sizeof(bytes) && !flush()) return false;
+            bytes[used++] = symbol;
+            return true;
+        }
+
+        bool flush() {
+            bool ok = used == 0 || sink.write(bytes, used);
+            used = 0;
+            return ok;
+        }
+    };
+
+    // Unir los tramos de la ronda desde pos (un límite verdadero)
+    // Retorna -1 (flujo inválido o error del sink), 0 si el flujo se cortó
+    // en un símbolo incompleto, 1 si la ronda terminó
+    template <class Sink>
+    int stitch(size_t used, uint64_t& pos, Sink& sink) {
+        Staging<Sink> staging(sink);
+        for (size_t i = 0; i < used; i++) {
+            const Span& span = spans[i];
+            size_t j = 0;
+            bool synced = false;
+            while (pos < span.stop) {
+                while (j < span.recorded && span.sync[j] < pos) j++;
+                if (j < span.recorded && span.sync[j] == pos) {
+                    synced = true;
+                    break;
+                }
+                unsigned char symbol;
+                int status = next_symbol(data, pos, end_bit, symbol);
+                if (status < 0) {
+                    GSEA_ERROR("Error: Flujo comprimido dañado\n");
+                    return -1;
+                }
+                if (status == 0) return staging.flush() ? 0 : -1;
+                if (!staging.put(symbol)) return -1;
+                serial_symbols++;
+            }
+            if (!synced) continue;
+
+            // Desde el símbolo j el hilo recorrió el flujo verdadero
+            if (!staging.flush() || !sink.write(span.out.data() + j, span.count - j)) return -1;
+            pos = span.end;
+            if (span.failed) {
+                GSEA_ERROR("Error: Flujo comprimido dañado\n");
+                return -1;
+            }
+            if (pos < span.stop) return 0;
+        }
+        return staging.flush() ? 1 : -1;
+    }
+
+public:
+    // tree: árbol ya leído con read_header() (debe vivir mientras se decodifica)
+    ParallelHuffmanDecoder(const HuffmanCoder& coder, int thread_count)
+        : root(coder.tree_root()), threads(std::max(1, thread_count)), spans(threads),
+          buffers_ok(true), data(nullptr), end_bit(0), serial_symbols(0) {
+        if (root != nullptr) build_table();
+        for (Span& span : spans) {
+            span.owner = this;
+            // Un símbolo ocupa al menos un bit (más el que cruza el final del tramo)
+            span.out.reserve(SPAN_BYTES * 8 + 64);
+            span.sync.resize(SYNC_WINDOW);
+            buffers_ok = buffers_ok && span.out.valid();
+        }
+    }
+
+    ParallelHuffmanDecoder(const ParallelHuffmanDecoder&) = delete;
+    ParallelHuffmanDecoder& operator=(const ParallelHuffmanDecoder&) = delete;
+
+    // Decodificar los símbolos de bits que empiezan en [start_bit, stop_bit)
+    // (start_bit es un límite de símbolo). Ninguno puede pasar de limit_bit:
+    // el que no termina antes queda sin decodificar, como el decodificador
+    // en serie con los bits sobrantes del final. next_bit recibe el comienzo
+    // del primer símbolo no decodificado. false si el flujo es inválido o el
+    // sink falló
+    template <class Sink>
+    bool decode(const unsigned char* bits, uint64_t start_bit, uint64_t stop_bit, uint64_t limit_bit,
+                Sink& sink, uint64_t& next_bit) {
+        if (root == nullptr || !buffers_ok) return false;
+        data = bits;
+        end_bit = limit_bit;
+        uint64_t pos = start_bit;
+
+        while (pos < stop_bit) {
+            // Tramos alineados a byte: con códigos de largo fijo (datos
+            // aleatorios o ya comprimidos) el comienzo nominal ya es un límite
+            uint64_t round_end = std::min(stop_bit, pos + (uint64_t)threads * SPAN_BYTES * 8);
+            uint64_t first_byte = pos / 8;
+            uint64_t bytes = (round_end + 7) / 8 - first_byte;
+            size_t used = (size_t)std::max<uint64_t>(1, std::min<uint64_t>(threads, bytes / (SPAN_BYTES / 4)));
+            for (size_t i = 0; i < used; i++) {
+                spans[i].start = i == 0 ? pos : (first_byte + bytes * i / used) * 8;
+                spans[i].stop = i + 1 == used ? round_end : (first_byte + bytes * (i + 1) / used) * 8;
+            }
+
+            // El tramo 0 en este hilo; si un hilo no arranca, su tramo también
+            std::vector<pthread_t> handles(used);
+            std::vector<bool> started(used, false);
+            for (size_t i = 1; i < used; i++) {
+                started[i] = pthread_create(&handles[i], nullptr, worker, &spans[i]) == 0;
+            }
+            run_span(spans[0]);
+            for (size_t i = 1; i < used; i++) {
+                if (started[i]) {
+                    pthread_join(handles[i], nullptr);
+                } else {
+                    run_span(spans[i]);
+                }
+            }
+
+            int status = stitch(used, pos, sink);
+            if (status < 0) return false;
+            if (status == 0) break;
+        }
+        next_bit = pos;
+        return true;
+    }
+
+    // Símbolos que hubo que decodificar en serie para sincronizar los tramos
+    uint64_t resynced_symbols() const { return serial_symbols; }
+};
+
+#endif // GSEA_HUFFMAN_PARALLEL_H
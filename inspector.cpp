@@ -1,11 +1,124 @@
-#include "file-manager.h"
+// gsea-inspect: análisis de archivos sin cargarlos en memoria
+//
+// El archivo se recorre por ventanas (1 MB por defecto) sobre un mmap de
+// solo lectura: cada ventana ya procesada se suelta con madvise(), así que
+// la memoria usada no depende del tamaño del archivo. Si mmap() no se puede
+// usar (p. ej. un pipe), se lee con read() en un buffer de una ventana.
+
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <vector>
+#include <map>
+#include <memory>
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include "huffman.h"
+#include "container.h"
+#include "memory_budget.h"
+#include "stats.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+static const uint64_t DEFAULT_WINDOW = 1 << 20;
+
+// Lectura de un archivo ventana por ventana
+class WindowReader {
+private:
+    int fd;
+    uint64_t file_size;
+    uint64_t window;
+    uint64_t offset;              // Inicio de la próxima ventana
+    unsigned char* map;           // nullptr = se lee con read()
+    std::vector<unsigned char> buffer;
+
+public:
+    WindowReader() : fd(-1), file_size(0), window(DEFAULT_WINDOW), offset(0), map(nullptr) {}
+
+    ~WindowReader() {
+        if (map != nullptr) munmap(map, file_size);
+        if (fd != -1) close(fd);
+    }
+
+    WindowReader(const WindowReader&) = delete;
+    WindowReader& operator=(const WindowReader&) = delete;
+
+    bool open_file(const std::string& path, uint64_t window_size, std::string& error) {
+        fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) == -1) {
+            error = strerror(errno);
+            return false;
+        }
+        if (S_ISDIR(st.st_mode)) {
+            error = "es un directorio";
+            return false;
+        }
+        file_size = S_ISREG(st.st_mode) ? st.st_size : 0;
+
+        // Ventanas múltiplo de página: madvise() trabaja con páginas completas
+        uint64_t page = sysconf(_SC_PAGESIZE);
+        window = std::max(page, (window_size + page - 1) / page * page);
+
+        if (file_size > 0) {
+            void* mapped = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                map = (unsigned char*)mapped;
+                madvise(map, file_size, MADV_SEQUENTIAL);
+            }
+        }
+        if (map == nullptr) {
+            buffer.resize(window);
+        }
+        return true;
+    }
+
+    // Tamaño según fstat() (0 si no es un archivo regular)
+    uint64_t size() const { return file_size; }
+    uint64_t window_size() const { return window; }
+
+    // Siguiente ventana: false al llegar al final (o si read() falla)
+    bool next(const unsigned char*& data, size_t& size) {
+        if (map != nullptr) {
+            if (offset > 0) {
+                // La ventana anterior ya no se necesita
+                madvise(map + offset - window, window, MADV_DONTNEED);
+            }
+            if (offset >= file_size) return false;
+            data = map + offset;
+            size = std::min(window, file_size - offset);
+            offset += size;
+            return true;
+        }
+
+        size_t done = 0;
+        while (done < buffer.size()) {
+            ssize_t n = read(fd, buffer.data() + done, buffer.size() - done);
+            if (n == -1 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += n;
+        }
+        if (done == 0) return false;
+        data = buffer.data();
+        size = done;
+        offset += done;
+        return true;
+    }
+
+    // Bytes leídos hasta ahora (el tamaño real si no es un archivo regular)
+    uint64_t consumed() const { return offset; }
+};
 
 // Función para mostrar bytes en hexadecimal con formato bonito
-void print_hex_dump(const std::vector<unsigned char>& data, int max_lines = 16) {
+void print_hex_dump(const std::vector<unsigned char>& data, uint64_t total_size, int max_lines = 16) {
     std::cout << "\n┌────────┬─────────────────────────────────────────────────┬──────────────────┐\n";
     std::cout << "│ Offset │ Hexadecimal                                     │ ASCII            │\n";
     std::cout << "├────────┼─────────────────────────────────────────────────┼──────────────────┤\n";
@@ -50,8 +163,8 @@ void print_hex_dump(const std::vector<unsigned char>& data, int max_lines = 16)
         std::cout << " │\n";
     }
     
-    if (data.size() > (size_t)(max_lines * bytes_per_line)) {
-        std::cout << "│   ...  │ ... (" << std::dec << (data.size() - max_lines * bytes_per_line) 
+    if (total_size > (uint64_t)(max_lines * bytes_per_line)) {
+        std::cout << "│   ...  │ ... (" << std::dec << (total_size - max_lines * bytes_per_line) 
                   << " bytes más) ...\n";
     }
     
@@ -59,44 +172,129 @@ void print_hex_dump(const std::vector<unsigned char>& data, int max_lines = 16)
     std::cout << std::dec;  // Restaurar formato decimal
 }
 
-// Calcular entropía (medida de aleatoriedad)
-double calculate_entropy(const std::vector<unsigned char>& data) {
-    if (data.empty()) return 0.0;
-    
-    // Contar frecuencias
-    int frequency[256] = {0};
-    for (unsigned char byte : data) {
-        frequency[byte]++;
-    }
+// Calcular entropía de Shannon (medida de aleatoriedad) en bits/byte
+// H = -Σ p·log2(p), con p la frecuencia relativa de cada byte
+double calculate_entropy(const uint64_t frequency[256], uint64_t total) {
+    if (total == 0) return 0.0;
     
-    // Calcular entropía de Shannon
     double entropy = 0.0;
     for (int i = 0; i < 256; i++) {
         if (frequency[i] > 0) {
-            double p = (double)frequency[i] / data.size();
-            entropy -= p; // Calculo mal hecho, en por log2p 
+            double p = (double)frequency[i] / total;
+            entropy -= p * std::log2(p);
         }
     }
     
     return entropy;
 }
 
-// Analizar distribución de bytes
-void analyze_distribution(const std::vector<unsigned char>& data) {
-    int frequency[256] = {0};
-    for (unsigned char byte : data) {
-        frequency[byte]++;
+// Clase de una entropía (los mismos rangos que la interpretación)
+int entropy_class(double entropy) {
+    if (entropy < 3.0) return 0;
+    if (entropy < 5.0) return 1;
+    if (entropy < 7.0) return 2;
+    return 3;
+}
+
+static const char* const ENTROPY_CLASS_NAMES[4] = {
+    "repetitivo", "texto", "comprimido/estructurado", "aleatorio (incomprimible)"
+};
+
+// Región de ventanas consecutivas con la misma clase de entropía
+struct EntropyRegion {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    int windows = 0;
+    int kind = 0;
+    double min = 8.0;
+    double max = 0.0;
+    double sum = 0.0;   // Σ entropía·bytes (para el promedio ponderado)
+};
+
+// Perfil de entropía por ventana, agrupado en regiones
+class EntropyProfile {
+private:
+    std::vector<EntropyRegion> regions;
+    std::vector<double> windows;   // Solo con -p (una entrada por ventana)
+    bool keep_windows;
+
+public:
+    explicit EntropyProfile(bool all_windows) : keep_windows(all_windows) {}
+
+    void add(uint64_t offset, uint64_t size, double entropy) {
+        int kind = entropy_class(entropy);
+        if (regions.empty() || regions.back().kind != kind) {
+            EntropyRegion region;
+            region.offset = offset;
+            region.kind = kind;
+            regions.push_back(region);
+        }
+        EntropyRegion& region = regions.back();
+        region.size += size;
+        region.windows++;
+        region.min = std::min(region.min, entropy);
+        region.max = std::max(region.max, entropy);
+        region.sum += entropy * size;
+        if (keep_windows) windows.push_back(entropy);
     }
-    
+
+    // Bytes en regiones incomprimibles (entropía >= 7)
+    uint64_t incompressible_bytes() const {
+        uint64_t total = 0;
+        for (const EntropyRegion& region : regions) {
+            if (region.kind == 3) total += region.size;
+        }
+        return total;
+    }
+
+    void print(uint64_t window, uint64_t total_size, size_t max_regions = 40) const {
+        std::string title = "PERFIL DE ENTROPÍA (ventanas de " + std::to_string(window >> 10) + " KB)";
+        std::cout << "\n┌─────────────────────────────────────────────────┐\n";
+        std::cout << "│ " << title << std::string(47 - (title.size() - 1), ' ') << " │\n";
+        std::cout << "└─────────────────────────────────────────────────┘\n";
+        
+        for (size_t i = 0; i < regions.size() && i < max_regions; i++) {
+            const EntropyRegion& r = regions[i];
+            double average = r.size > 0 ? r.sum / r.size : 0.0;
+            std::cout << "  " << std::hex << std::setw(10) << std::setfill('0') << r.offset
+                      << std::dec << std::setfill(' ') << "  " << std::setw(10) << r.size
+                      << " bytes  " << std::fixed << std::setprecision(2) << std::setw(4) << r.min
+                      << "-" << std::setw(4) << r.max << " (prom. " << average << ")  "
+                      << std::string((size_t)std::lround(average * 2), '#') << " "
+                      << ENTROPY_CLASS_NAMES[r.kind] << "\n";
+        }
+        if (regions.size() > max_regions) {
+            std::cout << "  ... (" << regions.size() - max_regions << " regiones más)\n";
+        }
+        
+        uint64_t incompressible = incompressible_bytes();
+        std::cout << "\n  Incomprimible (>= 7 bits/byte): " << incompressible << " de " << total_size
+                  << " bytes (" << std::fixed << std::setprecision(1)
+                  << (total_size > 0 ? 100.0 * incompressible / total_size : 0.0) << "%)\n";
+        
+        if (keep_windows) {
+            std::cout << "\n  Ventana      Offset  Entropía\n";
+            for (size_t i = 0; i < windows.size(); i++) {
+                std::cout << "  " << std::setw(7) << i << "  0x" << std::hex << std::setw(8)
+                          << std::setfill('0') << i * window << std::dec << std::setfill(' ')
+                          << "  " << std::setprecision(4) << windows[i] << "  "
+                          << std::string((size_t)std::lround(windows[i] * 4), '#') << "\n";
+            }
+        }
+    }
+};
+
+// Analizar distribución de bytes
+void analyze_distribution(const uint64_t frequency[256], uint64_t total) {
     // Encontrar los bytes más frecuentes
     std::cout << "\n┌─────────────────────────────────┐\n";
     std::cout << "│ Bytes más frecuentes:           │\n";
     std::cout << "├──────┬────────┬─────────────────┤\n";
-    std::cout << "│ Byte │ Freq.  │ ASCII           │\n";
+    std::cout << "│ Byte │ Frec.% │ ASCII           │\n";
     std::cout << "├──────┼────────┼─────────────────┤\n";
     
     // Ordenar y mostrar top 10
-    std::vector<std::pair<int, int>> freq_pairs;
+    std::vector<std::pair<uint64_t, int>> freq_pairs;
     for (int i = 0; i < 256; i++) {
         if (frequency[i] > 0) {
             freq_pairs.push_back({frequency[i], i});
@@ -110,8 +308,8 @@ void analyze_distribution(const std::vector<unsigned char>& data) {
         if (count >= 10) break;
         
         std::cout << "│ 0x" << std::hex << std::setw(2) << std::setfill('0') 
-                  << pair.second << " │ " << std::dec << std::setw(6) 
-                  << pair.first << " │ ";
+                  << pair.second << " │ " << std::dec << std::setfill(' ') << std::fixed
+                  << std::setprecision(2) << std::setw(6) << 100.0 * pair.first / total << " │ ";
         
         unsigned char c = pair.second;
         if (c >= 32 && c <= 126) {
@@ -133,30 +331,29 @@ void analyze_distribution(const std::vector<unsigned char>& data) {
     std::cout << "└──────┴────────┴─────────────────┘\n";
 }
 
-// Detectar tipo de archivo
+// Detectar tipo de archivo (por los primeros bytes)
 std::string detect_file_type(const std::vector<unsigned char>& data) {
     if (data.empty()) return "Vacío";
     
+    // Archivo ya procesado por gsea
+    ContainerHeader header;
+    size_t consumed = 0;
+    if (header.read(data.data(), data.size(), consumed) == 1) {
+        return "GSEA";
+    }
+    
     // Verificar magic numbers comunes
     if (data.size() >= 4) {
         // PDF
         if (data[0] == 0x25 && data[1] == 0x50 && data[2] == 0x44 && data[3] == 0x46) {
             return "PDF";
         }
-        // PNG
-        if (data[0] == 0x89 && data[1] == 0x50 && data[2] == 0x4E && data[3] == 0x47) {
-            return "PNG";
-        }
-        // JPEG
-        if (data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF) {
-            return "JPEG";
-        }
-        // ZIP
-        if (data[0] == 0x50 && data[1] == 0x4B && data[2] == 0x03 && data[3] == 0x04) {
-            return "ZIP";
-        }
     }
     
+    // Formatos ya comprimidos (la misma tabla que usa gsea --comp-alg auto)
+    const char* format = CodecSelector::compressed_format(data.data(), data.size());
+    if (format != nullptr) return format;
+    
     // Verificar si es texto ASCII
     bool is_text = true;
     int printable = 0;
@@ -173,37 +370,750 @@ std::string detect_file_type(const std::vector<unsigned char>& data) {
     return "Binario/Desconocido";
 }
 
+// ============================================================================
+// FORMATO DE GSEA: CABECERAS, ÁRBOLES E ÍNDICE DE BLOQUES
+// ============================================================================
+//
+// Solo se leen cabeceras con pread(): la del contenedor (32 bytes), la de
+// cada bloque (20 bytes) y el árbol de Huffman del principio de cada flujo
+// (hasta MAX_HEADER_SIZE bytes). Nunca se decodifica el payload.
+
+bool pread_full(int fd, unsigned char* buffer, size_t size, uint64_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, buffer + done, size - done, offset + done);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+// Árbol de Huffman leído de la cabecera de un flujo
+struct TreeInfo {
+    size_t header_size = 0;        // Tamaño del árbol + 4 + padding
+    int padding = 0;
+    int symbols = 0;
+    unsigned char lengths[256];    // Largo del código de cada símbolo
+};
+
+// Leer la cabecera Huffman de los primeros bytes de un flujo (ya sin cifrar)
+bool read_tree(const unsigned char* data, size_t size, TreeInfo& tree) {
+    // Descartar antes lo que no puede ser una cabecera (read_header() lo reportaría)
+    if (size < 5) return false;
+    uint32_t tree_size = ContainerHeader::get_u32(data);
+    if (tree_size == 0 || tree_size > HuffmanCoder::MAX_TREE_SIZE) return false;
+    
+    HuffmanCoder coder;
+    if (coder.read_header(data, size, tree.header_size) != 1) return false;
+    tree.padding = coder.get_padding();
+    coder.tree_code_lengths(tree.lengths);
+    tree.symbols = 0;
+    for (int i = 0; i < 256; i++) {
+        if (tree.lengths[i] > 0) tree.symbols++;
+    }
+    return true;
+}
+
+// Bits por símbolo de un flujo Huffman de stored bytes que produce raw bytes
+double bits_per_symbol(const TreeInfo& tree, uint64_t stored, uint64_t raw) {
+    if (raw == 0 || stored < tree.header_size) return 0.0;
+    return ((stored - tree.header_size) * 8.0 - tree.padding) / raw;
+}
+
+std::string symbol_name(int symbol) {
+    char text[8];
+    if (symbol >= 33 && symbol <= 126) snprintf(text, sizeof(text), "'%c'", symbol);
+    else if (symbol == ' ') snprintf(text, sizeof(text), "' '");
+    else if (symbol == '\n') snprintf(text, sizeof(text), "'\\n'");
+    else snprintf(text, sizeof(text), "%02x", symbol);
+    return text;
+}
+
+// Tabla de códigos agrupada por largo: "  5 bits (12): 'a' 'e' ..."
+void print_code_table(const TreeInfo& tree) {
+    std::cout << "  Árbol: " << tree.symbols << " símbolos, cabecera de " << tree.header_size
+              << " bytes, padding " << tree.padding << " bits\n";
+    for (int length = 1; length <= 64; length++) {
+        std::string symbols;
+        int count = 0;
+        for (int i = 0; i < 256; i++) {
+            if (tree.lengths[i] != length) continue;
+            if (count < 24) symbols += " " + symbol_name(i);
+            count++;
+        }
+        if (count == 0) continue;
+        std::cout << "  " << std::setw(3) << length << " bits (" << std::setw(3) << count << "):"
+                  << symbols << (count > 24 ? " ..." : "") << "\n";
+    }
+}
+
+// Distribución de largos de código (símbolos con cada largo, sumados sobre
+// todos los árboles leídos)
+void print_length_distribution(const uint64_t counts[65], int trees) {
+    uint64_t total = 0;
+    uint64_t peak = 0;
+    for (int length = 0; length <= 64; length++) {
+        total += counts[length];
+        peak = std::max(peak, counts[length]);
+    }
+    if (total == 0) return;
+    std::cout << "\n  Distribución de largos de código (" << trees << (trees == 1 ? " árbol" : " árboles")
+              << ", " << total << " símbolos):\n";
+    for (int length = 1; length <= 64; length++) {
+        if (counts[length] == 0) continue;
+        std::cout << "  " << std::setw(3) << length << " bits " << std::setw(8) << counts[length] << "  "
+                  << std::string((size_t)std::max<uint64_t>(1, counts[length] * 40 / peak), '#') << "\n";
+    }
+}
+
+// Una fila del índice de bloques
+struct BlockRow {
+    uint64_t index;                // Número de bloque (un hueco abarca varios)
+    uint64_t offset;
+    BlockHeader header;
+    bool tree_ok;
+    TreeInfo tree;
+};
+
+/**
+ * Mostrar la estructura de un archivo de GSEA sin decodificarlo
+ * 
+ * @param key Clave (opcional) para leer los árboles de un archivo cifrado
+ * @param show_block Bloque cuya tabla de códigos se muestra completa
+ * @return false si el archivo no tiene un formato reconocible
+ */
+bool inspect_format(const std::string& path, const std::string& key, uint64_t show_block) {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+        if (fd != -1) close(fd);
+        return false;
+    }
+    uint64_t file_size = st.st_size;
+    
+    unsigned char first[ContainerHeader::MAX_SIZE + HuffmanCoder::MAX_HEADER_SIZE];
+    size_t first_size = std::min<uint64_t>(sizeof(first), file_size);
+    if (!pread_full(fd, first, first_size, 0)) {
+        close(fd);
+        return false;
+    }
+    
+    ContainerHeader header;
+    size_t consumed = 0;
+    int status = header.read(first, first_size, consumed);
+    
+    std::cout << "\n┌─────────────────────────────────────────────────┐\n";
+    std::cout << "│ FORMATO (solo cabeceras)                        │\n";
+    std::cout << "└─────────────────────────────────────────────────┘\n";
+    
+    if (status == 0) {
+        // Sin cabecera: ¿flujo Huffman de una versión anterior?
+        TreeInfo tree;
+        if (!read_tree(first, first_size, tree)) {
+            std::cout << "  Sin cabecera de GSEA ni árbol de Huffman al inicio\n"
+                      << "  (archivo sin procesar, o .enc/.gsea de una versión anterior)\n";
+            close(fd);
+            return false;
+        }
+        std::cout << "  Flujo Huffman sin cabecera (versión anterior, sin tamaño original)\n";
+        std::cout << "  Bits de datos: " << (file_size - tree.header_size) * 8 - tree.padding << "\n";
+        print_code_table(tree);
+        uint64_t counts[65] = {0};
+        for (int i = 0; i < 256; i++) counts[tree.lengths[i]]++;
+        counts[0] = 0;
+        print_length_distribution(counts, 1);
+        close(fd);
+        return true;
+    }
+    if (status < 0) {
+        std::cout << "  Cabecera de GSEA dañada o de una versión no soportada\n";
+        close(fd);
+        return true;
+    }
+    
+    std::cout << "  Versión:          " << (int)header.version << "\n";
+    std::cout << "  Compresión:       " << CodecRegistry::description(header.codec);
+    if (header.level > 0) std::cout << " (nivel " << (int)header.level << ")";
+    std::cout << "\n";
+    const CipherEntry* cipher_entry = CipherRegistry::find(header.cipher);
+    std::cout << "  Cifrado:          " << (cipher_entry != nullptr ? cipher_entry->description : "ninguno")
+              << ((header.flags & CONTAINER_FLAG_KEY_CHECK) ? " (con verificador de clave)" : "") << "\n";
+    std::cout << "  Tamaño original:  " << header.original_size << " bytes\n";
+    std::cout << "  Tamaño guardado:  " << file_size << " bytes (ratio " << std::fixed << std::setprecision(3)
+              << (header.original_size > 0 ? (double)file_size / header.original_size : 0.0) << ")\n";
+    std::cout << "  Payload:          "
+              << (header.blocked() ? "bloques de " + std::to_string(header.block_size >> 10) + " KB con CRC32C"
+                                   : std::string("un solo flujo"))
+              << (header.holes() ? ", con huecos" : "") << "\n";
+    if (header.delta()) {
+        std::cout << "  Delta:            reconstruye " << header.target_size << " bytes a partir de una base"
+                  << " (hash " << std::hex << std::setw(16) << std::setfill('0') << header.base_hash
+                  << std::dec << std::setfill(' ') << "); se restaura con gsea -d --base\n";
+    }
+    
+    // Los árboles de un archivo cifrado solo se leen con la clave correcta
+    std::unique_ptr<XORCipher> cipher;
+    bool trees_readable = header.codec == CONTAINER_CODEC_HUFFMAN;
+    if (header.cipher != CONTAINER_CIPHER_NONE) {
+        if (key.empty()) {
+            trees_readable = false;
+            if (header.codec == CONTAINER_CODEC_HUFFMAN) {
+                std::cout << "  (archivo cifrado: use -k <clave> para ver los árboles)\n";
+            }
+        } else {
+            cipher.reset(new XORCipher(key));
+            if (!header.key_matches(*cipher)) {
+                std::cout << "  Clave incorrecta: no se leen los árboles\n";
+                trees_readable = false;
+            }
+        }
+    }
+    
+    // Descifrar solo el principio de un flujo (donde está el árbol)
+    auto read_stream_tree = [&](uint64_t offset, uint64_t stored, uint64_t position, TreeInfo& tree) {
+        unsigned char bytes[HuffmanCoder::MAX_HEADER_SIZE];
+        size_t n = std::min<uint64_t>(sizeof(bytes), stored);
+        if (!pread_full(fd, bytes, n, offset)) return false;
+        if (cipher) {
+            XORCipher::StreamState stream = cipher->begin_stream();
+            stream.position = position;
+            cipher->decrypt_chunk(bytes, bytes, n, stream);
+        }
+        return read_tree(bytes, n, tree);
+    };
+    
+    if (!header.blocked()) {
+        uint64_t stored = file_size - consumed;
+        TreeInfo tree;
+        if (trees_readable && read_stream_tree(consumed, stored, 0, tree)) {
+            std::cout << "  Bits por símbolo: " << std::setprecision(3)
+                      << bits_per_symbol(tree, stored, header.original_size) << "\n\n";
+            print_code_table(tree);
+            uint64_t counts[65] = {0};
+            for (int i = 0; i < 256; i++) counts[tree.lengths[i]]++;
+            counts[0] = 0;
+            print_length_distribution(counts, 1);
+        }
+        close(fd);
+        return true;
+    }
+    
+    // Índice de bloques: 20 bytes por bloque (+ el árbol si se puede leer)
+    std::vector<BlockRow> rows;
+    uint64_t offset = consumed;
+    uint64_t raw_total = 0;
+    uint64_t index = 0;
+    std::string error;
+    while (offset < file_size) {
+        unsigned char bytes[BlockHeader::SIZE];
+        BlockRow row;
+        row.index = index;
+        row.offset = offset;
+        row.tree_ok = false;
+        if (file_size - offset < BlockHeader::SIZE || !pread_full(fd, bytes, sizeof(bytes), offset) ||
+            !row.header.read(bytes, header.block_size) ||
+            row.header.stored_size > file_size - offset - BlockHeader::SIZE) {
+            error = "Bloque " + std::to_string(index) + ": cabecera inválida o datos truncados";
+            break;
+        }
+        if (trees_readable && row.header.codec == CONTAINER_CODEC_HUFFMAN) {
+            row.tree_ok = read_stream_tree(offset + BlockHeader::SIZE, row.header.stored_size,
+                                           index * header.block_size, row.tree);
+        }
+        raw_total += row.header.raw_bytes();
+        index += row.header.block_count();
+        offset += BlockHeader::SIZE + row.header.stored_size;
+        rows.push_back(row);
+    }
+    
+    std::cout << "\n  Bloque      Offset   Original   Guardado  Ratio  Bits/símb  Códec     CRC32C (guardado)\n";
+    uint64_t counts[65] = {0};
+    int trees = 0;
+    int stored_raw = 0;
+    uint64_t hole_blocks = 0;
+    const BlockRow* shown = nullptr;
+    double best = 1e9, worst = 0.0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        const BlockRow& row = rows[i];
+        bool selected = show_block >= row.index && show_block < row.index + row.header.block_count();
+        if (selected) shown = &row;
+        if (row.header.hole()) {
+            // Nada guardado: no entra en los ratios
+            hole_blocks += row.header.hole_blocks;
+            if (i < 40 || selected) {
+                std::cout << "  " << std::setw(6) << row.index << "  0x" << std::hex << std::setw(8)
+                          << std::setfill('0') << row.offset << std::dec << std::setfill(' ')
+                          << std::setw(11) << row.header.raw_bytes() << std::setw(11) << 0
+                          << "      -          -  hueco     (" << row.header.hole_blocks << " bloques)\n";
+            } else if (i == 40) {
+                std::cout << "  ... (" << rows.size() - 40 << " bloques más; -b <n> muestra uno)\n";
+            }
+            continue;
+        }
+        double ratio = (double)row.header.stored_size / row.header.raw_size;
+        best = std::min(best, ratio);
+        worst = std::max(worst, ratio);
+        if (row.header.codec == CONTAINER_CODEC_NONE) stored_raw++;
+        if (row.tree_ok) {
+            trees++;
+            for (int s = 0; s < 256; s++) counts[row.tree.lengths[s]]++;
+        }
+        if (i < 40 || selected) {
+            std::cout << "  " << std::setw(6) << row.index << "  0x" << std::hex << std::setw(8) << std::setfill('0')
+                      << row.offset << std::dec << std::setfill(' ') << std::setw(11) << row.header.raw_size
+                      << std::setw(11) << row.header.stored_size << "  " << std::setprecision(3) << ratio;
+            if (row.tree_ok) {
+                std::cout << std::setw(11) << bits_per_symbol(row.tree, row.header.stored_size, row.header.raw_size);
+            } else {
+                std::cout << std::setw(11) << "-";
+            }
+            std::cout << "  " << std::left << std::setw(8)
+                      << (row.header.codec != CONTAINER_CODEC_NONE ? CodecRegistry::find(row.header.codec)->name
+                                                                   : "tal cual") << std::right
+                      << "  " << std::hex << std::setw(8) << std::setfill('0') << row.header.stored_crc
+                      << std::dec << std::setfill(' ') << "\n";
+        } else if (i == 40) {
+            std::cout << "  ... (" << rows.size() - 40 << " bloques más; -b <n> muestra uno)\n";
+        }
+    }
+    counts[0] = 0;
+    
+    std::cout << "\n  Bloques: " << index << " (" << stored_raw << " guardados tal cual";
+    if (hole_blocks > 0) std::cout << ", " << hole_blocks << " en huecos";
+    std::cout << "), ratio " << std::setprecision(3) << (best > worst ? 0.0 : best) << " a " << worst << "\n";
+    if (raw_total != header.original_size && error.empty()) {
+        error = "Los bloques suman " + std::to_string(raw_total) + " bytes, la cabecera indica " +
+                std::to_string(header.original_size);
+    }
+    if (!error.empty()) {
+        std::cout << "  ✗ " << error << "\n";
+    }
+    
+    if (shown != nullptr && shown->tree_ok) {
+        std::cout << "\n  Tabla de códigos del bloque " << show_block << ":\n";
+        print_code_table(shown->tree);
+    }
+    print_length_distribution(counts, trees);
+    
+    close(fd);
+    return true;
+}
+
+// ============================================================================
+// MODO LOTE (-r): UNA FILA POR ARCHIVO DE UN ÁRBOL DE DIRECTORIOS
+// ============================================================================
+//
+// Para decidir qué vale la pena comprimir antes de correr gsea: cada archivo
+// se analiza (completo o solo su prefijo con -s) en bloques del mismo tamaño
+// que usa gsea, y el tamaño estimado es el que tendría cada bloque con su
+// propio árbol de Huffman. Las filas salen en el orden del recorrido aunque
+// los hilos terminen en otro orden.
+
+// Resultado del análisis de un archivo
+struct FileReport {
+    std::string path;
+    std::string error;             // Vacío si se pudo analizar
+    uint64_t size = 0;
+    uint64_t analyzed = 0;         // Bytes leídos (todo, o el prefijo de -s)
+    std::string type;
+    double entropy = 0.0;
+    double incompressible = 0.0;   // Fracción de bytes en bloques con entropía >= 7
+    int distinct = 0;              // Valores de byte distintos
+    double top_byte = 0.0;         // Fracción del byte más frecuente
+    uint64_t predicted = 0;        // Tamaño estimado con gsea -c
+    bool done = false;
+    
+    double predicted_ratio() const {
+        return size > 0 ? (double)predicted / size : 1.0;
+    }
+    
+    // Lo que conviene hacer con el archivo
+    const char* advice() const {
+        if (!error.empty()) return "error";
+        if (type == "GSEA") return "ya procesado";
+        return predicted_ratio() < 0.9 ? "comprimir" : "omitir";
+    }
+};
+
+// Bytes que ocupa un bloque con gsea -c: cabecera del bloque, árbol
+// serializado (2 bytes por hoja, 1 por nodo interno) y los códigos
+uint64_t predict_block(const uint64_t frequency[256]) {
+    HuffmanCoder coder;
+    if (!coder.build(frequency)) return BlockHeader::SIZE;
+    int symbols = 0;
+    for (int i = 0; i < 256; i++) {
+        if (frequency[i] > 0) symbols++;
+    }
+    uint64_t tree_size = 2 * symbols + (symbols - 1);
+    return BlockHeader::SIZE + 5 + tree_size + (coder.encoded_bits(frequency) + 7) / 8;
+}
+
+void analyze_file(FileReport& report, uint64_t sample) {
+    WindowReader reader;
+    if (!reader.open_file(report.path, CONTAINER_BLOCK_SIZE, report.error)) return;
+    report.size = reader.size();
+    
+    uint64_t frequency[256] = {0};
+    uint64_t incompressible = 0;
+    uint64_t predicted = 0;
+    std::vector<unsigned char> prefix;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    while ((sample == 0 || report.analyzed < sample) && reader.next(data, size)) {
+        if (sample > 0) size = std::min<uint64_t>(size, sample - report.analyzed);
+        if (prefix.empty()) {
+            prefix.assign(data, data + std::min<size_t>(size, 1024));
+        }
+        uint64_t block_frequency[256] = {0};
+        HuffmanCoder::count_frequencies(data, size, block_frequency);
+        for (int i = 0; i < 256; i++) {
+            frequency[i] += block_frequency[i];
+        }
+        if (calculate_entropy(block_frequency, size) >= 7.0) incompressible += size;
+        predicted += predict_block(block_frequency);
+        report.analyzed += size;
+    }
+    // Sin fstat() útil (no es un archivo regular) vale lo que se leyó
+    if (report.size == 0) report.size = report.analyzed;
+    
+    report.type = detect_file_type(prefix);
+    if (report.analyzed == 0) {
+        report.predicted = ContainerHeader::LEVEL_SIZE;
+        return;
+    }
+    report.entropy = calculate_entropy(frequency, report.analyzed);
+    report.incompressible = (double)incompressible / report.analyzed;
+    uint64_t top = 0;
+    for (int i = 0; i < 256; i++) {
+        if (frequency[i] > 0) report.distinct++;
+        top = std::max(top, frequency[i]);
+    }
+    report.top_byte = (double)top / report.analyzed;
+    
+    // Con -s el resto del archivo se estima con la proporción de la muestra
+    report.predicted = ContainerHeader::LEVEL_SIZE +
+                       (uint64_t)((double)predicted * report.size / report.analyzed);
+}
+
+static const char* const CSV_COLUMNS =
+    "ruta,tamano,analizado,tipo,entropia,incomprimible,bytes_distintos,byte_max,"
+    "estimado,ratio_estimado,sugerencia,error";
+
+std::string csv_field(const std::string& text) {
+    if (text.find_first_of(",\"\n\r") == std::string::npos) return text;
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string format_report(const FileReport& r, bool json) {
+    char numbers[160];
+    if (json) {
+        snprintf(numbers, sizeof(numbers),
+                 "\"entropia\": %.4f, \"incomprimible\": %.4f, \"bytes_distintos\": %d, "
+                 "\"byte_max\": %.4f, ",
+                 r.entropy, r.incompressible, r.distinct, r.top_byte);
+        char ratio[32];
+        snprintf(ratio, sizeof(ratio), "%.4f", r.predicted_ratio());
+        return "{\"ruta\": " + RunStats::json_string(r.path) +
+               ", \"tamano\": " + std::to_string(r.size) +
+               ", \"analizado\": " + std::to_string(r.analyzed) +
+               ", \"tipo\": " + RunStats::json_string(r.type) + ", " + numbers +
+               "\"estimado\": " + std::to_string(r.predicted) +
+               ", \"ratio_estimado\": " + ratio +
+               ", \"sugerencia\": " + RunStats::json_string(r.advice()) +
+               ", \"error\": " + RunStats::json_string(r.error) + "}";
+    }
+    snprintf(numbers, sizeof(numbers), "%.4f,%.4f,%d,%.4f,", r.entropy, r.incompressible,
+             r.distinct, r.top_byte);
+    char ratio[32];
+    snprintf(ratio, sizeof(ratio), "%.4f", r.predicted_ratio());
+    return csv_field(r.path) + "," + std::to_string(r.size) + "," + std::to_string(r.analyzed) + "," +
+           csv_field(r.type) + "," + numbers + std::to_string(r.predicted) + "," + ratio + "," +
+           r.advice() + "," + csv_field(r.error);
+}
+
+// Archivos regulares bajo dir (recursivo, sin seguir enlaces simbólicos),
+// en orden alfabético para que dos corridas den las mismas filas
+void collect_files(const std::string& dir, std::vector<std::string>& files) {
+    DIR* handle = opendir(dir.c_str());
+    if (handle == nullptr) {
+        std::cerr << "Advertencia: no se pudo abrir " << dir << ": " << strerror(errno) << "\n";
+        return;
+    }
+    std::vector<std::string> names;
+    struct dirent* entry;
+    while ((entry = readdir(handle)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") names.push_back(name);
+    }
+    closedir(handle);
+    std::sort(names.begin(), names.end());
+    
+    for (const std::string& name : names) {
+        std::string path = dir + "/" + name;
+        struct stat st;
+        if (lstat(path.c_str(), &st) == -1) continue;
+        if (S_ISDIR(st.st_mode)) {
+            collect_files(path, files);
+        } else if (S_ISREG(st.st_mode)) {
+            files.push_back(path);
+        }
+    }
+}
+
+// Cola compartida por los hilos del modo lote
+struct BatchJob {
+    std::vector<FileReport>* reports;
+    uint64_t sample;
+    bool json;
+    size_t next = 0;       // Próximo archivo a analizar
+    size_t printed = 0;    // Filas ya escritas (en orden)
+    pthread_mutex_t mutex;
+};
+
+void* batch_worker(void* arg) {
+    BatchJob* job = (BatchJob*)arg;
+    std::vector<FileReport>& reports = *job->reports;
+    
+    while (true) {
+        pthread_mutex_lock(&job->mutex);
+        if (job->next >= reports.size()) {
+            pthread_mutex_unlock(&job->mutex);
+            break;
+        }
+        FileReport& report = reports[job->next++];
+        pthread_mutex_unlock(&job->mutex);
+        
+        analyze_file(report, job->sample);
+        
+        // Escribir todas las filas consecutivas ya terminadas
+        pthread_mutex_lock(&job->mutex);
+        report.done = true;
+        while (job->printed < reports.size() && reports[job->printed].done) {
+            std::cout << format_report(reports[job->printed], job->json) << "\n";
+            job->printed++;
+        }
+        pthread_mutex_unlock(&job->mutex);
+    }
+    return nullptr;
+}
+
+// Resumen por subdirectorio de primer nivel (por stderr: stdout queda
+// solo con las filas)
+void print_batch_summary(const std::string& root, const std::vector<FileReport>& reports) {
+    struct Subtree {
+        int files = 0;
+        uint64_t size = 0;
+        uint64_t predicted = 0;
+    };
+    std::map<std::string, Subtree> subtrees;   // Los archivos sueltos de la raíz van a "."
+    Subtree total;
+    for (const FileReport& r : reports) {
+        if (!r.error.empty()) continue;
+        std::string relative = r.path.substr(root.size() + 1);
+        size_t slash = relative.find('/');
+        std::string name = slash == std::string::npos ? "." : relative.substr(0, slash);
+        for (Subtree* t : {&subtrees[name], &total}) {
+            t->files++;
+            t->size += r.size;
+            // Un archivo que no achica se guardaría sin comprimir
+            t->predicted += std::min(r.predicted, r.size);
+        }
+    }
+    
+    std::cerr << "\n  Subárbol                     Archivos        Bytes     Estimado  Ratio\n";
+    auto print_row = [](const std::string& name, const Subtree& t) {
+        std::cerr << "  " << std::left << std::setw(28) << name.substr(0, 28) << std::right
+                  << std::setw(9) << t.files << std::setw(13) << t.size << std::setw(13) << t.predicted
+                  << "  " << std::fixed << std::setprecision(3)
+                  << (t.size > 0 ? (double)t.predicted / t.size : 1.0) << "\n";
+    };
+    for (const auto& entry : subtrees) {
+        print_row(entry.first, entry.second);
+    }
+    print_row("TOTAL", total);
+}
+
+/**
+ * Analizar todos los archivos de un árbol de directorios en paralelo
+ * 
+ * @param sample Bytes a leer del principio de cada archivo (0 = completo)
+ * @return false si no se pudo analizar ningún archivo
+ */
+bool run_batch(const std::string& root, int threads, uint64_t sample, bool json) {
+    struct stat st;
+    if (stat(root.c_str(), &st) == -1 || !S_ISDIR(st.st_mode)) {
+        std::cerr << "Error: " << root << " no es un directorio\n";
+        return false;
+    }
+    std::vector<std::string> files;
+    collect_files(root, files);
+    
+    std::vector<FileReport> reports(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        reports[i].path = files[i];
+    }
+    
+    if (!json) std::cout << CSV_COLUMNS << "\n";
+    
+    BatchJob job;
+    job.reports = &reports;
+    job.sample = sample;
+    job.json = json;
+    pthread_mutex_init(&job.mutex, nullptr);
+    
+    int workers = std::max(1, std::min(threads, (int)files.size()));
+    std::vector<pthread_t> pool(workers);
+    int started = 0;
+    for (int i = 1; i < workers; i++) {
+        if (pthread_create(&pool[i], nullptr, batch_worker, &job) != 0) break;
+        started++;
+    }
+    batch_worker(&job);
+    for (int i = 1; i <= started; i++) {
+        pthread_join(pool[i], nullptr);
+    }
+    pthread_mutex_destroy(&job.mutex);
+    
+    int failed = 0;
+    for (const FileReport& r : reports) {
+        if (!r.error.empty()) failed++;
+    }
+    print_batch_summary(root, reports);
+    if (failed > 0) {
+        std::cerr << "  " << failed << " archivos no se pudieron leer\n";
+    }
+    return files.empty() || failed < (int)files.size();
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Uso: " << program_name << " [opciones] <archivo>\n";
+    std::cout << "     " << program_name << " -r <directorio> [-j <hilos>] [-s <tamaño>] [--format=csv|json]\n";
+    std::cout << "\nOpciones:\n";
+    std::cout << "  -w <tamaño>   Ventana del perfil de entropía (default: 1M)\n";
+    std::cout << "  -p            Mostrar la entropía de cada ventana\n";
+    std::cout << "  -f            Solo el formato (cabeceras, árboles, bloques): no lee el payload\n";
+    std::cout << "  -b <n>        Mostrar la tabla de códigos del bloque n (default: 0)\n";
+    std::cout << "  -k <clave>    Clave para leer los árboles de un archivo cifrado\n";
+    std::cout << "\nModo lote (una fila por archivo, predicción de compresibilidad):\n";
+    std::cout << "  -r <dir>      Analizar todos los archivos bajo dir (recursivo)\n";
+    std::cout << "  -j <n>        Hilos (default: uno por CPU)\n";
+    std::cout << "  -s <tamaño>   Analizar solo el principio de cada archivo (ej: 4M)\n";
+    std::cout << "  --format=csv|json  Formato de las filas (default: csv; json = una línea por archivo)\n";
+    std::cout << "\nEjemplos:\n";
+    std::cout << "  " << program_name << " archivo.txt\n";
+    std::cout << "  " << program_name << " archivo.txt.huff\n";
+    std::cout << "  " << program_name << " -w 64K -p imagen.iso\n";
+    std::cout << "  " << program_name << " -f -k miClave doc.gsea\n";
+    std::cout << "  " << program_name << " -r /datos -j 8 -s 4M > triage.csv\n";
+}
+
 int main(int argc, char* argv[]) {
+    std::string filename;
+    uint64_t window = DEFAULT_WINDOW;
+    bool all_windows = false;
+    bool format_only = false;
+    uint64_t show_block = 0;
+    std::string key;
+    std::string batch_root;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    uint64_t sample = 0;
+    bool json = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-w" && i + 1 < argc) {
+            if (!MemoryBudget::parse_size(argv[++i], window) || window == 0) {
+                std::cerr << "Error: -w requiere un tamaño válido (ej: 64K, 1M)\n";
+                return 1;
+            }
+        } else if (arg == "-p") {
+            all_windows = true;
+        } else if (arg == "-f") {
+            format_only = true;
+        } else if (arg == "-b" && i + 1 < argc) {
+            show_block = strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "-k" && i + 1 < argc) {
+            key = argv[++i];
+        } else if (arg == "-r" && i + 1 < argc) {
+            batch_root = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+            if (threads <= 0) {
+                std::cerr << "Error: -j requiere un número de hilos mayor que 0\n";
+                return 1;
+            }
+        } else if (arg == "-s" && i + 1 < argc) {
+            if (!MemoryBudget::parse_size(argv[++i], sample)) {
+                std::cerr << "Error: -s requiere un tamaño válido (ej: 4M)\n";
+                return 1;
+            }
+        } else if (arg == "--format=csv" || arg == "--format=json") {
+            json = arg == "--format=json";
+        } else if (filename.empty() && arg[0] != '-') {
+            filename = arg;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!batch_root.empty()) {
+        while (batch_root.size() > 1 && batch_root.back() == '/') batch_root.pop_back();
+        return run_batch(batch_root, threads, sample, json) ? 0 : 1;
+    }
+    if (filename.empty()) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    
     std::cout << "╔════════════════════════════════════════════════════════╗\n";
     std::cout << "║  GSEA Inspector - Herramienta de Inspección          ║\n";
     std::cout << "║  Visualiza archivos comprimidos/encriptados          ║\n";
     std::cout << "╚════════════════════════════════════════════════════════╝\n\n";
     
-    if (argc < 2) {
-        std::cout << "Uso: " << argv[0] << " <archivo>\n";
-        std::cout << "\nEjemplos:\n";
-        std::cout << "  " << argv[0] << " archivo.txt\n";
-        std::cout << "  " << argv[0] << " archivo.txt.huff\n";
-        std::cout << "  " << argv[0] << " archivo.txt.enc\n";
+    WindowReader reader;
+    std::string error;
+    if (!reader.open_file(filename, window, error)) {
+        std::cerr << "Error: No se pudo abrir " << filename << ": " << error << "\n";
         return 1;
     }
     
-    std::string filename = argv[1];
+    std::cout << "Analizando: " << filename << "\n";
+    std::cout << "════════════════════════════════════════════════════════\n";
     
-    // Verificar que el archivo existe
-    if (!FileManager::file_exists(filename)) {
-        std::cerr << "Error: El archivo no existe: " << filename << "\n";
-        return 1;
+    // Formato: solo cabeceras, así que va primero (y con -f es lo único)
+    bool recognized = inspect_format(filename, key, show_block);
+    if (format_only) {
+        return recognized ? 0 : 1;
     }
+    std::cout << "\n";
     
-    // Leer el archivo
-    std::cout << "Analizando: " << filename << "\n";
-    std::cout << "════════════════════════════════════════════════════════\n\n";
-    
-    FileManager fm(filename);
-    std::vector<unsigned char> data = fm.read_file();
+    // Una sola pasada: histograma total, perfil por ventana y los primeros
+    // bytes (para el tipo, el volcado y la vista de caracteres)
+    uint64_t frequency[256] = {0};
+    EntropyProfile profile(all_windows);
+    std::vector<unsigned char> prefix;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    while (reader.next(data, size)) {
+        uint64_t offset = reader.consumed() - size;
+        if (prefix.size() < 1024) {
+            prefix.insert(prefix.end(), data, data + std::min(size, 1024 - prefix.size()));
+        }
+        uint64_t window_frequency[256] = {0};
+        HuffmanCoder::count_frequencies(data, size, window_frequency);
+        for (int i = 0; i < 256; i++) {
+            frequency[i] += window_frequency[i];
+        }
+        profile.add(offset, size, calculate_entropy(window_frequency, size));
+    }
+    uint64_t total = reader.consumed();
     
-    if (data.empty()) {
+    if (total == 0) {
         std::cerr << "Error: No se pudo leer el archivo o está vacío\n";
         return 1;
     }
@@ -212,11 +1122,11 @@ int main(int argc, char* argv[]) {
     std::cout << "┌─────────────────────────────────────────────────┐\n";
     std::cout << "│ INFORMACIÓN BÁSICA                              │\n";
     std::cout << "├─────────────────────────────────────────────────┤\n";
-    std::cout << "│ Tamaño:        " << std::setw(10) << data.size() << " bytes             │\n";
+    std::cout << "│ Tamaño:        " << std::setw(10) << total << " bytes             │\n";
     std::cout << "│ Tipo detectado: " << std::setw(28) << std::left 
-              << detect_file_type(data) << " │\n" << std::right;
+              << detect_file_type(prefix) << " │\n" << std::right;
     
-    double entropy = calculate_entropy(data);
+    double entropy = calculate_entropy(frequency, total);
     std::cout << "│ Entropía:      " << std::fixed << std::setprecision(4) 
               << std::setw(10) << entropy << " bits/byte       │\n";
     std::cout << "│                                                 │\n";
@@ -238,23 +1148,29 @@ int main(int argc, char* argv[]) {
     } else {
         std::cout << "→ Este archivo tiene ALTA entropía (probablemente ENCRIPTADO)\n";
     }
+    std::cout << "  (Huffman no puede bajar de " << std::setprecision(2) << entropy
+              << " bits/byte: ~" << std::setprecision(0) << 100.0 * entropy / 8.0
+              << "% del tamaño original)\n";
+    
+    // PERFIL POR VENTANAS
+    profile.print(reader.window_size(), total);
     
     // VOLCADO HEXADECIMAL
     std::cout << "\n┌─────────────────────────────────────────────────┐\n";
     std::cout << "│ VOLCADO HEXADECIMAL (primeras 256 bytes)        │\n";
     std::cout << "└─────────────────────────────────────────────────┘";
-    print_hex_dump(data, 16);
+    print_hex_dump(prefix, total, 16);
     
     // DISTRIBUCIÓN DE BYTES
-    analyze_distribution(data);
+    analyze_distribution(frequency, total);
     
     // COMPARACIÓN VISUAL
     std::cout << "\n┌─────────────────────────────────────────────────┐\n";
     std::cout << "│ PRIMEROS 100 CARACTERES (representación visual) │\n";
     std::cout << "└─────────────────────────────────────────────────┘\n";
     std::cout << "\n";
-    for (size_t i = 0; i < data.size() && i < 100; i++) {
-        unsigned char c = data[i];
+    for (size_t i = 0; i < prefix.size() && i < 100; i++) {
+        unsigned char c = prefix[i];
         if (c >= 32 && c <= 126) {
             std::cout << c;
         } else {
@@ -267,4 +1183,4 @@ int main(int argc, char* argv[]) {
     std::cout << "Análisis completado\n";
     
     return 0;
-}
\ No newline at end of file
+}
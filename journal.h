@@ -0,0 +1,325 @@
+#ifndef GSEA_JOURNAL_H
+#define GSEA_JOURNAL_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "log.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+const uint64_t JOURNAL_DEFAULT_CHECKPOINT = 256ULL << 20;   // Entrada entre puntos de control
+
+// Punto de control de un archivo a medio procesar: hasta dónde se leyó la
+// entrada y se escribió la salida, en un límite de bloque del formato
+struct JournalCheckpoint {
+    uint64_t input_offset = 0;
+    uint64_t output_offset = 0;
+    uint64_t block_index = 0;      // Próximo bloque (los huecos cuentan varios)
+    uint64_t produced = 0;         // Al decodificar: bytes originales ya escritos
+    uint64_t holes = 0;            // Al codificar: bloques ya guardados como huecos
+    bool compressed_format = false;    // --comp-alg auto: lo que se detectó en el bloque 0
+};
+
+// Diario de un trabajo para retomarlo si se corta (--journal, --resume)
+//
+// Solo se agregan líneas al final y cada una se fuerza a disco con
+// fdatasync() antes de seguir, así que tras un corte (OOM, reinicio) el
+// diario dice exactamente qué quedó hecho. Formato de texto, campos
+// separados por TAB:
+//   GSEA-JOURNAL 1 <firma>
+//   D <entrada> <salida> <size> <mtime_s> <mtime_ns> <ino>
+//   C <entrada> <salida> <size> <mtime_s> <mtime_ns> <ino> <off_entrada> <off_salida> <bloque> <producido> <huecos> <formato>
+//
+// D: la salida está completa y en disco. C: punto de control de un archivo
+// grande procesado por bloques (el último de cada archivo es el que vale).
+// Una línea sin '\n' al final (cortada a mitad) se ignora. La firma resume
+// la configuración y las rutas de -i/-o: con otra, --resume empieza de cero.
+//
+// Todos los métodos pueden llamarse desde varios hilos (-j).
+class Journal {
+private:
+    struct FileState {
+        uint64_t size = 0;
+        int64_t mtime_sec = 0;
+        long mtime_nsec = 0;
+        uint64_t inode = 0;
+        std::string output;
+        bool done = false;
+        JournalCheckpoint checkpoint;
+    };
+
+    std::string path;
+    std::string signature;
+    uint64_t interval;                          // Bytes de entrada entre puntos de control
+    int fd;
+    std::map<std::string, FileState> files;     // entrada -> último estado
+    pthread_mutex_t mutex;
+
+    static std::string escape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '%') out += "%25";
+            else if (c == '\t') out += "%09";
+            else if (c == '\n') out += "%0A";
+            else out += c;
+        }
+        return out;
+    }
+
+    static std::string unescape(const std::string& s) {
+        std::string out;
+        for (size_t i = 0; i < s.size(); i++) {
+            if (s[i] == '%' && i + 2 < s.size()) {
+                out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            } else {
+                out += s[i];
+            }
+        }
+        return out;
+    }
+
+    static std::vector<std::string> split_tabs(const std::string& line) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            size_t tab = line.find('\t', start);
+            if (tab == std::string::npos) {
+                fields.push_back(line.substr(start));
+                break;
+            }
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        return fields;
+    }
+
+    static bool write_all(int fd, const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = write(fd, data.data() + done, data.size() - done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+    static bool same_input(const FileState& state, const std::string& output, const struct stat& st) {
+        return state.output == output && state.size == (uint64_t)st.st_size &&
+               state.mtime_sec == st.st_mtim.tv_sec && state.mtime_nsec == st.st_mtim.tv_nsec &&
+               state.inode == (uint64_t)st.st_ino;
+    }
+
+    static std::string identity(const std::string& input, const std::string& output, const struct stat& st) {
+        char number[96];
+        snprintf(number, sizeof(number), "\t%llu\t%lld\t%ld\t%llu", (unsigned long long)st.st_size,
+                 (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec, (unsigned long long)st.st_ino);
+        return escape(input) + "\t" + escape(output) + number;
+    }
+
+    // Agregar una línea y forzarla a disco (con el lock tomado)
+    bool append(const std::string& line) {
+        if (!write_all(fd, line) || fdatasync(fd) == -1) {
+            GSEA_ERROR("  [Error] No se pudo escribir el diario: " << strerror(errno) << "\n");
+            return false;
+        }
+        return true;
+    }
+
+    void parse(const std::string& content) {
+        size_t line_start = 0;
+        bool header_ok = false;
+        while (line_start < content.size()) {
+            size_t line_end = content.find('\n', line_start);
+            if (line_end == std::string::npos) break;      // Cortada por la interrupción
+            std::vector<std::string> fields = split_tabs(content.substr(line_start, line_end - line_start));
+            line_start = line_end + 1;
+
+            if (!header_ok) {
+                if (fields.size() != 2 || fields[0] != "GSEA-JOURNAL 1" || unescape(fields[1]) != signature) {
+                    GSEA_INFO("  [Diario] Es de otro trabajo o de otra configuración: se empieza de cero\n");
+                    return;
+                }
+                header_ok = true;
+                continue;
+            }
+
+            bool done = fields.size() == 7 && fields[0] == "D";
+            if (!done && (fields.size() != 13 || fields[0] != "C")) continue;   // Línea dañada
+            FileState state;
+            state.output = unescape(fields[2]);
+            state.size = strtoull(fields[3].c_str(), nullptr, 10);
+            state.mtime_sec = strtoll(fields[4].c_str(), nullptr, 10);
+            state.mtime_nsec = strtol(fields[5].c_str(), nullptr, 10);
+            state.inode = strtoull(fields[6].c_str(), nullptr, 10);
+            state.done = done;
+            if (!done) {
+                state.checkpoint.input_offset = strtoull(fields[7].c_str(), nullptr, 10);
+                state.checkpoint.output_offset = strtoull(fields[8].c_str(), nullptr, 10);
+                state.checkpoint.block_index = strtoull(fields[9].c_str(), nullptr, 10);
+                state.checkpoint.produced = strtoull(fields[10].c_str(), nullptr, 10);
+                state.checkpoint.holes = strtoull(fields[11].c_str(), nullptr, 10);
+                state.checkpoint.compressed_format = fields[12] == "1";
+            }
+            files[unescape(fields[1])] = state;
+        }
+    }
+
+public:
+    Journal(const std::string& journal_path, const std::string& job_signature, uint64_t checkpoint_bytes)
+        : path(journal_path), signature(job_signature), interval(checkpoint_bytes), fd(-1) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~Journal() {
+        if (fd != -1) close(fd);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    // Abrir el diario. Con resume se carga lo que dejó la ejecución anterior
+    // y se sigue agregando; sin resume (o si era de otro trabajo) se
+    // reescribe vacío
+    bool open_journal(bool resume) {
+        files.clear();
+        if (resume) {
+            int in = open(path.c_str(), O_RDONLY);
+            if (in == -1 && errno != ENOENT) {
+                GSEA_ERROR("  [Error] open() del diario falló: " << strerror(errno) << "\n");
+                return false;
+            }
+            std::string content;
+            char buffer[65536];
+            ssize_t n = 0;
+            while (in != -1 && (n = read(in, buffer, sizeof(buffer))) != 0) {
+                if (n == -1) {
+                    if (errno == EINTR) continue;
+                    GSEA_ERROR("  [Error] read() del diario falló: " << strerror(errno) << "\n");
+                    close(in);
+                    return false;
+                }
+                content.append(buffer, n);
+            }
+            if (in != -1) close(in);
+            parse(content);
+        }
+
+        if (!files.empty()) {
+            // Seguir agregando; una última línea cortada se descarta
+            fd = open(path.c_str(), O_RDWR);
+            struct stat st;
+            if (fd != -1 && fstat(fd, &st) == 0) {
+                off_t end = st.st_size;
+                char last = '\n';
+                while (end > 0 && pread(fd, &last, 1, end - 1) == 1 && last != '\n') end--;
+                if (ftruncate(fd, end) == -1 || lseek(fd, 0, SEEK_END) == -1) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            size_t done = 0;
+            for (const auto& pair : files) done += pair.second.done ? 1 : 0;
+            GSEA_INFO("  [Diario] Se retoma: " << done << " archivo(s) completos, "
+                      << files.size() - done << " a medio procesar\n");
+        } else {
+            fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd != -1 && !append("GSEA-JOURNAL 1\t" + escape(signature) + "\n")) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        if (fd == -1) {
+            GSEA_ERROR("  [Error] No se pudo abrir el diario " << path << ": " << strerror(errno) << "\n");
+            return false;
+        }
+
+        // fsync() del directorio: el diario recién creado también debe sobrevivir
+        size_t last_slash = path.find_last_of('/');
+        std::string dir = (last_slash != std::string::npos) ? path.substr(0, last_slash + 1) : ".";
+        int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dir_fd != -1) {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+        return true;
+    }
+
+    uint64_t checkpoint_interval() const { return interval; }
+
+    // ¿La salida de este archivo quedó completa en la ejecución anterior?
+    // (la entrada no cambió y la salida sigue existiendo)
+    bool completed(const std::string& input, const std::string& output, const struct stat& st) {
+        pthread_mutex_lock(&mutex);
+        std::map<std::string, FileState>::iterator it = files.find(input);
+        bool done = it != files.end() && it->second.done && same_input(it->second, output, st);
+        pthread_mutex_unlock(&mutex);
+        struct stat out_st;
+        return done && stat(output.c_str(), &out_st) == 0;
+    }
+
+    // Último punto de control de este archivo, si la entrada no cambió
+    bool checkpoint_for(const std::string& input, const std::string& output, const struct stat& st,
+                        JournalCheckpoint& checkpoint) {
+        pthread_mutex_lock(&mutex);
+        std::map<std::string, FileState>::iterator it = files.find(input);
+        bool found = it != files.end() && !it->second.done && same_input(it->second, output, st);
+        if (found) checkpoint = it->second.checkpoint;
+        pthread_mutex_unlock(&mutex);
+        struct stat out_st;
+        return found && stat(output.c_str(), &out_st) == 0;
+    }
+
+    // Registrar un punto de control. Quien llama ya forzó a disco la salida
+    // hasta output_offset
+    bool record_checkpoint(const std::string& input, const std::string& output, const struct stat& st,
+                           const JournalCheckpoint& checkpoint) {
+        char number[160];
+        snprintf(number, sizeof(number), "\t%llu\t%llu\t%llu\t%llu\t%llu\t%d\n",
+                 (unsigned long long)checkpoint.input_offset, (unsigned long long)checkpoint.output_offset,
+                 (unsigned long long)checkpoint.block_index, (unsigned long long)checkpoint.produced,
+                 (unsigned long long)checkpoint.holes, checkpoint.compressed_format ? 1 : 0);
+        pthread_mutex_lock(&mutex);
+        bool ok = append("C\t" + identity(input, output, st) + number);
+        pthread_mutex_unlock(&mutex);
+        return ok;
+    }
+
+    // Registrar una salida completa: primero se fuerza a disco (con su
+    // entrada en el directorio) y después se anota
+    bool record_done(const std::string& input, const std::string& output, const struct stat& st) {
+        int out = open(output.c_str(), O_RDONLY);
+        bool synced = out != -1 && fsync(out) == 0;
+        if (out != -1) close(out);
+        size_t last_slash = output.find_last_of('/');
+        std::string dir = (last_slash != std::string::npos) ? output.substr(0, last_slash + 1) : ".";
+        int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dir_fd != -1) {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+        if (!synced) {
+            GSEA_ERROR("  [Error] fsync() de " << output << " falló: " << strerror(errno) << "\n");
+            return false;
+        }
+        pthread_mutex_lock(&mutex);
+        bool ok = append("D\t" + identity(input, output, st) + "\n");
+        pthread_mutex_unlock(&mutex);
+        return ok;
+    }
+};
+
+#endif // GSEA_JOURNAL_H
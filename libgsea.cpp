@@ -0,0 +1,429 @@
+// libgsea: API en C sobre container.h (ver gsea.h)
+//
+// Se compila con GSEA_LOG_MAX_LEVEL=-1: los mensajes de los headers no
+// generan código, así que la biblioteca no escribe nada. Los símbolos son
+// ocultos salvo los gsea_* de gsea.h (-fvisibility=hidden).
+
+#include "gsea.h"
+
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "container.h"
+
+struct gsea_ctx {
+    enum Mode { IDLE, ENCODING, DECODING };
+    enum Step { STEP_HEADER, STEP_BLOCK_HEADER, STEP_BLOCK_DATA, STEP_DONE };
+
+    int level;                             // 0 = sin compresión
+    std::unique_ptr<XORCipher> cipher;     // nullptr = sin clave
+    BlockCodec codec;
+    std::vector<unsigned char> raw;        // Un bloque original
+    std::vector<unsigned char> frame;      // Un bloque codificado (cabecera incluida)
+    uint32_t decode_reserved;              // Bloque más grande para el que se reservó al decodificar
+
+    // Por tramos
+    Mode mode;
+    Step step;
+    ContainerHeader header;
+    unsigned char header_bytes[ContainerHeader::MAX_SIZE];
+    size_t header_need;                    // Bytes de cabecera a juntar
+    BlockHeader block;                     // Bloque que se está leyendo
+    uint64_t total;                        // Bytes originales consumidos / producidos
+    uint64_t index;                        // Próximo bloque
+    size_t fill;                           // Bytes juntados en raw (codificar) o frame (decodificar)
+    const unsigned char* pending;          // Salida lista que no entró en dst
+    size_t pending_size;
+
+    gsea_ctx(int compression_level, const void* key, size_t key_size)
+        : level(compression_level),
+          cipher(key != nullptr ? new XORCipher(std::string((const char*)key, key_size)) : nullptr),
+          codec(CONTAINER_CODEC_NONE, cipher.get(), block_size_of(compression_level)),
+          decode_reserved(0), mode(IDLE), step(STEP_DONE), header_need(0), total(0), index(0), fill(0),
+          pending(nullptr), pending_size(0) {
+        ContainerHeader sample = encode_header(0);
+        codec.reset(sample.codec, cipher.get(), sample.block_size);
+        codec.set_level(level > 0 ? level : CONTAINER_DEFAULT_LEVEL);
+        codec.reserve(true);
+        raw.resize(sample.block_size);
+        frame.resize(BlockCodec::frame_bound(sample.block_size));
+    }
+
+    static uint32_t block_size_of(int level) {
+        return level > 0 ? CompressionLevel::of(level).block_size : CONTAINER_BLOCK_SIZE;
+    }
+
+    ContainerHeader encode_header(uint64_t size) const {
+        return ContainerHeader::for_encode(level > 0, cipher.get(), size,
+                                           level > 0 ? level : CONTAINER_DEFAULT_LEVEL);
+    }
+
+    // Buffers y códecs para decodificar bloques de block_size (solo crecen:
+    // se reserva una vez por tamaño de bloque mayor al ya visto)
+    bool fit(uint32_t block_size) {
+        try {
+            if (raw.size() < block_size) raw.resize(block_size);
+            if (frame.size() < BlockCodec::frame_bound(block_size)) {
+                frame.resize(BlockCodec::frame_bound(block_size));
+            }
+            if (decode_reserved < block_size) {
+                codec.reserve(false);
+                decode_reserved = block_size;
+            }
+        } catch (const std::bad_alloc&) {
+            return false;
+        }
+        return true;
+    }
+
+    // Validar la cabecera de un archivo a decodificar y preparar el códec
+    int open_header(const unsigned char* data, size_t size, size_t& consumed) {
+        int status = header.read(data, size, consumed);
+        // Los huecos (archivos dispersos de gsea -c) no se producen ni se leen aquí
+        if (status != 1 || !header.blocked() || header.delta() || header.holes()) return GSEA_ERR_FORMAT;
+        if (header.cipher != CONTAINER_CIPHER_NONE) {
+            if (!cipher) return GSEA_ERR_KEY;
+            if (!header.key_matches(*cipher)) return GSEA_ERR_KEY;
+        }
+        codec.reset(header.codec, header.cipher != CONTAINER_CIPHER_NONE ? cipher.get() : nullptr,
+                    header.block_size);
+        return fit(header.block_size) ? GSEA_OK : GSEA_ERR_NOMEM;
+    }
+
+    // Decodificar el bloque actual (stored: sus bytes guardados) en out
+    int decode(const unsigned char* stored, unsigned char* out) {
+        // Sin cifrado decode_block no escribe en stored; con cifrado stored
+        // ya es una copia en frame
+        unsigned char* writable = const_cast<unsigned char*>(stored);
+        if (!codec.decode_block(block, writable, index, out).empty()) return GSEA_ERR_CORRUPT;
+        index++;
+        total += block.raw_size;
+        return GSEA_OK;
+    }
+
+    // Copiar a dst lo que quedó pendiente. Retorna true si no queda nada
+    bool drain(unsigned char* dst, size_t capacity, size_t& written) {
+        size_t n = std::min(pending_size, capacity - written);
+        if (n > 0) memcpy(dst + written, pending, n);
+        pending += n;
+        pending_size -= n;
+        written += n;
+        return pending_size == 0;
+    }
+
+    int fail(int status) {
+        mode = IDLE;
+        return status;
+    }
+};
+
+extern "C" {
+
+gsea_ctx* gsea_ctx_new(int level, const void* key, size_t key_size) {
+    if (level < GSEA_LEVEL_NONE || level > GSEA_LEVEL_MAX) return nullptr;
+    try {
+        return new gsea_ctx(level, key, key_size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void gsea_ctx_free(gsea_ctx* ctx) {
+    delete ctx;
+}
+
+size_t gsea_compress_bound(size_t src_size, int level) {
+    if (level < GSEA_LEVEL_NONE || level > GSEA_LEVEL_MAX) return 0;
+    return ContainerHeader::LEVEL_SIZE + BlockCodec::total_bound(src_size, gsea_ctx::block_size_of(level));
+}
+
+int gsea_compress(gsea_ctx* ctx, const void* src, size_t src_size,
+                  void* dst, size_t dst_capacity, size_t* dst_size) {
+    if (ctx == nullptr || (src == nullptr && src_size > 0) || dst == nullptr || dst_size == nullptr) {
+        return GSEA_ERR_ARGS;
+    }
+    ctx->mode = gsea_ctx::IDLE;
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+
+    ContainerHeader header = ctx->encode_header(src_size);
+    size_t written = header.write(ctx->header_bytes);
+    if (written > dst_capacity) return GSEA_ERR_DST_TOO_SMALL;
+    memcpy(out, ctx->header_bytes, written);
+    ctx->codec.reset(header.codec, ctx->cipher.get(), header.block_size);
+
+    uint64_t index = 0;
+    for (size_t offset = 0; offset < src_size; offset += header.block_size, index++) {
+        size_t n = std::min((size_t)header.block_size, src_size - offset);
+        if (dst_capacity - written >= BlockCodec::frame_bound(n)) {
+            written += ctx->codec.encode_block(in + offset, n, index, out + written);
+        } else {
+            // Cerca del final de dst: el bloque puede entrar aunque su cota no
+            size_t frame = ctx->codec.encode_block(in + offset, n, index, ctx->frame.data());
+            if (frame > dst_capacity - written) return GSEA_ERR_DST_TOO_SMALL;
+            memcpy(out + written, ctx->frame.data(), frame);
+            written += frame;
+        }
+    }
+    *dst_size = written;
+    return GSEA_OK;
+}
+
+int gsea_decompressed_size(const void* src, size_t src_size, uint64_t* size) {
+    if (src == nullptr || size == nullptr) return GSEA_ERR_ARGS;
+    ContainerHeader header;
+    size_t consumed = 0;
+    if (header.read((const unsigned char*)src, src_size, consumed) != 1 || !header.blocked() || header.delta() ||
+        header.holes()) {
+        return GSEA_ERR_FORMAT;
+    }
+    *size = header.original_size;
+    return GSEA_OK;
+}
+
+int gsea_decompress(gsea_ctx* ctx, const void* src, size_t src_size,
+                    void* dst, size_t dst_capacity, size_t* dst_size) {
+    if (ctx == nullptr || src == nullptr || (dst == nullptr && dst_capacity > 0) || dst_size == nullptr) {
+        return GSEA_ERR_ARGS;
+    }
+    ctx->mode = gsea_ctx::IDLE;
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+
+    size_t offset = 0;
+    int status = ctx->open_header(in, src_size, offset);
+    if (status != GSEA_OK) return status;
+    if (ctx->header.original_size > dst_capacity) return GSEA_ERR_DST_TOO_SMALL;
+
+    bool encrypted = ctx->header.cipher != CONTAINER_CIPHER_NONE;
+    ctx->total = 0;
+    ctx->index = 0;
+    while (offset < src_size) {
+        BlockHeader& block = ctx->block;
+        if (src_size - offset < BlockHeader::SIZE || !block.read(in + offset, ctx->header.block_size) ||
+            block.stored_size > src_size - offset - BlockHeader::SIZE ||
+            block.raw_size > ctx->header.original_size - ctx->total) {
+            return GSEA_ERR_CORRUPT;
+        }
+        const unsigned char* stored = in + offset + BlockHeader::SIZE;
+        if (encrypted) {
+            // Se desencripta en el lugar: sobre una copia, src es del llamador
+            memcpy(ctx->frame.data(), stored, block.stored_size);
+            stored = ctx->frame.data();
+        }
+        status = ctx->decode(stored, out + ctx->total);
+        if (status != GSEA_OK) return status;
+        offset += BlockHeader::SIZE + block.stored_size;
+    }
+    if (ctx->total != ctx->header.original_size) return GSEA_ERR_CORRUPT;
+    *dst_size = ctx->total;
+    return GSEA_OK;
+}
+
+int gsea_encode_begin(gsea_ctx* ctx, uint64_t total_size) {
+    if (ctx == nullptr) return GSEA_ERR_ARGS;
+    ctx->header = ctx->encode_header(total_size);
+    ctx->codec.reset(ctx->header.codec, ctx->cipher.get(), ctx->header.block_size);
+    ctx->pending = ctx->header_bytes;
+    ctx->pending_size = ctx->header.write(ctx->header_bytes);
+    ctx->mode = gsea_ctx::ENCODING;
+    ctx->step = gsea_ctx::STEP_BLOCK_DATA;
+    ctx->total = 0;
+    ctx->index = 0;
+    ctx->fill = 0;
+    return GSEA_OK;
+}
+
+int gsea_encode_update(gsea_ctx* ctx, const void* src, size_t* src_size,
+                       void* dst, size_t* dst_size, int finish) {
+    if (ctx == nullptr || src_size == nullptr || dst_size == nullptr ||
+        (src == nullptr && *src_size > 0) || (dst == nullptr && *dst_size > 0)) {
+        return GSEA_ERR_ARGS;
+    }
+    if (ctx->mode != gsea_ctx::ENCODING) return GSEA_ERR_ARGS;
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+    size_t available = *src_size, capacity = *dst_size;
+    size_t consumed = 0, written = 0;
+    uint32_t block_size = ctx->header.block_size;
+    int status = GSEA_OK;
+
+    while (ctx->drain(out, capacity, written)) {
+        if (ctx->step == gsea_ctx::STEP_DONE) {
+            ctx->mode = gsea_ctx::IDLE;
+            status = GSEA_END;
+            break;
+        }
+        size_t left = available - consumed;
+        if (left > ctx->header.original_size - ctx->total - ctx->fill) {
+            status = ctx->fail(GSEA_ERR_SIZE);
+            break;
+        }
+
+        // Un bloque entero en src se codifica sin copiarlo a raw
+        const unsigned char* raw = nullptr;
+        size_t n = 0;
+        if (ctx->fill == 0 && (left >= block_size || (finish && left > 0))) {
+            raw = in + consumed;
+            n = std::min((size_t)block_size, left);
+            consumed += n;
+        } else {
+            size_t take = std::min((size_t)block_size - ctx->fill, left);
+            if (take > 0) memcpy(ctx->raw.data() + ctx->fill, in + consumed, take);
+            ctx->fill += take;
+            consumed += take;
+            if (ctx->fill == block_size || (finish && consumed == available && ctx->fill > 0)) {
+                raw = ctx->raw.data();
+                n = ctx->fill;
+                ctx->fill = 0;
+            }
+        }
+
+        if (raw != nullptr) {
+            if (capacity - written >= BlockCodec::frame_bound(n)) {
+                written += ctx->codec.encode_block(raw, n, ctx->index, out + written);
+            } else {
+                ctx->pending = ctx->frame.data();
+                ctx->pending_size = ctx->codec.encode_block(raw, n, ctx->index, ctx->frame.data());
+            }
+            ctx->index++;
+            ctx->total += n;
+            continue;
+        }
+        if (finish && consumed == available) {
+            if (ctx->total != ctx->header.original_size) {
+                status = ctx->fail(GSEA_ERR_SIZE);
+                break;
+            }
+            ctx->step = gsea_ctx::STEP_DONE;
+            continue;
+        }
+        break;  // Falta entrada
+    }
+    *src_size = consumed;
+    *dst_size = written;
+    return status;
+}
+
+int gsea_decode_begin(gsea_ctx* ctx) {
+    if (ctx == nullptr) return GSEA_ERR_ARGS;
+    ctx->mode = gsea_ctx::DECODING;
+    ctx->step = gsea_ctx::STEP_HEADER;
+    ctx->header_need = ContainerHeader::SIZE;
+    ctx->pending = nullptr;
+    ctx->pending_size = 0;
+    ctx->total = 0;
+    ctx->index = 0;
+    ctx->fill = 0;
+    return GSEA_OK;
+}
+
+int gsea_decode_update(gsea_ctx* ctx, const void* src, size_t* src_size,
+                       void* dst, size_t* dst_size) {
+    if (ctx == nullptr || src_size == nullptr || dst_size == nullptr ||
+        (src == nullptr && *src_size > 0) || (dst == nullptr && *dst_size > 0)) {
+        return GSEA_ERR_ARGS;
+    }
+    if (ctx->mode != gsea_ctx::DECODING) return GSEA_ERR_ARGS;
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+    size_t available = *src_size, capacity = *dst_size;
+    size_t consumed = 0, written = 0;
+    int status = GSEA_OK;
+
+    // Juntar need bytes de src en buffer (a partir de ctx->fill)
+    auto gather = [&](unsigned char* buffer, size_t need) {
+        size_t take = std::min(need - ctx->fill, available - consumed);
+        if (take > 0) memcpy(buffer + ctx->fill, in + consumed, take);
+        ctx->fill += take;
+        consumed += take;
+        return ctx->fill == need;
+    };
+
+    while (ctx->drain(out, capacity, written)) {
+        if (ctx->step == gsea_ctx::STEP_DONE) {
+            status = GSEA_END;
+            break;
+        }
+        if (ctx->step == gsea_ctx::STEP_HEADER) {
+            if (!gather(ctx->header_bytes, ctx->header_need)) break;
+            size_t header_size = ctx->header_bytes[7];
+            if (ctx->header_need == ContainerHeader::SIZE && header_size > ContainerHeader::SIZE &&
+                memcmp(ctx->header_bytes, "GSEA", 4) == 0) {
+                ctx->header_need = header_size;   // Cabecera con campos extra
+                continue;
+            }
+            size_t unused = 0;
+            status = ctx->open_header(ctx->header_bytes, ctx->fill, unused);
+            if (status != GSEA_OK) {
+                status = ctx->fail(status);
+                break;
+            }
+            ctx->fill = 0;
+            ctx->step = ctx->header.original_size == 0 ? gsea_ctx::STEP_DONE : gsea_ctx::STEP_BLOCK_HEADER;
+        } else if (ctx->step == gsea_ctx::STEP_BLOCK_HEADER) {
+            if (!gather(ctx->frame.data(), BlockHeader::SIZE)) break;
+            if (!ctx->block.read(ctx->frame.data(), ctx->header.block_size) ||
+                ctx->block.raw_size > ctx->header.original_size - ctx->total) {
+                status = ctx->fail(GSEA_ERR_CORRUPT);
+                break;
+            }
+            ctx->fill = 0;
+            ctx->step = gsea_ctx::STEP_BLOCK_DATA;
+        } else {
+            // Sin cifrado, un bloque entero en src se decodifica desde ahí
+            const unsigned char* stored = nullptr;
+            size_t stored_size = ctx->block.stored_size;
+            if (ctx->fill == 0 && available - consumed >= stored_size &&
+                ctx->header.cipher == CONTAINER_CIPHER_NONE) {
+                stored = in + consumed;
+                consumed += stored_size;
+            } else if (gather(ctx->frame.data(), stored_size)) {
+                stored = ctx->frame.data();
+            } else {
+                break;
+            }
+            ctx->fill = 0;
+
+            // Directo a dst si entra; si no, a raw y se copia de a poco
+            bool direct = capacity - written >= ctx->block.raw_size;
+            unsigned char* target = direct ? out + written : ctx->raw.data();
+            status = ctx->decode(stored, target);
+            if (status != GSEA_OK) {
+                status = ctx->fail(status);
+                break;
+            }
+            if (direct) {
+                written += ctx->block.raw_size;
+            } else {
+                ctx->pending = ctx->raw.data();
+                ctx->pending_size = ctx->block.raw_size;
+            }
+            ctx->step = ctx->total == ctx->header.original_size ? gsea_ctx::STEP_DONE
+                                                                : gsea_ctx::STEP_BLOCK_HEADER;
+        }
+    }
+    *src_size = consumed;
+    *dst_size = written;
+    return status;
+}
+
+const char* gsea_strerror(int status) {
+    switch (status) {
+        case GSEA_OK: return "ok";
+        case GSEA_END: return "fin del flujo";
+        case GSEA_ERR_ARGS: return "argumento inválido";
+        case GSEA_ERR_DST_TOO_SMALL: return "buffer de salida insuficiente";
+        case GSEA_ERR_FORMAT: return "no es un archivo de GSEA por bloques";
+        case GSEA_ERR_CORRUPT: return "datos dañados o truncados";
+        case GSEA_ERR_KEY: return "falta la clave o no coincide";
+        case GSEA_ERR_NOMEM: return "sin memoria";
+        case GSEA_ERR_SIZE: return "la entrada no coincide con el tamaño declarado";
+    }
+    return "error desconocido";
+}
+
+}  // extern "C"
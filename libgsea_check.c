@@ -0,0 +1,186 @@
+/*
+ * gsea-libcheck: prueba de libgsea desde C (make test)
+ *
+ * Uso: gsea-libcheck <entrada> <clave> <salida.gsea> [<archivo de gsea -ce>]
+ *
+ *   - Varios hilos, cada uno con su contexto, comprimen y descomprimen la
+ *     entrada buffer a buffer y por tramos de tamaños variados, con y sin
+ *     clave y con distintos niveles; los dos caminos deben dar los mismos
+ *     bytes y reproducir la entrada
+ *   - Escribe la entrada comprimida y cifrada (nivel 3) en <salida.gsea>,
+ *     para abrirla con gsea -du
+ *   - Si se da, descomprime un archivo escrito por gsea -ce y lo compara
+ */
+
+#include "gsea.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define THREADS 4
+
+static unsigned char* input;
+static size_t input_size;
+static const char* key;
+
+static unsigned char* read_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    unsigned char* data = malloc(length > 0 ? (size_t)length : 1);
+    if (data != NULL && fread(data, 1, (size_t)length, file) != (size_t)length) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return data;
+}
+
+/* Codificar por tramos de tamaños que cambian en cada llamado */
+static int encode_chunked(gsea_ctx* ctx, unsigned char* dst, size_t capacity, size_t* written) {
+    size_t in_pos = 0, out_pos = 0, step = 1;
+    int status = gsea_encode_begin(ctx, input_size);
+    while (status == GSEA_OK) {
+        size_t in = input_size - in_pos < step ? input_size - in_pos : step;
+        size_t out = capacity - out_pos < step / 2 + 1 ? capacity - out_pos : step / 2 + 1;
+        if (out == 0) return GSEA_ERR_DST_TOO_SMALL;
+        status = gsea_encode_update(ctx, input + in_pos, &in, dst + out_pos, &out,
+                                    in_pos + in == input_size);
+        in_pos += in;
+        out_pos += out;
+        step = step * 7 % 65521 + 1;
+    }
+    *written = out_pos;
+    return status == GSEA_END ? GSEA_OK : status;
+}
+
+static int decode_chunked(gsea_ctx* ctx, const unsigned char* src, size_t size,
+                          unsigned char* dst, size_t capacity, size_t* written) {
+    size_t in_pos = 0, out_pos = 0, step = 3;
+    int status = gsea_decode_begin(ctx);
+    while (status == GSEA_OK) {
+        size_t in = size - in_pos < step ? size - in_pos : step;
+        size_t out = capacity - out_pos < step * 2 ? capacity - out_pos : step * 2;
+        if (in == 0 && out == 0) return GSEA_ERR_CORRUPT;
+        status = gsea_decode_update(ctx, src + in_pos, &in, dst + out_pos, &out);
+        in_pos += in;
+        out_pos += out;
+        step = step * 5 % 131071 + 1;
+    }
+    *written = out_pos;
+    return status == GSEA_END ? GSEA_OK : status;
+}
+
+static void* round_trips(void* arg) {
+    int id = *(int*)arg;
+    static const int LEVELS[THREADS] = {GSEA_LEVEL_NONE, 1, GSEA_LEVEL_DEFAULT, 5};
+    int level = LEVELS[id % THREADS];
+    const char* failure = NULL;
+
+    for (int keyed = 0; keyed < 2 && failure == NULL; keyed++) {
+        gsea_ctx* ctx = gsea_ctx_new(level, keyed ? key : NULL, keyed ? strlen(key) : 0);
+        size_t bound = gsea_compress_bound(input_size, level);
+        unsigned char* packed = malloc(bound);
+        unsigned char* chunked = malloc(bound);
+        unsigned char* restored = malloc(input_size + 1);
+        size_t packed_size = 0, chunked_size = 0, restored_size = 0;
+        uint64_t original = 0;
+
+        if (ctx == NULL || packed == NULL || chunked == NULL || restored == NULL) {
+            failure = "sin memoria";
+        } else if (gsea_compress(ctx, input, input_size, packed, bound, &packed_size) != GSEA_OK) {
+            failure = "gsea_compress";
+        } else if (gsea_decompressed_size(packed, packed_size, &original) != GSEA_OK ||
+                   original != input_size) {
+            failure = "gsea_decompressed_size";
+        } else if (gsea_decompress(ctx, packed, packed_size, restored, input_size, &restored_size) != GSEA_OK ||
+                   restored_size != input_size || memcmp(restored, input, input_size) != 0) {
+            failure = "gsea_decompress";
+        } else if (encode_chunked(ctx, chunked, bound, &chunked_size) != GSEA_OK ||
+                   chunked_size != packed_size || memcmp(chunked, packed, packed_size) != 0) {
+            failure = "gsea_encode_update";
+        } else if (decode_chunked(ctx, packed, packed_size, restored, input_size, &restored_size) != GSEA_OK ||
+                   restored_size != input_size || memcmp(restored, input, input_size) != 0) {
+            failure = "gsea_decode_update";
+        } else if (packed_size > 64 &&
+                   (packed[packed_size / 2] ^= 0x40,
+                    gsea_decompress(ctx, packed, packed_size, restored, input_size, &restored_size)) !=
+                       GSEA_ERR_CORRUPT) {
+            failure = "no detectó un byte dañado";
+        } else if (input_size > 0 && gsea_compress(ctx, input, input_size, packed, 16, &packed_size) !=
+                                         GSEA_ERR_DST_TOO_SMALL) {
+            failure = "no detectó un buffer chico";
+        }
+        if (failure != NULL) {
+            fprintf(stderr, "✗ Hilo %d, nivel %d%s: %s\n", id, level, keyed ? " con clave" : "", failure);
+        }
+        free(packed);
+        free(chunked);
+        free(restored);
+        gsea_ctx_free(ctx);
+    }
+    return (void*)failure;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "Uso: %s <entrada> <clave> <salida.gsea> [<archivo de gsea -ce>]\n", argv[0]);
+        return 2;
+    }
+    key = argv[2];
+    input = read_file(argv[1], &input_size);
+    if (input == NULL) {
+        fprintf(stderr, "✗ No se pudo leer %s\n", argv[1]);
+        return 1;
+    }
+
+    pthread_t threads[THREADS];
+    int ids[THREADS];
+    int failed = 0;
+    for (int i = 0; i < THREADS; i++) {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, round_trips, &ids[i]);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        void* result = NULL;
+        pthread_join(threads[i], &result);
+        if (result != NULL) failed = 1;
+    }
+
+    /* Para gsea -du */
+    gsea_ctx* ctx = gsea_ctx_new(3, key, strlen(key));
+    size_t bound = gsea_compress_bound(input_size, 3);
+    unsigned char* packed = malloc(bound);
+    size_t packed_size = 0;
+    FILE* out = fopen(argv[3], "wb");
+    if (out == NULL || gsea_compress(ctx, input, input_size, packed, bound, &packed_size) != GSEA_OK ||
+        fwrite(packed, 1, packed_size, out) != packed_size) {
+        fprintf(stderr, "✗ No se pudo escribir %s\n", argv[3]);
+        failed = 1;
+    }
+    if (out != NULL) fclose(out);
+
+    /* Lo que escribió gsea -ce */
+    if (argc > 4) {
+        size_t size = 0, restored_size = 0;
+        unsigned char* data = read_file(argv[4], &size);
+        unsigned char* restored = malloc(input_size + 1);
+        int status = data == NULL ? GSEA_ERR_ARGS
+                                  : gsea_decompress(ctx, data, size, restored, input_size, &restored_size);
+        if (status != GSEA_OK || restored_size != input_size || memcmp(restored, input, input_size) != 0) {
+            fprintf(stderr, "✗ %s: %s\n", argv[4], gsea_strerror(status));
+            failed = 1;
+        }
+        free(data);
+        free(restored);
+    }
+    free(packed);
+    gsea_ctx_free(ctx);
+    free(input);
+    return failed;
+}
@@ -0,0 +1,130 @@
+#ifndef GSEA_LOG_H
+#define GSEA_LOG_H
+
+#include <string>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+
+// Niveles de los mensajes (cuanto más alto, más detalle)
+enum LogLevel {
+    LOG_LEVEL_ERROR = 0,     // Siempre, también con -q (va a stderr)
+    LOG_LEVEL_INFO = 1,      // Por defecto: resultado de cada archivo y resúmenes
+    LOG_LEVEL_VERBOSE = 2,   // -v: banner, configuración y etapas de cada archivo
+    LOG_LEVEL_DEBUG = 3      // -vv: syscalls, códigos Huffman, volcados hex
+};
+
+// Umbral de compilación: los mensajes de nivel mayor no generan código
+// (make LOG_MAX_LEVEL=1 deja solo errores e info)
+#ifndef GSEA_LOG_MAX_LEVEL
+#define GSEA_LOG_MAX_LEVEL 3
+#endif
+
+// Salida de mensajes compartida por todos los hilos
+//
+// Cada mensaje se arma completo (en el hilo que lo emite) y se agrega a un
+// buffer bajo un mutex, así que los mensajes de distintos hilos nunca se
+// mezclan a mitad de línea. El buffer se vuelca con write() al pasar de
+// 64 KB, antes de cada error (para conservar el orden) y al terminar.
+class Log {
+private:
+    static const size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    pthread_mutex_t mutex;
+    std::string pending;
+    int level;
+
+    Log() : level(LOG_LEVEL_INFO) {
+        pthread_mutex_init(&mutex, nullptr);
+        pending.reserve(FLUSH_THRESHOLD * 2);
+    }
+
+    ~Log() {
+        flush();
+        pthread_mutex_destroy(&mutex);
+    }
+
+    static void write_all(int fd, const char* data, size_t size) {
+        while (size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return;  // Sin terminal/pipe no hay a dónde reportar
+            }
+            data += n;
+            size -= n;
+        }
+    }
+
+    void flush_locked() {
+        write_all(STDOUT_FILENO, pending.data(), pending.size());
+        pending.clear();
+    }
+
+public:
+    static Log& global() {
+        static Log instance;
+        return instance;
+    }
+
+    void set_level(int new_level) { level = new_level; }
+    int get_level() const { return level; }
+
+    // ¿Se emitiría un mensaje de este nivel? (constante si supera el umbral)
+    static bool enabled(int message_level) {
+        return message_level <= GSEA_LOG_MAX_LEVEL && message_level <= global().level;
+    }
+
+    void write(int message_level, const std::string& text) {
+        pthread_mutex_lock(&mutex);
+        if (message_level == LOG_LEVEL_ERROR) {
+            flush_locked();
+            write_all(STDERR_FILENO, text.data(), text.size());
+        } else {
+            pending += text;
+            if (pending.size() >= FLUSH_THRESHOLD) {
+                flush_locked();
+            }
+        }
+        pthread_mutex_unlock(&mutex);
+    }
+
+    void flush() {
+        pthread_mutex_lock(&mutex);
+        flush_locked();
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // Primeros bytes en hexadecimal ("48 6f 6c 61 ...")
+    static std::string hex(const unsigned char* data, size_t size, size_t max_bytes = 16) {
+        std::string out;
+        char byte[4];
+        for (size_t i = 0; i < size && i < max_bytes; i++) {
+            snprintf(byte, sizeof(byte), "%02x ", data[i]);
+            out += byte;
+        }
+        if (size > max_bytes) out += "...";
+        return out;
+    }
+};
+
+// Los argumentos solo se evalúan (y se formatean) si el nivel está activo
+#define GSEA_LOG(message_level, expr)                                  \
+    do {                                                               \
+        if (Log::enabled(message_level)) {                             \
+            std::ostringstream gsea_log_line;                          \
+            gsea_log_line << expr;                                     \
+            Log::global().write(message_level, gsea_log_line.str());   \
+        }                                                              \
+    } while (0)
+
+#define GSEA_ERROR(expr)   GSEA_LOG(LOG_LEVEL_ERROR, expr)
+#define GSEA_INFO(expr)    GSEA_LOG(LOG_LEVEL_INFO, expr)
+#define GSEA_VERBOSE(expr) GSEA_LOG(LOG_LEVEL_VERBOSE, expr)
+#define GSEA_DEBUG(expr)   GSEA_LOG(LOG_LEVEL_DEBUG, expr)
+
+#endif // GSEA_LOG_H
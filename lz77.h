@@ -0,0 +1,426 @@
+#ifndef GSEA_LZ77_H
+#define GSEA_LZ77_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "huffman.h"
+
+// Compresión LZ77 + Huffman de un bloque (códec 2, niveles 3 a 9)
+//
+// El bloque se recorre buscando repeticiones con cadenas de hash de 4 bytes.
+// Cada secuencia es [literales][copia de largo bytes desde offset atrás], y
+// las secuencias se reparten en tres flujos que se comprimen cada uno con su
+// propio árbol de Huffman (los bytes de un mismo flujo se parecen entre sí):
+//
+//   literales  los bytes que no forman parte de ninguna copia
+//   largos     cantidad de literales y largo - 4 de cada copia (varint)
+//   offsets    offset - 1 de cada copia (varint)
+//
+// Formato: tres veces [modo u8][largo u32][guardado u32][datos], con
+// modo 0 = tal cual, 1 = Huffman. La última secuencia no tiene copia: el
+// decodificador termina al completar el tamaño original del bloque.
+//
+// Las copias no salen del bloque, así que los bloques siguen siendo
+// independientes (se decodifican en cualquier orden o en paralelo).
+
+// Parámetros del buscador de coincidencias (dependen del nivel)
+struct LzParams {
+    int chain_depth;    // Candidatos a revisar por posición
+    int nice_length;    // Una coincidencia de este largo se acepta sin buscar más
+    bool lazy;          // Antes de copiar, ver si en la posición siguiente hay algo mejor
+    bool optimal;       // Parseo óptimo: camino más barato según costos estimados
+};
+
+class LzCoder {
+private:
+    static const int MIN_MATCH = 4;
+    static const int MAX_MATCH = 1 << 16;
+    static const int HASH_BITS = 16;
+    static const size_t STREAM_HEADER = 9;
+
+    // Cadenas de hash: head[h] = última posición con ese hash, prev[p] = la
+    // anterior a p con el mismo hash (-1 = no hay)
+    std::vector<int32_t> head;
+    std::vector<int32_t> prev;
+
+    // Flujos del bloque actual (se reutilizan entre bloques)
+    std::vector<unsigned char> literals;
+    std::vector<unsigned char> lengths;
+    std::vector<unsigned char> offsets;
+
+    // Parseo óptimo: costo mínimo para llegar a cada posición y por dónde
+    std::vector<uint32_t> cost;
+    std::vector<uint32_t> step_length;
+    std::vector<uint32_t> step_offset;
+    std::vector<std::pair<uint32_t, uint32_t>> path;   // Copias elegidas (inicio, fin)
+
+    HuffmanCoder huffman;
+
+    static void put_u32(unsigned char* p, uint32_t v) {
+        for (int i = 0; i < 4; i++) p[i] = (v >> (24 - 8 * i)) & 0xFF;
+    }
+
+    static uint32_t get_u32(const unsigned char* p) {
+        return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+
+    static uint32_t hash4(const unsigned char* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (v * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    void insert(const unsigned char* data, size_t pos) {
+        uint32_t h = hash4(data + pos);
+        prev[pos] = head[h];
+        head[h] = (int32_t)pos;
+    }
+
+    // Bytes iguales a partir de a y b (de a 8 bytes mientras se pueda)
+    static size_t common_length(const unsigned char* a, const unsigned char* b, size_t limit) {
+        size_t n = 0;
+        while (n + 8 <= limit) {
+            uint64_t x, y;
+            memcpy(&x, a + n, 8);
+            memcpy(&y, b + n, 8);
+            if (x != y) return n + (__builtin_ctzll(x ^ y) >> 3);
+            n += 8;
+        }
+        while (n < limit && a[n] == b[n]) n++;
+        return n;
+    }
+
+    // Mejor coincidencia para pos entre las posiciones ya insertadas
+    // Retorna el largo (0 si no llega a MIN_MATCH) y el offset en offset
+    size_t longest_match(const unsigned char* data, size_t size, size_t pos, const LzParams& params,
+                         size_t& offset) const {
+        size_t limit = std::min((size_t)MAX_MATCH, size - pos);
+        size_t best = MIN_MATCH - 1;
+        int32_t candidate = head[hash4(data + pos)];
+        for (int depth = params.chain_depth; candidate >= 0 && depth > 0; depth--) {
+            const unsigned char* match = data + candidate;
+            // Descarte rápido: el byte que mejoraría la mejor coincidencia
+            if (match[best] == data[pos + best]) {
+                size_t length = common_length(match, data + pos, limit);
+                if (length > best) {
+                    best = length;
+                    offset = pos - candidate;
+                    if (length >= (size_t)params.nice_length || length == limit) break;
+                }
+            }
+            candidate = prev[candidate];
+        }
+        return best >= (size_t)MIN_MATCH ? best : 0;
+    }
+
+    static void put_varint(std::vector<unsigned char>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back((unsigned char)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((unsigned char)value);
+    }
+
+    static bool get_varint(const std::vector<unsigned char>& in, size_t& pos, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 32; shift += 7) {
+            if (pos >= in.size()) return false;
+            unsigned char byte = in[pos++];
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    static int varint_bytes(uint32_t value) {
+        int n = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            n++;
+        }
+        return n;
+    }
+
+    void emit(const unsigned char* data, size_t literal_start, size_t pos, size_t length, size_t offset) {
+        put_varint(lengths, (uint32_t)(pos - literal_start));
+        literals.insert(literals.end(), data + literal_start, data + pos);
+        put_varint(lengths, (uint32_t)(length - MIN_MATCH));
+        put_varint(offsets, (uint32_t)(offset - 1));
+    }
+
+    // Parseo voraz (con lazy: una posición de anticipación)
+    void parse_greedy(const unsigned char* data, size_t size, const LzParams& params) {
+        size_t pos = 0;
+        size_t literal_start = 0;
+        while (pos + MIN_MATCH <= size) {
+            size_t offset = 0;
+            size_t length = longest_match(data, size, pos, params, offset);
+            insert(data, pos);
+            if (length > 0 && params.lazy && length < (size_t)params.nice_length &&
+                pos + 1 + MIN_MATCH <= size) {
+                size_t next_offset = 0;
+                if (longest_match(data, size, pos + 1, params, next_offset) > length) {
+                    pos++;   // Mejor empezar la copia en la posición siguiente
+                    continue;
+                }
+            }
+            if (length == 0) {
+                pos++;
+                continue;
+            }
+            emit(data, literal_start, pos, length, offset);
+            for (size_t i = pos + 1; i < pos + length && i + MIN_MATCH <= size; i++) {
+                insert(data, i);
+            }
+            pos += length;
+            literal_start = pos;
+        }
+        put_varint(lengths, (uint32_t)(size - literal_start));
+        literals.insert(literals.end(), data + literal_start, data + size);
+    }
+
+    // Parseo óptimo: el camino de costo mínimo (en 1/16 de bit) desde el
+    // principio del bloque hasta el final, eligiendo en cada posición entre
+    // un literal (costo según la frecuencia del byte en el bloque) o una de
+    // las copias encontradas (costo según los bytes de sus varints)
+    void parse_optimal(const unsigned char* data, size_t size, const LzParams& params) {
+        uint64_t frequencies[256] = {0};
+        HuffmanCoder::count_frequencies(data, size, frequencies);
+        uint32_t literal_cost[256];
+        for (int i = 0; i < 256; i++) {
+            double p = frequencies[i] > 0 ? (double)frequencies[i] / size : 1.0 / size;
+            literal_cost[i] = (uint32_t)(16 * -std::log2(p)) + 8;
+        }
+
+        cost.assign(size + 1, UINT32_MAX);
+        step_length.assign(size + 1, 1);
+        step_offset.assign(size + 1, 0);
+        cost[0] = 0;
+
+        size_t pos = 0;
+        while (pos < size) {
+            uint32_t literal = cost[pos] + literal_cost[data[pos]];
+            if (literal < cost[pos + 1]) {
+                cost[pos + 1] = literal;
+                step_length[pos + 1] = 1;
+                step_offset[pos + 1] = 0;
+            }
+            if (pos + MIN_MATCH > size) {
+                pos++;
+                continue;
+            }
+
+            // Todas las copias de la cadena, cada una más larga que la anterior
+            size_t limit = std::min((size_t)MAX_MATCH, size - pos);
+            size_t best = MIN_MATCH - 1;
+            int32_t candidate = head[hash4(data + pos)];
+            for (int depth = params.chain_depth; candidate >= 0 && depth > 0; depth--) {
+                size_t length = common_length(data + candidate, data + pos, limit);
+                if (length > best) {
+                    uint32_t offset = (uint32_t)(pos - candidate);
+                    uint32_t offset_cost = 16 * 7 * varint_bytes(offset - 1);
+                    for (size_t l = best + 1; l <= length; l++) {
+                        uint32_t total = cost[pos] + offset_cost + 16 * 6 * varint_bytes((uint32_t)(l - MIN_MATCH));
+                        if (total < cost[pos + l]) {
+                            cost[pos + l] = total;
+                            step_length[pos + l] = (uint32_t)l;
+                            step_offset[pos + l] = offset;
+                        }
+                    }
+                    best = length;
+                    if (length >= (size_t)params.nice_length || length == limit) break;
+                }
+                candidate = prev[candidate];
+            }
+            insert(data, pos);
+
+            // Una copia muy larga (p. ej. una corrida de ceros) se toma
+            // entera: evaluar cada posición intermedia no cambiaría nada
+            if (best >= (size_t)params.nice_length) {
+                for (size_t i = pos + 1; i < pos + best && i + MIN_MATCH <= size; i++) {
+                    insert(data, i);
+                }
+                pos += best;
+            } else {
+                pos++;
+            }
+        }
+
+        // Recorrer el camino desde el final (las copias quedan al revés)
+        path.clear();
+        for (size_t at = size; at > 0; at -= step_length[at]) {
+            if (step_offset[at] != 0) path.push_back({(uint32_t)(at - step_length[at]), (uint32_t)at});
+        }
+        size_t literal_start = 0;
+        for (size_t i = path.size(); i-- > 0;) {
+            size_t start = path[i].first;
+            size_t end = path[i].second;
+            emit(data, literal_start, start, end - start, step_offset[end]);
+            literal_start = end;
+        }
+        put_varint(lengths, (uint32_t)(size - literal_start));
+        literals.insert(literals.end(), data + literal_start, data + size);
+    }
+
+    // Escribir un flujo (Huffman si achica, si no tal cual) en out
+    // Retorna los bytes escritos, o 0 si no entra en capacity
+    size_t put_stream(const std::vector<unsigned char>& stream, unsigned char* out, size_t capacity) {
+        if (capacity < STREAM_HEADER) return 0;
+        uint64_t frequencies[256] = {0};
+        HuffmanCoder::count_frequencies(stream.data(), stream.size(), frequencies);
+        size_t raw_cost = STREAM_HEADER + stream.size();
+
+        size_t written = STREAM_HEADER;
+        if (huffman.build(frequencies)) {
+            uint64_t bits = huffman.encoded_bits(frequencies);
+            size_t bound = STREAM_HEADER + HuffmanCoder::MAX_HEADER_SIZE + (bits + 7) / 8;
+            if (bound < raw_cost && bound <= capacity) {
+                out[0] = 1;
+                written += huffman.write_header(out + written, bits);
+                written += huffman.encode(stream.data(), stream.size(), out + written);
+                written += huffman.finish_encode(out + written);
+            }
+        }
+        if (written == STREAM_HEADER) {
+            if (raw_cost > capacity) return 0;
+            out[0] = 0;
+            if (!stream.empty()) memcpy(out + written, stream.data(), stream.size());
+            written += stream.size();
+        }
+        put_u32(out + 1, (uint32_t)stream.size());
+        put_u32(out + 5, (uint32_t)(written - STREAM_HEADER));
+        return written;
+    }
+
+    // Leer un flujo de data (avanza pos). max_size limita el largo declarado
+    bool get_stream(const unsigned char* data, size_t size, size_t& pos, size_t max_size,
+                    std::vector<unsigned char>& stream) {
+        if (size - pos < STREAM_HEADER) return false;
+        unsigned char mode = data[pos];
+        size_t raw = get_u32(data + pos + 1);
+        size_t stored = get_u32(data + pos + 5);
+        pos += STREAM_HEADER;
+        if (raw > max_size || stored > size - pos) return false;
+
+        stream.resize(raw);
+        if (mode == 0) {
+            if (stored != raw) return false;
+            if (raw > 0) memcpy(stream.data(), data + pos, raw);
+        } else if (mode == 1) {
+            size_t consumed = 0;
+            size_t produced = 0;
+            if (huffman.read_header(data + pos, stored, consumed) != 1 ||
+                !huffman.decode(data + pos + consumed, stored - consumed, true, stream.data(), raw, produced) ||
+                produced != raw) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+        pos += stored;
+        return true;
+    }
+
+public:
+    // Las tablas se reservan al comprimir el primer bloque: para
+    // descomprimir no hacen falta
+    LzCoder() {}
+
+    LzCoder(const LzCoder&) = delete;
+    LzCoder& operator=(const LzCoder&) = delete;
+
+    // Reservar de antemano para bloques de hasta block_size bytes (después
+    // comprimir o descomprimir no pide memoria, salvo bloques muy repetitivos
+    // cuyos flujos de largos u offsets superen el bloque)
+    void reserve(size_t block_size, bool for_compress) {
+        literals.reserve(block_size);
+        lengths.reserve(block_size);
+        offsets.reserve(block_size);
+        if (for_compress) {
+            head.reserve((size_t)1 << HASH_BITS);
+            prev.reserve(block_size);
+        }
+    }
+
+    // Comprimir un bloque en out (capacity bytes)
+    // Retorna los bytes escritos, o 0 si el resultado no entra en capacity
+    // (el bloque no achica: conviene guardarlo tal cual)
+    size_t compress(const unsigned char* data, size_t size, const LzParams& params,
+                    unsigned char* out, size_t capacity) {
+        head.assign((size_t)1 << HASH_BITS, -1);
+        if (prev.size() < size) prev.resize(size);
+        literals.clear();
+        lengths.clear();
+        offsets.clear();
+
+        if (params.optimal) {
+            parse_optimal(data, size, params);
+        } else {
+            parse_greedy(data, size, params);
+        }
+
+        size_t written = 0;
+        for (const std::vector<unsigned char>* stream : {&literals, &lengths, &offsets}) {
+            size_t n = put_stream(*stream, out + written, capacity - written);
+            if (n == 0) return 0;
+            written += n;
+        }
+        return written;
+    }
+
+    // Descomprimir un bloque de raw_size bytes. Retorna false si está dañado
+    bool decompress(const unsigned char* data, size_t size, unsigned char* out, size_t raw_size) {
+        // Cada byte original genera a lo sumo un literal o parte de una
+        // copia; cada secuencia ocupa a lo sumo 10 bytes en el flujo de
+        // largos y 5 en el de offsets
+        size_t pos = 0;
+        if (!get_stream(data, size, pos, raw_size, literals) ||
+            !get_stream(data, size, pos, 10 * (raw_size / MIN_MATCH + 1), lengths) ||
+            !get_stream(data, size, pos, 5 * (raw_size / MIN_MATCH + 1), offsets) ||
+            pos != size) {
+            return false;
+        }
+
+        size_t produced = 0;
+        size_t literal_pos = 0;
+        size_t length_pos = 0;
+        size_t offset_pos = 0;
+        while (true) {
+            uint32_t run = 0;
+            if (!get_varint(lengths, length_pos, run) || run > raw_size - produced ||
+                run > literals.size() - literal_pos) {
+                return false;
+            }
+            if (run > 0) memcpy(out + produced, literals.data() + literal_pos, run);
+            produced += run;
+            literal_pos += run;
+            if (produced == raw_size) break;
+
+            uint32_t length = 0;
+            uint32_t offset = 0;
+            if (!get_varint(lengths, length_pos, length) || !get_varint(offsets, offset_pos, offset)) {
+                return false;
+            }
+            length += MIN_MATCH;
+            offset += 1;
+            if (offset > produced || length > raw_size - produced) return false;
+
+            unsigned char* dst = out + produced;
+            const unsigned char* src = dst - offset;
+            if (offset >= length) {
+                memcpy(dst, src, length);
+            } else {
+                // Copia que se superpone con lo que escribe (p. ej. una corrida)
+                for (uint32_t i = 0; i < length; i++) dst[i] = src[i];
+            }
+            produced += length;
+        }
+        return literal_pos == literals.size() && length_pos == lengths.size() &&
+               offset_pos == offsets.size();
+    }
+};
+
+#endif
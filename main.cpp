@@ -1,17 +1,42 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <cstdlib>
 #include <vector>
+#include <algorithm>
 #include "huffman.h"
+#include "huffman_parallel.h"
+#include "direct_io.h"
+#include "journal.h"
 #include "xor.h"
+#include "hash.h"
+#include "manifest.h"
+#include "dedup.h"
+#include "delta.h"
+#include "daemon.h"
+#include "memory_budget.h"
+#include "buffer_pool.h"
+#include "container.h"
+#include "codec_registry.h"
+#include "crc32c.h"
+#include "log.h"
+#include "verify.h"
+#include "stats.h"
+#include "throttle.h"
+#include <memory>
 
 // Librerías para syscalls de Linux
 #include <unistd.h>      // open, read, write, close
 #include <fcntl.h>       // Flags para open (O_RDONLY, O_WRONLY, etc.)
 #include <sys/stat.h>    // fstat, stat
 #include <sys/types.h>   // Tipos de datos para syscalls
+#include <sys/uio.h>     // writev (cabecera + datos en una sola escritura)
+#include <sys/mman.h>    // mmap de la base y del archivo nuevo (--base)
 #include <dirent.h>      // opendir, readdir, closedir
 #include <errno.h>       // errno para errores
+#include <time.h>        // clock_gettime para medir throughput
+#include <pthread.h>     // Hilos de trabajo para directorios (-j)
 
 // Estructura para almacenar la configuración del programa
 struct Config {
@@ -26,12 +51,53 @@ struct Config {
     std::string output_path;    // -o: ruta de salida
     
     // Algoritmos
-    std::string comp_algorithm = "huffman";  // --comp-alg
+    std::string comp_algorithm;              // --comp-alg: códec del registro o auto ("" = según el nivel)
     std::string enc_algorithm = "xor";       // --enc-alg
+    int level = CONTAINER_DEFAULT_LEVEL;     // --level: 1 (rápido) a 9 (más chico)
     
     // Clave de encriptación
     std::string key;            // -k: clave secreta
     
+    // Modo incremental
+    std::string manifest_path;  // --incremental: manifiesto persistente
+    bool manifest_hash = false; // --incremental-hash: comparar también el contenido
+    
+    // Deduplicación por contenido
+    std::string dedup_store;    // --dedup: directorio del almacén de chunks
+    
+    // Delta contra una versión anterior
+    std::string base_path;      // --base: -c guarda solo las diferencias, -d las aplica
+    
+    // Daemon y concurrencia
+    std::string daemon_socket;  // --daemon: socket Unix donde escuchar
+    int threads = 0;            // -j: hilos de trabajo (0 = automático)
+    int decode_threads = 1;     // Hilos para un .huff de un solo flujo (lo fija main())
+    
+    // Presupuesto de memoria
+    uint64_t max_memory = 0;    // --max-memory: bytes (0 = sin límite)
+    bool huge_pages = false;    // --hugepages: buffers grandes con huge pages
+    bool direct = false;        // --direct: E/S por bloques sin la caché de páginas
+    
+    // Diario para retomar trabajos cortados
+    std::string journal_path;   // --journal: diario del trabajo
+    bool resume = false;        // --resume: seguir desde lo que dejó el diario
+    uint64_t checkpoint_bytes = JOURNAL_DEFAULT_CHECKPOINT;   // --checkpoint: entrada entre puntos de control
+    
+    // Límites para correr en segundo plano
+    uint64_t io_limit = 0;      // --io-limit: bytes/s de lectura + escritura (0 = sin límite)
+    double cpu_limit = 0;       // --cpu-limit: CPUs de todo el proceso (0 = sin límite)
+    bool idle = false;          // --idle: SCHED_IDLE y prioridad de E/S idle
+    
+    // Verificación de integridad
+    bool verify = false;        // --verify: comprobar los CRC sin escribir nada
+    
+    // Mensajes por consola
+    int verbosity = LOG_LEVEL_INFO;  // -q: solo errores, -v / -vv: más detalle
+    
+    // Métricas por etapa
+    std::string stats_format;   // --stats=json (vacío = sin métricas)
+    std::string stats_path;     // --stats-out: archivo del reporte (vacío = stdout)
+    
     // Flag para verificar si la configuración es válida
     bool is_valid = true;
 };
@@ -55,10 +121,11 @@ struct Config {
 std::vector<unsigned char> read_file_syscall(const std::string& filepath) {
     std::vector<unsigned char> data;
     
-    std::cout << "  [Syscall] Abriendo archivo para lectura: " << filepath << "\n";
+    GSEA_DEBUG("  [Syscall] Abriendo archivo para lectura: " << filepath << "\n");
     
     // PASO 1: Abrir el archivo con open()
     // O_RDONLY = Open for Reading ONLY (solo lectura)
+    count_syscall();
     int fd = open(filepath.c_str(), O_RDONLY);
     
     // Verificar si open() falló
@@ -66,81 +133,168 @@ std::vector<unsigned char> read_file_syscall(const std::string& filepath) {
         // fd == -1 significa error
         // errno contiene el código de error
         // strerror(errno) convierte el código a texto legible
-        std::cerr << "  [Error] open() falló: " << strerror(errno) << "\n";
+        GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
         return data;  // Retornar vector vacío
     }
     
-    std::cout << "  [Syscall] ✓ open() exitoso - File descriptor (fd) = " << fd << "\n";
+    GSEA_DEBUG("  [Syscall] ✓ open() exitoso - File descriptor (fd) = " << fd << "\n");
     
     // PASO 2: Obtener información del archivo con fstat()
     // struct stat es una estructura que contiene metadata del archivo
     struct stat file_stat;
     
+    count_syscall();
     if (fstat(fd, &file_stat) == -1) {
         // fstat() retorna -1 si hay error
-        std::cerr << "  [Error] fstat() falló: " << strerror(errno) << "\n";
-        close(fd);  // Cerrar el fd antes de salir
+        GSEA_ERROR("  [Error] fstat() falló: " << strerror(errno) << "\n");
+        close(fd);
+        count_syscall();
         return data;
     }
     
-    // file_stat.st_size contiene el tamaño del archivo en bytes
-    long file_size = file_stat.st_size;
-    std::cout << "  [Syscall] ✓ fstat() exitoso - Tamaño: " << file_size << " bytes\n";
+    // file_stat.st_size contiene el tamaño del archivo en bytes (off_t, 64 bits)
+    uint64_t file_size = file_stat.st_size;
+    GSEA_DEBUG("  [Syscall] ✓ fstat() exitoso - Tamaño: " << file_size << " bytes\n");
+    if (file_size > SIZE_MAX) {
+        GSEA_ERROR("  [Error] El archivo no cabe en memoria: " << file_size << " bytes\n");
+        close(fd);
+        count_syscall();
+        return data;
+    }
     
     // PASO 3: Reservar espacio en memoria para los datos
     // resize() ajusta el tamaño del vector al tamaño del archivo
     data.resize(file_size);
-    std::cout << "  [Memoria] Vector redimensionado a " << file_size << " bytes\n";
+    GSEA_DEBUG("  [Memoria] Vector redimensionado a " << file_size << " bytes\n");
     
     // PASO 4: Leer el archivo con read()
-    std::cout << "  [Syscall] Llamando a read()...\n";
+    GSEA_DEBUG("  [Syscall] Llamando a read()...\n");
     
     // read(fd, buffer, count):
     //   - fd: file descriptor del archivo abierto
     //   - buffer: puntero a donde guardar los datos (data.data())
     //   - count: cantidad de bytes a leer
     // Retorna: cantidad de bytes leídos (o -1 si error)
-    ssize_t bytes_read = read(fd, data.data(), file_size);
-    
-    // Verificar si read() fue exitoso
-    if (bytes_read == -1) {
-        std::cerr << "  [Error] read() falló: " << strerror(errno) << "\n";
-        data.clear();
-    } else if (bytes_read != file_size) {
-        // Se leyeron menos bytes de los esperados
-        std::cerr << "  [Advertencia] read() incompleto\n";
-        std::cerr << "  [Advertencia] Esperados: " << file_size << " bytes\n";
-        std::cerr << "  [Advertencia] Leídos: " << bytes_read << " bytes\n";
-        data.resize(bytes_read);  // Ajustar al tamaño real
-    } else {
-        std::cout << "  [Syscall] ✓ read() exitoso - " << bytes_read << " bytes leídos\n";
+    // Un read() devuelve como mucho ~2 GB en Linux (y menos si lo interrumpe
+    // una señal): se repite hasta completar el tamaño
+    size_t done = 0;
+    while (done < file_size) {
+        count_syscall();
+        ssize_t bytes_read = read(fd, data.data() + done, file_size - done);
+        if (bytes_read == -1) {
+            if (errno == EINTR) continue;
+            GSEA_ERROR("  [Error] read() falló: " << strerror(errno) << "\n");
+            data.clear();
+            break;
+        }
+        if (bytes_read == 0) {
+            // El archivo se achicó mientras se leía
+            GSEA_ERROR("  [Advertencia] read() incompleto\n");
+            GSEA_ERROR("  [Advertencia] Esperados: " << file_size << " bytes\n");
+            GSEA_ERROR("  [Advertencia] Leídos: " << done << " bytes\n");
+            data.resize(done);  // Ajustar al tamaño real
+            break;
+        }
+        done += bytes_read;
+    }
+    if (done == file_size) {
+        GSEA_DEBUG("  [Syscall] ✓ read() exitoso - " << done << " bytes leídos\n");
     }
     
     // PASO 5: Cerrar el archivo con close()
     // Siempre debemos cerrar los file descriptors que abrimos
     close(fd);
-    std::cout << "  [Syscall] ✓ close() - File descriptor cerrado\n";
+    count_syscall();
+    GSEA_DEBUG("  [Syscall] ✓ close() - File descriptor cerrado\n");
     
     return data;
 }
 
+/**
+ * Leer un archivo completo en un buffer del pool (mismas syscalls)
+ * 
+ * En modo directorio el buffer se recicla entre archivos: tras los primeros,
+ * leer un archivo no reserva memoria. read() se repite hasta completar el
+ * tamaño, ya que puede devolver menos bytes de los pedidos.
+ * 
+ * @return true si se leyó el archivo completo (buffer.size() = bytes leídos)
+ */
+bool read_file_syscall(const std::string& filepath, PooledBuffer& buffer) {
+    GSEA_DEBUG("  [Syscall] Abriendo archivo para lectura: " << filepath << "\n");
+    
+    count_syscall();
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
+        return false;
+    }
+    GSEA_DEBUG("  [Syscall] ✓ open() exitoso - File descriptor (fd) = " << fd << "\n");
+    
+    struct stat file_stat;
+    count_syscall();
+    if (fstat(fd, &file_stat) == -1) {
+        GSEA_ERROR("  [Error] fstat() falló: " << strerror(errno) << "\n");
+        close(fd);
+        count_syscall();
+        return false;
+    }
+    uint64_t file_size = file_stat.st_size;
+    GSEA_DEBUG("  [Syscall] ✓ fstat() exitoso - Tamaño: " << file_size << " bytes\n");
+    
+    if (file_size > SIZE_MAX || !buffer.reserve(file_size)) {
+        GSEA_ERROR("  [Error] No hay memoria para " << file_size << " bytes\n");
+        close(fd);
+        count_syscall();
+        return false;
+    }
+    GSEA_DEBUG("  [Memoria] Buffer del pool de " << buffer.capacity() << " bytes\n");
+    
+    size_t done = 0;
+    while (done < file_size) {
+        size_t want = Throttle::global().grant_io(file_size - done);
+        count_syscall();
+        ssize_t n = read(fd, buffer.data() + done, want);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            GSEA_ERROR("  [Error] read() falló: " << strerror(errno) << "\n");
+            close(fd);
+            count_syscall();
+            return false;
+        }
+        if (n == 0) break;  // El archivo se achicó mientras se leía
+        done += n;
+    }
+    buffer.set_size(done);
+    GSEA_DEBUG("  [Syscall] ✓ read() exitoso - " << done << " bytes leídos\n");
+    
+    close(fd);
+    count_syscall();
+    GSEA_DEBUG("  [Syscall] ✓ close() - File descriptor cerrado\n");
+    return true;
+}
+
 /**
  * Función para ESCRIBIR un archivo completo usando syscalls de Linux
  * 
  * Syscalls usadas:
- *   - open()  : Crea/abre el archivo
- *   - write() : Escribe bytes al archivo
- *   - close() : Cierra el file descriptor
+ *   - open()   : Crea/abre el archivo
+ *   - writev() : Escribe la cabecera y los datos en una sola llamada
+ *   - close()  : Cierra el file descriptor
  * 
  * @param filepath Ruta del archivo a escribir
- * @param data Vector con los bytes a escribir
+ * @param data Bytes a escribir
+ * @param size Cantidad de bytes
+ * @param prefix Bytes a escribir antes de data (p. ej. la cabecera), o nullptr
+ * @param prefix_size Cantidad de bytes de prefix
  * @return true si fue exitoso, false si hubo error
  */
-bool write_file_syscall(const std::string& filepath, const std::vector<unsigned char>& data) {
-    std::cout << "  [Syscall] Abriendo archivo para escritura: " << filepath << "\n";
+bool write_file_syscall(const std::string& filepath, const unsigned char* data, size_t size,
+                        const unsigned char* prefix = nullptr, size_t prefix_size = 0) {
+    GSEA_DEBUG("  [Syscall] Abriendo archivo para escritura: " << filepath << "\n");
     
-    if (data.empty()) {
-        std::cout << "  [Advertencia] Datos vacíos, creando archivo vacío\n";
+    size_t total = prefix_size + size;
+    if (total == 0) {
+        GSEA_VERBOSE("  [Advertencia] Datos vacíos, creando archivo vacío\n");
     }
     
     // PASO 1: Crear/abrir el archivo con open()
@@ -154,51 +308,90 @@ bool write_file_syscall(const std::string& filepath, const std::vector<unsigned
     //   Owner: read(4) + write(2) = 6
     //   Group: read(4) = 4
     //   Others: read(4) = 4
+    count_syscall();
     int fd = open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
     
     // Verificar si open() falló
     if (fd == -1) {
-        std::cerr << "  [Error] open() falló: " << strerror(errno) << "\n";
+        GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
         return false;
     }
     
-    std::cout << "  [Syscall] ✓ open() exitoso - File descriptor (fd) = " << fd << "\n";
+    GSEA_DEBUG("  [Syscall] ✓ open() exitoso - File descriptor (fd) = " << fd << "\n");
     
-    // PASO 2: Escribir datos con write() (si hay datos)
-    if (!data.empty()) {
-        std::cout << "  [Syscall] Llamando a write() para " << data.size() << " bytes...\n";
+    // PASO 2: Escribir datos con writev() (si hay datos)
+    if (total > 0) {
+        GSEA_DEBUG("  [Syscall] Llamando a writev() para " << total << " bytes...\n");
         
-        // write(fd, buffer, count):
+        // writev(fd, iov, iovcnt):
         //   - fd: file descriptor del archivo abierto
-        //   - buffer: puntero a los datos a escribir
-        //   - count: cantidad de bytes a escribir
+        //   - iov: arreglo de {puntero, cantidad}: cabecera y datos sin copiarlos
+        //     a un buffer común
+        //   - iovcnt: cantidad de elementos de iov
         // Retorna: cantidad de bytes escritos (o -1 si error)
-        ssize_t bytes_written = write(fd, data.data(), data.size());
-        
-        // Verificar si write() fue exitoso
-        if (bytes_written == -1) {
-            std::cerr << "  [Error] write() falló: " << strerror(errno) << "\n";
-            close(fd);
-            return false;
-        } else if (bytes_written != (ssize_t)data.size()) {
-            // Se escribieron menos bytes de los esperados
-            std::cerr << "  [Error] write() incompleto\n";
-            std::cerr << "  [Error] Esperados: " << data.size() << " bytes\n";
-            std::cerr << "  [Error] Escritos: " << bytes_written << " bytes\n";
-            close(fd);
-            return false;
-        } else {
-            std::cout << "  [Syscall] ✓ write() exitoso - " << bytes_written << " bytes escritos\n";
+        struct iovec iov[2];
+        int iovcnt = 0;
+        if (prefix_size > 0) {
+            iov[iovcnt].iov_base = (void*)prefix;
+            iov[iovcnt].iov_len = prefix_size;
+            iovcnt++;
+        }
+        if (size > 0) {
+            iov[iovcnt].iov_base = (void*)data;
+            iov[iovcnt].iov_len = size;
+            iovcnt++;
+        }
+        // writev() puede escribir menos de lo pedido (como mucho ~2 GB por
+        // llamada en Linux): se avanza iov y se repite con lo que falta.
+        // Con --io-limit cada llamada escribe a lo sumo un tramo
+        size_t done = 0;
+        struct iovec* pending = iov;
+        while (done < total) {
+            size_t want = Throttle::global().grant_io(total - done);
+            struct iovec limited[2];
+            int limited_count = 0;
+            for (int i = 0; i < iovcnt && want > 0; i++) {
+                limited[i].iov_base = pending[i].iov_base;
+                limited[i].iov_len = std::min(pending[i].iov_len, want);
+                want -= limited[i].iov_len;
+                limited_count++;
+            }
+            count_syscall();
+            ssize_t bytes_written = writev(fd, limited, limited_count);
+            if (bytes_written == -1) {
+                if (errno == EINTR) continue;
+                GSEA_ERROR("  [Error] writev() falló: " << strerror(errno) << "\n");
+                close(fd);
+                count_syscall();
+                return false;
+            }
+            done += bytes_written;
+            size_t advance = bytes_written;
+            while (iovcnt > 0 && advance >= pending->iov_len) {
+                advance -= pending->iov_len;
+                pending++;
+                iovcnt--;
+            }
+            if (iovcnt > 0) {
+                pending->iov_base = (unsigned char*)pending->iov_base + advance;
+                pending->iov_len -= advance;
+            }
         }
+        GSEA_DEBUG("  [Syscall] ✓ writev() exitoso - " << done << " bytes escritos\n");
     }
     
     // PASO 3: Cerrar el archivo con close()
     close(fd);
-    std::cout << "  [Syscall] ✓ close() - File descriptor cerrado\n";
+    count_syscall();
+    GSEA_DEBUG("  [Syscall] ✓ close() - File descriptor cerrado\n");
     
     return true;
 }
 
+bool write_file_syscall(const std::string& filepath, const std::vector<unsigned char>& data) {
+    return write_file_syscall(filepath, data.data(), data.size());
+}
+
 /**
  * Función para verificar si un archivo existe
  * Usa la syscall stat()
@@ -231,18 +424,18 @@ bool is_directory(const std::string& path) {
 std::vector<std::string> list_files(const std::string& dir_path) {
     std::vector<std::string> files;
     
-    std::cout << "  [Syscall] Abriendo directorio: " << dir_path << "\n";
+    GSEA_DEBUG("  [Syscall] Abriendo directorio: " << dir_path << "\n");
     
     // PASO 1: Abrir el directorio con opendir()
     DIR* dir = opendir(dir_path.c_str());
     
     if (dir == nullptr) {
         // opendir() retorna nullptr si hay error
-        std::cerr << "  [Error] opendir() falló: " << strerror(errno) << "\n";
+        GSEA_ERROR("  [Error] opendir() falló: " << strerror(errno) << "\n");
         return files;
     }
     
-    std::cout << "  [Syscall] ✓ opendir() exitoso\n";
+    GSEA_DEBUG("  [Syscall] ✓ opendir() exitoso\n");
     
     // PASO 2: Leer entradas del directorio con readdir()
     // struct dirent contiene información de cada entrada (archivo/carpeta)
@@ -263,14 +456,14 @@ std::vector<std::string> list_files(const std::string& dir_path) {
         // Verificar que sea un archivo regular (no un subdirectorio)
         if (file_exists(full_path)) {
             files.push_back(full_path);
-            std::cout << "    - Encontrado: " << filename << "\n";
+            GSEA_DEBUG("    - Encontrado: " << filename << "\n");
         }
     }
     
     // PASO 3: Cerrar el directorio con closedir()
     closedir(dir);
-    std::cout << "  [Syscall] ✓ closedir() - Directorio cerrado\n";
-    std::cout << "  [Syscall] Total archivos: " << files.size() << "\n";
+    GSEA_DEBUG("  [Syscall] ✓ closedir() - Directorio cerrado\n");
+    GSEA_DEBUG("  [Syscall] Total archivos: " << files.size() << "\n");
     
     return files;
 }
@@ -280,25 +473,80 @@ std::vector<std::string> list_files(const std::string& dir_path) {
 // ============================================================================
 
 void print_usage(const char* program_name) {
-    std::cout << "Uso: " << program_name << " [opciones]\n\n";
-    std::cout << "Opciones obligatorias:\n";
-    std::cout << "  -i <ruta>        Archivo o directorio de entrada\n";
-    std::cout << "  -o <ruta>        Archivo o directorio de salida\n\n";
-    std::cout << "Operaciones (al menos una):\n";
-    std::cout << "  -c               Comprimir\n";
-    std::cout << "  -d               Descomprimir\n";
-    std::cout << "  -e               Encriptar\n";
-    std::cout << "  -u               Desencriptar\n";
-    std::cout << "  (Pueden combinarse: -ce = comprimir y encriptar)\n\n";
-    std::cout << "Opciones adicionales:\n";
-    std::cout << "  --comp-alg <alg> Algoritmo de compresión (default: huffman)\n";
-    std::cout << "  --enc-alg <alg>  Algoritmo de encriptación (default: xor)\n";
-    std::cout << "  -k <clave>       Clave secreta para encriptación\n\n";
-    std::cout << "Ejemplos:\n";
-    std::cout << "  " << program_name << " -c -i archivo.txt -o archivo.huff\n";
-    std::cout << "  " << program_name << " -ce -i doc.pdf -o doc.gsea -k miClave\n";
-    std::cout << "  " << program_name << " -d -i archivo.huff -o archivo.txt\n";
-    std::cout << "  " << program_name << " -du -i doc.gsea -o doc.pdf -k miClave\n";
+    GSEA_INFO("Uso: " << program_name << " [opciones]\n\n");
+    GSEA_INFO("Opciones obligatorias:\n");
+    GSEA_INFO("  -i <ruta>        Archivo o directorio de entrada\n");
+    GSEA_INFO("  -o <ruta>        Archivo o directorio de salida\n\n");
+    GSEA_INFO("Operaciones (al menos una):\n");
+    GSEA_INFO("  -c               Comprimir\n");
+    GSEA_INFO("  -d               Descomprimir\n");
+    GSEA_INFO("  -e               Encriptar\n");
+    GSEA_INFO("  -u               Desencriptar\n");
+    GSEA_INFO("  (Pueden combinarse: -ce = comprimir y encriptar)\n\n");
+    GSEA_INFO("Opciones adicionales:\n");
+    GSEA_INFO("  --comp-alg <alg> Algoritmo de compresión: " << CodecRegistry::names()
+              << " o auto (default: el del nivel)\n");
+    GSEA_INFO("                   (auto: guarda tal cual los bloques que no achican y los\n");
+    GSEA_INFO("                   formatos ya comprimidos, p. ej. PNG, JPEG, ZIP)\n");
+    GSEA_INFO("  --level <1-9>    Nivel de compresión (default: 2): 1 = Huffman con árbol de\n");
+    GSEA_INFO("                   muestra, 2 = Huffman, 3-9 = LZ77 + Huffman, cada vez más\n");
+    GSEA_INFO("                   lento y con mejor ratio\n");
+    GSEA_INFO("  --enc-alg <alg>  Algoritmo de encriptación: " << CipherRegistry::names()
+              << " (default: xor)\n");
+    GSEA_INFO("  -k <clave>       Clave secreta para encriptación\n");
+    GSEA_INFO("  -q               Silencioso: solo errores\n");
+    GSEA_INFO("  -v, -vv          Más detalle: etapas de cada archivo / syscalls y volcados\n");
+    GSEA_INFO("  --incremental <manifiesto>\n");
+    GSEA_INFO("                   Omitir archivos sin cambios desde la última ejecución\n");
+    GSEA_INFO("  --incremental-hash\n");
+    GSEA_INFO("                   Con --incremental: comparar el hash del contenido\n");
+    GSEA_INFO("                   cuando cambia mtime/inodo (p. ej. tras un touch)\n");
+    GSEA_INFO("  --dedup <almacén>\n");
+    GSEA_INFO("                   Deduplicar por chunks: -c/-e guardan los chunks únicos en\n");
+    GSEA_INFO("                   el almacén y escriben una receta; -d/-u la reconstruyen\n");
+    GSEA_INFO("  --base <archivo>\n");
+    GSEA_INFO("                   Versión anterior del archivo: -c guarda solo las\n");
+    GSEA_INFO("                   diferencias con ella y -d las aplica sobre ella\n");
+    GSEA_INFO("  --daemon <socket>\n");
+    GSEA_INFO("                   Atender peticiones de gsea-client por un socket Unix\n");
+    GSEA_INFO("  -j <hilos>       Hilos de trabajo (default: 1 en directorios,\n");
+    GSEA_INFO("                   uno por CPU en el daemon y al descomprimir\n");
+    GSEA_INFO("                   un .huff de un solo flujo)\n");
+    GSEA_INFO("  --max-memory <tamaño>\n");
+    GSEA_INFO("                   Presupuesto de memoria para los archivos en proceso\n");
+    GSEA_INFO("                   (ej: 512M, 2G). Los archivos que no caben esperan\n");
+    GSEA_INFO("                   turno o se procesan por bloques\n");
+    GSEA_INFO("  --hugepages      Respaldar los buffers grandes con huge pages\n");
+    GSEA_INFO("                   (MAP_HUGETLB si hay reservadas, si no THP)\n");
+    GSEA_INFO("  --direct         Procesar por bloques con O_DIRECT, sin llenar la caché\n");
+    GSEA_INFO("                   de páginas (si no se admite: posix_fadvise DONTNEED)\n");
+    GSEA_INFO("  --journal <archivo>\n");
+    GSEA_INFO("                   Anotar en un diario cada archivo terminado y puntos de\n");
+    GSEA_INFO("                   control dentro de los archivos grandes\n");
+    GSEA_INFO("  --resume         Con --journal: saltar lo ya terminado y seguir los\n");
+    GSEA_INFO("                   archivos cortados desde su último punto de control\n");
+    GSEA_INFO("  --checkpoint <tamaño>\n");
+    GSEA_INFO("                   Entrada entre puntos de control (default: 256M)\n");
+    GSEA_INFO("  --io-limit <MB/s>\n");
+    GSEA_INFO("                   Tope de lectura + escritura a disco de todo el proceso\n");
+    GSEA_INFO("  --cpu-limit <fracción>\n");
+    GSEA_INFO("                   Tope de CPU de todo el proceso (0.5 = media CPU, 2 = dos)\n");
+    GSEA_INFO("  --idle           Usar CPU y disco solo cuando nadie más los pide\n");
+    GSEA_INFO("                   (SCHED_IDLE y clase idle de ioprio_set)\n");
+    GSEA_INFO("  --verify         Solo comprobar los CRC32C de los bloques de -i (sin -o);\n");
+    GSEA_INFO("                   con -k también se decodifica y se verifica el contenido\n");
+    GSEA_INFO("  --stats=json     Al terminar, tiempo real/CPU, bytes y syscalls de cada\n");
+    GSEA_INFO("                   etapa (lectura, compresión, cifrado...) por archivo y total\n");
+    GSEA_INFO("  --stats-out <archivo>\n");
+    GSEA_INFO("                   Escribir el reporte de --stats en un archivo (default: stdout)\n\n");
+    GSEA_INFO("Ejemplos:\n");
+    GSEA_INFO("  " << program_name << " -c -i archivo.txt -o archivo.huff\n");
+    GSEA_INFO("  " << program_name << " -ce -i doc.pdf -o doc.gsea -k miClave\n");
+    GSEA_INFO("  " << program_name << " -d -i archivo.huff -o archivo.txt\n");
+    GSEA_INFO("  " << program_name << " -du -i doc.gsea -o doc.pdf -k miClave\n");
+    GSEA_INFO("  " << program_name << " -c --base backup_v1.tar -i backup_v2.tar -o v2.delta\n");
+    GSEA_INFO("  " << program_name << " --verify -i doc.gsea -k miClave -j 4\n");
+    GSEA_INFO("  " << program_name << " -q -c -i datos/ -o salida/ -j 4 --stats=json\n");
 }
 
 Config parse_arguments(int argc, char* argv[]) {
@@ -320,11 +568,15 @@ Config parse_arguments(int argc, char* argv[]) {
                     case 'd': config.decompress = true; break;
                     case 'e': config.encrypt = true; break;
                     case 'u': config.decrypt = true; break;
+                    case 'q': config.verbosity = LOG_LEVEL_ERROR; break;
+                    case 'v':
+                        config.verbosity = std::min(config.verbosity + 1, (int)LOG_LEVEL_DEBUG);
+                        break;
                     case 'i':
                         if (i + 1 < argc) {
                             config.input_path = argv[++i];
                         } else {
-                            std::cerr << "Error: -i requiere un argumento\n";
+                            GSEA_ERROR("Error: -i requiere un argumento\n");
                             config.is_valid = false;
                         }
                         j = arg.length();
@@ -333,7 +585,7 @@ Config parse_arguments(int argc, char* argv[]) {
                         if (i + 1 < argc) {
                             config.output_path = argv[++i];
                         } else {
-                            std::cerr << "Error: -o requiere un argumento\n";
+                            GSEA_ERROR("Error: -o requiere un argumento\n");
                             config.is_valid = false;
                         }
                         j = arg.length();
@@ -342,13 +594,22 @@ Config parse_arguments(int argc, char* argv[]) {
                         if (i + 1 < argc) {
                             config.key = argv[++i];
                         } else {
-                            std::cerr << "Error: -k requiere un argumento\n";
+                            GSEA_ERROR("Error: -k requiere un argumento\n");
+                            config.is_valid = false;
+                        }
+                        j = arg.length();
+                        break;
+                    case 'j':
+                        if (i + 1 < argc && atoi(argv[i + 1]) > 0) {
+                            config.threads = atoi(argv[++i]);
+                        } else {
+                            GSEA_ERROR("Error: -j requiere un número de hilos mayor que 0\n");
                             config.is_valid = false;
                         }
                         j = arg.length();
                         break;
                     default:
-                        std::cerr << "Error: Opción desconocida -" << arg[j] << "\n";
+                        GSEA_ERROR("Error: Opción desconocida -" << arg[j] << "\n");
                         config.is_valid = false;
                 }
             }
@@ -357,7 +618,20 @@ Config parse_arguments(int argc, char* argv[]) {
             if (i + 1 < argc) {
                 config.comp_algorithm = argv[++i];
             } else {
-                std::cerr << "Error: --comp-alg requiere un argumento\n";
+                GSEA_ERROR("Error: --comp-alg requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--level") {
+            char* end = nullptr;
+            long level = i + 1 < argc ? strtol(argv[i + 1], &end, 10) : 0;
+            if (end != nullptr && end != argv[i + 1] && *end == '\0' &&
+                level >= CONTAINER_MIN_LEVEL && level <= CONTAINER_MAX_LEVEL) {
+                config.level = (int)level;
+                i++;
+            } else {
+                GSEA_ERROR("Error: --level requiere un número de " << CONTAINER_MIN_LEVEL
+                           << " a " << CONTAINER_MAX_LEVEL << "\n");
                 config.is_valid = false;
             }
         }
@@ -365,261 +639,2363 @@ Config parse_arguments(int argc, char* argv[]) {
             if (i + 1 < argc) {
                 config.enc_algorithm = argv[++i];
             } else {
-                std::cerr << "Error: --enc-alg requiere un argumento\n";
+                GSEA_ERROR("Error: --enc-alg requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--incremental") {
+            if (i + 1 < argc) {
+                config.manifest_path = argv[++i];
+            } else {
+                GSEA_ERROR("Error: --incremental requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--incremental-hash") {
+            config.manifest_hash = true;
+        }
+        else if (arg == "--max-memory") {
+            if (i + 1 < argc && MemoryBudget::parse_size(argv[i + 1], config.max_memory) &&
+                config.max_memory > 0) {
+                i++;
+            } else {
+                GSEA_ERROR("Error: --max-memory requiere un tamaño válido (ej: 512M, 2G)\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--hugepages") {
+            config.huge_pages = true;
+        }
+        else if (arg == "--direct") {
+            config.direct = true;
+        }
+        else if (arg == "--journal") {
+            if (i + 1 < argc) {
+                config.journal_path = argv[++i];
+            } else {
+                GSEA_ERROR("Error: --journal requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--resume") {
+            config.resume = true;
+        }
+        else if (arg == "--io-limit" || arg == "--cpu-limit") {
+            char* end = nullptr;
+            double value = i + 1 < argc ? strtod(argv[i + 1], &end) : 0;
+            if (end != nullptr && end != argv[i + 1] && *end == '\0' && value > 0) {
+                i++;
+                if (arg == "--io-limit") {
+                    config.io_limit = (uint64_t)(value * (1 << 20));
+                } else {
+                    config.cpu_limit = value;
+                }
+            } else {
+                GSEA_ERROR("Error: " << arg << " requiere un número mayor que 0 (ej: "
+                           << (arg == "--io-limit" ? "50" : "0.5") << ")\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--idle") {
+            config.idle = true;
+        }
+        else if (arg == "--checkpoint") {
+            if (i + 1 < argc && MemoryBudget::parse_size(argv[i + 1], config.checkpoint_bytes) &&
+                config.checkpoint_bytes > 0) {
+                i++;
+            } else {
+                GSEA_ERROR("Error: --checkpoint requiere un tamaño válido (ej: 64M, 1G)\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--verify") {
+            config.verify = true;
+        }
+        else if (arg.compare(0, 8, "--stats=") == 0) {
+            config.stats_format = arg.substr(8);
+            if (config.stats_format != "json") {
+                GSEA_ERROR("Error: Formato de --stats no soportado: " << config.stats_format
+                           << " (disponible: json)\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--stats-out") {
+            if (i + 1 < argc) {
+                config.stats_path = argv[++i];
+            } else {
+                GSEA_ERROR("Error: --stats-out requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--daemon") {
+            if (i + 1 < argc) {
+                config.daemon_socket = argv[++i];
+            } else {
+                GSEA_ERROR("Error: --daemon requiere un argumento\n");
                 config.is_valid = false;
             }
         }
+        else if (arg == "--dedup") {
+            if (i + 1 < argc) {
+                config.dedup_store = argv[++i];
+            } else {
+                GSEA_ERROR("Error: --dedup requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+        else if (arg == "--base") {
+            if (i + 1 < argc) {
+                config.base_path = argv[++i];
+            } else {
+                GSEA_ERROR("Error: --base requiere un argumento\n");
+                config.is_valid = false;
+            }
+        }
+    }
+    
+    // En modo daemon las operaciones, las rutas y la clave llegan con cada
+    // petición: si se pasaron aquí no se usarían
+    if (!config.daemon_socket.empty()) {
+        if (config.compress || config.decompress || config.encrypt || config.decrypt ||
+            !config.input_path.empty() || !config.output_path.empty() || !config.key.empty() ||
+            !config.manifest_path.empty() || !config.dedup_store.empty() || !config.base_path.empty() ||
+            !config.journal_path.empty() || config.verify) {
+            GSEA_ERROR("Error: --daemon no admite -c, -d, -e, -u, -i, -o, -k, --incremental, --dedup,\n"
+                       "       --base, --journal ni --verify (llegan con cada petición de gsea-client)\n");
+            config.is_valid = false;
+        }
+        return config;
     }
     
     // Validaciones
     if (config.input_path.empty()) {
-        std::cerr << "Error: Debe especificar archivo de entrada con -i\n";
+        GSEA_ERROR("Error: Debe especificar archivo de entrada con -i\n");
         config.is_valid = false;
     }
     
+    // --verify solo lee: no necesita operaciones ni salida
+    if (config.verify) {
+        if (config.compress || config.decompress || config.encrypt || config.decrypt ||
+            !config.output_path.empty()) {
+            GSEA_ERROR("Error: --verify no admite operaciones (-c, -d, -e, -u) ni -o\n");
+            config.is_valid = false;
+        }
+        return config;
+    }
+    
     if (config.output_path.empty()) {
-        std::cerr << "Error: Debe especificar archivo de salida con -o\n";
+        GSEA_ERROR("Error: Debe especificar archivo de salida con -o\n");
         config.is_valid = false;
     }
     
     if (!config.compress && !config.decompress && !config.encrypt && !config.decrypt) {
-        std::cerr << "Error: Debe especificar al menos una operación (-c, -d, -e, -u)\n";
+        GSEA_ERROR("Error: Debe especificar al menos una operación (-c, -d, -e, -u)\n");
         config.is_valid = false;
     }
     
     if ((config.encrypt || config.decrypt) && config.key.empty()) {
-        std::cerr << "Error: La encriptación/desencriptación requiere una clave (-k)\n";
+        GSEA_ERROR("Error: La encriptación/desencriptación requiere una clave (-k)\n");
         config.is_valid = false;
     }
     
     if (config.compress && config.decompress) {
-        std::cerr << "Error: No se puede comprimir y descomprimir simultáneamente\n";
+        GSEA_ERROR("Error: No se puede comprimir y descomprimir simultáneamente\n");
         config.is_valid = false;
     }
     
     if (config.encrypt && config.decrypt) {
-        std::cerr << "Error: No se puede encriptar y desencriptar simultáneamente\n";
+        GSEA_ERROR("Error: No se puede encriptar y desencriptar simultáneamente\n");
+        config.is_valid = false;
+    }
+    
+    if (!config.dedup_store.empty() &&
+        (config.compress || config.encrypt) && (config.decompress || config.decrypt)) {
+        GSEA_ERROR("Error: --dedup no admite guardar (-c/-e) y restaurar (-d/-u) a la vez\n");
+        config.is_valid = false;
+    }
+    
+    if (!config.base_path.empty() && (config.compress == config.decompress || !config.dedup_store.empty())) {
+        GSEA_ERROR("Error: --base requiere -c (guardar el delta) o -d (restaurarlo), y no admite --dedup\n");
+        config.is_valid = false;
+    }
+    
+    if (config.direct && (!config.base_path.empty() || !config.dedup_store.empty())) {
+        GSEA_ERROR("Error: --direct no admite --base ni --dedup (leen los archivos con mmap o completos)\n");
+        config.is_valid = false;
+    }
+    
+    if ((config.resume || config.checkpoint_bytes != JOURNAL_DEFAULT_CHECKPOINT) && config.journal_path.empty()) {
+        GSEA_ERROR("Error: --resume y --checkpoint requieren --journal <archivo>\n");
+        config.is_valid = false;
+    }
+    
+    if (config.manifest_hash && config.manifest_path.empty()) {
+        GSEA_ERROR("Error: --incremental-hash requiere --incremental <manifiesto>\n");
+        config.is_valid = false;
+    }
+    
+    if (!config.stats_path.empty() && config.stats_format.empty()) {
+        GSEA_ERROR("Error: --stats-out requiere --stats=json\n");
+        config.is_valid = false;
+    }
+    
+    if (!config.comp_algorithm.empty() && config.comp_algorithm != "auto" &&
+        CodecRegistry::find(config.comp_algorithm) == nullptr) {
+        GSEA_ERROR("Error: Algoritmo de compresión no soportado: " << config.comp_algorithm
+                   << " (use " << CodecRegistry::names() << " o auto)\n");
+        config.is_valid = false;
+    }
+    
+    if (CipherRegistry::find(config.enc_algorithm) == nullptr) {
+        GSEA_ERROR("Error: Algoritmo de encriptación no soportado: " << config.enc_algorithm
+                   << " (use " << CipherRegistry::names() << ")\n");
         config.is_valid = false;
     }
     
     return config;
 }
 
+/**
+ * Códec pedido con --comp-alg, o CONTAINER_CODEC_NONE si lo decide el nivel
+ */
+uint8_t forced_codec(const Config& config) {
+    const CodecEntry* entry = CodecRegistry::find(config.comp_algorithm);
+    return entry != nullptr ? entry->id : (uint8_t)CONTAINER_CODEC_NONE;
+}
+
 void print_config(const Config& config) {
-    std::cout << "\n═══════════════════════════════════════════════════════\n";
-    std::cout << "  CONFIGURACIÓN\n";
-    std::cout << "═══════════════════════════════════════════════════════\n";
-    std::cout << "  Entrada:     " << config.input_path << "\n";
-    std::cout << "  Salida:      " << config.output_path << "\n";
-    std::cout << "  Operaciones: ";
-    if (config.compress) std::cout << "comprimir ";
-    if (config.decompress) std::cout << "descomprimir ";
-    if (config.encrypt) std::cout << "encriptar ";
-    if (config.decrypt) std::cout << "desencriptar ";
-    std::cout << "\n";
+    GSEA_VERBOSE("\n═══════════════════════════════════════════════════════\n");
+    GSEA_VERBOSE("  CONFIGURACIÓN\n");
+    GSEA_VERBOSE("═══════════════════════════════════════════════════════\n");
+    GSEA_VERBOSE("  Entrada:     " << config.input_path << "\n");
+    GSEA_VERBOSE("  Salida:      " << config.output_path << "\n");
+    GSEA_VERBOSE("  Operaciones: " << (config.compress ? "comprimir " : "")
+                 << (config.decompress ? "descomprimir " : "")
+                 << (config.encrypt ? "encriptar " : "")
+                 << (config.decrypt ? "desencriptar " : "") << "\n");
     if (!config.key.empty()) {
-        std::cout << "  Clave:       [***oculta***]\n";
+        GSEA_VERBOSE("  Clave:       [***oculta***]\n");
+    }
+    GSEA_VERBOSE("  Compresión:  "
+                 << CodecRegistry::find(forced_codec(config) != CONTAINER_CODEC_NONE ? forced_codec(config)
+                                        : CompressionLevel::of(config.level).codec)->name
+                 << (config.comp_algorithm == "auto" ? " (auto)" : "") << ", nivel " << config.level << "\n");
+    GSEA_VERBOSE("  Encriptación: " << config.enc_algorithm << "\n");
+    if (!config.manifest_path.empty()) {
+        GSEA_VERBOSE("  Incremental: " << config.manifest_path
+                     << (config.manifest_hash ? " (con hash de contenido)" : "") << "\n");
+    }
+    if (!config.dedup_store.empty()) {
+        GSEA_VERBOSE("  Dedup:       " << config.dedup_store << "\n");
     }
-    std::cout << "  Compresión:  " << config.comp_algorithm << "\n";
-    std::cout << "  Encriptación: " << config.enc_algorithm << "\n";
-    std::cout << "═══════════════════════════════════════════════════════\n\n";
+    if (!config.base_path.empty()) {
+        GSEA_VERBOSE("  Base:        " << config.base_path << "\n");
+    }
+    if (config.threads > 1) {
+        GSEA_VERBOSE("  Hilos:       " << config.threads << "\n");
+    }
+    if (config.max_memory > 0) {
+        GSEA_VERBOSE("  Memoria máx: " << (config.max_memory >> 20) << " MB\n");
+    }
+    if (config.huge_pages) {
+        GSEA_VERBOSE("  Huge pages:  sí\n");
+    }
+    if (config.io_limit > 0) {
+        GSEA_VERBOSE("  Límite E/S:  " << ((double)config.io_limit / (1 << 20)) << " MB/s\n");
+    }
+    if (config.cpu_limit > 0) {
+        GSEA_VERBOSE("  Límite CPU:  " << config.cpu_limit << " CPU\n");
+    }
+    if (config.idle) {
+        GSEA_VERBOSE("  Prioridad:   idle\n");
+    }
+    if (!config.stats_format.empty()) {
+        GSEA_VERBOSE("  Métricas:    " << config.stats_format << " → "
+                     << (config.stats_path.empty() ? "stdout" : config.stats_path) << "\n");
+    }
+    GSEA_VERBOSE("═══════════════════════════════════════════════════════\n\n");
 }
 
 // ============================================================================
 // FUNCIÓN PRINCIPAL DE PROCESAMIENTO
 // ============================================================================
 
-bool process_file(const std::string& input_file, const std::string& output_file, const Config& config) {
-    std::cout << "\n┌───────────────────────────────────────────────────────┐\n";
-    std::cout << "│ PROCESANDO: " << input_file << "\n";
-    std::cout << "│ DESTINO:    " << output_file << "\n";
-    std::cout << "└───────────────────────────────────────────────────────┘\n";
+/**
+ * Firma de la configuración para el manifiesto incremental
+ * 
+ * Si cambian las operaciones, los algoritmos, la clave o la versión del
+ * formato de salida, las salidas anteriores ya no sirven. La clave NO se
+ * guarda: solo su verificador de 32 bits (compute_key_check()).
+ */
+std::string config_signature(const Config& config) {
+    std::string ops;
+    if (config.compress) ops += "c";
+    if (config.decompress) ops += "d";
+    if (config.encrypt) ops += "e";
+    if (config.decrypt) ops += "u";
+    
+    // El mismo verificador que ya va en la cabecera de cada contenedor
+    char key_tag[16] = "-";
+    if (!config.key.empty()) {
+        snprintf(key_tag, sizeof(key_tag), "%08x",
+                 (unsigned int)ContainerHeader::compute_key_check(XORCipher(config.key)));
+    }
+    
+    return "ops=" + ops + ";comp=" + config.comp_algorithm + ";level=" + std::to_string(config.level) +
+           ";enc=" + config.enc_algorithm +
+           ";key=" + key_tag + ";fmt=" + std::to_string((int)CONTAINER_VERSION) +
+           (config.base_path.empty() ? "" : ";base=" + config.base_path);
+}
+
+/**
+ * Con --comp-alg auto: informar qué bloques se guardaron sin comprimir
+ */
+void log_adaptive_choice(const BlockCodec& codec, uint64_t blocks) {
+    if (codec.adaptive_stored_blocks() == 0) return;
+    GSEA_VERBOSE("  → --comp-alg auto: " << codec.adaptive_stored_blocks() << " de " << blocks
+                 << " bloque(s) guardados tal cual"
+                 << (codec.detected_compressed_format() ? " (formato ya comprimido)" : "") << "\n");
+}
+
+/**
+ * Salida de ParallelHuffmanDecoder en un buffer del llamador
+ */
+struct BufferSink {
+    unsigned char* data;
+    size_t capacity;
+    size_t size = 0;
+    
+    BufferSink(unsigned char* buffer, size_t buffer_capacity) : data(buffer), capacity(buffer_capacity) {}
+    
+    bool write(const unsigned char* bytes, size_t n) {
+        if (n > capacity - size) {
+            GSEA_ERROR("Error: Buffer de salida insuficiente\n");
+            return false;
+        }
+        memcpy(data + size, bytes, n);
+        size += n;
+        return true;
+    }
+};
+
+/**
+ * Descomprimir un flujo Huffman único completo con varios hilos
+ * 
+ * Equivale a HuffmanCoder::decompress_into() (misma salida y mismos
+ * errores), pero reparte el flujo entre los hilos (ver huffman_parallel.h)
+ */
+bool decode_single_stream(HuffmanCoder& huffman, const unsigned char* input, size_t size, int threads,
+                          unsigned char* output, size_t capacity, size_t& output_size) {
+    size_t index = 0;
+    if (size < 5 || huffman.read_header(input, size, index) != 1) {
+        GSEA_ERROR("Error: Cabecera Huffman inválida o archivo demasiado pequeño\n");
+        return false;
+    }
+    
+    ParallelHuffmanDecoder decoder(huffman, threads);
+    BufferSink sink(output, capacity);
+    uint64_t end_bit = (uint64_t)(size - index) * 8;
+    end_bit -= std::min<uint64_t>(end_bit, huffman.get_padding());
+    uint64_t next_bit = 0;
+    if (!decoder.decode(input + index, 0, end_bit, end_bit, sink, next_bit)) {
+        return false;
+    }
+    output_size = sink.size;
+    GSEA_VERBOSE("  → Flujo único decodificado con " << threads << " hilos ("
+                 << decoder.resynced_symbols() << " símbolos resincronizados en serie)\n");
+    return true;
+}
+
+/**
+ * @param content_hash Si no es nullptr, recibe el ContentHash de la entrada
+ *                     (se calcula sobre los bytes ya leídos, sin releer)
+ * @param stats Si no es nullptr, recibe el tiempo y los bytes de cada etapa
+ */
+bool process_file(const std::string& input_file, const std::string& output_file, const Config& config,
+                  uint64_t* content_hash = nullptr, FileStats* stats = nullptr) {
+    GSEA_VERBOSE("\n┌───────────────────────────────────────────────────────┐\n");
+    GSEA_VERBOSE("│ PROCESANDO: " << input_file << "\n");
+    GSEA_VERBOSE("│ DESTINO:    " << output_file << "\n");
+    GSEA_VERBOSE("└───────────────────────────────────────────────────────┘\n");
     
     // PASO 1: Leer el archivo con syscalls
-    std::cout << "\n[PASO 1: LECTURA CON SYSCALLS]\n";
-    std::vector<unsigned char> data = read_file_syscall(input_file);
+    // Todos los buffers salen del pool: en modo directorio se reciclan entre
+    // archivos y la salida de cada etapa pasa a ser la entrada de la siguiente
+    GSEA_VERBOSE("\n[PASO 1: LECTURA CON SYSCALLS]\n");
+    PooledBuffer data;
+    PooledBuffer scratch;
     
-    if (data.empty()) {
-        std::cerr << "\n✗ ERROR CRÍTICO: No se pudo leer el archivo o está vacío\n";
-        std::cerr << "  Archivo: " << input_file << "\n";
+    StageTimer read_timer(stats, STAGE_READ);
+    if (!read_file_syscall(input_file, data) || data.size() == 0) {
+        GSEA_ERROR("\n✗ ERROR CRÍTICO: No se pudo leer el archivo o está vacío\n");
+        GSEA_ERROR("  Archivo: " << input_file << "\n");
         return false;
     }
     
-    std::cout << "\n✓ Lectura completada exitosamente\n";
-    std::cout << "  Bytes leídos: " << data.size() << "\n";
-    std::cout << "  Primeros bytes (hex): ";
-    for (size_t i = 0; i < std::min(data.size(), (size_t)16); i++) {
-        printf("%02x ", data[i]);
+    if (content_hash != nullptr) {
+        *content_hash = ContentHash::of(data.data(), data.size());
     }
-    std::cout << "\n";
+    
+    read_timer.stop(data.size(), data.size());
+    
+    GSEA_VERBOSE("\n✓ Lectura completada exitosamente\n");
+    GSEA_VERBOSE("  Bytes leídos: " << data.size() << "\n");
+    GSEA_DEBUG("  Primeros bytes (hex): " << Log::hex(data.data(), data.size()) << "\n");
     
     // PASO 2: Aplicar operaciones según configuración
     
-    // Orden para comprimir + encriptar: COMPRIMIR PRIMERO
-    if (config.compress) {
-        std::cout << "\n[PASO 2: COMPRESIÓN]\n";
-        HuffmanCoder huffman;
-        data = huffman.compress(data);
-        
-        if (data.empty()) {
-            std::cerr << "\n✗ Error: Fallo en la compresión\n";
-            return false;
-        }
+    // La clave se expande una sola vez por archivo
+    std::unique_ptr<XORCipher> cipher;
+    if (!config.key.empty() && (config.encrypt || config.decrypt)) {
+        cipher.reset(new XORCipher(config.key));
     }
     
-    if (config.encrypt) {
-        std::cout << "\n[PASO 3: ENCRIPTACIÓN]\n";
-        XORCipher cipher(config.key);
-        data = cipher.encrypt(data);
+    // Cabecera de la salida (se escribe delante de los datos, sin encriptar)
+    unsigned char header_bytes[ContainerHeader::MAX_SIZE];
+    size_t header_size = 0;
+    
+    // Inicio de los datos útiles dentro de data (se salta la cabecera de la entrada)
+    size_t offset = 0;
+    
+    // Comprimir y/o encriptar: bloques independientes con CRC32C
+    // Orden dentro de cada bloque: COMPRIMIR PRIMERO, luego encriptar
+    if (config.compress || config.encrypt) {
+        GSEA_VERBOSE("\n[PASO 2: " << (config.compress ? "COMPRESIÓN" : "")
+                     << (config.compress && config.encrypt ? " + " : "")
+                     << (config.encrypt ? "ENCRIPTACIÓN" : "") << " POR BLOQUES]\n");
+        ContainerHeader header = ContainerHeader::for_encode(config.compress, cipher.get(), data.size(),
+                                                            config.level, forced_codec(config));
         
-        if (data.empty()) {
-            std::cerr << "\n✗ Error: Fallo en la encriptación\n";
+        BlockCodec codec(header.codec, cipher.get(), header.block_size);
+        codec.set_stats(stats);
+        codec.set_adaptive(config.comp_algorithm == "auto");
+        codec.set_level(config.level);
+        codec.set_zero_runs(true);
+        if (!scratch.reserve(BlockCodec::total_bound(data.size(), header.block_size))) {
+            GSEA_ERROR("\n✗ Error: No hay memoria para la salida\n");
             return false;
         }
+        size_t written = codec.encode_all(data.data(), data.size(), scratch.data());
+        if (codec.hole_blocks() > 0) header.flags |= CONTAINER_FLAG_HOLES;
+        header_size = header.write(header_bytes);
+        
+        GSEA_VERBOSE("  → " << (data.size() + header.block_size - 1) / header.block_size
+                     << " bloque(s) de hasta " << (header.block_size >> 10) << " KB, CRC32C ("
+                     << CRC32C::implementation() << ")\n");
+        if (codec.hole_blocks() > 0) {
+            GSEA_VERBOSE("  → " << codec.hole_blocks() << " bloque(s) de ceros guardados como huecos\n");
+        }
+        log_adaptive_choice(codec, (data.size() + header.block_size - 1) / header.block_size);
+        GSEA_VERBOSE("  → " << data.size() << " bytes → " << header_size + written << " bytes");
+        if (config.compress) {
+            GSEA_VERBOSE(" (ratio: " << (100.0 * (header_size + written) / data.size()) << "%)");
+        }
+        GSEA_VERBOSE("\n");
+        scratch.set_size(written);
+        data.swap(scratch);
     }
     
-    // Orden para desencriptar + descomprimir: DESENCRIPTAR PRIMERO
-    if (config.decrypt) {
-        std::cout << "\n[PASO 2: DESENCRIPTACIÓN]\n";
-        XORCipher cipher(config.key);
-        data = cipher.decrypt(data);
-        
-        if (data.empty()) {
-            std::cerr << "\n✗ Error: Fallo en la desencriptación\n";
+    // Al decodificar, la cabecera de la entrada (si la tiene) decide las etapas
+    ContainerPlan plan;
+    if (config.decrypt || config.decompress) {
+        ContainerHeader input_header;
+        int status = input_header.read(data.data(), data.size(), offset);
+        std::string error = plan.prepare(status, input_header, config.decrypt,
+                                         config.decompress, cipher.get());
+        if (!error.empty()) {
+            GSEA_ERROR("\n✗ Error: " << error << "\n");
             return false;
         }
+        if (plan.has_header) {
+            GSEA_VERBOSE("  [Formato] Cabecera GSEA v" << (int)input_header.version
+                         << ": tamaño original " << input_header.original_size << " bytes\n");
+        }
+        if (plan.write_header) {
+            header_size = plan.output_header.write(header_bytes);
+        }
     }
     
-    if (config.decompress) {
-        std::cout << "\n[PASO 3: DESCOMPRESIÓN]\n";
-        HuffmanCoder huffman;
-        data = huffman.decompress(data);
+    if (plan.has_header && plan.input_header.blocked()) {
+        // Desencriptar y/o descomprimir bloque a bloque, verificando los CRC
+        const ContainerHeader& input_header = plan.input_header;
+        GSEA_VERBOSE("\n[PASO 2: DECODIFICACIÓN POR BLOQUES]\n");
+        BlockCodec codec(input_header.codec, plan.decrypt ? cipher.get() : nullptr,
+                         input_header.block_size);
+        codec.set_stats(stats);
         
-        if (data.empty()) {
-            std::cerr << "\n✗ Error: Fallo en la descompresión\n";
+        // Con descompresión (o sin compresión) se reserva exactamente el
+        // tamaño original; si el archivo queda comprimido se trabaja en el lugar
+        bool full = !plan.write_header;
+        size_t produced = 0;
+        std::string error;
+        if (full && !scratch.reserve(input_header.original_size)) {
+            error = "No hay memoria para la salida";
+        } else {
+            error = codec.decode_all(data.data() + offset, data.size() - offset, full,
+                                     full ? scratch.data() : nullptr,
+                                     full ? input_header.original_size : 0, produced);
+        }
+        if (error.empty() && produced != input_header.original_size) {
+            error = "Se obtuvieron " + std::to_string(produced) + " bytes, la cabecera indica " +
+                    std::to_string(input_header.original_size);
+        }
+        if (!error.empty()) {
+            GSEA_ERROR("\n✗ Error: " << error << "\n");
             return false;
         }
+        GSEA_VERBOSE("  → CRC32C verificado en todos los bloques (" << CRC32C::implementation() << ")\n");
+        
+        if (full) {
+            scratch.set_size(produced);
+            data.swap(scratch);
+            offset = 0;
+        }
+    } else {
+        // Formato de un solo flujo o archivo sin cabecera
+        
+        // Orden para desencriptar + descomprimir: DESENCRIPTAR PRIMERO
+        if (plan.decrypt) {
+            GSEA_VERBOSE("\n[PASO 2: DESENCRIPTACIÓN]\n");
+            
+            StageTimer timer(stats, STAGE_DECRYPT);
+            if (!cipher->decrypt_in_place(data.data() + offset, data.size() - offset)) {
+                GSEA_ERROR("\n✗ Error: Fallo en la desencriptación\n");
+                return false;
+            }
+            timer.stop(data.size() - offset, data.size() - offset);
+        }
+        
+        if (plan.decompress) {
+            GSEA_VERBOSE("\n[PASO 3: DESCOMPRESIÓN]\n");
+            HuffmanCoder huffman;
+            // Con cabecera se reserva exactamente el tamaño original. Sin ella se
+            // reserva el máximo posible (8 x entrada): los buffers grandes son
+            // mmap(), así que solo las páginas escritas ocupan memoria
+            // (acotado por el máximo, por si la cabecera miente)
+            size_t capacity = HuffmanCoder::decode_bound(data.size() - offset);
+            if (plan.has_header) {
+                capacity = std::min((uint64_t)capacity, plan.input_header.original_size);
+            }
+            size_t produced = 0;
+            StageTimer timer(stats, STAGE_DECOMPRESS);
+            bool ok = scratch.reserve(capacity);
+            if (ok && config.decode_threads > 1) {
+                ok = decode_single_stream(huffman, data.data() + offset, data.size() - offset,
+                                          config.decode_threads, scratch.data(), capacity, produced);
+            } else if (ok) {
+                ok = huffman.decompress_into(data.data() + offset, data.size() - offset,
+                                             scratch.data(), capacity, produced);
+            }
+            
+            if (ok && plan.has_header && produced != plan.input_header.original_size) {
+                GSEA_ERROR("Error: Se obtuvieron " << produced << " bytes, la cabecera indica "
+                           << plan.input_header.original_size << "\n");
+                ok = false;
+            }
+            if (!ok || produced == 0) {
+                GSEA_ERROR("\n✗ Error: Fallo en la descompresión\n");
+                return false;
+            }
+            timer.stop(data.size() - offset, produced);
+            scratch.set_size(produced);
+            data.swap(scratch);
+            offset = 0;
+        }
     }
     
     // PASO 3: Escribir el resultado con syscalls
-    std::cout << "\n[PASO 4: ESCRITURA CON SYSCALLS]\n";
-    if (!write_file_syscall(output_file, data)) {
-        std::cerr << "\n✗ Error: No se pudo escribir el archivo\n";
+    GSEA_VERBOSE("\n[PASO 4: ESCRITURA CON SYSCALLS]\n");
+    StageTimer write_timer(stats, STAGE_WRITE);
+    if (!write_file_syscall(output_file, data.data() + offset, data.size() - offset,
+                            header_bytes, header_size)) {
+        GSEA_ERROR("\n✗ Error: No se pudo escribir el archivo\n");
         return false;
     }
+    write_timer.stop(header_size + data.size() - offset, header_size + data.size() - offset);
+    if (stats != nullptr) {
+        // Entrada y salida de la última etapa conviven hasta el final
+        stats->note_buffers(data.capacity() + scratch.capacity());
+    }
     
-    std::cout << "\n✓ Archivo procesado exitosamente\n";
-    std::cout << "  → Guardado en: " << output_file << " (" << data.size() << " bytes)\n";
+    GSEA_VERBOSE("\n✓ Archivo procesado exitosamente\n");
+    GSEA_INFO("  ✓ " << input_file << " → " << output_file << " ("
+              << header_size + data.size() - offset << " bytes)\n");
     
     return true;
 }
 
 // ============================================================================
-// FUNCIÓN MAIN
+// PROCESAMIENTO POR BLOQUES (STREAMING) Y PRESUPUESTO DE MEMORIA
 // ============================================================================
 
-int main(int argc, char* argv[]) {
-    std::cout << "\n";
-    std::cout << "╔════════════════════════════════════════════════════════╗\n";
-    std::cout << "║                                                        ║\n";
-    std::cout << "║  GSEA - Gestión Segura y Eficiente de Archivos       ║\n";
-    std::cout << "║  Universidad EAFIT - Sistemas Operativos             ║\n";
-    std::cout << "║                                                        ║\n";
-    std::cout << "║  Usando syscalls POSIX directas:                      ║\n";
-    std::cout << "║    • open() / read() / write() / close()              ║\n";
-    std::cout << "║    • opendir() / readdir() / closedir()               ║\n";
-    std::cout << "║    • stat() / fstat()                                 ║\n";
-    std::cout << "║                                                        ║\n";
-    std::cout << "╚════════════════════════════════════════════════════════╝\n";
-    
-    // Parsear argumentos
-    Config config = parse_arguments(argc, argv);
-    
-    if (!config.is_valid) {
-        return 1;
+// Tamaño de bloque del camino por bloques
+static const size_t STREAM_CHUNK_SIZE = 1 << 20;
+
+// Cada bloque se (de)codifica en tramos de este tamaño: la salida de un tramo
+// (hasta 57/8 bytes por byte al codificar, 8 al decodificar) cabe en un
+// buffer de STREAM_CHUNK_SIZE
+static const size_t STREAM_SLICE_SIZE = STREAM_CHUNK_SIZE / 8;
+
+// Un archivo cuya memoria estimada (estimate_memory()) supere esto va siempre
+// por bloques, haya o no --max-memory: uno de varios GB (o TB) nunca se carga
+// completo
+static const uint64_t IN_MEMORY_LIMIT = 1ULL << 30;
+
+// Con --cpu-limit la CPU se descuenta entre lecturas y escrituras: en memoria
+// un archivo grande se codifica entero sin pausas, así que desde este tamaño
+// va por bloques (pausas cada 1 MB)
+static const uint64_t PACED_IN_MEMORY_LIMIT = 16ULL << 20;
+
+/**
+ * Memoria fija del camino por bloques: bloque leído y buffer de salida
+ * 
+ * El buffer de un bloque codificado (frame_bound(), algo más de 1 MB) cae en
+ * la clase de 2 MB del pool, por eso el total es 3 bloques
+ */
+uint64_t stream_footprint(const Config& config) {
+    uint64_t footprint = 3 * STREAM_CHUNK_SIZE;
+    if (config.direct) footprint += 2 * DIRECT_CHUNK;      // Buffers alineados de entrada y salida
+    if (config.decompress && config.decode_threads > 1) {
+        // Un .huff de un solo flujo: ventana de lectura y tramos de los hilos
+        footprint += config.decode_threads * ParallelHuffmanDecoder::SPAN_BYTES +
+                     ParallelHuffmanDecoder::footprint(config.decode_threads);
     }
-    
-    // Mostrar configuración
-    print_config(config);
-    
-    // Verificar que la entrada existe
+    return footprint;
+}
+
+/**
+ * Estimar la memoria que process_file() necesita para un archivo
+ * 
+ * process_file() mantiene vivos a la vez la entrada y la salida de cada
+ * etapa que cambia el tamaño. El pico es la etapa con mayor entrada+salida:
+ *   - comprimir:    salida <= entrada + cabecera (Huffman nunca supera 8 bits/byte)
+ *   - (des)cifrar:  sobre el mismo buffer, no suma memoria
+ *   - descomprimir: salida = original_size si la cabecera lo declara (LZ77
+ *     puede multiplicar el tamaño por miles); si no, <= 8 x entrada (cada
+ *     bit puede ser un símbolo)
+ * 
+ * @param original_size Tamaño que declara la cabecera de la entrada (0 = no hay)
+ */
+uint64_t estimate_memory(uint64_t file_size, const Config& config, uint64_t original_size = 0) {
+    uint64_t current = file_size;
+    uint64_t peak = file_size;
+    
+    if (config.compress) {
+        uint64_t out = current + 5 + HuffmanCoder::MAX_TREE_SIZE;
+        peak = std::max(peak, current + out);
+        current = out;
+    }
+    if (config.decompress) {
+        peak = std::max(peak, current + (original_size != 0 ? original_size : 8 * current));
+    }
+    return peak;
+}
+
+/**
+ * Leer hasta size bytes (solo devuelve menos al llegar al final del archivo)
+ * @param stats Si no es nullptr, suma el tiempo a la etapa de lectura
+ * @return bytes leídos, o -1 si hubo error
+ */
+ssize_t read_full(int fd, unsigned char* buffer, size_t size, FileStats* stats = nullptr) {
+    StageTimer timer(stats, STAGE_READ);
+    size_t done = 0;
+    while (done < size) {
+        size_t want = Throttle::global().grant_io(size - done);
+        count_syscall();
+        ssize_t n = read(fd, buffer + done, want);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;  // EOF
+        done += n;
+    }
+    timer.stop(done, done);
+    return done;
+}
+
+/**
+ * Escribir todo el buffer (write() puede escribir menos de lo pedido)
+ * @param stats Si no es nullptr, suma el tiempo a la etapa de escritura
+ */
+bool write_full(int fd, const unsigned char* buffer, size_t size, FileStats* stats = nullptr) {
+    StageTimer timer(stats, STAGE_WRITE);
+    size_t done = 0;
+    while (done < size) {
+        size_t want = Throttle::global().grant_io(size - done);
+        count_syscall();
+        ssize_t n = write(fd, buffer + done, want);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        done += n;
+    }
+    timer.stop(size, size);
+    return true;
+}
+
+/**
+ * Bloques completos de hueco de un archivo disperso a partir de offset
+ * 
+ * Con lseek(SEEK_DATA) se busca el próximo byte con datos: los bloques
+ * completos antes de él son hueco y no hace falta leerlos. data_end recibe
+ * dónde empieza el siguiente hueco (SEEK_HOLE), para no volver a preguntar
+ * mientras se leen datos. Si el sistema de archivos no lo soporta, todo el
+ * archivo cuenta como datos. Mueve la posición del descriptor
+ * 
+ * @return bytes a saltar (múltiplo de block_size)
+ */
+uint64_t sparse_hole_at(int fd, uint64_t offset, uint64_t file_size, uint32_t block_size,
+                        uint64_t& data_end) {
+    count_syscall();
+    off_t data = lseek(fd, offset, SEEK_DATA);
+    if (data == -1) {
+        if (errno != ENXIO) {
+            data_end = file_size;
+            return 0;
+        }
+        data = file_size;      // Hueco hasta el final
+    }
+    uint64_t skip = (std::min((uint64_t)data, file_size) - offset) / block_size * block_size;
+    count_syscall();
+    off_t hole = lseek(fd, offset + skip, SEEK_HOLE);
+    data_end = hole == -1 ? file_size : (uint64_t)hole;
+    return skip;
+}
+
+/**
+ * Salida de ParallelHuffmanDecoder directo al archivo
+ */
+struct StreamSink {
+    DirectWriter& output;
+    FileStats* stats;
+    uint64_t written = 0;
+    
+    StreamSink(DirectWriter& writer, FileStats* file_stats) : output(writer), stats(file_stats) {}
+    
+    bool write(const unsigned char* bytes, size_t n) {
+        written += n;
+        return output.write(bytes, n, stats);
+    }
+};
+
+/**
+ * Procesar un archivo POR BLOQUES, con memoria fija (stream_footprint())
+ * 
+ * Produce exactamente los mismos bytes que process_file(), pero nunca tiene
+ * el archivo completo en memoria:
+ *   - comprimir/encriptar: cada bloque del formato se codifica apenas se lee
+ *   - decodificar en bloques: se lee cada bloque (cabecera + datos) y se verifica
+ *   - un solo flujo o sin cabecera: el estado de cifrado y del decodificador
+ *     Huffman pasa de un bloque de lectura al siguiente
+ * 
+ * Con journal, en los dos caminos por bloques del formato se anota un punto
+ * de control cada checkpoint_interval() bytes de entrada, y si el diario ya
+ * tiene uno de este archivo se sigue desde ahí (la salida se corta en ese
+ * punto). El hash de contenido no se puede retomar: con content_hash el
+ * archivo empieza de cero
+ */
+bool process_file_streaming(const std::string& input_file, const std::string& output_file,
+                            const Config& config, uint64_t* content_hash = nullptr,
+                            FileStats* stats = nullptr, Journal* journal = nullptr) {
+    GSEA_VERBOSE("\n┌───────────────────────────────────────────────────────┐\n");
+    GSEA_VERBOSE("│ PROCESANDO POR BLOQUES: " << input_file << "\n");
+    GSEA_VERBOSE("│ DESTINO:    " << output_file << "\n");
+    GSEA_VERBOSE("└───────────────────────────────────────────────────────┘\n");
+    
+    // fstat() y los dos close() al final (open_for_stream() cuenta los suyos)
+    count_syscall(3);
+    DirectMode in_mode, out_mode;
+    int in_fd = open_for_stream(input_file.c_str(), O_RDONLY, config.direct, in_mode);
+    if (in_fd == -1) {
+        GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
+        return false;
+    }
+    
+    struct stat file_stat;
+    if (fstat(in_fd, &file_stat) == -1 || file_stat.st_size == 0) {
+        GSEA_ERROR("\n✗ ERROR CRÍTICO: No se pudo leer el archivo o está vacío\n");
+        close(in_fd);
+        return false;
+    }
+    uint64_t file_size = file_stat.st_size;
+    
+    // Con --resume la salida se conserva hasta el último punto de control
+    JournalCheckpoint resume;
+    bool resuming = journal != nullptr && content_hash == nullptr &&
+                    journal->checkpoint_for(input_file, output_file, file_stat, resume);
+    // (con O_DIRECT el último bloque lógico se vuelve a leer: O_RDWR)
+    int out_fd = open_for_stream(output_file.c_str(), O_CREAT | (resuming ? O_RDWR : O_WRONLY | O_TRUNC),
+                                 config.direct, out_mode);
+    if (out_fd == -1) {
+        GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
+        close(in_fd);
+        return false;
+    }
+    if (config.direct) {
+        GSEA_VERBOSE("  [E/S] entrada " << DIRECT_MODE_NAMES[in_mode] << ", salida "
+                     << DIRECT_MODE_NAMES[out_mode] << "\n");
+    }
+    
+    // Con --direct la E/S pasa por buffers alineados (ver direct_io.h)
+    DirectReader input(in_fd, in_mode);
+    DirectWriter output(out_fd, out_mode);
+    
+    std::unique_ptr<XORCipher> cipher;
+    if (!config.key.empty() && (config.encrypt || config.decrypt)) {
+        cipher.reset(new XORCipher(config.key));
+    }
+    
+    ContentHash hasher;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    bool ok = input.valid() && output.valid();
+    if (stats != nullptr) stats->note_buffers(input.footprint() + output.footprint());
+    
+    if (ok && resuming) {
+        // Lo escrito después del punto de control se descarta
+        count_syscall();
+        ok = ftruncate(out_fd, resume.output_offset) == 0 && output.resume_at(resume.output_offset);
+        if (ok) {
+            GSEA_INFO("  ⟳ " << input_file << ": se retoma desde el byte " << resume.input_offset << " de "
+                      << file_size << " (bloque " << resume.block_index << ")\n");
+        } else {
+            GSEA_ERROR("  [Error] No se pudo retomar " << output_file << ": " << strerror(errno) << "\n");
+        }
+    }
+    
+    // Punto de control: la salida hasta bytes_out queda en disco y el diario
+    // anota desde dónde seguir
+    uint64_t next_checkpoint = journal == nullptr ? UINT64_MAX
+                             : (resuming ? resume.input_offset : 0) + journal->checkpoint_interval();
+    auto checkpoint = [&](JournalCheckpoint& point) {
+        point.input_offset = bytes_in;
+        point.output_offset = bytes_out;
+        next_checkpoint = bytes_in + journal->checkpoint_interval();
+        return output.sync(stats) && journal->record_checkpoint(input_file, output_file, file_stat, point);
+    };
+    
+    if (config.compress || config.encrypt) {
+        // Una sola pasada: cada bloque se codifica apenas se lee
+        ContainerHeader header = ContainerHeader::for_encode(config.compress, cipher.get(), file_size,
+                                                            config.level, forced_codec(config));
+        BlockCodec codec(header.codec, cipher.get(), header.block_size);
+        codec.set_stats(stats);
+        codec.set_adaptive(config.comp_algorithm == "auto");
+        codec.set_level(config.level);
+        codec.set_zero_runs(true);
+        
+        // Buffers del pool: el mismo par sirve para todos los archivos por bloques
+        PooledBuffer in_buf(header.block_size);
+        PooledBuffer out_buf(BlockCodec::frame_bound(header.block_size));
+        ok = ok && in_buf.valid() && out_buf.valid();
+        if (stats != nullptr) stats->note_buffers(in_buf.capacity() + out_buf.capacity());
+        
+        // La cabecera del contenedor va primero y sin encriptar
+        unsigned char header_bytes[ContainerHeader::MAX_SIZE];
+        size_t header_size = header.write(header_bytes);
+        uint64_t index = 0;
+        if (resuming) {
+            // La cabecera ya está en la salida
+            codec.resume(resume.compressed_format, resume.holes);
+            index = resume.block_index;
+            bytes_in = resume.input_offset;
+            bytes_out = resume.output_offset;
+            ok = ok && input.seek(bytes_in);
+        } else {
+            ok = ok && output.write(header_bytes, header_size, stats);
+            bytes_out += header_size;
+        }
+        
+        // Los huecos del archivo no se leen: se suman a la racha de bloques
+        // de ceros, que se escribe antes del próximo bloque con datos
+        auto flush_holes = [&]() {
+            while (ok && codec.holes_pending()) {
+                size_t frame = codec.flush_holes(out_buf.data(), out_buf.capacity());
+                ok = output.write(out_buf.data(), frame, stats);
+                bytes_out += frame;
+            }
+        };
+        uint64_t data_end = 0;      // Hasta dónde hay datos sin volver a preguntar
+        ssize_t n = 0;
+        while (ok) {
+            if (bytes_in >= next_checkpoint && bytes_in < file_size && !codec.holes_pending()) {
+                JournalCheckpoint point;
+                point.block_index = index;
+                point.holes = codec.hole_blocks();
+                point.compressed_format = codec.detected_compressed_format();
+                ok = checkpoint(point);
+            }
+            if (ok && bytes_in >= data_end && bytes_in < file_size) {
+                uint64_t skip = sparse_hole_at(in_fd, bytes_in, file_size, header.block_size, data_end);
+                codec.add_holes(skip / header.block_size);
+                index += skip / header.block_size;
+                if (content_hash != nullptr) hasher.skip_zeros(skip);
+                bytes_in += skip;
+                ok = input.seek(bytes_in);
+            }
+            if (!ok || (n = input.read(in_buf.data(), header.block_size, stats)) <= 0) break;
+            hasher.update(in_buf.data(), n);
+            bytes_in += n;
+            if (codec.take_zero_block(in_buf.data(), n)) {
+                index++;
+                continue;
+            }
+            flush_holes();
+            size_t frame = codec.encode_block(in_buf.data(), n, index++, out_buf.data());
+            ok = ok && output.write(out_buf.data(), frame, stats);
+            bytes_out += frame;
+        }
+        flush_holes();
+        // El tamaño original ya está en la cabecera: si el archivo cambió, la salida no sirve
+        ok = ok && n == 0 && bytes_in == file_size;
+        ok = ok && output.finish(bytes_out, stats);
+        if (ok && codec.hole_blocks() > 0) {
+            // La cabecera ya se escribió: se marca FLAG_HOLES en el lugar
+            header.flags |= CONTAINER_FLAG_HOLES;
+            header.write(header_bytes);
+            ok = output.rewrite(0, header_bytes, header_size);
+            GSEA_VERBOSE("  → " << codec.hole_blocks() << " bloque(s) de ceros o huecos guardados como huecos\n");
+        }
+        log_adaptive_choice(codec, index);
+    } else {
+        // La cabecera del contenedor (si la hay) decide las etapas
+        unsigned char first[ContainerHeader::MAX_SIZE];
+        ssize_t n = input.read(first, sizeof(first), stats);
+        ContainerHeader input_header;
+        ContainerPlan plan;
+        size_t consumed = 0;
+        int status = n < 0 ? -1 : input_header.read(first, n, consumed);
+        std::string error = plan.prepare(status, input_header, config.decrypt,
+                                         config.decompress, cipher.get());
+        if (!error.empty()) {
+            GSEA_ERROR("\n✗ Error: " << error << "\n");
+            ok = false;
+        }
+        
+        // Continuar justo después de la cabecera (o desde el principio si no hay)
+        // (se leyó de más: la cabecera ocupa entre SIZE y MAX_SIZE bytes)
+        if (ok && plan.has_header) {
+            hasher.update(first, consumed);
+            bytes_in += consumed;
+            ok = input.seek(consumed);
+        } else if (ok) {
+            ok = input.seek(0);
+        }
+        
+        if (ok && plan.write_header && !resuming) {
+            unsigned char header_bytes[ContainerHeader::MAX_SIZE];
+            size_t header_size = plan.output_header.write(header_bytes);
+            ok = output.write(header_bytes, header_size, stats);
+            bytes_out += header_size;
+        }
+        
+        if (ok && plan.has_header && input_header.blocked()) {
+            // Bloques con CRC32C: se leen de a uno (cabecera + datos guardados)
+            BlockCodec codec(input_header.codec, plan.decrypt ? cipher.get() : nullptr,
+                             input_header.block_size);
+            codec.set_stats(stats);
+            PooledBuffer stored_buf(BlockCodec::frame_bound(input_header.block_size));
+            PooledBuffer raw_buf(input_header.block_size);
+            ok = stored_buf.valid() && raw_buf.valid();
+            if (stats != nullptr) stats->note_buffers(stored_buf.capacity() + raw_buf.capacity());
+            
+            uint64_t index = 0;
+            uint64_t produced = 0;
+            if (resuming) {
+                index = resume.block_index;
+                produced = resume.produced;
+                bytes_in = resume.input_offset;
+                bytes_out = resume.output_offset;
+                ok = ok && input.seek(bytes_in);
+            }
+            while (ok) {
+                if (bytes_in >= next_checkpoint && bytes_in < file_size) {
+                    JournalCheckpoint point;
+                    point.block_index = index;
+                    point.produced = produced;
+                    if (!checkpoint(point)) {
+                        ok = false;
+                        break;
+                    }
+                }
+                unsigned char block_bytes[BlockHeader::SIZE];
+                n = input.read(block_bytes, sizeof(block_bytes), stats);
+                if (n == 0) break;
+                
+                BlockHeader block;
+                if (n != (ssize_t)sizeof(block_bytes) || !block.read(block_bytes, input_header.block_size) ||
+                    input.read(stored_buf.data(), block.stored_size, stats) != (ssize_t)block.stored_size) {
+                    error = "cabecera inválida o datos truncados";
+                } else if (block.hole()) {
+                    // Nada que decodificar: -u copia la cabecera, -d deja el hueco
+                    hasher.update(block_bytes, sizeof(block_bytes));
+                    bytes_in += sizeof(block_bytes);
+                    if (plan.write_header) {
+                        ok = output.write(block_bytes, sizeof(block_bytes), stats);
+                        bytes_out += sizeof(block_bytes);
+                    } else {
+                        ok = output.skip(block.raw_bytes(), stats);
+                        bytes_out += block.raw_bytes();
+                    }
+                    produced += block.raw_bytes();
+                    index += block.hole_blocks;
+                    continue;
+                } else {
+                    hasher.update(block_bytes, sizeof(block_bytes));
+                    hasher.update(stored_buf.data(), block.stored_size);
+                    bytes_in += sizeof(block_bytes) + block.stored_size;
+                    
+                    if (plan.write_header) {
+                        // Queda comprimido: solo se quita el cifrado
+                        error = codec.strip_cipher(block, stored_buf.data(), index);
+                        block.write(block_bytes);
+                        ok = error.empty() && output.write(block_bytes, sizeof(block_bytes), stats) &&
+                             output.write(stored_buf.data(), block.stored_size, stats);
+                        bytes_out += sizeof(block_bytes) + block.stored_size;
+                    } else {
+                        error = codec.decode_block(block, stored_buf.data(), index, raw_buf.data());
+                        ok = error.empty() && output.write(raw_buf.data(), block.raw_size, stats);
+                        bytes_out += block.raw_size;
+                    }
+                    produced += block.raw_size;
+                }
+                if (!error.empty()) {
+                    GSEA_ERROR("\n✗ Error: Bloque " << index << ": " << error << "\n");
+                    ok = false;
+                }
+                index++;
+            }
+            if (ok && produced != input_header.original_size) {
+                GSEA_ERROR("Error: Se obtuvieron " << produced << " bytes, la cabecera indica "
+                           << input_header.original_size << "\n");
+                ok = false;
+            }
+            ok = ok && bytes_in == file_size;
+        } else if (ok && plan.decompress && config.decode_threads > 1) {
+            // Un solo flujo con varios hilos: se lee una ventana de un tramo
+            // por hilo y se decodifican los símbolos que seguro terminan en
+            // ella (un código ocupa a lo sumo 57 bits); el resto pasa a la
+            // siguiente ventana
+            static const size_t MARGIN = 8;
+            XORCipher::StreamState stream;
+            if (plan.decrypt) stream = cipher->begin_stream();
+            HuffmanCoder huffman;
+            std::unique_ptr<ParallelHuffmanDecoder> decoder;
+            PooledBuffer in_buf((size_t)config.decode_threads * ParallelHuffmanDecoder::SPAN_BYTES);
+            ok = in_buf.valid();
+            if (stats != nullptr) {
+                stats->note_buffers(in_buf.capacity() +
+                                    ParallelHuffmanDecoder::footprint(config.decode_threads));
+            }
+            StreamSink sink(output, stats);
+            size_t filled = 0;
+            uint64_t bit = 0;       // Próximo símbolo, en bits desde in_buf
+            
+            while (ok) {
+                n = input.read(in_buf.data() + filled, in_buf.capacity() - filled, stats);
+                if (n < 0 || (n == 0 && bytes_in < file_size)) {
+                    ok = false;
+                    break;
+                }
+                hasher.update(in_buf.data() + filled, n);
+                bytes_in += n;
+                if (plan.decrypt) {
+                    StageTimer timer(stats, STAGE_DECRYPT);
+                    cipher->decrypt_chunk(in_buf.data() + filled, in_buf.data() + filled, n, stream);
+                    timer.stop(n, n);
+                }
+                filled += n;
+                bool is_last = (bytes_in >= file_size);
+                
+                if (decoder == nullptr) {
+                    size_t huffman_header = 0;
+                    if (huffman.read_header(in_buf.data(), filled, huffman_header) != 1) {
+                        ok = false;
+                        break;
+                    }
+                    decoder.reset(new ParallelHuffmanDecoder(huffman, config.decode_threads));
+                    bit = (uint64_t)huffman_header * 8;
+                }
+                
+                uint64_t end_bit = (uint64_t)filled * 8;
+                if (is_last) end_bit -= std::min<uint64_t>(end_bit, huffman.get_padding());
+                uint64_t stop_bit = is_last ? end_bit : (uint64_t)(filled - MARGIN) * 8;
+                if (stop_bit > bit) {
+                    StageTimer timer(stats, STAGE_DECOMPRESS);
+                    uint64_t first_bit = bit;
+                    uint64_t written = sink.written;
+                    ok = decoder->decode(in_buf.data(), first_bit, stop_bit, end_bit, sink, bit);
+                    timer.stop((bit - first_bit) / 8, sink.written - written);
+                }
+                if (is_last) break;
+                
+                // Conservar desde el byte del próximo símbolo
+                size_t keep = (size_t)(bit / 8);
+                memmove(in_buf.data(), in_buf.data() + keep, filled - keep);
+                filled -= keep;
+                bit -= (uint64_t)keep * 8;
+            }
+            bytes_out += sink.written;
+            ok = ok && bytes_in == file_size;
+            if (ok && decoder != nullptr) {
+                GSEA_VERBOSE("  → Flujo único decodificado con " << config.decode_threads << " hilos ("
+                             << decoder->resynced_symbols() << " símbolos resincronizados en serie)\n");
+            }
+            
+            if (ok && plan.has_header && bytes_out != input_header.original_size) {
+                GSEA_ERROR("Error: Se obtuvieron " << bytes_out << " bytes, la cabecera indica "
+                           << input_header.original_size << "\n");
+                ok = false;
+            }
+        } else if (ok) {
+            // Un solo flujo (o archivo sin cabecera), en bloques de lectura
+            XORCipher::StreamState stream;
+            if (plan.decrypt) stream = cipher->begin_stream();
+            HuffmanCoder huffman;
+            PooledBuffer in_buf(STREAM_CHUNK_SIZE);
+            PooledBuffer out_buf(HuffmanCoder::decode_bound(STREAM_SLICE_SIZE));
+            ok = in_buf.valid() && out_buf.valid();
+            if (stats != nullptr) stats->note_buffers(in_buf.capacity() + out_buf.capacity());
+            bool header_done = false;
+            
+            while (ok && (n = input.read(in_buf.data(), in_buf.capacity(), stats)) > 0) {
+                hasher.update(in_buf.data(), n);
+                bytes_in += n;
+                bool is_last = (bytes_in >= file_size);
+                
+                unsigned char* payload = in_buf.data();
+                size_t payload_size = n;
+                
+                if (plan.decrypt) {
+                    StageTimer timer(stats, STAGE_DECRYPT);
+                    cipher->decrypt_chunk(payload, payload, payload_size, stream);
+                    timer.stop(payload_size, payload_size);
+                }
+                
+                if (!plan.decompress) {
+                    ok = output.write(payload, payload_size, stats);
+                    bytes_out += payload_size;
+                    continue;
+                }
+                
+                // La cabecera Huffman (<= MAX_HEADER_SIZE) siempre entra en el
+                // primer bloque: read_full() solo devuelve menos al final del archivo
+                if (!header_done) {
+                    size_t huffman_header = 0;
+                    if (huffman.read_header(payload, payload_size, huffman_header) != 1) {
+                        ok = false;
+                        break;
+                    }
+                    header_done = true;
+                    payload += huffman_header;
+                    payload_size -= huffman_header;
+                }
+                
+                for (size_t offset = 0; ok && offset < payload_size; offset += STREAM_SLICE_SIZE) {
+                    size_t slice = std::min(STREAM_SLICE_SIZE, payload_size - offset);
+                    size_t produced = 0;
+                    StageTimer timer(stats, STAGE_DECOMPRESS);
+                    ok = huffman.decode(payload + offset, slice, is_last && offset + slice == payload_size,
+                                        out_buf.data(), out_buf.capacity(), produced);
+                    timer.stop(slice, produced);
+                    ok = ok && output.write(out_buf.data(), produced, stats);
+                    bytes_out += produced;
+                }
+            }
+            ok = ok && n == 0 && bytes_in == file_size && (header_done || !plan.decompress);
+            
+            if (ok && plan.decompress && plan.has_header && bytes_out != input_header.original_size) {
+                GSEA_ERROR("Error: Se obtuvieron " << bytes_out << " bytes, la cabecera indica "
+                           << input_header.original_size << "\n");
+                ok = false;
+            }
+        }
+        // Los huecos al final solo existen después de fijar el tamaño
+        ok = ok && output.finish(bytes_out, stats);
+    }
+    
+    close(in_fd);
+    close(out_fd);
+    
+    if (!ok) {
+        GSEA_ERROR("\n✗ Error: Fallo en el procesamiento por bloques de " << input_file << "\n");
+        return false;
+    }
+    
+    if (content_hash != nullptr) {
+        *content_hash = hasher.digest();
+    }
+    
+    GSEA_VERBOSE("\n✓ Archivo procesado exitosamente (por bloques)\n");
+    GSEA_INFO("  ✓ " << input_file << " → " << output_file << " (" << bytes_in << " → "
+              << bytes_out << " bytes, por bloques)\n");
+    return true;
+}
+
+// ============================================================================
+// MODO DELTA: VERSIONES CONTRA UN ARCHIVO BASE (--base)
+// ============================================================================
+
+/**
+ * Archivo proyectado en memoria con mmap() (solo lectura)
+ * 
+ * El delta compara el archivo nuevo con la base en cualquier orden, y dedup
+ * corta chunks sobre el archivo entero: con mmap() el kernel trae las
+ * páginas a medida que se tocan y no hace falta que el archivo quepa en RAM.
+ */
+struct MappedFile {
+    const unsigned char* data = nullptr;
+    uint64_t size = 0;
+    
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile() {
+        if (data != nullptr) munmap((void*)data, size);
+    }
+    
+    // open(), fstat(), mmap() y close(). Un archivo vacío queda con data = nullptr
+    bool map(const std::string& path) {
+        count_syscall(4);
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            GSEA_ERROR("  [Error] open() de " << path << " falló: " << strerror(errno) << "\n");
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)) {
+            GSEA_ERROR("  [Error] " << path << " no es un archivo regular\n");
+            close(fd);
+            return false;
+        }
+        size = st.st_size;
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                GSEA_ERROR("  [Error] mmap() de " << path << " falló: " << strerror(errno) << "\n");
+                close(fd);
+                return false;
+            }
+            data = (const unsigned char*)mapped;
+            madvise(mapped, size, MADV_SEQUENTIAL);
+        }
+        close(fd);
+        return true;
+    }
+};
+
+/**
+ * Salida del delta al restaurar: junta las instrucciones chicas en un
+ * buffer y escribe las copias grandes directo desde la base proyectada
+ */
+struct DeltaFileSink {
+    int fd;
+    FileStats* stats;
+    PooledBuffer buffer;
+    size_t used = 0;
+    
+    DeltaFileSink(int out_fd, FileStats* file_stats)
+        : fd(out_fd), stats(file_stats), buffer(STREAM_CHUNK_SIZE) {}
+    
+    bool flush() {
+        bool ok = write_full(fd, buffer.data(), used, stats);
+        used = 0;
+        return ok;
+    }
+    
+    bool write(const unsigned char* data, size_t size) {
+        if (used + size > buffer.capacity() && !flush()) return false;
+        if (size >= buffer.capacity()) return write_full(fd, data, size, stats);
+        memcpy(buffer.data() + used, data, size);
+        used += size;
+        return true;
+    }
+};
+
+/**
+ * Guardar (-c) o restaurar (-d) un archivo como delta contra config.base_path
+ * 
+ *   - guardar: se indexan los bloques de la base, se calculan las
+ *     instrucciones (copias de la base + literales) y se escriben en bloques
+ *     del contenedor con FLAG_DELTA, comprimidos con el nivel pedido y
+ *     cifrados si se pidió -e. La cabecera lleva el Hash64 de la base
+ *   - restaurar: se comprueba que la base sea la misma (tamaño y hash), se
+ *     decodifican los bloques de a uno y se aplican sus instrucciones
+ * 
+ * La memoria no depende del tamaño de los archivos (ambos van por mmap()),
+ * salvo la lista de instrucciones, que crece con las ediciones.
+ */
+bool process_file_delta(const std::string& input_file, const std::string& output_file,
+                        const Config& config, uint64_t* content_hash = nullptr,
+                        FileStats* stats = nullptr) {
+    GSEA_VERBOSE("\n┌───────────────────────────────────────────────────────┐\n");
+    GSEA_VERBOSE("│ DELTA:   " << input_file << "\n");
+    GSEA_VERBOSE("│ BASE:    " << config.base_path << "\n");
+    GSEA_VERBOSE("│ DESTINO: " << output_file << "\n");
+    GSEA_VERBOSE("└───────────────────────────────────────────────────────┘\n");
+    
+    MappedFile base;
+    if (!base.map(config.base_path)) {
+        GSEA_ERROR("\n✗ Error: No se pudo leer la base " << config.base_path << "\n");
+        return false;
+    }
+    
+    std::unique_ptr<XORCipher> cipher;
+    if (!config.key.empty() && (config.encrypt || config.decrypt)) {
+        cipher.reset(new XORCipher(config.key));
+    }
+    
+    bool ok = true;
+    std::string error;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    DeltaStats delta;
+    
+    if (config.compress) {
+        MappedFile input;
+        if (!input.map(input_file) || input.size == 0) {
+            GSEA_ERROR("\n✗ ERROR CRÍTICO: No se pudo leer el archivo o está vacío\n");
+            return false;
+        }
+        bytes_in = input.size;
+        
+        // Las instrucciones se calculan antes de escribir: su tamaño va en la cabecera
+        std::vector<DeltaOp> ops;
+        ContainerHeader header;
+        {
+            StageTimer timer(stats, STAGE_COMPRESS);
+            DeltaIndex index;
+            index.build(base.data, base.size);
+            DeltaEncoder::plan(index, base.data, base.size, input.data, input.size, ops);
+            header = ContainerHeader::for_encode(true, cipher.get(), DeltaEncoder::stream_size(ops, &delta),
+                                                 config.level, forced_codec(config));
+            header.flags |= CONTAINER_FLAG_DELTA;
+            header.base_hash = Hash64::of(base.data, base.size);
+            header.target_size = input.size;
+            timer.stop(0, 0);   // Los bytes los cuentan los bloques al comprimir
+        }
+        if (content_hash != nullptr) {
+            *content_hash = ContentHash::of(input.data, input.size);
+        }
+        
+        count_syscall(2);
+        int out_fd = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd == -1) {
+            GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
+            return false;
+        }
+        
+        BlockCodec codec(header.codec, cipher.get(), header.block_size);
+        codec.set_stats(stats);
+        codec.set_adaptive(config.comp_algorithm == "auto");
+        codec.set_level(config.level);
+        PooledBuffer in_buf(header.block_size);
+        PooledBuffer out_buf(BlockCodec::frame_bound(header.block_size));
+        ok = in_buf.valid() && out_buf.valid();
+        
+        unsigned char header_bytes[ContainerHeader::MAX_SIZE];
+        size_t header_size = header.write(header_bytes);
+        ok = ok && write_full(out_fd, header_bytes, header_size, stats);
+        bytes_out += header_size;
+        
+        DeltaWriter writer(ops, input.data);
+        uint64_t index = 0;
+        size_t n = 0;
+        while (ok && (n = writer.next(in_buf.data(), header.block_size)) > 0) {
+            size_t frame = codec.encode_block(in_buf.data(), n, index++, out_buf.data());
+            ok = write_full(out_fd, out_buf.data(), frame, stats);
+            bytes_out += frame;
+        }
+        log_adaptive_choice(codec, index);
+        close(out_fd);
+    } else {
+        count_syscall(3);
+        int in_fd = open(input_file.c_str(), O_RDONLY);
+        if (in_fd == -1) {
+            GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
+            return false;
+        }
+        
+        unsigned char first[ContainerHeader::MAX_SIZE];
+        ssize_t n = read_full(in_fd, first, sizeof(first), stats);
+        ContainerHeader header;
+        ContainerPlan plan;
+        size_t consumed = 0;
+        int status = n < 0 ? -1 : header.read(first, n, consumed);
+        error = plan.prepare(status, header, config.decrypt, config.decompress, cipher.get(), true);
+        if (error.empty() && Hash64::of(base.data, base.size) != header.base_hash) {
+            error = "La base no es la versión contra la que se guardó el delta";
+        }
+        
+        int out_fd = -1;
+        if (error.empty()) {
+            out_fd = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (out_fd == -1) error = std::string("open() falló: ") + strerror(errno);
+        }
+        ok = error.empty() && lseek(in_fd, consumed, SEEK_SET) == (off_t)consumed;
+        count_syscall();
+        bytes_in += consumed;
+        
+        if (ok) {
+            BlockCodec codec(header.codec, plan.decrypt ? cipher.get() : nullptr, header.block_size);
+            codec.set_stats(stats);
+            PooledBuffer stored_buf(BlockCodec::frame_bound(header.block_size));
+            PooledBuffer raw_buf(header.block_size);
+            DeltaFileSink sink(out_fd, stats);
+            DeltaDecoder decoder(base.data, base.size, header.target_size);
+            ok = stored_buf.valid() && raw_buf.valid() && sink.buffer.valid();
+            
+            uint64_t index = 0;
+            uint64_t produced = 0;
+            while (ok) {
+                unsigned char block_bytes[BlockHeader::SIZE];
+                n = read_full(in_fd, block_bytes, sizeof(block_bytes), stats);
+                if (n == 0) break;
+                
+                BlockHeader block;
+                if (n != (ssize_t)sizeof(block_bytes) || !block.read(block_bytes, header.block_size) ||
+                    read_full(in_fd, stored_buf.data(), block.stored_size, stats) != (ssize_t)block.stored_size) {
+                    error = "cabecera inválida o datos truncados";
+                } else {
+                    bytes_in += sizeof(block_bytes) + block.stored_size;
+                    error = codec.decode_block(block, stored_buf.data(), index, raw_buf.data());
+                    if (error.empty() && !decoder.feed(raw_buf.data(), block.raw_size, sink)) {
+                        error = "instrucciones del delta inválidas (o falló la escritura)";
+                    }
+                    produced += block.raw_size;
+                }
+                if (!error.empty()) {
+                    GSEA_ERROR("\n✗ Error: Bloque " << index << ": " << error << "\n");
+                    error.clear();
+                    ok = false;
+                }
+                index++;
+            }
+            ok = ok && sink.flush();
+            if (ok && (produced != header.original_size || !decoder.finished())) {
+                GSEA_ERROR("Error: El delta reconstruyó " << decoder.bytes_produced()
+                           << " bytes, la cabecera indica " << header.target_size << "\n");
+                ok = false;
+            }
+            bytes_out = decoder.bytes_produced();
+        }
+        if (!error.empty()) {
+            GSEA_ERROR("\n✗ Error: " << error << "\n");
+        }
+        close(in_fd);
+        if (out_fd != -1) close(out_fd);
+    }
+    
+    if (!ok) {
+        GSEA_ERROR("\n✗ Error: Fallo en el delta de " << input_file << "\n");
+        return false;
+    }
+    
+    GSEA_VERBOSE("\n✓ Delta procesado exitosamente\n");
+    if (config.compress) {
+        GSEA_VERBOSE("  → " << delta.copied << " bytes copiados de la base, " << delta.literal
+                     << " literales, " << delta.ops << " instrucciones\n");
+    }
+    GSEA_INFO("  ✓ " << input_file << " → " << output_file << " (" << bytes_in << " → "
+              << bytes_out << " bytes, delta)\n");
+    return true;
+}
+
+/**
+ * Tamaño original que declara la cabecera de contenedor de un archivo
+ * @param flags Si no es nullptr, recibe los flags de la cabecera (0 si no hay)
+ * @return 0 si no tiene cabecera o no se pudo leer
+ */
+uint64_t declared_original_size(const std::string& path, uint32_t* flags = nullptr) {
+    unsigned char bytes[ContainerHeader::SIZE];
+    uint64_t original = 0;
+    count_syscall(2);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) return 0;
+    ssize_t n = read_full(fd, bytes, sizeof(bytes));
+    close(fd);
+    if (n != (ssize_t)sizeof(bytes) || !ContainerHeader::peek_original_size(bytes, n, original)) {
+        return 0;
+    }
+    if (flags != nullptr) *flags = ContainerHeader::peek_flags(bytes, n);
+    return original;
+}
+
+/**
+ * Códec, cifrado y flags de la cabecera de contenedor de un archivo, sin
+ * escribir mensajes (los errores de la cabecera se informan al procesarlo)
+ * @return false si no tiene cabecera o no se pudo leer
+ */
+bool declared_header(const std::string& path, ContainerHeader& header) {
+    unsigned char bytes[ContainerHeader::SIZE];
+    count_syscall(2);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+    ssize_t n = read_full(fd, bytes, sizeof(bytes));
+    close(fd);
+    return n == (ssize_t)sizeof(bytes) && ContainerHeader::peek(bytes, n, header);
+}
+
+/**
+ * Crear un archivo temporal junto a path (o en $TMPDIR si ese directorio no
+ * admite archivos nuevos, como /dev)
+ * @return La ruta creada, o "" si no se pudo
+ */
+std::string create_temp_file(const std::string& path) {
+    const char* tmpdir = getenv("TMPDIR");
+    std::string candidates[2] = {
+        path + ".XXXXXX",
+        std::string(tmpdir != nullptr && *tmpdir != '\0' ? tmpdir : "/tmp") + "/gsea.XXXXXX"
+    };
+    for (const std::string& candidate : candidates) {
+        std::vector<char> name(candidate.begin(), candidate.end());
+        name.push_back('\0');
+        count_syscall(2);
+        int fd = mkstemp(name.data());
+        if (fd != -1) {
+            close(fd);
+            return std::string(name.data());
+        }
+    }
+    GSEA_ERROR("  [Error] No se pudo crear un archivo temporal para " << path << ": "
+               << strerror(errno) << "\n");
+    return "";
+}
+
+/**
+ * Memoria de process_file_delta() fuera de los archivos proyectados: los
+ * buffers de bloque y, al guardar, el índice de la base y la lista de
+ * instrucciones
+ */
+uint64_t delta_footprint(const std::string& input_file, const Config& config) {
+    uint64_t footprint = stream_footprint(config);
+    if (!config.compress) return footprint;
+    struct stat base_st, input_st;
+    count_syscall(2);
+    if (stat(config.base_path.c_str(), &base_st) == -1 || stat(input_file.c_str(), &input_st) == -1) {
+        return footprint;      // process_file_delta() informa el error
+    }
+    return footprint + DeltaIndex::footprint(base_st.st_size) +
+           DeltaEncoder::ops_footprint(base_st.st_size, input_st.st_size);
+}
+
+/**
+ * Procesar un archivo respetando el presupuesto de memoria
+ * 
+ * Si el archivo cabe en el presupuesto (y en IN_MEMORY_LIMIT) se reserva su
+ * memoria (esperando a que otros hilos liberen si hace falta) y se procesa
+ * completo en memoria. Si no, se procesa por bloques.
+ * Un delta (--base) reserva delta_footprint() y va siempre por
+ * process_file_delta().
+ * Con journal también van por bloques los archivos de al menos un intervalo
+ * de punto de control, para poder retomarlos a mitad; con --cpu-limit, los
+ * de más de PACED_IN_MEMORY_LIMIT.
+ */
+bool process_file_budgeted(const std::string& input_file, const std::string& output_file,
+                           const Config& config, MemoryBudget* budget, uint64_t* content_hash,
+                           FileStats* stats, Journal* journal = nullptr) {
+    if (!config.base_path.empty()) {
+        // El índice de la base y las instrucciones también cuentan: si no
+        // entran junto a otros trabajos, el delta espera a correr solo
+        uint64_t needed = delta_footprint(input_file, config);
+        if (budget != nullptr && !budget->fits(needed)) {
+            GSEA_VERBOSE("  [Memoria] " << input_file << ": el delta necesitaría " << (needed >> 20)
+                         << " MB, espera a correr solo\n");
+        }
+        BudgetReservation reservation(budget, needed);
+        return process_file_delta(input_file, output_file, config, content_hash, stats);
+    }
+    
+    // -du sobre algo comprimido con -c y encriptado después con -e: el
+    // payload es otro contenedor. Se desencripta a un temporal y se
+    // descomprime ese (el diario no puede retomar ninguna de las dos pasadas)
+    ContainerHeader outer;
+    if (declared_header(input_file, outer) &&
+        ContainerPlan::nested(outer, config.decrypt, config.decompress)) {
+        GSEA_VERBOSE("  [Formato] " << input_file << " encripta otro contenedor: se decodifica en dos pasadas\n");
+        std::string temp = create_temp_file(output_file);
+        if (temp.empty()) return false;
+        Config decrypt_only = config;
+        decrypt_only.decompress = false;
+        Config decompress_only = config;
+        decompress_only.decrypt = false;
+        ContainerHeader inner;
+        bool ok = process_file_budgeted(input_file, temp, decrypt_only, budget, content_hash, nullptr);
+        if (ok && !(declared_header(temp, inner) && inner.codec != CONTAINER_CODEC_NONE)) {
+            GSEA_ERROR("\n✗ Error: El contenido desencriptado no está comprimido: quite -d\n");
+            ok = false;
+        }
+        if (ok) ok = process_file_budgeted(temp, output_file, decompress_only, budget, nullptr, stats);
+        count_syscall();
+        unlink(temp.c_str());
+        return ok;
+    }
+    
+    struct stat st;
+    count_syscall();
+    if (stat(input_file.c_str(), &st) == -1) {
+        GSEA_ERROR("  [Error] stat() falló: " << strerror(errno) << "\n");
+        return false;
+    }
+    
+    // Al decodificar (también con -u solo) la cabecera dice si hay huecos
+    uint32_t flags = 0;
+    bool decoding = config.decrypt || config.decompress;
+    uint64_t declared = decoding ? declared_original_size(input_file, &flags) : 0;
+    uint64_t original_size = config.decompress ? declared : 0;
+    uint64_t needed = estimate_memory(st.st_size, config, original_size);
+    // Los huecos solo se saltan (al leer) y se recrean (al escribir) por bloques
+    bool sparse = decoding ? (flags & CONTAINER_FLAG_HOLES) != 0
+                           : (config.compress || config.encrypt) &&
+                             (uint64_t)st.st_blocks * 512 < (uint64_t)st.st_size;
+    bool resumable = journal != nullptr && (uint64_t)st.st_size >= journal->checkpoint_interval();
+    bool paced = Throttle::global().cpu_limited() && (uint64_t)st.st_size > PACED_IN_MEMORY_LIMIT;
+    if (config.direct || sparse || resumable || paced || needed > IN_MEMORY_LIMIT ||
+        (budget != nullptr && !budget->fits(needed))) {
+        if (config.direct) {
+            GSEA_VERBOSE("  [E/S] " << input_file << ": --direct, se procesa por bloques\n");
+        } else if (paced) {
+            GSEA_VERBOSE("  [CPU] " << input_file << ": --cpu-limit, se procesa por bloques\n");
+        } else if (resumable) {
+            GSEA_VERBOSE("  [Diario] " << input_file << ": se procesa por bloques con puntos de control\n");
+        } else if (sparse) {
+            GSEA_VERBOSE("  [Huecos] " << input_file << ": se procesa por bloques\n");
+        } else {
+            GSEA_VERBOSE("  [Memoria] " << input_file << " necesitaría " << (needed >> 20)
+                         << " MB: se procesa por bloques\n");
+        }
+        BudgetReservation reservation(budget, stream_footprint(config));
+        if (stats != nullptr) stats->streaming = true;
+        return process_file_streaming(input_file, output_file, config, content_hash, stats, journal);
+    }
+    
+    BudgetReservation reservation(budget, needed);
+    return process_file(input_file, output_file, config, content_hash, stats);
+}
+
+// ============================================================================
+// MODO DEDUP: CHUNKS DEFINIDOS POR CONTENIDO
+// ============================================================================
+
+// Estado compartido por todos los archivos de una ejecución con --dedup
+struct DedupContext {
+    ChunkStore* store = nullptr;
+    ContentChunker chunker;
+    DedupStats stats;
+};
+
+/**
+ * Guardar un archivo en el almacén de chunks y escribir su receta
+ * 
+ * Cada chunk se identifica por su hash de 128 bits. Solo los chunks que el
+ * almacén no conoce se comprimen/encriptan y se escriben; los repetidos
+ * (dentro del mismo archivo o entre archivos) cuestan el hash y una
+ * comparación con el chunk guardado.
+ */
+bool dedup_store_file(const std::string& input_file, const std::string& output_file,
+                      DedupContext& ctx, uint64_t* content_hash) {
+    GSEA_VERBOSE("\n[DEDUP] " << input_file << " → " << output_file << "\n");
+    
+    // Por mmap(), como --base: los chunks se cortan sobre el archivo
+    // proyectado, así que no ocupa memoria propia ni pasa por --max-memory
+    MappedFile data;
+    if (!data.map(input_file) || data.size == 0) {
+        GSEA_ERROR("\n✗ ERROR CRÍTICO: No se pudo leer el archivo o está vacío\n");
+        return false;
+    }
+    if (content_hash != nullptr) {
+        *content_hash = ContentHash::of(data.data, data.size);
+    }
+    
+    DedupRecipe recipe;
+    recipe.total_size = data.size;
+    uint64_t new_before = ctx.stats.new_chunks;
+    
+    uint64_t offset = 0;
+    while (offset < data.size) {
+        size_t length = ctx.chunker.next_cut(data.data + offset, data.size - offset);
+        ChunkId id = ChunkId::of(data.data + offset, length);
+        
+        if (!ctx.store->put(id, data.data + offset, length, ctx.stats)) {
+            GSEA_ERROR("\n✗ Error: No se pudo guardar un chunk en el almacén\n");
+            return false;
+        }
+        recipe.chunks.push_back(id);
+        recipe.sizes.push_back(length);
+        ctx.stats.chunks++;
+        offset += length;
+    }
+    
+    // Los chunks deben ser durables ANTES de que exista una receta que los use
+    if (!ctx.store->flush()) return false;
+    
+    if (!write_file_syscall(output_file, recipe.serialize())) {
+        GSEA_ERROR("\n✗ Error: No se pudo escribir la receta\n");
+        return false;
+    }
+    
+    ctx.stats.files++;
+    ctx.stats.logical_bytes += data.size;
+    GSEA_INFO("  ✓ " << input_file << " → " << output_file << ": " << recipe.chunks.size() << " chunks, "
+              << (ctx.stats.new_chunks - new_before) << " nuevos\n");
+    return true;
+}
+
+/**
+ * Reconstruir un archivo a partir de su receta y el almacén de chunks
+ */
+bool dedup_restore_file(const std::string& input_file, const std::string& output_file,
+                        DedupContext& ctx) {
+    GSEA_VERBOSE("\n[DEDUP] Restaurando " << input_file << " → " << output_file << "\n");
+    
+    DedupRecipe recipe;
+    if (!recipe.parse(read_file_syscall(input_file))) return false;
+    
+    int fd = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        GSEA_ERROR("  [Error] open() falló: " << strerror(errno) << "\n");
+        return false;
+    }
+    
+    std::vector<unsigned char> chunk;
+    uint64_t written = 0;
+    for (size_t i = 0; i < recipe.chunks.size(); i++) {
+        if (!ctx.store->get(recipe.chunks[i], chunk) || chunk.size() != recipe.sizes[i]) {
+            close(fd);
+            return false;
+        }
+        size_t done = 0;
+        while (done < chunk.size()) {
+            ssize_t n = write(fd, chunk.data() + done, chunk.size() - done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                GSEA_ERROR("  [Error] write() falló: " << strerror(errno) << "\n");
+                close(fd);
+                return false;
+            }
+            done += n;
+        }
+        written += chunk.size();
+    }
+    close(fd);
+    
+    if (written != recipe.total_size) {
+        GSEA_ERROR("  [Error] Tamaño reconstruido incorrecto: " << written
+                   << " de " << recipe.total_size << " bytes\n");
+        return false;
+    }
+    
+    ctx.stats.files++;
+    ctx.stats.logical_bytes += written;
+    ctx.stats.chunks += recipe.chunks.size();
+    GSEA_INFO("  ✓ " << output_file << ": " << written << " bytes reconstruidos desde "
+              << recipe.chunks.size() << " chunks\n");
+    return true;
+}
+
+// Estado compartido de una ejecución (lo que no es configuración)
+struct RunContext {
+    Manifest* manifest = nullptr;   // --incremental
+    DedupContext* dedup = nullptr;  // --dedup
+    MemoryBudget* budget = nullptr; // --max-memory
+    RunStats* stats = nullptr;      // --stats
+    Journal* journal = nullptr;     // --journal
+};
+
+/**
+ * Procesar un archivo respetando el manifiesto incremental
+ * 
+ * Si no hay manifiesto ni diario se comporta igual que process_file().
+ * Con manifiesto: omite el archivo si su salida sigue vigente y, si se
+ * procesa con éxito, lo registra con su metadata (y hash, si se pidió).
+ * Con diario: omite el archivo si la ejecución anterior lo terminó y anota
+ * cada salida completa.
+ * 
+ * @param stats Si no es nullptr, recibe las métricas de las etapas
+ * @return 1 si se procesó, 0 si se omitió por no tener cambios, -1 si falló
+ */
+int process_file_incremental(const std::string& input_file, const std::string& output_file,
+                             const Config& config, RunContext& ctx, FileStats* stats) {
+    Manifest* manifest = ctx.manifest;
+    DedupContext* dedup = ctx.dedup;
+    Journal* journal = ctx.journal;
+    
+    // Elegir el camino: dedup (guardar o restaurar) o procesamiento normal
+    bool dedup_restore = config.decompress || config.decrypt;
+    
+    if (manifest == nullptr && journal == nullptr) {
+        bool ok;
+        if (dedup != nullptr) {
+            ok = dedup_restore ? dedup_restore_file(input_file, output_file, *dedup)
+                               : dedup_store_file(input_file, output_file, *dedup, nullptr);
+        } else {
+            ok = process_file_budgeted(input_file, output_file, config, ctx.budget, nullptr, stats);
+        }
+        return ok ? 1 : -1;
+    }
+    
+    // stat() ANTES de procesar: si el archivo cambia durante el proceso,
+    // la próxima ejecución lo detectará y lo volverá a procesar
+    struct stat st;
+    if (stat(input_file.c_str(), &st) == -1) {
+        GSEA_ERROR("  [Error] stat() falló: " << strerror(errno) << "\n");
+        return -1;
+    }
+    
+    uint64_t hash = 0;
+    uint64_t* hash_out = manifest != nullptr && config.manifest_hash ? &hash : nullptr;
+    
+    if (journal != nullptr && journal->completed(input_file, output_file, st)) {
+        // Terminado antes del corte: el manifiesto igual debe enterarse
+        GSEA_INFO("  ⟳ Ya terminado según el diario, omitido: " << input_file << "\n");
+        if (manifest != nullptr && (hash_out == nullptr || Manifest::hash_file(input_file, hash))) {
+            manifest->record(input_file, output_file, st, config.manifest_hash, hash);
+        }
+        return 0;
+    }
+    
+    if (manifest != nullptr && manifest->is_current(input_file, output_file, st, config.manifest_hash)) {
+        GSEA_INFO("  ⟳ Sin cambios, omitido: " << input_file << "\n");
+        return 0;
+    }
+    
+    bool ok;
+    if (dedup == nullptr) {
+        ok = process_file_budgeted(input_file, output_file, config, ctx.budget, hash_out, stats, journal);
+    } else if (dedup_restore) {
+        ok = dedup_restore_file(input_file, output_file, *dedup);
+        if (ok && hash_out != nullptr) ok = Manifest::hash_file(input_file, hash);
+    } else {
+        ok = dedup_store_file(input_file, output_file, *dedup, hash_out);
+    }
+    if (!ok || (journal != nullptr && !journal->record_done(input_file, output_file, st))) {
+        return -1;
+    }
+    
+    if (manifest != nullptr) manifest->record(input_file, output_file, st, config.manifest_hash, hash);
+    return 1;
+}
+
+/**
+ * Procesar un archivo y, con --stats, registrar sus métricas
+ * 
+ * El tiempo, la CPU y las syscalls se toman alrededor de todo el archivo
+ * (incluye dedup y manifiesto); los bytes son los tamaños de entrada y
+ * salida en disco. Los archivos omitidos por el manifiesto no se registran.
+ */
+int process_file_measured(const std::string& input_file, const std::string& output_file,
+                          const Config& config, RunContext& ctx) {
+    if (ctx.stats == nullptr) {
+        return process_file_incremental(input_file, output_file, config, ctx, nullptr);
+    }
+    
+    FileStats file;
+    file.input = input_file;
+    file.output = output_file;
+    uint64_t syscalls_before = thread_syscalls();
+    StageClock start = StageClock::now();
+    
+    int result = process_file_incremental(input_file, output_file, config, ctx, &file);
+    
+    StageClock end = StageClock::now();
+    if (result == 0) {
+        return result;
+    }
+    file.ok = result > 0;
+    file.wall_ns = end.wall_ns - start.wall_ns;
+    file.cpu_ns = end.cpu_ns - start.cpu_ns;
+    file.syscalls = thread_syscalls() - syscalls_before;
+    
+    struct stat st;
+    if (stat(input_file.c_str(), &st) == 0) file.bytes_in = st.st_size;
+    if (file.ok && stat(output_file.c_str(), &st) == 0) file.bytes_out = st.st_size;
+    
+    ctx.stats->add(file);
+    return result;
+}
+
+/**
+ * Construir la ruta de salida de un archivo dentro de un directorio
+ */
+std::string directory_output_path(const std::string& input_file, const Config& config) {
+    // Extraer nombre del archivo
+    size_t last_slash = input_file.find_last_of('/');
+    std::string filename = (last_slash != std::string::npos) 
+                           ? input_file.substr(last_slash + 1) 
+                           : input_file;
+    
+    // Construir ruta de salida
+    std::string output_file = config.output_path + "/" + filename;
+    
+    // Agregar extensión apropiada
+    if (!config.dedup_store.empty() && (config.compress || config.encrypt)) {
+        output_file += ".gdd";
+    } else if (config.compress && config.encrypt) {
+        output_file += ".gsea";
+    } else if (config.compress) {
+        output_file += ".huff";
+    } else if (config.encrypt) {
+        output_file += ".enc";
+    }
+    return output_file;
+}
+
+// Cola de trabajo compartida por los hilos del modo directorio
+struct DirectoryJob {
+    const std::vector<std::string>* files;
+    const Config* config;
+    RunContext* ctx;
+    size_t next = 0;        // Próximo archivo a tomar
+    int processed = 0;
+    int skipped = 0;
+    int failed = 0;
+    pthread_mutex_t mutex;
+};
+
+/**
+ * Hilo de trabajo: toma archivos de la cola hasta que se acaben
+ */
+void* directory_worker(void* arg) {
+    DirectoryJob* job = (DirectoryJob*)arg;
+    
+    while (true) {
+        pthread_mutex_lock(&job->mutex);
+        if (job->next >= job->files->size()) {
+            pthread_mutex_unlock(&job->mutex);
+            break;
+        }
+        const std::string& input_file = (*job->files)[job->next++];
+        pthread_mutex_unlock(&job->mutex);
+        
+        std::string output_file = directory_output_path(input_file, *job->config);
+        
+        // Procesar archivo
+        int result = process_file_measured(input_file, output_file, *job->config, *job->ctx);
+        
+        pthread_mutex_lock(&job->mutex);
+        if (result > 0) {
+            job->processed++;
+        } else if (result == 0) {
+            job->skipped++;
+        } else {
+            job->failed++;
+        }
+        pthread_mutex_unlock(&job->mutex);
+    }
+    return nullptr;
+}
+
+/**
+ * Modo --verify: comprobar los CRC32C de un archivo o de todos los de un
+ * directorio, sin escribir nada
+ * 
+ * Los bloques de cada archivo se verifican en paralelo (-j, por defecto uno
+ * por CPU). Sin la clave solo se comprueban los bytes guardados; con ella
+ * (o si el archivo no está encriptado) también el contenido original.
+ * @return true si ningún archivo tiene bloques dañados
+ */
+bool run_verify(const Config& config, bool input_is_directory) {
+    std::vector<std::string> files;
+    if (input_is_directory) {
+        files = list_files(config.input_path);
+    } else {
+        files.push_back(config.input_path);
+    }
+    
+    int threads = config.threads > 0 ? config.threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    std::unique_ptr<XORCipher> cipher;
+    if (!config.key.empty()) {
+        cipher.reset(new XORCipher(config.key));
+    }
+    
+    GSEA_INFO("\n┌───────────────────────────────────────────────────────┐\n");
+    GSEA_INFO("│ VERIFICACIÓN: " << files.size() << " archivo(s), " << threads << " hilo(s)\n");
+    GSEA_INFO("│ CRC32C: " << CRC32C::implementation() << "\n");
+    GSEA_INFO("└───────────────────────────────────────────────────────┘\n");
+    
+    int good = 0;
+    int damaged = 0;
+    int unchecked = 0;
+    uint64_t total_bytes = 0;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    
+    for (const std::string& file : files) {
+        BlockVerifier verifier;
+        VerifyReport report = verifier.verify(file, cipher.get(), threads);
+        total_bytes += report.stored_bytes;
+        
+        if (!report.error.empty()) {
+            GSEA_INFO("  ✗ " << file << ": " << report.error << "\n");
+            damaged++;
+        } else if (!report.has_header) {
+            GSEA_INFO("  - " << file << ": sin cabecera de GSEA, no se puede verificar\n");
+            unchecked++;
+        } else if (!report.blocked) {
+            GSEA_INFO("  - " << file << ": formato de un solo flujo, sin CRC por bloque\n");
+            unchecked++;
+        } else if (!report.bad_blocks.empty()) {
+            std::string list;
+            for (size_t i = 0; i < report.bad_blocks.size() && i < 10; i++) {
+                list += " " + std::to_string(report.bad_blocks[i]);
+            }
+            if (report.bad_blocks.size() > 10) list += " ...";
+            GSEA_INFO("  ✗ " << file << ": " << report.bad_blocks.size() << " de "
+                      << report.blocks << " bloque(s) dañado(s):" << list << "\n");
+            damaged++;
+        } else {
+            GSEA_INFO("  ✓ " << file << ": " << report.blocks << " bloque(s), "
+                      << (report.content_checked ? "contenido verificado"
+                                                 : "datos guardados verificados (sin clave)")
+                      << "\n");
+            good++;
+        }
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    
+    GSEA_INFO("\n  Archivos correctos:  " << good << "\n");
+    GSEA_INFO("  Archivos dañados:    " << damaged << "\n");
+    if (unchecked > 0) {
+        GSEA_INFO("  Sin verificar:       " << unchecked << "\n");
+    }
+    if (seconds > 0) {
+        GSEA_INFO("  Throughput:          " << (total_bytes / 1048576.0) / seconds << " MB/s\n");
+    }
+    return damaged == 0;
+}
+
+// ============================================================================
+// FUNCIÓN MAIN
+// ============================================================================
+
+/**
+ * Banner de inicio (solo con -v)
+ */
+void print_banner() {
+    GSEA_VERBOSE("\n");
+    GSEA_VERBOSE("╔════════════════════════════════════════════════════════╗\n");
+    GSEA_VERBOSE("║                                                        ║\n");
+    GSEA_VERBOSE("║  GSEA - Gestión Segura y Eficiente de Archivos       ║\n");
+    GSEA_VERBOSE("║  Universidad EAFIT - Sistemas Operativos             ║\n");
+    GSEA_VERBOSE("║                                                        ║\n");
+    GSEA_VERBOSE("║  Usando syscalls POSIX directas:                      ║\n");
+    GSEA_VERBOSE("║    • open() / read() / write() / close()              ║\n");
+    GSEA_VERBOSE("║    • opendir() / readdir() / closedir()               ║\n");
+    GSEA_VERBOSE("║    • stat() / fstat()                                 ║\n");
+    GSEA_VERBOSE("║                                                        ║\n");
+    GSEA_VERBOSE("╚════════════════════════════════════════════════════════╝\n");
+}
+
+/**
+ * Escribir el reporte de --stats (en stdout o en --stats-out)
+ * 
+ * Se llama cuando todos los hilos ya terminaron.
+ */
+bool write_stats_report(const Config& config, const RunStats& stats) {
+    std::string operations = std::string(config.compress ? "c" : "") + (config.decompress ? "d" : "") +
+                             (config.encrypt ? "e" : "") + (config.decrypt ? "u" : "");
+    std::string report = stats.to_json(operations, config.threads > 0 ? config.threads : 1,
+                                        CRC32C::implementation(), MemoryBudget::peak_rss_bytes());
+    
+    if (!config.stats_path.empty()) {
+        return write_file_syscall(config.stats_path, (const unsigned char*)report.data(), report.size());
+    }
+    Log::global().flush();
+    return write_full(STDOUT_FILENO, (const unsigned char*)report.data(), report.size());
+}
+
+int main(int argc, char* argv[]) {
+    // Parsear argumentos
+    Config config = parse_arguments(argc, argv);
+    
+    if (!config.is_valid) {
+        return 1;
+    }
+    
+    Log::global().set_level(config.verbosity);
+    print_banner();
+    
+    // Límites de segundo plano: antes de crear hilos (los heredan)
+    Throttle::global().configure(config.io_limit, config.cpu_limit);
+    if (config.idle) {
+        std::string error = Throttle::set_idle_priority();
+        if (!error.empty()) {
+            GSEA_INFO("  [Advertencia] --idle: " << error << "\n");
+        }
+    }
+    
+    // Modo daemon: atender peticiones hasta recibir SIGINT/SIGTERM
+    if (!config.daemon_socket.empty()) {
+        int workers = config.threads > 0 ? config.threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        GseaDaemon daemon(config.daemon_socket, workers);
+        if (!daemon.start()) {
+            return 1;
+        }
+        return daemon.run();
+    }
+    
+    // Verificar que la entrada existe
     bool input_is_directory = is_directory(config.input_path);
     bool input_exists = file_exists(config.input_path) || input_is_directory;
     
     if (!input_exists) {
-        std::cerr << "✗ Error: La ruta de entrada no existe: " << config.input_path << "\n";
+        GSEA_ERROR("✗ Error: La ruta de entrada no existe: " << config.input_path << "\n");
+        return 1;
+    }
+    
+    if (input_is_directory && !config.base_path.empty()) {
+        GSEA_ERROR("✗ Error: --base compara un archivo con su versión anterior: -i debe ser un archivo\n");
         return 1;
     }
     
+    // Un .huff de un solo flujo se descomprime con -j hilos (o uno por CPU);
+    // con -j en un directorio los hilos ya se reparten entre los archivos
+    config.decode_threads = config.threads > 0 ? config.threads
+                                               : std::max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+    if (input_is_directory && config.threads > 1) {
+        config.decode_threads = 1;
+    }
+    
+    // Modo verificación: solo lectura, sin configuración de salida
+    if (config.verify) {
+        return run_verify(config, input_is_directory) ? 0 : 1;
+    }
+    
+    // Mostrar configuración
+    print_config(config);
+    
+    // Cargar el manifiesto del modo incremental (si se pidió)
+    Manifest* manifest = nullptr;
+    if (!config.manifest_path.empty()) {
+        manifest = new Manifest(config.manifest_path, config_signature(config));
+        if (!manifest->load()) {
+            delete manifest;
+            return 1;
+        }
+    }
+    
+    // Abrir el diario (si se pidió): la firma incluye -i y -o, así que
+    // --resume con otro trabajo empieza de cero
+    Journal* journal = nullptr;
+    if (!config.journal_path.empty()) {
+        journal = new Journal(config.journal_path,
+                              config_signature(config) + ";in=" + config.input_path +
+                              ";out=" + config.output_path,
+                              config.checkpoint_bytes);
+        if (!journal->open_journal(config.resume)) {
+            delete journal;
+            delete manifest;
+            return 1;
+        }
+    }
+    
+    // Abrir el almacén de chunks del modo dedup (si se pidió)
+    DedupContext* dedup = nullptr;
+    XORCipher* dedup_cipher = nullptr;
+    struct timespec dedup_start;
+    if (!config.dedup_store.empty()) {
+        if (config.encrypt || config.decrypt) {
+            dedup_cipher = new XORCipher(config.key);
+        }
+        dedup = new DedupContext();
+        dedup->store = new ChunkStore(config.dedup_store,
+                                      config.compress || config.decompress,
+                                      config.encrypt || config.decrypt, dedup_cipher);
+        if (!dedup->store->open_store()) {
+            delete dedup->store;
+            delete dedup;
+            delete dedup_cipher;
+            delete journal;
+            delete manifest;
+            return 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &dedup_start);
+    }
+    
+    // Presupuesto de memoria (si se pidió)
+    MemoryBudget* budget = nullptr;
+    if (config.max_memory > 0) {
+        budget = new MemoryBudget(config.max_memory);
+    }
+    
+    // Pool de buffers: con presupuesto, los buffers libres guardados para
+    // reutilizar no pueden ocupar más de un cuarto del límite
+    BufferPool::global().set_huge_pages(config.huge_pages);
+    if (config.max_memory > 0) {
+        BufferPool::global().set_cache_limit(config.max_memory / 4);
+    }
+    
+    // Métricas por etapa (si se pidieron)
+    RunStats* run_stats = nullptr;
+    if (!config.stats_format.empty()) {
+        run_stats = new RunStats();
+    }
+    
+    RunContext ctx;
+    ctx.manifest = manifest;
+    ctx.dedup = dedup;
+    ctx.budget = budget;
+    ctx.stats = run_stats;
+    ctx.journal = journal;
+    
     bool success = false;
     
     if (input_is_directory) {
         // CASO 1: Procesar directorio completo
-        std::cout << "→ Tipo de entrada: DIRECTORIO\n\n";
+        GSEA_VERBOSE("→ Tipo de entrada: DIRECTORIO\n\n");
         std::vector<std::string> files = list_files(config.input_path);
         
         if (files.empty()) {
-            std::cerr << "✗ Error: No hay archivos en el directorio\n";
+            GSEA_ERROR("✗ Error: No hay archivos en el directorio\n");
             return 1;
         }
         
-        std::cout << "\n→ Total de archivos a procesar: " << files.size() << "\n";
+        GSEA_VERBOSE("\n→ Total de archivos a procesar: " << files.size() << "\n");
+        
+        // Hilos de trabajo: el almacén de dedup es secuencial, así que ese
+        // modo usa siempre un solo hilo
+        int workers = config.threads > 0 ? config.threads : 1;
+        if (dedup != nullptr && workers > 1) {
+            GSEA_INFO("→ --dedup procesa los archivos de a uno: se ignora -j\n");
+            workers = 1;
+        }
+        if ((size_t)workers > files.size()) {
+            workers = files.size();
+        }
         
-        int processed = 0;
-        int failed = 0;
+        DirectoryJob job;
+        job.files = &files;
+        job.config = &config;
+        job.ctx = &ctx;
+        pthread_mutex_init(&job.mutex, nullptr);
         
-        for (const std::string& input_file : files) {
-            // Extraer nombre del archivo
-            size_t last_slash = input_file.find_last_of('/');
-            std::string filename = (last_slash != std::string::npos) 
-                                   ? input_file.substr(last_slash + 1) 
-                                   : input_file;
-            
-            // Construir ruta de salida
-            std::string output_file = config.output_path + "/" + filename;
-            
-            // Agregar extensión apropiada
-            if (config.compress && config.encrypt) {
-                output_file += ".gsea";
-            } else if (config.compress) {
-                output_file += ".huff";
-            } else if (config.encrypt) {
-                output_file += ".enc";
+        if (workers == 1) {
+            directory_worker(&job);
+        } else {
+            GSEA_VERBOSE("→ Procesando con " << workers << " hilos\n");
+            std::vector<pthread_t> threads(workers);
+            int started = 0;
+            for (int i = 0; i < workers; i++) {
+                if (pthread_create(&threads[i], nullptr, directory_worker, &job) != 0) {
+                    GSEA_ERROR("  [Advertencia] pthread_create() falló, se continúa con "
+                               << started << " hilos\n");
+                    break;
+                }
+                started++;
             }
-            
-            // Procesar archivo
-            if (process_file(input_file, output_file, config)) {
-                processed++;
-            } else {
-                failed++;
+            if (started == 0) {
+                directory_worker(&job);
+            }
+            for (int i = 0; i < started; i++) {
+                pthread_join(threads[i], nullptr);
             }
         }
+        pthread_mutex_destroy(&job.mutex);
+        
+        int processed = job.processed;
+        int skipped = job.skipped;
+        int failed = job.failed;
         
         // Resumen
-        std::cout << "\n╔════════════════════════════════════════════════════════╗\n";
-        std::cout << "║  RESUMEN                                               ║\n";
-        std::cout << "╚════════════════════════════════════════════════════════╝\n";
-        std::cout << "  Archivos procesados: " << processed << "\n";
-        std::cout << "  Archivos fallidos:   " << failed << "\n\n";
+        GSEA_INFO("\n╔════════════════════════════════════════════════════════╗\n");
+        GSEA_INFO("║  RESUMEN                                               ║\n");
+        GSEA_INFO("╚════════════════════════════════════════════════════════╝\n");
+        GSEA_INFO("  Archivos procesados: " << processed << "\n");
+        if (manifest != nullptr || journal != nullptr) {
+            GSEA_INFO("  Archivos sin cambios: " << skipped << "\n");
+        }
+        GSEA_INFO("  Archivos fallidos:   " << failed << "\n\n");
         
-        success = (processed > 0);
+        success = (processed + skipped > 0);
         
     } else {
         // CASO 2: Procesar archivo individual
-        std::cout << "→ Tipo de entrada: ARCHIVO INDIVIDUAL\n";
-        success = process_file(config.input_path, config.output_path, config);
+        GSEA_VERBOSE("→ Tipo de entrada: ARCHIVO INDIVIDUAL\n");
+        success = process_file_measured(config.input_path, config.output_path, config, ctx) >= 0;
     }
     
+    // Reporte del modo dedup: ratio y throughput
+    if (dedup != nullptr) {
+        struct timespec dedup_end;
+        clock_gettime(CLOCK_MONOTONIC, &dedup_end);
+        double seconds = (dedup_end.tv_sec - dedup_start.tv_sec) +
+                         (dedup_end.tv_nsec - dedup_start.tv_nsec) / 1e9;
+        const DedupStats& st = dedup->stats;
+        
+        GSEA_INFO("\n┌───────────────────────────────────────────────────────┐\n");
+        GSEA_INFO("│ DEDUP\n");
+        GSEA_INFO("└───────────────────────────────────────────────────────┘\n");
+        GSEA_INFO("  Archivos:          " << st.files << "\n");
+        GSEA_INFO("  Bytes lógicos:     " << st.logical_bytes << "\n");
+        GSEA_INFO("  Chunks:            " << st.chunks << " (" << st.new_chunks << " nuevos)\n");
+        if (config.compress || config.encrypt) {
+            GSEA_INFO("  Bytes únicos:      " << st.new_raw_bytes << "\n");
+            GSEA_INFO("  Bytes almacenados: " << st.stored_bytes << "\n");
+            if (st.new_raw_bytes > 0) {
+                GSEA_INFO("  Ratio dedup:       " << ((double)st.logical_bytes / st.new_raw_bytes) << "x\n");
+            } else if (st.logical_bytes > 0) {
+                GSEA_INFO("  Ratio dedup:       ∞ (todo el contenido ya estaba en el almacén)\n");
+            }
+        }
+        if (seconds > 0) {
+            GSEA_INFO("  Throughput:        " << (st.logical_bytes / 1e6 / seconds) << " MB/s\n");
+        }
+        GSEA_VERBOSE("\n");
+        
+        delete dedup->store;
+        delete dedup;
+        delete dedup_cipher;
+    }
+    
+    // Reporte de memoria: pico de RSS real y del presupuesto reservado
+    GSEA_VERBOSE("  Pico de memoria (RSS): " << (MemoryBudget::peak_rss_bytes() >> 20) << " MB");
+    if (budget != nullptr) {
+        GSEA_VERBOSE(" (reservado: " << (budget->peak_reserved() >> 20) << " de "
+                     << (budget->get_limit() >> 20) << " MB)");
+        delete budget;
+    }
+    GSEA_VERBOSE("\n");
+    GSEA_VERBOSE("  Buffers del pool: " << BufferPool::global().fresh_allocations()
+                 << " reservados, " << BufferPool::global().reuses() << " reutilizados\n");
+    if (Throttle::global().limited()) {
+        GSEA_VERBOSE("  En pausa por --io-limit/--cpu-limit: " << Throttle::global().slept_seconds() << " s\n");
+    }
+    GSEA_VERBOSE("\n");
+    
+    // Guardar el manifiesto aunque algún archivo haya fallado:
+    // los que sí se procesaron no deben repetirse en la próxima ejecución
+    if (manifest != nullptr) {
+        if (!manifest->save()) {
+            success = false;
+        }
+        delete manifest;
+    }
+    delete journal;
+    
     // Mensaje final
     if (success) {
-        std::cout << "╔════════════════════════════════════════════════════════╗\n";
-        std::cout << "║  ✓ PROCESO COMPLETADO EXITOSAMENTE                    ║\n";
-        std::cout << "╚════════════════════════════════════════════════════════╝\n\n";
-        return 0;
+        GSEA_INFO("╔════════════════════════════════════════════════════════╗\n");
+        GSEA_INFO("║  ✓ PROCESO COMPLETADO EXITOSAMENTE                    ║\n");
+        GSEA_INFO("╚════════════════════════════════════════════════════════╝\n\n");
     } else {
-        std::cout << "╔════════════════════════════════════════════════════════╗\n";
-        std::cout << "║  ✗ PROCESO TERMINADO CON ERRORES                      ║\n";
-        std::cout << "╚════════════════════════════════════════════════════════╝\n\n";
-        return 1;
+        GSEA_INFO("╔════════════════════════════════════════════════════════╗\n");
+        GSEA_INFO("║  ✗ PROCESO TERMINADO CON ERRORES                      ║\n");
+        GSEA_INFO("╚════════════════════════════════════════════════════════╝\n\n");
     }
+    
+    // Reporte de métricas: después de todos los mensajes, para que con -q
+    // la salida estándar sea solo el JSON
+    if (run_stats != nullptr) {
+        if (!write_stats_report(config, *run_stats)) {
+            success = false;
+        }
+        delete run_stats;
+    }
+    
+    return success ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,391 @@
+#ifndef GSEA_MANIFEST_H
+#define GSEA_MANIFEST_H
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "hash.h"
+#include "log.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+// Entrada del manifiesto: lo que sabíamos de un archivo la última vez
+// que se procesó con éxito
+struct ManifestEntry {
+    uint64_t size = 0;           // st_size de la entrada
+    int64_t mtime_sec = 0;       // st_mtim.tv_sec
+    long mtime_nsec = 0;         // st_mtim.tv_nsec
+    uint64_t inode = 0;          // st_ino
+    bool has_hash = false;       // ¿Se calculó el hash de contenido?
+    uint64_t hash = 0;           // ContentHash del contenido
+    std::string output;          // Ruta de salida generada
+    uint64_t output_size = 0;    // st_size de la salida al terminar
+    int64_t output_mtime_sec = 0;
+    long output_mtime_nsec = 0;
+};
+
+// Manifiesto persistente para el modo incremental (--incremental)
+//
+// Formato de texto, una línea por archivo (campos separados por TAB):
+//   GSEA-MANIFEST 1 <firma>
+//   <entrada> <size> <mtime_s> <mtime_ns> <ino> <hash|-> <salida> <out_size> <out_mtime_s> <out_mtime_ns>
+//
+// La firma resume las operaciones, algoritmos y clave usados: si cambia,
+// todas las entradas se consideran obsoletas.
+//
+// is_current() y record() pueden llamarse desde varios hilos (-j).
+class Manifest {
+private:
+    std::string path;                               // Ruta del manifiesto
+    std::string signature;                          // Firma de la configuración
+    std::map<std::string, ManifestEntry> entries;   // entrada -> metadata
+    pthread_mutex_t mutex;                          // Protege entries
+
+    // Escapar TAB, salto de línea y '%' para que las rutas no rompan el formato
+    static std::string escape(const std::string& s) {
+        std::string out;
+        for (char c : s) {
+            if (c == '%') out += "%25";
+            else if (c == '\t') out += "%09";
+            else if (c == '\n') out += "%0A";
+            else out += c;
+        }
+        return out;
+    }
+
+    static std::string unescape(const std::string& s) {
+        std::string out;
+        for (size_t i = 0; i < s.size(); i++) {
+            if (s[i] == '%' && i + 2 < s.size()) {
+                out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+                i += 2;
+            } else {
+                out += s[i];
+            }
+        }
+        return out;
+    }
+
+    static std::vector<std::string> split_tabs(const std::string& line) {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        while (true) {
+            size_t tab = line.find('\t', start);
+            if (tab == std::string::npos) {
+                fields.push_back(line.substr(start));
+                break;
+            }
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        return fields;
+    }
+
+    // Escribir todo el buffer (write() puede escribir menos de lo pedido)
+    static bool write_all(int fd, const std::string& data) {
+        size_t done = 0;
+        while (done < data.size()) {
+            ssize_t n = write(fd, data.data() + done, data.size() - done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+
+public:
+    Manifest(const std::string& manifest_path, const std::string& config_signature)
+        : path(manifest_path), signature(config_signature) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~Manifest() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    // Cargar el manifiesto del disco
+    // Si no existe o la firma no coincide, se empieza vacío (todo se procesa);
+    // si el archivo no es un manifiesto, false (no se pisa)
+    bool load() {
+        entries.clear();
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1) {
+            if (errno != ENOENT) {
+                GSEA_ERROR("  [Error] open() del manifiesto falló: " << strerror(errno) << "\n");
+                return false;
+            }
+            GSEA_VERBOSE("  [Manifiesto] No existe todavía, se creará: " << path << "\n");
+            return true;
+        }
+
+        std::string content;
+        char buffer[65536];
+        ssize_t n;
+        while ((n = read(fd, buffer, sizeof(buffer))) != 0) {
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                GSEA_ERROR("  [Error] read() del manifiesto falló: " << strerror(errno) << "\n");
+                close(fd);
+                return false;
+            }
+            content.append(buffer, n);
+        }
+        close(fd);
+
+        size_t line_start = 0;
+        bool header_ok = false;
+        while (line_start < content.size()) {
+            size_t line_end = content.find('\n', line_start);
+            if (line_end == std::string::npos) line_end = content.size();
+            std::string line = content.substr(line_start, line_end - line_start);
+            line_start = line_end + 1;
+
+            std::vector<std::string> fields = split_tabs(line);
+
+            if (!header_ok) {
+                // Primera línea: versión y firma
+                // No es un manifiesto: save() lo pisaría (¿ruta equivocada?)
+                if (fields.size() != 2 || fields[0] != "GSEA-MANIFEST 1") {
+                    GSEA_ERROR("  [Error] " << path << " no es un manifiesto de GSEA: no se sobrescribe\n");
+                    return false;
+                }
+                if (unescape(fields[1]) != signature) {
+                    GSEA_VERBOSE("  [Manifiesto] La configuración cambió: se reprocesará todo\n");
+                    return true;
+                }
+                header_ok = true;
+                continue;
+            }
+
+            if (fields.size() != 10) continue;  // Línea dañada: se ignora
+
+            ManifestEntry entry;
+            entry.size = strtoull(fields[1].c_str(), nullptr, 10);
+            entry.mtime_sec = strtoll(fields[2].c_str(), nullptr, 10);
+            entry.mtime_nsec = strtol(fields[3].c_str(), nullptr, 10);
+            entry.inode = strtoull(fields[4].c_str(), nullptr, 10);
+            if (fields[5] != "-") {
+                entry.has_hash = true;
+                entry.hash = strtoull(fields[5].c_str(), nullptr, 16);
+            }
+            entry.output = unescape(fields[6]);
+            entry.output_size = strtoull(fields[7].c_str(), nullptr, 10);
+            entry.output_mtime_sec = strtoll(fields[8].c_str(), nullptr, 10);
+            entry.output_mtime_nsec = strtol(fields[9].c_str(), nullptr, 10);
+            entries[unescape(fields[0])] = entry;
+        }
+
+        GSEA_VERBOSE("  [Manifiesto] " << entries.size() << " entradas cargadas de " << path << "\n");
+        return true;
+    }
+
+    // ¿La salida de este archivo sigue vigente?
+    //
+    // Se considera vigente si la metadata de la entrada (tamaño, mtime, inodo)
+    // no cambió y la salida existe tal como la dejamos. Si use_hash está activo
+    // y solo cambió mtime/inodo (p. ej. un "touch" o una copia), se compara el
+    // hash de contenido antes de reprocesar.
+    bool is_current(const std::string& input, const std::string& output,
+                    const struct stat& st, bool use_hash) {
+        pthread_mutex_lock(&mutex);
+        std::map<std::string, ManifestEntry>::iterator it = entries.find(input);
+        if (it == entries.end()) {
+            pthread_mutex_unlock(&mutex);
+            return false;
+        }
+        ManifestEntry entry = it->second;  // Copia: el resto se hace sin el lock
+        pthread_mutex_unlock(&mutex);
+
+        if (entry.output != output || entry.size != (uint64_t)st.st_size) {
+            return false;
+        }
+
+        // La salida debe seguir existiendo y no haber sido modificada
+        struct stat out_st;
+        if (stat(output.c_str(), &out_st) == -1 ||
+            (uint64_t)out_st.st_size != entry.output_size ||
+            out_st.st_mtim.tv_sec != entry.output_mtime_sec ||
+            out_st.st_mtim.tv_nsec != entry.output_mtime_nsec) {
+            return false;
+        }
+
+        if (entry.mtime_sec == st.st_mtim.tv_sec &&
+            entry.mtime_nsec == st.st_mtim.tv_nsec &&
+            entry.inode == (uint64_t)st.st_ino) {
+            return true;
+        }
+
+        // La metadata cambió: solo el hash puede salvar el archivo
+        if (!use_hash || !entry.has_hash) return false;
+
+        uint64_t hash;
+        if (!hash_file(input, hash) || hash != entry.hash) return false;
+
+        // Mismo contenido: actualizar la metadata para no volver a hashear
+        entry.mtime_sec = st.st_mtim.tv_sec;
+        entry.mtime_nsec = st.st_mtim.tv_nsec;
+        entry.inode = st.st_ino;
+        pthread_mutex_lock(&mutex);
+        entries[input] = entry;
+        pthread_mutex_unlock(&mutex);
+        return true;
+    }
+
+    // Registrar un archivo procesado con éxito
+    void record(const std::string& input, const std::string& output,
+                const struct stat& st, bool has_hash, uint64_t hash) {
+        ManifestEntry entry;
+        entry.size = st.st_size;
+        entry.mtime_sec = st.st_mtim.tv_sec;
+        entry.mtime_nsec = st.st_mtim.tv_nsec;
+        entry.inode = st.st_ino;
+        entry.has_hash = has_hash;
+        entry.hash = hash;
+        entry.output = output;
+
+        struct stat out_st;
+        if (stat(output.c_str(), &out_st) == 0) {
+            entry.output_size = out_st.st_size;
+            entry.output_mtime_sec = out_st.st_mtim.tv_sec;
+            entry.output_mtime_nsec = out_st.st_mtim.tv_nsec;
+        }
+        pthread_mutex_lock(&mutex);
+        entries[input] = entry;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // Guardar el manifiesto de forma ATÓMICA
+    //
+    // Se escribe un archivo temporal, se fuerza a disco con fsync() y se
+    // renombra sobre el original con rename(), que es atómico en POSIX.
+    // Un corte a mitad de camino deja el manifiesto anterior intacto.
+    bool save() {
+        std::string content = "GSEA-MANIFEST 1\t" + escape(signature) + "\n";
+        char number[32];
+
+        for (const auto& pair : entries) {
+            // Olvidar archivos que ya no existen
+            struct stat st;
+            if (stat(pair.first.c_str(), &st) == -1) continue;
+
+            const ManifestEntry& e = pair.second;
+            content += escape(pair.first);
+            snprintf(number, sizeof(number), "\t%llu", (unsigned long long)e.size);
+            content += number;
+            snprintf(number, sizeof(number), "\t%lld", (long long)e.mtime_sec);
+            content += number;
+            snprintf(number, sizeof(number), "\t%ld", e.mtime_nsec);
+            content += number;
+            snprintf(number, sizeof(number), "\t%llu", (unsigned long long)e.inode);
+            content += number;
+            if (e.has_hash) {
+                snprintf(number, sizeof(number), "\t%016llx", (unsigned long long)e.hash);
+                content += number;
+            } else {
+                content += "\t-";
+            }
+            content += "\t" + escape(e.output);
+            snprintf(number, sizeof(number), "\t%llu", (unsigned long long)e.output_size);
+            content += number;
+            snprintf(number, sizeof(number), "\t%lld", (long long)e.output_mtime_sec);
+            content += number;
+            snprintf(number, sizeof(number), "\t%ld\n", e.output_mtime_nsec);
+            content += number;
+        }
+
+        std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd == -1) {
+            GSEA_ERROR("  [Error] open() del manifiesto temporal falló: " << strerror(errno) << "\n");
+            return false;
+        }
+
+        if (!write_all(fd, content) || fsync(fd) == -1) {
+            GSEA_ERROR("  [Error] No se pudo escribir el manifiesto: " << strerror(errno) << "\n");
+            close(fd);
+            unlink(tmp_path.c_str());
+            return false;
+        }
+        close(fd);
+
+        if (rename(tmp_path.c_str(), path.c_str()) == -1) {
+            GSEA_ERROR("  [Error] rename() del manifiesto falló: " << strerror(errno) << "\n");
+            unlink(tmp_path.c_str());
+            return false;
+        }
+
+        // fsync() del directorio para que el rename() también sea durable
+        size_t last_slash = path.find_last_of('/');
+        std::string dir = (last_slash != std::string::npos) ? path.substr(0, last_slash + 1) : ".";
+        int dir_fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dir_fd != -1) {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+
+        GSEA_VERBOSE("  [Manifiesto] Guardado atómicamente: " << path
+                     << " (" << entries.size() << " entradas)\n");
+        return true;
+    }
+
+    // Calcular el hash de contenido (ContentHash) de un archivo leyéndolo
+    // por bloques. Los huecos se saltan con SEEK_DATA/SEEK_HOLE sin leerlos;
+    // si el sistema de archivos no los soporta, todo cuenta como datos
+    static bool hash_file(const std::string& filepath, uint64_t& hash) {
+        int fd = open(filepath.c_str(), O_RDONLY);
+        if (fd == -1) return false;
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            close(fd);
+            return false;
+        }
+
+        ContentHash hasher;
+        std::vector<unsigned char> buffer(1 << 20);
+        uint64_t size = st.st_size;
+        uint64_t offset = 0;
+        while (offset < size) {
+            off_t data = lseek(fd, offset, SEEK_DATA);
+            if (data == -1) data = errno == ENXIO ? size : offset;
+            if ((uint64_t)data > offset) {
+                hasher.skip_zeros(std::min<uint64_t>(data, size) - offset);
+                offset = data;
+                continue;
+            }
+            off_t hole = lseek(fd, offset, SEEK_HOLE);
+            uint64_t data_end = hole == -1 || (uint64_t)hole <= offset ? size : std::min<uint64_t>(hole, size);
+            while (offset < data_end) {
+                ssize_t n = pread(fd, buffer.data(), std::min<uint64_t>(buffer.size(), data_end - offset), offset);
+                if (n == -1) {
+                    if (errno == EINTR) continue;
+                    close(fd);
+                    return false;
+                }
+                if (n == 0) {
+                    size = offset;     // El archivo se achicó mientras se leía
+                    break;
+                }
+                hasher.update(buffer.data(), n);
+                offset += n;
+            }
+        }
+        close(fd);
+        hash = hasher.digest();
+        return true;
+    }
+};
+
+#endif // GSEA_MANIFEST_H
@@ -0,0 +1,117 @@
+#ifndef GSEA_MEMORY_BUDGET_H
+#define GSEA_MEMORY_BUDGET_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include <pthread.h>
+#include <sys/resource.h>
+
+// Contador central de memoria para trabajos concurrentes (--max-memory)
+//
+// Antes de cargar un archivo, cada hilo pide a este contador la memoria
+// que va a necesitar (acquire) y la devuelve al terminar (release). Si
+// admitir el archivo superaría el presupuesto, el hilo se BLOQUEA hasta
+// que otro libere memoria (backpressure). Un pedido mayor que el
+// presupuesto completo nunca cabría: quien llama debe usar el camino por
+// bloques (streaming), cuya memoria es fija.
+class MemoryBudget {
+private:
+    uint64_t limit;        // Presupuesto total (0 = sin límite)
+    uint64_t in_use;       // Bytes reservados en este momento
+    uint64_t peak;         // Máximo reservado a la vez
+    pthread_mutex_t mutex;
+    pthread_cond_t released;
+
+public:
+    explicit MemoryBudget(uint64_t limit_bytes)
+        : limit(limit_bytes), in_use(0), peak(0) {
+        pthread_mutex_init(&mutex, nullptr);
+        pthread_cond_init(&released, nullptr);
+    }
+
+    ~MemoryBudget() {
+        pthread_cond_destroy(&released);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    bool unlimited() const { return limit == 0; }
+    uint64_t get_limit() const { return limit; }
+
+    // ¿Un pedido de este tamaño podría llegar a admitirse?
+    bool fits(uint64_t bytes) const {
+        return limit == 0 || bytes <= limit;
+    }
+
+    // Reservar memoria, esperando si hace falta
+    // Si nadie tiene memoria reservada, el pedido se admite siempre (aunque
+    // supere el límite): así un pedido grande no puede quedar bloqueado para siempre
+    void acquire(uint64_t bytes) {
+        pthread_mutex_lock(&mutex);
+        while (limit != 0 && in_use > 0 && in_use + bytes > limit) {
+            pthread_cond_wait(&released, &mutex);
+        }
+        in_use += bytes;
+        if (in_use > peak) peak = in_use;
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // Devolver memoria y despertar a los hilos que esperan
+    void release(uint64_t bytes) {
+        pthread_mutex_lock(&mutex);
+        in_use -= bytes;
+        pthread_cond_broadcast(&released);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    uint64_t peak_reserved() {
+        pthread_mutex_lock(&mutex);
+        uint64_t value = peak;
+        pthread_mutex_unlock(&mutex);
+        return value;
+    }
+
+    // Pico de memoria residente (RSS) del proceso, según el kernel
+    static uint64_t peak_rss_bytes() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == -1) return 0;
+        return (uint64_t)usage.ru_maxrss * 1024;  // Linux reporta KB
+    }
+
+    // Interpretar tamaños como "512M", "2G", "64K" o bytes
+    static bool parse_size(const std::string& text, uint64_t& bytes) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        unsigned long long value = strtoull(text.c_str(), &end, 10);
+        if (end == text.c_str()) return false;
+
+        std::string suffix(end);
+        if (suffix.empty() || suffix == "B") bytes = value;
+        else if (suffix == "K" || suffix == "KB") bytes = value << 10;
+        else if (suffix == "M" || suffix == "MB") bytes = value << 20;
+        else if (suffix == "G" || suffix == "GB") bytes = value << 30;
+        else return false;
+        return true;
+    }
+};
+
+// Reserva con alcance: devuelve la memoria al salir del bloque
+class BudgetReservation {
+private:
+    MemoryBudget* budget;
+    uint64_t bytes;
+
+public:
+    BudgetReservation(MemoryBudget* b, uint64_t n) : budget(b), bytes(n) {
+        if (budget != nullptr) budget->acquire(bytes);
+    }
+    ~BudgetReservation() {
+        if (budget != nullptr) budget->release(bytes);
+    }
+
+    BudgetReservation(const BudgetReservation&) = delete;
+    BudgetReservation& operator=(const BudgetReservation&) = delete;
+};
+
+#endif // GSEA_MEMORY_BUDGET_H
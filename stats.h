@@ -0,0 +1,267 @@
+#ifndef GSEA_STATS_H
+#define GSEA_STATS_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+
+#include <pthread.h>
+#include <time.h>
+
+// Etapas de process_file() que se miden por separado
+enum StatStage {
+    STAGE_READ = 0,
+    STAGE_COMPRESS,
+    STAGE_ENCRYPT,
+    STAGE_DECRYPT,
+    STAGE_DECOMPRESS,
+    STAGE_CHECKSUM,     // CRC32C de los bloques
+    STAGE_WRITE,
+    STAGE_COUNT
+};
+
+static const char* const STAGE_NAMES[STAGE_COUNT] = {
+    "read", "compress", "encrypt", "decrypt", "decompress", "checksum", "write"
+};
+
+// Syscalls hechas por este hilo: las de E/S (open, fstat, read, write, close...)
+// y la lectura del reloj de CPU del hilo. Es un contador por hilo: no necesita lock y cuesta una suma
+inline uint64_t& thread_syscalls() {
+    static thread_local uint64_t count = 0;
+    return count;
+}
+
+inline void count_syscall(uint64_t n = 1) {
+    thread_syscalls() += n;
+}
+
+// Instante de reloj: tiempo real (monotónico) y CPU del hilo
+// CLOCK_MONOTONIC va por vDSO (decenas de ns), pero CLOCK_THREAD_CPUTIME_ID
+// es una syscall real en Linux: se cuenta, y se mide por bloque/etapa
+struct StageClock {
+    uint64_t wall_ns;
+    uint64_t cpu_ns;
+
+    static uint64_t read_clock(clockid_t id) {
+        struct timespec ts;
+        clock_gettime(id, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    StageClock() : wall_ns(0), cpu_ns(0) {}
+
+    static StageClock now() {
+        StageClock clock;
+        clock.wall_ns = read_clock(CLOCK_MONOTONIC);
+        clock.cpu_ns = read_clock(CLOCK_THREAD_CPUTIME_ID);
+        count_syscall();
+        return clock;
+    }
+};
+
+// Tiempo y bytes acumulados de una etapa
+struct StageStats {
+    uint64_t wall_ns = 0;
+    uint64_t cpu_ns = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t calls = 0;
+
+    void add(const StageStats& other) {
+        wall_ns += other.wall_ns;
+        cpu_ns += other.cpu_ns;
+        bytes_in += other.bytes_in;
+        bytes_out += other.bytes_out;
+        calls += other.calls;
+    }
+};
+
+// Métricas de un archivo
+struct FileStats {
+    std::string input;
+    std::string output;
+    bool ok = false;
+    bool streaming = false;          // Procesado por bloques (--max-memory)
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t wall_ns = 0;
+    uint64_t cpu_ns = 0;
+    uint64_t syscalls = 0;
+    uint64_t peak_buffer_bytes = 0;  // Buffers vivos a la vez en el peor momento
+    StageStats stages[STAGE_COUNT];
+
+    // Sumar una etapa medida desde start hasta ahora
+    void record(int stage, const StageClock& start, uint64_t in, uint64_t out) {
+        StageClock now = StageClock::now();
+        stages[stage].wall_ns += now.wall_ns - start.wall_ns;
+        stages[stage].cpu_ns += now.cpu_ns - start.cpu_ns;
+        stages[stage].bytes_in += in;
+        stages[stage].bytes_out += out;
+        stages[stage].calls++;
+    }
+
+    void note_buffers(uint64_t bytes) {
+        if (bytes > peak_buffer_bytes) peak_buffer_bytes = bytes;
+    }
+};
+
+// Medir una etapa solo si se piden métricas (sin FileStats no lee el reloj)
+class StageTimer {
+private:
+    FileStats* stats;
+    int stage;
+    StageClock start;
+
+public:
+    StageTimer(FileStats* file_stats, int stage_id) : stats(file_stats), stage(stage_id) {
+        if (stats != nullptr) start = StageClock::now();
+    }
+
+    void stop(uint64_t in, uint64_t out) {
+        if (stats != nullptr) {
+            stats->record(stage, start, in, out);
+            stats = nullptr;
+        }
+    }
+};
+
+// Métricas de toda la ejecución (--stats), compartidas por los hilos
+class RunStats {
+private:
+    pthread_mutex_t mutex;
+    std::vector<FileStats> files;
+    StageClock start;
+
+    static std::string number(double value) {
+        char text[32];
+        snprintf(text, sizeof(text), "%.3f", value);
+        return text;
+    }
+
+    static double mb_per_s(uint64_t bytes, uint64_t ns) {
+        return ns > 0 ? (bytes / 1048576.0) / (ns / 1e9) : 0.0;
+    }
+
+    static double ratio(uint64_t in, uint64_t out) {
+        return in > 0 ? (double)out / in : 0.0;
+    }
+
+    static std::string stages_json(const StageStats* stages, const std::string& indent) {
+        std::string out = "{";
+        bool first = true;
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            if (stages[s].calls == 0) continue;
+            const StageStats& st = stages[s];
+            out += first ? "\n" : ",\n";
+            first = false;
+            out += indent + "  \"" + STAGE_NAMES[s] + "\": {" +
+                   "\"wall_ms\": " + number(st.wall_ns / 1e6) +
+                   ", \"cpu_ms\": " + number(st.cpu_ns / 1e6) +
+                   ", \"bytes_in\": " + std::to_string(st.bytes_in) +
+                   ", \"bytes_out\": " + std::to_string(st.bytes_out) +
+                   ", \"mb_per_s\": " + number(mb_per_s(st.bytes_in, st.wall_ns)) +
+                   ", \"calls\": " + std::to_string(st.calls) + "}";
+        }
+        return out + (first ? "}" : "\n" + indent + "}");
+    }
+
+public:
+    // Texto como string de JSON (con comillas y escapes)
+    static std::string json_string(const std::string& text) {
+        std::string out = "\"";
+        for (unsigned char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (c < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+        return out + "\"";
+    }
+
+    RunStats() : start(StageClock::now()) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~RunStats() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    RunStats(const RunStats&) = delete;
+    RunStats& operator=(const RunStats&) = delete;
+
+    void add(const FileStats& file) {
+        pthread_mutex_lock(&mutex);
+        files.push_back(file);
+        pthread_mutex_unlock(&mutex);
+    }
+
+    // Reporte completo: un objeto por archivo y el total de la ejecución
+    // (llamar cuando los hilos ya terminaron)
+    std::string to_json(const std::string& operations, int threads, const char* crc_impl,
+                        uint64_t peak_rss) const {
+        StageClock end = StageClock::now();
+        uint64_t wall_ns = end.wall_ns - start.wall_ns;
+        uint64_t cpu_ns = StageClock::read_clock(CLOCK_PROCESS_CPUTIME_ID);
+
+        FileStats total;
+        int failed = 0;
+        std::string out = "{\n  \"version\": 1,\n";
+        out += "  \"operations\": " + json_string(operations) +
+               ", \"threads\": " + std::to_string(threads) +
+               ", \"crc32c\": " + json_string(crc_impl) + ",\n";
+        out += "  \"files\": [";
+
+        for (size_t i = 0; i < files.size(); i++) {
+            const FileStats& f = files[i];
+            out += i == 0 ? "\n" : ",\n";
+            out += "    {\"input\": " + json_string(f.input) +
+                   ", \"output\": " + json_string(f.output) +
+                   ", \"ok\": " + (f.ok ? "true" : "false") +
+                   ", \"mode\": " + (f.streaming ? "\"streaming\"" : "\"memory\"") + ",\n";
+            out += "     \"bytes_in\": " + std::to_string(f.bytes_in) +
+                   ", \"bytes_out\": " + std::to_string(f.bytes_out) +
+                   ", \"ratio\": " + number(ratio(f.bytes_in, f.bytes_out)) +
+                   ", \"wall_ms\": " + number(f.wall_ns / 1e6) +
+                   ", \"cpu_ms\": " + number(f.cpu_ns / 1e6) +
+                   ", \"mb_per_s\": " + number(mb_per_s(f.bytes_in, f.wall_ns)) +
+                   ", \"syscalls\": " + std::to_string(f.syscalls) +
+                   ", \"peak_buffer_bytes\": " + std::to_string(f.peak_buffer_bytes) + ",\n";
+            out += "     \"stages\": " + stages_json(f.stages, "     ") + "}";
+
+            if (!f.ok) failed++;
+            total.bytes_in += f.bytes_in;
+            total.bytes_out += f.bytes_out;
+            total.syscalls += f.syscalls;
+            total.note_buffers(f.peak_buffer_bytes);
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                total.stages[s].add(f.stages[s]);
+            }
+        }
+        out += files.empty() ? "],\n" : "\n  ],\n";
+
+        // El total usa el tiempo real de toda la ejecución (con -j los
+        // archivos se solapan) y la CPU de todo el proceso
+        out += "  \"total\": {\"files\": " + std::to_string(files.size()) +
+               ", \"failed\": " + std::to_string(failed) +
+               ", \"bytes_in\": " + std::to_string(total.bytes_in) +
+               ", \"bytes_out\": " + std::to_string(total.bytes_out) +
+               ", \"ratio\": " + number(ratio(total.bytes_in, total.bytes_out)) + ",\n";
+        out += "            \"wall_ms\": " + number(wall_ns / 1e6) +
+               ", \"cpu_ms\": " + number(cpu_ns / 1e6) +
+               ", \"mb_per_s\": " + number(mb_per_s(total.bytes_in, wall_ns)) +
+               ", \"syscalls\": " + std::to_string(total.syscalls) +
+               ", \"peak_buffer_bytes\": " + std::to_string(total.peak_buffer_bytes) +
+               ", \"peak_rss_bytes\": " + std::to_string(peak_rss) + ",\n";
+        out += "            \"stages\": " + stages_json(total.stages, "            ") + "}\n}\n";
+        return out;
+    }
+};
+
+#endif // GSEA_STATS_H
@@ -0,0 +1,174 @@
+#ifndef GSEA_THROTTLE_H
+#define GSEA_THROTTLE_H
+
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Límites de E/S y de CPU para correr en segundo plano (--io-limit,
+// --cpu-limit, --idle)
+//
+// Los dos límites son cubetas de fichas compartidas por todos los hilos:
+//   - E/S: cada read()/write() pide fichas por los bytes que va a mover. Las
+//     lecturas y escrituras grandes se parten en tramos (io_slice()) para
+//     que el disco no reciba ráfagas de cientos de MB
+//   - CPU: en cada pedido de E/S se descuenta la CPU que usó el proceso
+//     (todos sus hilos) desde la vez anterior; la cubeta se llena a razón
+//     de fraction segundos de CPU por segundo real
+// Si la cubeta queda en negativo, quien pidió duerme hasta que se vuelva a
+// llenar. La deuda se reparte: varios hilos que llegan a la vez duermen el
+// mismo tramo, no uno detrás de otro.
+class Throttle {
+private:
+    static const uint64_t NS_PER_SEC = 1000000000ULL;
+    static const uint64_t BURST_NS = 50000000ULL;      // Ráfaga máxima: 50 ms de cualquiera de los dos
+
+    // Cubeta de fichas: rate fichas por segundo, hasta rate × BURST_NS
+    struct Bucket {
+        double rate = 0;           // 0 = sin límite
+        double tokens = 0;
+        uint64_t last_ns = 0;
+
+        void refill(uint64_t now) {
+            tokens = std::min(rate * BURST_NS / NS_PER_SEC, tokens + rate * (now - last_ns) / NS_PER_SEC);
+            last_ns = now;
+        }
+
+        // Descontar amount y devolver cuánto dormir para saldar la deuda
+        uint64_t take(double amount, uint64_t now) {
+            refill(now);
+            tokens -= amount;
+            return tokens < 0 ? (uint64_t)(-tokens / rate * NS_PER_SEC) : 0;
+        }
+    };
+
+    Bucket io;
+    Bucket cpu;
+    size_t slice;                  // Tramo máximo de E/S por syscall
+    uint64_t cpu_seen_ns;          // CPU del proceso ya descontada
+    uint64_t slept_ns;             // Total dormido por los límites (todos los hilos)
+    pthread_mutex_t mutex;
+
+    static uint64_t clock_ns(clockid_t clock) {
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return (uint64_t)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+    }
+
+    // Descontar bytes de E/S y la CPU usada desde el último pedido; dormir
+    // fuera del mutex
+    void pace(size_t bytes) {
+        pthread_mutex_lock(&mutex);
+        uint64_t now = clock_ns(CLOCK_MONOTONIC);
+        uint64_t wait = 0;
+        if (io.rate > 0 && bytes > 0) wait = io.take(bytes, now);
+        if (cpu.rate > 0) {
+            uint64_t used = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+            wait = std::max(wait, cpu.take((double)(used - cpu_seen_ns), now));
+            cpu_seen_ns = used;
+        }
+        slept_ns += wait;
+        pthread_mutex_unlock(&mutex);
+
+        if (wait > 0) {
+            struct timespec ts;
+            ts.tv_sec = wait / NS_PER_SEC;
+            ts.tv_nsec = wait % NS_PER_SEC;
+            while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+        }
+    }
+
+public:
+    Throttle() : slice(SIZE_MAX), cpu_seen_ns(0), slept_ns(0) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~Throttle() {
+        pthread_mutex_destroy(&mutex);
+    }
+
+    Throttle(const Throttle&) = delete;
+    Throttle& operator=(const Throttle&) = delete;
+
+    // Instancia única del proceso (como el pool de buffers)
+    static Throttle& global() {
+        static Throttle throttle;
+        return throttle;
+    }
+
+    // Configurar antes de lanzar los hilos. bytes_per_sec = 0: sin límite
+    // de E/S; fraction = 0: sin límite de CPU (1.0 = una CPU completa)
+    void configure(uint64_t bytes_per_sec, double fraction) {
+        uint64_t now = clock_ns(CLOCK_MONOTONIC);
+        io.rate = (double)bytes_per_sec;
+        io.tokens = 0;
+        io.last_ns = now;
+        cpu.rate = fraction * NS_PER_SEC;
+        cpu.tokens = 0;
+        cpu.last_ns = now;
+        cpu_seen_ns = clock_ns(CLOCK_PROCESS_CPUTIME_ID);
+        // Unos 20 tramos por segundo, entre 64 KB y 4 MB
+        slice = bytes_per_sec == 0 ? SIZE_MAX
+              : (size_t)std::max<uint64_t>(64 << 10, std::min<uint64_t>(4 << 20, bytes_per_sec / 20));
+    }
+
+    bool limited() const { return io.rate > 0 || cpu.rate > 0; }
+    bool cpu_limited() const { return cpu.rate > 0; }
+
+    // Pedir permiso para mover hasta wanted bytes en una syscall. Devuelve
+    // cuántos mover ahora (con límite de E/S, a lo sumo io_slice())
+    size_t grant_io(size_t wanted) {
+        if (!limited()) return wanted;
+        size_t granted = std::min(wanted, slice);
+        pace(granted);
+        return granted;
+    }
+
+    // Descontar bytes que no se pueden partir (E/S alineada de --direct)
+    void charge_io(size_t bytes) {
+        if (limited()) pace(bytes);
+    }
+
+    size_t io_slice() const { return slice; }
+    double slept_seconds() const { return (double)slept_ns / NS_PER_SEC; }
+
+    // Clases de prioridad "idle" (--idle): SCHED_IDLE para la CPU y la
+    // clase idle de ioprio_set() para el disco. Los hilos creados después
+    // las heredan. Devuelve un error ("" si se aplicaron las dos)
+    static std::string set_idle_priority() {
+        std::string error;
+#ifdef SCHED_IDLE
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        if (sched_setscheduler(0, SCHED_IDLE, &param) == -1) {
+            error = std::string("sched_setscheduler(SCHED_IDLE): ") + strerror(errno);
+        }
+#else
+        error = "SCHED_IDLE no disponible";
+#endif
+#ifdef SYS_ioprio_set
+        // glibc no trae envoltorio: IOPRIO_WHO_PROCESS = 1, clase idle = 3
+        const int who_process = 1;
+        const int class_idle = 3;
+        const int class_shift = 13;
+        if (syscall(SYS_ioprio_set, who_process, 0, class_idle << class_shift) == -1) {
+            if (!error.empty()) error += "; ";
+            error += std::string("ioprio_set(IDLE): ") + strerror(errno);
+        }
+#else
+        if (!error.empty()) error += "; ";
+        error += "ioprio_set no disponible";
+#endif
+        return error;
+    }
+};
+
+#endif // GSEA_THROTTLE_H
@@ -0,0 +1,222 @@
+#ifndef GSEA_VERIFY_H
+#define GSEA_VERIFY_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "container.h"
+#include "buffer_pool.h"
+#include "throttle.h"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+// Resultado de verificar un archivo (gsea --verify)
+struct VerifyReport {
+    bool has_header = false;       // false = sin cabecera (versión anterior u otro archivo)
+    bool blocked = false;          // false = formato sin CRC por bloque
+    bool content_checked = false;  // true = también se decodificó y se comparó el CRC original
+    uint64_t blocks = 0;
+    uint64_t stored_bytes = 0;     // Bytes guardados leídos
+    uint64_t original_size = 0;
+    std::vector<uint64_t> bad_blocks;
+    std::string error;             // Error que impide verificar (cabecera, truncado...)
+};
+
+// Verificación de integridad sin escribir nada
+//
+// Los bloques son independientes, así que se reparten entre N hilos que
+// leen con pread() (sin compartir la posición del descriptor):
+//   - siempre: CRC32C de los bytes guardados (no necesita la clave)
+//   - sin cifrado, o con la clave correcta: además se decodifica el bloque
+//     y se compara el CRC32C del contenido original
+class BlockVerifier {
+private:
+    int fd;
+    ContainerHeader header;
+    const XORCipher* cipher;       // Solo si hay que desencriptar para decodificar
+    bool check_content;
+
+    std::vector<uint64_t> offsets;   // Posición de cada bloque en el archivo
+    std::vector<uint64_t> indices;   // Número de cada bloque (los huecos cuentan varios)
+    std::vector<BlockHeader> blocks;
+
+    pthread_mutex_t mutex;
+    size_t next;
+    std::vector<uint64_t> bad;
+
+    static bool pread_full(int fd, unsigned char* buffer, size_t size, uint64_t offset) {
+        size_t done = 0;
+        while (done < size) {
+            size_t want = Throttle::global().grant_io(size - done);
+            ssize_t n = pread(fd, buffer + done, want, offset + done);
+            if (n == -1) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if (n == 0) return false;  // Truncado
+            done += n;
+        }
+        return true;
+    }
+
+    // Recorrer las cabeceras de bloque (solo 20 bytes por bloque)
+    // Los huecos no guardan nada que verificar: solo cuentan en el tamaño
+    std::string scan(uint64_t start, uint64_t file_size) {
+        uint64_t offset = start;
+        uint64_t total = 0;
+        uint64_t index = 0;
+        while (offset < file_size) {
+            unsigned char bytes[BlockHeader::SIZE];
+            BlockHeader block;
+            if (file_size - offset < BlockHeader::SIZE ||
+                !pread_full(fd, bytes, sizeof(bytes), offset) ||
+                !block.read(bytes, header.block_size) ||
+                block.stored_size > file_size - offset - BlockHeader::SIZE) {
+                return "Bloque " + std::to_string(index) + ": cabecera inválida o datos truncados";
+            }
+            if (!block.hole()) {
+                offsets.push_back(offset + BlockHeader::SIZE);
+                indices.push_back(index);
+                blocks.push_back(block);
+            }
+            total += block.raw_bytes();
+            index += block.block_count();
+            offset += BlockHeader::SIZE + block.stored_size;
+        }
+        if (total != header.original_size) {
+            return "Los bloques suman " + std::to_string(total) + " bytes, la cabecera indica " +
+                   std::to_string(header.original_size);
+        }
+        return "";
+    }
+
+    static void* worker(void* arg) {
+        BlockVerifier* self = (BlockVerifier*)arg;
+        BlockCodec codec(self->header.codec, self->cipher, self->header.block_size);
+        PooledBuffer stored(BlockCodec::frame_bound(self->header.block_size));
+        PooledBuffer raw(self->header.block_size);
+        bool buffers_ok = stored.valid() && raw.valid();
+
+        while (true) {
+            pthread_mutex_lock(&self->mutex);
+            if (self->next >= self->blocks.size()) {
+                pthread_mutex_unlock(&self->mutex);
+                break;
+            }
+            size_t entry = self->next++;
+            pthread_mutex_unlock(&self->mutex);
+
+            const BlockHeader& block = self->blocks[entry];
+            uint64_t index = self->indices[entry];
+            bool ok = buffers_ok &&
+                      pread_full(self->fd, stored.data(), block.stored_size, self->offsets[entry]);
+            if (ok && self->check_content) {
+                ok = codec.decode_block(block, stored.data(), index, raw.data()).empty();
+            } else if (ok) {
+                ok = BlockCodec::stored_ok(block, stored.data());
+            }
+
+            if (!ok) {
+                pthread_mutex_lock(&self->mutex);
+                self->bad.push_back(index);
+                pthread_mutex_unlock(&self->mutex);
+            }
+        }
+        return nullptr;
+    }
+
+public:
+    BlockVerifier() : fd(-1), cipher(nullptr), check_content(false), next(0) {
+        pthread_mutex_init(&mutex, nullptr);
+    }
+
+    ~BlockVerifier() {
+        if (fd != -1) close(fd);
+        pthread_mutex_destroy(&mutex);
+    }
+
+    BlockVerifier(const BlockVerifier&) = delete;
+    BlockVerifier& operator=(const BlockVerifier&) = delete;
+
+    // Verificar un archivo con threads hilos. key_cipher puede ser nullptr
+    VerifyReport verify(const std::string& path, const XORCipher* key_cipher, int threads) {
+        VerifyReport report;
+
+        fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) == -1) {
+            report.error = std::string("No se pudo abrir: ") + strerror(errno);
+            return report;
+        }
+
+        unsigned char bytes[ContainerHeader::MAX_SIZE];
+        size_t length = (size_t)std::min<uint64_t>(sizeof(bytes), st.st_size);
+        size_t consumed = 0;
+        int status = 0;
+        if (length >= ContainerHeader::SIZE && pread_full(fd, bytes, length, 0)) {
+            status = header.read(bytes, length, consumed);
+        }
+        if (status == -1) {
+            report.error = "Cabecera del archivo inválida";
+            return report;
+        }
+        if (status == 0) {
+            // Sin cabecera: no hay CRC que comparar
+            return report;
+        }
+        report.has_header = true;
+        report.original_size = header.original_size;
+        if (!header.blocked()) {
+            // Formato de un solo flujo: no tiene CRC por bloque
+            return report;
+        }
+        report.blocked = true;
+
+        // El contenido solo se puede comprobar si se puede desencriptar
+        if (header.cipher == CONTAINER_CIPHER_NONE) {
+            check_content = true;
+        } else if (key_cipher != nullptr) {
+            if (!header.key_matches(*key_cipher)) {
+                report.error = "Clave incorrecta";
+                return report;
+            }
+            cipher = key_cipher;
+            check_content = true;
+        }
+        report.content_checked = check_content;
+
+        std::string error = scan(consumed, st.st_size);
+        if (!error.empty()) {
+            report.error = error;
+            return report;
+        }
+        report.blocks = blocks.size();
+        report.stored_bytes = st.st_size;
+
+        if ((size_t)threads > blocks.size()) threads = blocks.size();
+        std::vector<pthread_t> workers(threads > 1 ? threads : 0);
+        int started = 0;
+        for (int i = 0; i < (int)workers.size(); i++) {
+            if (pthread_create(&workers[i], nullptr, worker, this) != 0) break;
+            started++;
+        }
+        if (started == 0) {
+            worker(this);
+        }
+        for (int i = 0; i < started; i++) {
+            pthread_join(workers[i], nullptr);
+        }
+
+        std::sort(bad.begin(), bad.end());
+        report.bad_blocks = bad;
+        return report;
+    }
+};
+
+#endif // GSEA_VERIFY_H
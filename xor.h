@@ -4,23 +4,28 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <cstring>
 #include <cstdint>
+#include "log.h"
 
 // Clase para encriptación/desencriptación XOR mejorada
+//
+// Solo se conserva la clave expandida (un arreglo fijo dentro del objeto):
+// crear un XORCipher por archivo no reserva memoria en el heap.
 class XORCipher {
 private:
-    std::string key;                    // Clave secreta del usuario
-    std::vector<unsigned char> expanded_key;  // Clave expandida
     static const int KEY_EXPANSION_SIZE = 256;  // Tamaño de la clave expandida
+    unsigned char expanded_key[KEY_EXPANSION_SIZE];  // Clave expandida
+    bool key_ready;                              // false si la clave estaba vacía
     
     // Función hash simple para expandir la clave
     // Convierte una clave de cualquier longitud en una de 256 bytes
-    void expand_key() {
-        expanded_key.clear();
-        expanded_key.resize(KEY_EXPANSION_SIZE);
+    void expand_key(const std::string& key) {
+        memset(expanded_key, 0, sizeof(expanded_key));
+        key_ready = false;
         
         if (key.empty()) {
-            std::cerr << "Error: Clave vacía\n";
+            GSEA_ERROR("Error: Clave vacía\n");
             return;
         }
         
@@ -40,25 +45,26 @@ private:
             // Rotar el hash para el siguiente byte
             hash = (hash >> 8) | (hash << 24);
         }
+        key_ready = true;
         
-        std::cout << "  → Clave expandida a " << KEY_EXPANSION_SIZE << " bytes\n";
+        GSEA_DEBUG("  → Clave expandida a " << KEY_EXPANSION_SIZE << " bytes\n");
     }
     
     // Función auxiliar para rotar bits a la izquierda
-    unsigned char rotate_left(unsigned char value, int positions) {
+    static unsigned char rotate_left(unsigned char value, int positions) {
         positions = positions % 8;  // Asegurar que positions esté en rango 0-7
         return (value << positions) | (value >> (8 - positions));
     }
     
     // Función auxiliar para rotar bits a la derecha
-    unsigned char rotate_right(unsigned char value, int positions) {
+    static unsigned char rotate_right(unsigned char value, int positions) {
         positions = positions % 8;
         return (value >> positions) | (value << (8 - positions));
     }
     
     // Aplicar transformación no lineal (S-box simplificada)
     // Esto dificulta el análisis de frecuencias
-    unsigned char apply_sbox(unsigned char value) {
+    static unsigned char apply_sbox(unsigned char value) {
         // Tabla de sustitución simple (S-box)
         // En un cifrado real como AES, esta tabla está cuidadosamente diseñada
         static const unsigned char sbox[256] = {
@@ -84,7 +90,7 @@ private:
     }
     
     // Aplicar transformación inversa (S-box inversa)
-    unsigned char apply_inverse_sbox(unsigned char value) {
+    static unsigned char apply_inverse_sbox(unsigned char value) {
         // Tabla de sustitución inversa
         static const unsigned char inv_sbox[256] = {
             0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb,
@@ -109,40 +115,47 @@ private:
     }
     
 public:
+    // Estado del cifrado por bloques: el encadenamiento hace que cada byte
+    // dependa del anterior, así que el estado debe pasar de un bloque al siguiente
+    struct StreamState {
+        unsigned char state;     // Estado de encadenamiento
+        uint64_t position;       // Posición absoluta dentro del flujo
+    };
+    
     // Constructor
-    XORCipher(const std::string& user_key) : key(user_key) {
-        expand_key();
+    XORCipher(const std::string& user_key) {
+        expand_key(user_key);
     }
     
-    // ENCRIPTAR: Aplica XOR mejorado con modificación de estado
-    std::vector<unsigned char> encrypt(const std::vector<unsigned char>& plaintext) {
-        if (plaintext.empty()) {
-            std::cerr << "Error: Datos vacíos para encriptar\n";
-            return std::vector<unsigned char>();
-        }
-        
-        if (expanded_key.empty()) {
-            std::cerr << "Error: Clave no inicializada\n";
-            return std::vector<unsigned char>();
-        }
-        
-        std::vector<unsigned char> ciphertext;
-        ciphertext.reserve(plaintext.size());
-        
-        // Estado inicial basado en la suma de la clave expandida
-        unsigned char state = 0;
+    // Borrar la clave expandida (volatile: que el compilador no lo omita
+    // por ser la última escritura del objeto)
+    ~XORCipher() {
+        volatile unsigned char* key = expanded_key;
+        for (int i = 0; i < KEY_EXPANSION_SIZE; i++) key[i] = 0;
+    }
+    
+    // Estado inicial basado en la suma de la clave expandida
+    StreamState begin_stream() const {
+        StreamState stream;
+        stream.state = 0;
+        stream.position = 0;
         for (unsigned char k : expanded_key) {
-            state ^= k;
+            stream.state ^= k;
         }
-        
-        std::cout << "  → Encriptando " << plaintext.size() << " bytes...\n";
+        return stream;
+    }
+    
+    // Encriptar un bloque de un flujo (in y out pueden ser el mismo buffer)
+    void encrypt_chunk(const unsigned char* in, unsigned char* out, size_t size, StreamState& stream) const {
+        unsigned char state = stream.state;
+        uint64_t position = stream.position;
         
         // Procesar cada byte del texto plano
-        for (size_t i = 0; i < plaintext.size(); i++) {
-            unsigned char plain_byte = plaintext[i];
+        for (size_t i = 0; i < size; i++, position++) {
+            unsigned char plain_byte = in[i];
             
             // PASO 1: XOR con la clave expandida (rotada según posición)
-            unsigned char key_byte = expanded_key[i % KEY_EXPANSION_SIZE];
+            unsigned char key_byte = expanded_key[position % KEY_EXPANSION_SIZE];
             unsigned char temp = plain_byte ^ key_byte;
             
             // PASO 2: Aplicar S-box (sustitución no lineal)
@@ -156,53 +169,34 @@ public:
             temp = rotate_left(temp, state % 8);
             
             // PASO 5: XOR adicional con posición (difusión)
-            temp ^= (i & 0xFF);
+            temp ^= (position & 0xFF);
             
             // Guardar el byte encriptado
-            ciphertext.push_back(temp);
+            out[i] = temp;
             
             // PASO 6: Actualizar el estado para el siguiente byte
             // El estado se mezcla con el byte encriptado y la posición
             state = (state + temp + key_byte) & 0xFF;
         }
         
-        std::cout << "  → Encriptación completada\n";
-        
-        return ciphertext;
+        stream.state = state;
+        stream.position = position;
     }
     
-    // DESENCRIPTAR: Proceso inverso de la encriptación
-    std::vector<unsigned char> decrypt(const std::vector<unsigned char>& ciphertext) {
-        if (ciphertext.empty()) {
-            std::cerr << "Error: Datos vacíos para desencriptar\n";
-            return std::vector<unsigned char>();
-        }
-        
-        if (expanded_key.empty()) {
-            std::cerr << "Error: Clave no inicializada\n";
-            return std::vector<unsigned char>();
-        }
-        
-        std::vector<unsigned char> plaintext;
-        plaintext.reserve(ciphertext.size());
-        
-        // Estado inicial (mismo que en encriptación)
-        unsigned char state = 0;
-        for (unsigned char k : expanded_key) {
-            state ^= k;
-        }
-        
-        std::cout << "  → Desencriptando " << ciphertext.size() << " bytes...\n";
+    // Desencriptar un bloque de un flujo (in y out pueden ser el mismo buffer)
+    void decrypt_chunk(const unsigned char* in, unsigned char* out, size_t size, StreamState& stream) const {
+        unsigned char state = stream.state;
+        uint64_t position = stream.position;
         
         // Procesar cada byte del texto cifrado (en orden inverso a la encriptación)
-        for (size_t i = 0; i < ciphertext.size(); i++) {
-            unsigned char cipher_byte = ciphertext[i];
+        for (size_t i = 0; i < size; i++, position++) {
+            unsigned char cipher_byte = in[i];
             
             // Obtener la clave para esta posición
-            unsigned char key_byte = expanded_key[i % KEY_EXPANSION_SIZE];
+            unsigned char key_byte = expanded_key[position % KEY_EXPANSION_SIZE];
             
             // PASO 1 (inverso): XOR con posición
-            unsigned char temp = cipher_byte ^ (i & 0xFF);
+            unsigned char temp = cipher_byte ^ (position & 0xFF);
             
             // PASO 2 (inverso): Rotar bits a la derecha
             temp = rotate_right(temp, state % 8);
@@ -214,30 +208,94 @@ public:
             temp = apply_inverse_sbox(temp);
             
             // PASO 5 (inverso): XOR con la clave expandida
-            unsigned char plain_byte = temp ^ key_byte;
-            
-            // Guardar el byte desencriptado
-            plaintext.push_back(plain_byte);
+            out[i] = temp ^ key_byte;
             
             // PASO 6: Actualizar el estado (igual que en encriptación)
             // IMPORTANTE: Usamos cipher_byte (no plain_byte) porque es lo que teníamos en encrypt
             state = (state + cipher_byte + key_byte) & 0xFF;
         }
         
-        std::cout << "  → Desencriptación completada\n";
+        stream.state = state;
+        stream.position = position;
+    }
+    
+    // ENCRIPTAR sobre el mismo buffer (sin copia ni reserva de memoria)
+    bool encrypt_in_place(unsigned char* data, size_t size) const {
+        if (size == 0 || !key_ready) {
+            GSEA_ERROR("Error: Datos vacíos o clave no inicializada\n");
+            return false;
+        }
+        GSEA_VERBOSE("  → Encriptando " << size << " bytes...\n");
+        StreamState stream = begin_stream();
+        encrypt_chunk(data, data, size, stream);
+        GSEA_VERBOSE("  → Encriptación completada\n");
+        return true;
+    }
+    
+    // DESENCRIPTAR sobre el mismo buffer
+    bool decrypt_in_place(unsigned char* data, size_t size) const {
+        if (size == 0 || !key_ready) {
+            GSEA_ERROR("Error: Datos vacíos o clave no inicializada\n");
+            return false;
+        }
+        GSEA_VERBOSE("  → Desencriptando " << size << " bytes...\n");
+        StreamState stream = begin_stream();
+        decrypt_chunk(data, data, size, stream);
+        GSEA_VERBOSE("  → Desencriptación completada\n");
+        return true;
+    }
+    
+    // ENCRIPTAR: Aplica XOR mejorado con modificación de estado
+    std::vector<unsigned char> encrypt(const std::vector<unsigned char>& plaintext) const {
+        if (plaintext.empty()) {
+            GSEA_ERROR("Error: Datos vacíos para encriptar\n");
+            return std::vector<unsigned char>();
+        }
+        
+        if (!key_ready) {
+            GSEA_ERROR("Error: Clave no inicializada\n");
+            return std::vector<unsigned char>();
+        }
         
-        return plaintext;
+        std::vector<unsigned char> ciphertext(plaintext.size());
+        
+        GSEA_VERBOSE("  → Encriptando " << plaintext.size() << " bytes...\n");
+        
+        StreamState stream = begin_stream();
+        encrypt_chunk(plaintext.data(), ciphertext.data(), plaintext.size(), stream);
+        
+        GSEA_VERBOSE("  → Encriptación completada\n");
+        
+        return ciphertext;
     }
     
-    // Función auxiliar para mostrar bytes en hexadecimal (útil para debug)
-    static void print_hex(const std::vector<unsigned char>& data, int max_bytes = 16) {
-        for (size_t i = 0; i < data.size() && i < (size_t)max_bytes; i++) {
-            printf("%02x ", data[i]);
+    // DESENCRIPTAR: Proceso inverso de la encriptación
+    std::vector<unsigned char> decrypt(const std::vector<unsigned char>& ciphertext) const {
+        if (ciphertext.empty()) {
+            GSEA_ERROR("Error: Datos vacíos para desencriptar\n");
+            return std::vector<unsigned char>();
         }
-        if (data.size() > (size_t)max_bytes) {
-            std::cout << "...";
+        
+        if (!key_ready) {
+            GSEA_ERROR("Error: Clave no inicializada\n");
+            return std::vector<unsigned char>();
         }
-        std::cout << "\n";
+        
+        std::vector<unsigned char> plaintext(ciphertext.size());
+        
+        GSEA_VERBOSE("  → Desencriptando " << ciphertext.size() << " bytes...\n");
+        
+        StreamState stream = begin_stream();
+        decrypt_chunk(ciphertext.data(), plaintext.data(), ciphertext.size(), stream);
+        
+        GSEA_VERBOSE("  → Desencriptación completada\n");
+        
+        return plaintext;
+    }
+    
+    // Función auxiliar para mostrar bytes en hexadecimal (útil para debug, -vv)
+    static void print_hex(const std::vector<unsigned char>& data, int max_bytes = 16) {
+        GSEA_DEBUG(Log::hex(data.data(), data.size(), max_bytes) << "\n");
     }
 };
 